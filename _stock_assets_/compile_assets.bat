@@ -1,3 +1,10 @@
+set cooker=..\_build_release_\cmd_fract_cooking\Build_Output\bin\Release\fract_cooking.exe
+
+if not exist %cooker% (
+  echo fract_cooking has not been built, build the cmake projects first
+  exit /b 1
+)
+
 mkdir tmp_texture_packs
 mkdir tmp_models_packs
 
@@ -5,8 +12,8 @@ rmdir ..\content\ /S /Q
 
 xcopy .\content ..\content /s /i
 
-..\_tools_\win\fract_cooking.exe td ./textures o ./tmp_texture_packs/stock
-..\_tools_\win\fract_cooking.exe md ./models o ./tmp_models_packs/stock
+%cooker% td ./textures o ./tmp_texture_packs/stock
+%cooker% md ./models o ./tmp_models_packs/stock
 
 xcopy ".\tmp_texture_packs\stock_texpack" "..\content\stock_texpack*" /Y
 
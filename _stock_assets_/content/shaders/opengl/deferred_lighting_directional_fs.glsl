@@ -1,8 +1,8 @@
-#version 420 core
+#version 430 core
 
 out vec4 FragColor;
 in vec2 TexCoords;
-flat in int inst_id;
+flat in int light_id;
 
 uniform sampler2D g_position;
 uniform sampler2D g_normal;
@@ -10,8 +10,17 @@ uniform sampler2D g_albedo;
 uniform sampler2D g_rma;
 uniform sampler2D g_depth;
 uniform vec3 cam_pos;
-uniform vec3 light_directions[50];
-uniform vec3 light_color[50];
+
+// Matches GlDeferredLighting::LightInstance.
+struct LightInstance {
+  mat4 world;
+  vec4 position_radius;
+  vec4 coeff;
+  vec4 color;
+  vec4 direction;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { LightInstance lights[]; };
 
 const float PI = 3.14159265359;
 
@@ -63,14 +72,14 @@ void main() {
   float r = clamp(rma.r, 0.05, 1.0);
   float m = rma.g;
   float e = rma.b;
-  int i = inst_id;
+  LightInstance light = lights[light_id];
 
   vec3 F0 = vec3(0.04);
   F0 = mix(F0, albedo, m);
   vec3 Lo = vec3(0.0);
-  vec3 L = normalize(-light_directions[i]);
+  vec3 L = normalize(-light.direction.xyz);
   vec3 H = normalize(V + L);
-  vec3 radiance = light_color[i];
+  vec3 radiance = light.color.rgb;
 
   float NDF = DistributionGGX(N, H, r);
   float G = GeometrySmith(N, V, L, r);
@@ -1,8 +1,8 @@
-#version 420 core
+#version 430 core
 
 out vec4 FragColor;
 in vec2 TexCoords;
-flat in int inst_id;
+flat in int light_id;
 
 uniform sampler2D g_position;
 uniform sampler2D g_normal;
@@ -11,11 +11,22 @@ uniform sampler2D g_rma;
 uniform sampler2D g_depth;
 
 uniform vec3 cam_pos;
-uniform vec3 light_directions[50];
-uniform vec3 light_color[50];
-uniform mat4 world[3];
-uniform sampler2DShadow depth_map[3];
-uniform float cascade_depth[3];
+
+// Matches GlDeferredLighting::LightInstance.
+struct LightInstance {
+  mat4 world;
+  vec4 position_radius;
+  vec4 coeff;
+  vec4 color;
+  vec4 direction;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { LightInstance lights[]; };
+
+uniform mat4 world[4];
+uniform sampler2DShadow depth_map[4];
+uniform float cascade_depth[4];
+uniform int cascade_count;
 
 const float PI = 3.14159265359;
 
@@ -24,13 +35,8 @@ float ShadowCalculation(vec4 fragPos, float ndotl, int i) {
   projCoords = projCoords * 0.5 + 0.5;
   float currentDepth = projCoords.z;
 
-  float bias;
-  if (i == 0)
-    bias = 0.001;
-  else if (i == 1)
-    bias = 0.001;
-  else if (i == 2)
-    bias = 0.01;
+  const float biases[4] = float[](0.001, 0.001, 0.005, 0.01);
+  float bias = biases[i];
 
   // float bias = 0.001;//max(0.01 * (1.0 - ndotl), 0.0001);
   vec2 texelSize = 1.0 / textureSize(depth_map[i], 0);
@@ -95,14 +101,14 @@ void main() {
   float r = clamp(rma.r, 0.05, 1.0);
   float m = rma.g;
   float e = rma.b;
-  int i = inst_id;
+  LightInstance light = lights[light_id];
 
   vec3 F0 = vec3(0.04);
   F0 = mix(F0, albedo, m);
   vec3 Lo = vec3(0.0);
-  vec3 L = normalize(-light_directions[i]);
+  vec3 L = normalize(-light.direction.xyz);
   vec3 H = normalize(V + L);
-  vec3 radiance = light_color[i];
+  vec3 radiance = light.color.rgb;
 
   float NDF = DistributionGGX(N, H, r);
   float G = GeometrySmith(N, V, L, r);
@@ -119,8 +125,8 @@ void main() {
   float NdotL = max(dot(N, L), 0.0);
   float depth = texture(g_depth, frag_coord).r;
 
-  for (int l = 0; l < 3; ++l) {
-    if (depth < cascade_depth[l] || l == 2) {
+  for (int l = 0; l < cascade_count; ++l) {
+    if (depth < cascade_depth[l] || l == cascade_count - 1) {
       vec4 light_pos = world[l] * vec4(frag_pos, 1.0);
       float shadow = ShadowCalculation(light_pos, NdotL, l);
       Lo = shadow * (kD * albedo / PI + brdf) * radiance * NdotL;
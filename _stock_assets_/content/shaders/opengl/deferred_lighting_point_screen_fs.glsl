@@ -1,8 +1,8 @@
-#version 420 core
+#version 430 core
 
 out vec4 FragColor;
 in vec2 TexCoords;
-flat in int inst_id;
+flat in int light_id;
 
 uniform sampler2D g_position;
 uniform sampler2D g_normal;
@@ -11,10 +11,17 @@ uniform sampler2D g_rma;
 uniform sampler2D g_depth;
 
 uniform vec3 cam_pos;
-uniform vec3 light_position[50];
-uniform vec3 light_coeff[50];
-uniform float light_radius[50];
-uniform vec3 light_color[50];
+
+// Matches GlDeferredLighting::LightInstance.
+struct LightInstance {
+  mat4 world;
+  vec4 position_radius;
+  vec4 coeff;
+  vec4 color;
+  vec4 direction;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { LightInstance lights[]; };
 
 const float PI = 3.14159265359;
 
@@ -67,18 +74,20 @@ void main() {
   float r = clamp(rma.r, 0.05, 1.0);
   float m = rma.g;
   float e = rma.b;
-  int i = inst_id;
+  LightInstance light = lights[light_id];
+  vec3 light_pos = light.position_radius.xyz;
+  float light_radius = light.position_radius.w;
 
   vec3 F0 = vec3(0.04);
   F0 = mix(F0, albedo, m);
   vec3 Lo = vec3(0.0);
-  vec3 L = normalize(light_position[i] - frag_pos);
+  vec3 L = normalize(light_pos - frag_pos);
   vec3 H = normalize(V + L);
-  float distance = length(light_position[i] - frag_pos);
-  float attenuation = 1.0 / (light_coeff[i].x + light_coeff[i].y * distance +
-                             light_coeff[i].z * (distance * distance));
-  attenuation *= clamp(1. - ((1. / light_radius[i]) * distance), 0., 1.);
-  vec3 radiance = light_color[i] * clamp(attenuation, 0.0, 1.0);
+  float distance = length(light_pos - frag_pos);
+  float attenuation = 1.0 / (light.coeff.x + light.coeff.y * distance +
+                             light.coeff.z * (distance * distance));
+  attenuation *= clamp(1. - ((1. / light_radius) * distance), 0., 1.);
+  vec3 radiance = light.color.rgb * clamp(attenuation, 0.0, 1.0);
 
   float NDF = DistributionGGX(N, H, r);
   float G = GeometrySmith(N, V, L, r);
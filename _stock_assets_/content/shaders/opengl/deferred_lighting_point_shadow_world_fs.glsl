@@ -1,7 +1,8 @@
-#version 420 core
+#version 430 core
 
 out vec4 FragColor;
 flat in int inst_id;
+flat in int light_id;
 
 uniform sampler2D g_position;
 uniform sampler2D g_normal;
@@ -12,15 +13,22 @@ uniform vec3 cam_pos;
 uniform vec2 screen_dim;
 uniform samplerCube depth_map[5];
 uniform float far_plane[5];
-uniform vec3 light_position[50];
-uniform vec3 light_coeff[50];
-uniform float light_radius[50];
-uniform vec3 light_color[50];
+
+// Matches GlDeferredLighting::LightInstance.
+struct LightInstance {
+  mat4 world;
+  vec4 position_radius;
+  vec4 coeff;
+  vec4 color;
+  vec4 direction;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { LightInstance lights[]; };
 
 const float PI = 3.14159265359;
 
-float ShadowCalculation(vec3 fragPos, int i) {
-  vec3 fragToLight = fragPos - light_position[i];
+float ShadowCalculation(vec3 fragPos, vec3 lightPos, int i) {
+  vec3 fragToLight = fragPos - lightPos;
   float currentDepth = length(fragToLight);
   float bias = 0.05;
   float shadow = 0.0;
@@ -88,17 +96,20 @@ void main() {
   float m = rma.g;
   float e = rma.b;
   int i = inst_id;
+  LightInstance light = lights[light_id];
+  vec3 light_pos = light.position_radius.xyz;
+  float light_radius = light.position_radius.w;
 
   vec3 F0 = vec3(0.04);
   F0 = mix(F0, albedo, m);
   vec3 Lo = vec3(0.0);
-  vec3 L = normalize(light_position[i] - frag_pos);
+  vec3 L = normalize(light_pos - frag_pos);
   vec3 H = normalize(V + L);
-  float distance = length(light_position[i] - frag_pos);
-  float attenuation = 1.0 / (light_coeff[i].x + light_coeff[i].y * distance +
-                             light_coeff[i].z * (distance * distance));
-  attenuation *= clamp(1. - ((1. / light_radius[i]) * distance), 0., 1.);
-  vec3 radiance = light_color[i] * clamp(attenuation, 0.0, 1.0);
+  float distance = length(light_pos - frag_pos);
+  float attenuation = 1.0 / (light.coeff.x + light.coeff.y * distance +
+                             light.coeff.z * (distance * distance));
+  attenuation *= clamp(1. - ((1. / light_radius) * distance), 0., 1.);
+  vec3 radiance = light.color.rgb * clamp(attenuation, 0.0, 1.0);
 
   float NDF = DistributionGGX(N, H, r);
   float G = GeometrySmith(N, V, L, r);
@@ -114,7 +125,7 @@ void main() {
 
   float NdotL = max(dot(N, L), 0.0);
 
-  float shadow = 1.0 - ShadowCalculation(frag_pos, i);
+  float shadow = 1.0 - ShadowCalculation(frag_pos, light_pos, i);
   Lo = shadow * (kD * albedo / PI + brdf) * radiance * NdotL;
   FragColor = vec4(Lo, 1.0);
 }
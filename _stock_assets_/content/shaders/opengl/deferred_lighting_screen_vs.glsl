@@ -1,13 +1,17 @@
-#version 420 core
+#version 430 core
 
 layout(location = 0) in vec2 position;
 layout(location = 1) in vec2 texCoords;
 
+uniform int first_light;
+
 out vec2 TexCoords;
 flat out int inst_id;
+flat out int light_id;
 
 void main() {
   gl_Position = vec4(position.x, position.y, 0.0f, 1.0f);
   TexCoords = texCoords;
   inst_id = gl_InstanceID;
+  light_id = first_light + gl_InstanceID;
 }
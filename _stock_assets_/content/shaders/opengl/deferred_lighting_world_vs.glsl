@@ -1,16 +1,31 @@
-#version 420 core
+#version 430 core
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
-uniform mat4 world[50];
+// Matches GlDeferredLighting::LightInstance.
+struct LightInstance {
+  mat4 world;
+  vec4 position_radius;
+  vec4 coeff;
+  vec4 color;
+  vec4 direction;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { LightInstance lights[]; };
 uniform mat4 view_proj;
+uniform int first_light;
 
 flat out int inst_id;
+flat out int light_id;
 
 void main() {
-  gl_Position = view_proj * (world[gl_InstanceID] * vec4(position, 1.0));
+  vec3 position = mesh_center + mesh_extent * packed_position;
+  light_id = first_light + gl_InstanceID;
+  gl_Position = view_proj * (lights[light_id].world * vec4(position, 1.0));
   inst_id = gl_InstanceID;
 }
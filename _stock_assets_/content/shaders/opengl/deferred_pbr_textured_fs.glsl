@@ -1,4 +1,4 @@
-#version 420 core
+#version 430 core
 
 layout(location = 0) out vec3 g_position;
 layout(location = 1) out vec3 g_normal;
@@ -11,13 +11,12 @@ in VS_OUT {
   mat3 TBN;
 } fs_in;
 
-uniform vec3 albedo[100];
-uniform vec3 rme[100];
 uniform sampler2D albedo_tex;
 uniform sampler2D normal_tex;
 uniform sampler2D rma_tex;
 
-flat in int inst_id;
+flat in vec3 inst_albedo;
+flat in vec3 inst_rme;
 
 void main() {
   vec4 albedo_color = texture(albedo_tex, fs_in.TexCoords);
@@ -25,13 +24,15 @@ void main() {
     discard;
   }
 
-  vec3 N = texture(normal_tex, fs_in.TexCoords).rgb;
-  N = normalize(N * 2.0 - 1.0);
+  // Normal maps are cooked to two channel BC5, rebuild z from x and y.
+  vec3 N;
+  N.xy = texture(normal_tex, fs_in.TexCoords).rg * 2.0 - 1.0;
+  N.z = sqrt(max(1.0 - dot(N.xy, N.xy), 0.0));
   N = normalize(fs_in.TBN * N);
 
   g_position = fs_in.WorldPos;
   g_normal = vec3(N * 0.5 + 0.5);
 
-  g_albedo = albedo_color.rgb * albedo[inst_id];
-  g_rma = texture(rma_tex, fs_in.TexCoords).rgb + rme[inst_id];
+  g_albedo = albedo_color.rgb * inst_albedo;
+  g_rma = texture(rma_tex, fs_in.TexCoords).rgb + inst_rme;
 }
@@ -1,9 +1,12 @@
-#version 420 core
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : enable
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
 out VS_OUT {
   vec3 WorldPos;
@@ -11,37 +14,63 @@ out VS_OUT {
   mat3 TBN;
 } vs_out;
 
-uniform mat4 world[100];
-uniform mat4 world_inv_trans[100];
+struct Surface {
+  mat4 world_inv_trans;
+  vec4 albedo;
+  vec4 rme;
+  vec4 tex;
+};
+
+layout(std430, binding = 0) readonly buffer InstanceData { mat4 world[]; };
+layout(std430, binding = 1) readonly buffer DrawData { vec4 draw_bounds[]; };
+layout(std430, binding = 3) readonly buffer SurfaceData { Surface surfaces[]; };
 uniform mat4 view_proj;
-uniform vec2 tex_scale[100];
-uniform vec2 tex_offset[100];
+uniform uint instance_offset;
+uniform bool multi_draw;
+
+flat out vec3 inst_albedo;
+flat out vec3 inst_rme;
 
-flat out int inst_id;
+#include "shaders/opengl/vertex_packing.glsl"
 
 void main() {
-  vec3 T =
-      normalize((world_inv_trans[gl_InstanceID] * vec4(tangent, 0.0f)).xyz);
-  vec3 N = normalize((world_inv_trans[gl_InstanceID] * vec4(normal, 0.0f)).xyz);
+  uint instance = instance_offset + gl_InstanceID;
+  vec3 center = mesh_center, extent = mesh_extent;
+#ifdef GL_ARB_shader_draw_parameters
+  if (multi_draw) {
+    instance += gl_BaseInstanceARB;
+    center = draw_bounds[gl_DrawIDARB * 2].xyz;
+    extent = draw_bounds[gl_DrawIDARB * 2 + 1].xyz;
+  }
+#endif
+  Surface surface = surfaces[instance];
+
+  vec3 position = center + extent * packed_position;
+  vec3 normal = OctDecode(packed_normal);
+  vec3 tangent = OctDecode(packed_tangent);
+
+  vec3 T = normalize((surface.world_inv_trans * vec4(tangent, 0.0f)).xyz);
+  vec3 N = normalize((surface.world_inv_trans * vec4(normal, 0.0f)).xyz);
   vec3 B = normalize(cross(N, T));
 
-  vec4 world_pos = world[gl_InstanceID] * vec4(position, 1.0);
+  vec4 world_pos = world[instance] * vec4(position, 1.0);
 
   vs_out.WorldPos = world_pos.xyz;
+  vec2 tex_scale = surface.tex.xy;
   vec2 scale_center = vec2(.5f, .5f);
-  vs_out.TexCoords =
-      (texcoord - scale_center) * abs(tex_scale[gl_InstanceID]) + scale_center;
-  vs_out.TexCoords += tex_offset[gl_InstanceID];
+  vs_out.TexCoords = (texcoord - scale_center) * abs(tex_scale) + scale_center;
+  vs_out.TexCoords += surface.tex.zw;
 
-  if (tex_scale[gl_InstanceID][0] < 0.f) {
+  if (tex_scale[0] < 0.f) {
     vs_out.TexCoords[0] = 1.f - vs_out.TexCoords[0];
   }
 
-  if (tex_scale[gl_InstanceID][1] < 0.f) {
+  if (tex_scale[1] < 0.f) {
     vs_out.TexCoords[1] = 1.f - vs_out.TexCoords[1];
   }
 
   vs_out.TBN = mat3(T, B, N);
   gl_Position = view_proj * world_pos;
-  inst_id = gl_InstanceID;
+  inst_albedo = surface.albedo.rgb;
+  inst_rme = surface.rme.rgb;
 }
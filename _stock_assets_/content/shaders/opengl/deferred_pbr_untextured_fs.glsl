@@ -1,4 +1,4 @@
-#version 420 core
+#version 430 core
 
 layout(location = 0) out vec3 g_position;
 layout(location = 1) out vec3 g_normal;
@@ -11,14 +11,12 @@ in VS_OUT {
   vec3 Normal;
 } fs_in;
 
-uniform vec3 albedo[100];
-uniform vec3 rme[100];
-
-flat in int inst_id;
+flat in vec3 inst_albedo;
+flat in vec3 inst_rme;
 
 void main() {
   g_position = fs_in.WorldPos;
   g_normal = normalize(fs_in.Normal) * 0.5 + 0.5;
-  g_albedo = albedo[inst_id];
-  g_rma = rme[inst_id];
+  g_albedo = inst_albedo;
+  g_rma = inst_rme;
 }
@@ -115,8 +115,10 @@ vec3 PbrLighting(vec3 frag_pos, vec3 V, vec3 N, vec3 F0, vec3 a, float m,
 void main() {
   vec3 V = normalize(cam_pos - fs_in.WorldPos);
 
-  vec3 N = texture(normal_tex, fs_in.TexCoords).rgb;
-  N = normalize(N * 2.0 - 1.0);
+  // Normal maps are cooked to two channel BC5, rebuild z from x and y.
+  vec3 N;
+  N.xy = texture(normal_tex, fs_in.TexCoords).rg * 2.0 - 1.0;
+  N.z = sqrt(max(1.0 - dot(N.xy, N.xy), 0.0));
   N = normalize(fs_in.TBN * N);
 
   vec3 rma = rme[inst_id] + texture(rma_tex, fs_in.TexCoords).rgb;
@@ -1,9 +1,11 @@
 #version 420 core
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
 flat out int inst_id;
 
@@ -19,7 +21,13 @@ out VS_OUT {
   mat3 TBN;
 } vs_out;
 
+#include "shaders/opengl/vertex_packing.glsl"
+
 void main() {
+  vec3 position = mesh_center + mesh_extent * packed_position;
+  vec3 normal = OctDecode(packed_normal);
+  vec3 tangent = OctDecode(packed_tangent);
+
   vec3 T =
       normalize((world_inv_trans[gl_InstanceID] * vec4(tangent, 0.0f)).xyz);
   vec3 N = normalize((world_inv_trans[gl_InstanceID] * vec4(normal, 0.0f)).xyz);
@@ -1,9 +1,11 @@
 #version 420 core
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
 out VS_OUT {
   vec3 WorldPos;
@@ -17,7 +19,12 @@ uniform mat4 view_proj;
 
 flat out int inst_id;
 
+#include "shaders/opengl/vertex_packing.glsl"
+
 void main() {
+  vec3 position = mesh_center + mesh_extent * packed_position;
+  vec3 normal = OctDecode(packed_normal);
+
   vec4 world_pos = world[gl_InstanceID] * vec4(position, 1.0);
   gl_Position = view_proj * world_pos;
   vs_out.WorldPos = world_pos.xyz;
@@ -1,6 +1,5 @@
 #version 420 core
-out vec4 color;
+in vec4 color;
+out vec4 frag_color;
 
-uniform vec4 rect_color;
-
-void main() { color = rect_color; }
+void main() { frag_color = color; }
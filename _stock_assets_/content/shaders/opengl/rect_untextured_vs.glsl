@@ -1,6 +1,18 @@
 #version 420 core
-layout(location = 0) in vec2 vertex;
+layout(location = 0) in vec4 rect;
+layout(location = 1) in vec4 rect_color;
 
-uniform mat4 projection;
+out vec4 color;
 
-void main() { gl_Position = projection * vec4(vertex, 0.0, 1.0); }
+uniform vec2 screen_dim;
+
+const vec2 corners[6] = vec2[](vec2(-1.0, 1.0), vec2(-1.0, -1.0),
+                               vec2(1.0, -1.0), vec2(-1.0, 1.0),
+                               vec2(1.0, -1.0), vec2(1.0, 1.0));
+
+void main() {
+  // Rects are sized by screen height on both axes to keep their aspect.
+  vec2 pixel = (rect.xy + rect.zw * corners[gl_VertexID]) * screen_dim.y;
+  gl_Position = vec4(pixel / screen_dim * 2.0 - 1.0, 0.0, 1.0);
+  color = rect_color;
+}
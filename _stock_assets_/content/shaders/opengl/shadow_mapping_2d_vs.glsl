@@ -1,14 +1,30 @@
-#version 420 core
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : enable
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
 uniform mat4 shadow_matrices[3];
-uniform mat4 world[200];
+layout(std430, binding = 0) readonly buffer InstanceData { mat4 world[]; };
+layout(std430, binding = 1) readonly buffer DrawData { vec4 draw_bounds[]; };
+uniform uint instance_offset;
+uniform bool multi_draw;
 
 void main() {
-  gl_Position =
-      shadow_matrices[0] * (world[gl_InstanceID] * vec4(position, 1.0f));
+  uint instance = instance_offset + gl_InstanceID;
+  vec3 center = mesh_center, extent = mesh_extent;
+#ifdef GL_ARB_shader_draw_parameters
+  if (multi_draw) {
+    instance += gl_BaseInstanceARB;
+    center = draw_bounds[gl_DrawIDARB * 2].xyz;
+    extent = draw_bounds[gl_DrawIDARB * 2 + 1].xyz;
+  }
+#endif
+
+  vec3 position = center + extent * packed_position;
+  gl_Position = shadow_matrices[0] * (world[instance] * vec4(position, 1.0f));
 }
@@ -1,9 +1,11 @@
 #version 420 core
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec2 packed_normal;
+layout(location = 2) in vec2 packed_tangent;
 layout(location = 3) in vec2 texcoord;
+layout(location = 4) in vec3 mesh_center;
+layout(location = 5) in vec3 mesh_extent;
 
 out vec3 TexCoords;
 
@@ -11,6 +13,7 @@ uniform mat4 projection;
 uniform mat4 view;
 
 void main() {
+  vec3 position = mesh_center + mesh_extent * packed_position;
   vec4 pos = projection * view * vec4(position, 1.0);
   gl_Position = pos.xyww;
   TexCoords = position.xyz;
@@ -0,0 +1,9 @@
+// Decoders for the packed vertex format, see vertex_packing.h.
+
+// Unit vector from its octahedral encoding in [-1, 1].
+vec3 OctDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
@@ -6,6 +6,7 @@ if not exist .\_build_release_\ (
 
 cd .\_build_release_\ 
 cmake -G "Visual Studio 16 2019" -A x64 .. 
+cmake --build . --config Release --target fract_cooking
 cd .. 
 
 cd .\_stock_assets_\
@@ -0,0 +1,108 @@
+#include "cook_cache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace cmd_fract_cooking {
+namespace {
+constexpr uint32_t kCacheMagic = 0x4b4f4f43;  // "COOK"
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t codec;
+  uint64_t raw_size;
+  uint64_t blob_size;
+  std::array<uint32_t, 4> meta;
+};
+
+uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t hash) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+}  // namespace
+
+CookCache::CookCache(ct::string directory) : directory_(std::move(directory)) {
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+}
+
+uint64_t CookCache::Key(const ct::string& source_path, uint32_t cooker_version,
+                        lib_core::Codec::Type codec,
+                        uint64_t settings) const {
+  std::ifstream file(source_path, std::ios::binary);
+  if (file.fail()) return 0;
+
+  uint64_t options[] = {cooker_version, uint64_t(codec), settings};
+  auto hash = HashBytes(reinterpret_cast<const uint8_t*>(options),
+                        sizeof(options), 14695981039346656037ull);
+
+  ct::dyn_array<char> chunk(1024 * 1024);
+  while (file) {
+    file.read(chunk.data(), chunk.size());
+    hash = HashBytes(reinterpret_cast<const uint8_t*>(chunk.data()),
+                     size_t(file.gcount()), hash);
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+bool CookCache::Load(uint64_t key, Entry& entry) {
+  std::ifstream file(EntryPath(key), std::ios::binary);
+  CacheHeader header;
+  if (key == 0 || file.fail() ||
+      !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != kCacheMagic) {
+    ++misses_;
+    return false;
+  }
+
+  entry.blob.resize(header.blob_size);
+  if (!file.read(reinterpret_cast<char*>(entry.blob.data()),
+                 header.blob_size)) {
+    ++misses_;
+    return false;
+  }
+
+  entry.meta = header.meta;
+  entry.codec = lib_core::Codec::Type(header.codec);
+  entry.raw_size = header.raw_size;
+  ++hits_;
+  return true;
+}
+
+void CookCache::Store(uint64_t key, const Entry& entry) {
+  if (key == 0) return;
+
+  CacheHeader header;
+  header.magic = kCacheMagic;
+  header.codec = entry.codec;
+  header.raw_size = entry.raw_size;
+  header.blob_size = entry.blob.size();
+  header.meta = entry.meta;
+
+  std::stringstream tmp_name;
+  tmp_name << EntryPath(key) << "." << std::this_thread::get_id() << ".tmp";
+  auto tmp_path = tmp_name.str();
+
+  std::ofstream file(tmp_path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(entry.blob.data()),
+             entry.blob.size());
+  file.close();
+
+  std::error_code error;
+  if (!file.fail())
+    std::filesystem::rename(tmp_path, EntryPath(key), error);
+  if (file.fail() || error) std::remove(tmp_path.c_str());
+}
+
+ct::string CookCache::EntryPath(uint64_t key) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+  return directory_ + "/" + name + ".cook";
+}
+}  // namespace cmd_fract_cooking
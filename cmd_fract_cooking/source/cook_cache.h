@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include "codec.h"
+#include "core_utilities.h"
+
+namespace cmd_fract_cooking {
+// Keeps cooked blobs on disk keyed by the source file content, the cooker
+// version, the codec and the cooker settings, so a rebuild only re-imports
+// assets that changed.
+// Entries are written to a temporary file and renamed into place, several
+// cook threads can load and store at the same time.
+class CookCache {
+ public:
+  struct Entry {
+    ct::dyn_array<uint8_t> blob;
+    std::array<uint32_t, 4> meta = {};
+    lib_core::Codec::Type codec = lib_core::Codec::kStore;
+    size_t raw_size = 0;
+  };
+
+  explicit CookCache(ct::string directory);
+
+  // settings hashes any cooker option that changes the blob. Returns 0 if
+  // the source can not be read.
+  uint64_t Key(const ct::string& source_path, uint32_t cooker_version,
+               lib_core::Codec::Type codec, uint64_t settings) const;
+
+  bool Load(uint64_t key, Entry& entry);
+  void Store(uint64_t key, const Entry& entry);
+
+  size_t Hits() const { return hits_; }
+  size_t Misses() const { return misses_; }
+
+ private:
+  ct::string EntryPath(uint64_t key) const;
+
+  ct::string directory_;
+  std::atomic<size_t> hits_ = {0}, misses_ = {0};
+};
+
+// Fills entry from the cache, or by running cook(entry) on a miss and storing
+// the result. Without a cache every asset is cooked.
+template <typename Func>
+bool CookCached(CookCache* cache, const ct::string& source_path,
+                uint32_t cooker_version, lib_core::Codec::Type codec,
+                uint64_t settings, CookCache::Entry& entry, Func&& cook) {
+  if (!cache) return cook(entry);
+
+  auto key = cache->Key(source_path, cooker_version, codec, settings);
+  if (cache->Load(key, entry)) return true;
+  if (!cook(entry)) return false;
+  cache->Store(key, entry);
+  return true;
+}
+}  // namespace cmd_fract_cooking
@@ -1,7 +1,10 @@
-#include <execution>
+#include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <sstream>
+#include "codec.h"
+#include "cook_cache.h"
 #include "core_utilities.h"
 #include "model_cooker.h"
 #include "sound_cooker.h"
@@ -12,8 +15,11 @@ using namespace cmd_fract_cooking;
 
 int main(int argc, char** argv) {
   int asset_id = 0;
-  ct::string out_path = "./";
+  ct::string out_path = "./", cache_path;
+  uint32_t lod_levels = 4;
   ct::dyn_array<ct::string> assets[6];
+  lib_core::Codec::Type codecs[3] = {
+      lib_core::Codec::kZlib, lib_core::Codec::kZlib, lib_core::Codec::kZlib};
 
   for (int i = 1; i < argc; ++i) {
     if (ct::string(argv[i]).compare("t") == 0)
@@ -30,9 +36,26 @@ int main(int argc, char** argv) {
       asset_id = 5;
     else if (ct::string(argv[i]).compare("o") == 0)
       asset_id = 6;
+    else if (ct::string(argv[i]).compare("ct") == 0)
+      asset_id = 7;
+    else if (ct::string(argv[i]).compare("cm") == 0)
+      asset_id = 8;
+    else if (ct::string(argv[i]).compare("cs") == 0)
+      asset_id = 9;
+    else if (ct::string(argv[i]).compare("cache") == 0)
+      asset_id = 10;
+    else if (ct::string(argv[i]).compare("lod") == 0)
+      asset_id = 11;
     else if (asset_id == 6)
       out_path = argv[i];
-    else
+    else if (asset_id == 10)
+      cache_path = argv[i];
+    else if (asset_id == 11) {
+      lod_levels = uint32_t(std::max(std::atoi(argv[i]), 1));
+    } else if (asset_id > 6) {
+      if (!lib_core::Codec::Parse(argv[i], codecs[asset_id - 7]))
+        std::cout << "Unsupported codec: " << argv[i] << "\n";
+    } else
       assets[asset_id].push_back(argv[i]);
   }
 
@@ -47,10 +70,22 @@ int main(int argc, char** argv) {
   model_foramts.insert(".fbx");
 
   sound_formats.insert(".wav");
+  sound_formats.insert(".ogg");
 
   auto tex_cooker = std::make_unique<TextureCooker>();
   auto mod_cooker = std::make_unique<ModelCooker>();
   auto sound_cooker = std::make_unique<SoundCooker>();
+  tex_cooker->SetCodec(codecs[0]);
+  mod_cooker->SetCodec(codecs[1]);
+  mod_cooker->SetLodLevels(lod_levels);
+  sound_cooker->SetCodec(codecs[2]);
+
+  if (cache_path.empty()) cache_path = out_path + "_cookcache";
+  CookCache cache(cache_path);
+  tex_cooker->SetCache(&cache);
+  mod_cooker->SetCache(&cache);
+  sound_cooker->SetCache(&cache);
+
   ct::dyn_array<ct::string> textures, models, sounds;
 
   for (auto& path : assets[0]) {
@@ -132,22 +167,9 @@ int main(int argc, char** argv) {
     }
   }
 
-  auto tex_thread = [&](auto& tex) { tex_cooker->LoadTexture(tex); };
-  if (!textures.empty())
-    std::for_each(std::execution::par_unseq, std::begin(textures),
-                  std::end(textures), tex_thread);
-
-  auto model_thread = [&](auto& model) { mod_cooker->LoadModel(model); };
-  if (!models.empty())
-    std::for_each(std::execution::par_unseq, std::begin(models),
-                  std::end(models), model_thread);
-
-  // for (auto& model : models) mod_cooker->LoadModel(model);
-
-  auto sound_thread = [&](auto& sound) { sound_cooker->LoadSound(sound); };
-  if (!sounds.empty())
-    std::for_each(std::execution::par_unseq, std::begin(sounds),
-                  std::end(sounds), sound_thread);
+  for (auto& tex : textures) tex_cooker->AddTexture(tex);
+  for (auto& model : models) mod_cooker->AddModel(model);
+  for (auto& sound : sounds) sound_cooker->AddSound(sound);
 
   if (!assets[0].empty() || !assets[2].empty())
     tex_cooker->SerializeAndSave(out_path + "_texpack");
@@ -156,5 +178,8 @@ int main(int argc, char** argv) {
   if (!assets[4].empty() || !assets[5].empty())
     sound_cooker->SerializeAndSave(out_path + "_soundpack");
 
+  std::cout << "Cook cache: " << cache.Hits() << " reused, " << cache.Misses()
+            << " cooked\n";
+
   return 1;
 }
@@ -0,0 +1,192 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace cmd_fract_cooking {
+namespace {
+struct Adjacency {
+  ct::dyn_array<uint32_t> offsets;
+  ct::dyn_array<uint32_t> triangles;
+};
+
+Adjacency BuildAdjacency(const ct::dyn_array<uint32_t>& indices,
+                         size_t vertex_count) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(vertex_count + 1, 0);
+  for (auto index : indices) ++adjacency.offsets[index + 1];
+  for (size_t v = 0; v < vertex_count; ++v)
+    adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+  auto fill = adjacency.offsets;
+  adjacency.triangles.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    adjacency.triangles[fill[indices[i]]++] = uint32_t(i / 3);
+  return adjacency;
+}
+
+// Sander et al, "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw". Fans around the vertex that stays in cache the longest and
+// starts a new cluster every time the walk hits a dead end.
+void Tipsify(const ct::dyn_array<uint32_t>& indices, size_t vertex_count,
+             size_t cache_size, ct::dyn_array<uint32_t>& order,
+             ct::dyn_array<size_t>& clusters) {
+  auto adjacency = BuildAdjacency(indices, vertex_count);
+  ct::dyn_array<uint32_t> live(vertex_count), stamps(vertex_count, 0);
+  for (size_t v = 0; v < vertex_count; ++v)
+    live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+  ct::dyn_array<uint8_t> emitted(indices.size() / 3, 0);
+  ct::dyn_array<uint32_t> dead_end, candidates;
+  auto time = uint32_t(cache_size + 1);
+  size_t cursor = 0;
+
+  auto skip_dead_end = [&]() -> int64_t {
+    while (!dead_end.empty()) {
+      auto v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0) return v;
+    }
+    for (; cursor < vertex_count; ++cursor)
+      if (live[cursor] > 0) return int64_t(cursor);
+    return -1;
+  };
+
+  auto fan = skip_dead_end();
+  while (fan >= 0) {
+    clusters.push_back(order.size());
+    while (fan >= 0) {
+      candidates.clear();
+      for (auto i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1];
+           ++i) {
+        auto t = adjacency.triangles[i];
+        if (emitted[t]) continue;
+        emitted[t] = 1;
+        order.push_back(t);
+
+        for (size_t k = 0; k < 3; ++k) {
+          auto v = indices[t * 3 + k];
+          dead_end.push_back(v);
+          candidates.push_back(v);
+          --live[v];
+          if (time - stamps[v] > cache_size) stamps[v] = time++;
+        }
+      }
+
+      int64_t next = -1, best = -1;
+      for (auto v : candidates) {
+        if (live[v] == 0) continue;
+        int64_t priority = 0;
+        if (time - stamps[v] + 2 * live[v] <= cache_size)
+          priority = time - stamps[v];
+        if (priority > best) {
+          best = priority;
+          next = v;
+        }
+      }
+      fan = next;
+    }
+    fan = skip_dead_end();
+  }
+}
+
+using Vec3 = std::array<double, 3>;
+
+Vec3 Position(const float* positions, size_t stride, uint32_t index) {
+  auto p = positions + index * stride;
+  return {p[0], p[1], p[2]};
+}
+}  // namespace
+
+void MeshOptimizer::OptimizeTriangles(ct::dyn_array<uint32_t>& indices,
+                                      const float* positions, size_t stride,
+                                      size_t vertex_count) {
+  if (indices.size() < 6) return;
+
+  ct::dyn_array<uint32_t> order;
+  ct::dyn_array<size_t> clusters;
+  Tipsify(indices, vertex_count, kCacheSize, order, clusters);
+  clusters.push_back(order.size());
+
+  Vec3 mesh_center = {};
+  for (auto index : indices) {
+    auto p = Position(positions, stride, index);
+    for (int c = 0; c < 3; ++c) mesh_center[c] += p[c] / indices.size();
+  }
+
+  // Clusters facing away from the mesh center are likely to occlude the rest,
+  // drawing them first lets early depth reject more of what follows.
+  ct::dyn_array<std::pair<double, size_t>> keys;
+  for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+    Vec3 center = {}, normal = {};
+    double area = 0.0;
+    for (auto i = clusters[c]; i < clusters[c + 1]; ++i) {
+      auto t = order[i];
+      auto p0 = Position(positions, stride, indices[t * 3]);
+      auto p1 = Position(positions, stride, indices[t * 3 + 1]);
+      auto p2 = Position(positions, stride, indices[t * 3 + 2]);
+      Vec3 e0 = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      Vec3 e1 = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      Vec3 n = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2],
+                e0[0] * e1[1] - e0[1] * e1[0]};
+      auto a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int k = 0; k < 3; ++k) {
+        center[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * a;
+        normal[k] += n[k];
+      }
+      area += a;
+    }
+
+    double key = 0.0;
+    auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] +
+                            normal[2] * normal[2]);
+    if (area > 0.0 && length > 0.0)
+      for (int k = 0; k < 3; ++k)
+        key += (center[k] / area - mesh_center[k]) * normal[k] / length;
+    keys.push_back({key, c});
+  }
+  std::stable_sort(keys.begin(), keys.end(),
+                   [](auto& a, auto& b) { return a.first > b.first; });
+
+  ct::dyn_array<uint32_t> optimized;
+  optimized.reserve(indices.size());
+  for (auto& key : keys)
+    for (auto i = clusters[key.second]; i < clusters[key.second + 1]; ++i)
+      for (size_t k = 0; k < 3; ++k)
+        optimized.push_back(indices[order[i] * 3 + k]);
+  indices = std::move(optimized);
+}
+
+ct::dyn_array<uint32_t> MeshOptimizer::OptimizeFetch(
+    ct::dyn_array<uint32_t>& indices, size_t vertex_count) {
+  ct::dyn_array<uint32_t> remap(vertex_count, kUnused);
+  uint32_t next = 0;
+  for (auto& index : indices) {
+    if (remap[index] == kUnused) remap[index] = next++;
+    index = remap[index];
+  }
+  return remap;
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::SimulateCache(
+    const ct::dyn_array<uint32_t>& indices, size_t vertex_count,
+    size_t cache_size) {
+  ct::dyn_array<size_t> inserted(vertex_count, 0);
+  ct::dyn_array<uint8_t> seen(vertex_count, 0);
+  size_t misses = 0, unique = 0;
+  for (auto index : indices) {
+    if (!seen[index]) {
+      seen[index] = 1;
+      ++unique;
+    } else if (misses - inserted[index] < cache_size) {
+      continue;
+    }
+    inserted[index] = misses++;
+  }
+
+  CacheStats stats = {0.f, 0.f};
+  if (indices.size() >= 3) stats.acmr = float(misses) / (indices.size() / 3);
+  if (unique > 0) stats.atvr = float(misses) / unique;
+  return stats;
+}
+}  // namespace cmd_fract_cooking
@@ -0,0 +1,233 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace cmd_fract_cooking {
+namespace {
+using Vec3 = std::array<double, 3>;
+
+Vec3 Sub(const Vec3& a, const Vec3& b) {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+Vec3 Cross(const Vec3& a, const Vec3& b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+double Dot(const Vec3& a, const Vec3& b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+double Normalize(Vec3& v) {
+  auto length = std::sqrt(Dot(v, v));
+  if (length > 0.0)
+    for (auto& c : v) c /= length;
+  return length;
+}
+
+// Sum of weighted squared plane distances, a symmetric 4x4 matrix.
+struct Quadric {
+  double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+  double b0 = 0, b1 = 0, b2 = 0, c = 0, w = 0;
+
+  void AddPlane(const Vec3& n, double d, double weight) {
+    a00 += weight * n[0] * n[0], a01 += weight * n[0] * n[1];
+    a02 += weight * n[0] * n[2], a11 += weight * n[1] * n[1];
+    a12 += weight * n[1] * n[2], a22 += weight * n[2] * n[2];
+    b0 += weight * n[0] * d, b1 += weight * n[1] * d, b2 += weight * n[2] * d;
+    c += weight * d * d;
+    w += weight;
+  }
+
+  void operator+=(const Quadric& q) {
+    a00 += q.a00, a01 += q.a01, a02 += q.a02, a11 += q.a11, a12 += q.a12;
+    a22 += q.a22, b0 += q.b0, b1 += q.b1, b2 += q.b2, c += q.c, w += q.w;
+  }
+
+  // Mean squared distance of p to the accumulated planes.
+  double Error(const Vec3& p) const {
+    if (w <= 0.0) return 0.0;
+    auto x = p[0], y = p[1], z = p[2];
+    auto e = a00 * x * x + a11 * y * y + a22 * z * z +
+             2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+             2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    return std::max(e, 0.0) / w;
+  }
+};
+
+enum VertexKind : uint8_t { kManifold, kBorder, kLocked };
+
+// Planes perpendicular to open edges keep borders from shrinking.
+constexpr double kBorderWeight = 10.0;
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) { return uint64_t(a) << 32 | b; }
+
+void CountEdges(const ct::dyn_array<uint32_t>& indices,
+                ct::hash_map<uint64_t, uint32_t>& edges) {
+  edges.clear();
+  for (size_t i = 0; i < indices.size(); i += 3)
+    for (size_t k = 0; k < 3; ++k)
+      ++edges[EdgeKey(indices[i + k], indices[i + (k + 1) % 3])];
+}
+
+struct Collapse {
+  uint32_t from, to;
+  double error;
+};
+}  // namespace
+
+float MeshSimplifier::Simplify(ct::dyn_array<uint32_t>& indices,
+                               const float* positions, size_t stride,
+                               size_t vertex_count, size_t target_index_count,
+                               float max_error) {
+  ct::dyn_array<Vec3> points(vertex_count);
+  for (size_t v = 0; v < vertex_count; ++v)
+    for (int c = 0; c < 3; ++c) points[v][c] = positions[v * stride + c];
+
+  ct::hash_map<uint64_t, uint32_t> edges;
+  CountEdges(indices, edges);
+
+  auto border_edge = [&](uint32_t a, uint32_t b) {
+    return edges.count(EdgeKey(a, b)) != edges.count(EdgeKey(b, a));
+  };
+
+  ct::dyn_array<uint8_t> kinds(vertex_count, kManifold);
+  for (auto& edge : edges) {
+    auto a = uint32_t(edge.first >> 32), b = uint32_t(edge.first);
+    if (edge.second > 1) {
+      kinds[a] = kinds[b] = kLocked;
+    } else if (!edges.count(EdgeKey(b, a))) {
+      if (kinds[a] == kManifold) kinds[a] = kBorder;
+      if (kinds[b] == kManifold) kinds[b] = kBorder;
+    }
+  }
+
+  ct::tree_map<Vec3, uint32_t> first_at;
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    auto it = first_at.emplace(points[v], v);
+    if (!it.second) kinds[v] = kinds[it.first->second] = kLocked;
+  }
+
+  ct::dyn_array<Quadric> quadrics(vertex_count);
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    uint32_t t[3] = {indices[i], indices[i + 1], indices[i + 2]};
+    auto normal = Cross(Sub(points[t[1]], points[t[0]]),
+                        Sub(points[t[2]], points[t[0]]));
+    auto area = Normalize(normal) * 0.5;
+    auto d = -Dot(normal, points[t[0]]);
+    for (auto v : t) quadrics[v].AddPlane(normal, d, area);
+
+    for (size_t k = 0; k < 3; ++k) {
+      auto a = t[k], b = t[(k + 1) % 3];
+      if (!border_edge(a, b)) continue;
+      auto edge = Sub(points[b], points[a]);
+      auto length = Normalize(edge);
+      auto plane = Cross(edge, normal);
+      Normalize(plane);
+      auto weight = length * length * kBorderWeight;
+      quadrics[a].AddPlane(plane, -Dot(plane, points[a]), weight);
+      quadrics[b].AddPlane(plane, -Dot(plane, points[a]), weight);
+    }
+  }
+
+  auto max_error_sq = double(max_error) * max_error;
+  double worst = 0.0;
+  ct::dyn_array<uint32_t> offsets, triangles, remap(vertex_count);
+  ct::dyn_array<uint8_t> pass_locked(vertex_count);
+  ct::dyn_array<Collapse> collapses;
+
+  while (indices.size() > target_index_count) {
+    CountEdges(indices, edges);
+    offsets.assign(vertex_count + 1, 0);
+    for (auto index : indices) ++offsets[index + 1];
+    for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+    auto fill = offsets;
+    triangles.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+      triangles[fill[indices[i]]++] = uint32_t(i / 3);
+
+    auto allowed = [&](uint32_t from, uint32_t to) {
+      if (kinds[from] == kLocked) return false;
+      if (kinds[from] == kBorder) return border_edge(from, to);
+      return true;
+    };
+
+    collapses.clear();
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      for (size_t k = 0; k < 3; ++k) {
+        auto a = indices[i + k], b = indices[i + (k + 1) % 3];
+        for (auto edge : {std::make_pair(a, b), std::make_pair(b, a)}) {
+          if (edge.second == a && !border_edge(a, b)) continue;
+          if (!allowed(edge.first, edge.second)) continue;
+          auto error = quadrics[edge.first].Error(points[edge.second]);
+          if (error <= max_error_sq)
+            collapses.push_back({edge.first, edge.second, error});
+        }
+      }
+    }
+    std::stable_sort(
+        collapses.begin(), collapses.end(),
+        [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+    // Collapsing a vertex rejects any collapse touching its ring for the rest
+    // of the pass, so flip checks always see current triangles.
+    for (uint32_t v = 0; v < vertex_count; ++v) remap[v] = v;
+    std::fill(pass_locked.begin(), pass_locked.end(), 0);
+    auto triangle_count = indices.size() / 3;
+    size_t collapsed = 0;
+
+    auto flips = [&](uint32_t from, uint32_t to) {
+      for (auto i = offsets[from]; i < offsets[from + 1]; ++i) {
+        auto t = &indices[triangles[i] * 3];
+        if (t[0] == to || t[1] == to || t[2] == to) continue;
+
+        Vec3 p[3], q[3];
+        for (int k = 0; k < 3; ++k) {
+          p[k] = points[t[k]];
+          q[k] = t[k] == from ? points[to] : p[k];
+        }
+        auto before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+        auto after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+        if (Normalize(after) == 0.0) return true;
+        Normalize(before);
+        if (Dot(before, after) < 0.2) return true;
+      }
+      return false;
+    };
+
+    for (auto& collapse : collapses) {
+      if (triangle_count * 3 <= target_index_count) break;
+      auto from = collapse.from, to = collapse.to;
+      if (pass_locked[from] || pass_locked[to]) continue;
+      if (flips(from, to)) continue;
+
+      for (auto i = offsets[from]; i < offsets[from + 1]; ++i) {
+        auto t = &indices[triangles[i] * 3];
+        bool removed = false;
+        for (int k = 0; k < 3; ++k) {
+          pass_locked[t[k]] = 1;
+          removed |= t[k] == to;
+        }
+        if (removed) --triangle_count;
+      }
+      remap[from] = to;
+      quadrics[to] += quadrics[from];
+      worst = std::max(worst, collapse.error);
+      ++collapsed;
+    }
+    if (collapsed == 0) break;
+
+    size_t write = 0;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      auto a = remap[indices[i]], b = remap[indices[i + 1]],
+           c = remap[indices[i + 2]];
+      if (a == b || b == c || a == c) continue;
+      indices[write++] = a, indices[write++] = b, indices[write++] = c;
+    }
+    indices.resize(write);
+  }
+  return float(std::sqrt(worst));
+}
+}  // namespace cmd_fract_cooking
@@ -0,0 +1,21 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace cmd_fract_cooking {
+// Quadric error metric simplification (Garland and Heckbert) restricted to
+// half edge collapses, so every level keeps using a subset of the source
+// vertices and their attributes. Vertices on uv or normal seams, where
+// several vertices share a position, stay put to avoid cracks, and open
+// borders only collapse along themselves.
+class MeshSimplifier {
+ public:
+  // Collapses edges until at most target_index_count indices remain or the
+  // next collapse would exceed max_error. positions points at the first vertex
+  // position, stride is in floats. Returns the largest error introduced, in
+  // the same units as the positions.
+  static float Simplify(ct::dyn_array<uint32_t>& indices,
+                        const float* positions, size_t stride,
+                        size_t vertex_count, size_t target_index_count,
+                        float max_error);
+};
+}  // namespace cmd_fract_cooking
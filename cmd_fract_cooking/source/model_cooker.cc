@@ -2,94 +2,149 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include "../../source_shared/include/serialization_utilities.hpp"
+#include "asset_pack.h"
 #include "core_utilities.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "parallel_cook.h"
+#include "vertex_packing.h"
 
 namespace cmd_fract_cooking {
-void ModelCooker::LoadModel(ct::string path) {
-  if (!std::filesystem::exists(path)) return;
+void ModelCooker::AddModel(ct::string path) {
+  paths_.push_back(std::move(path));
+}
+
+bool ModelCooker::LoadModel(const ct::string& path,
+                            CompressedModel& comp_model) {
+  if (!std::filesystem::exists(path)) return false;
 
   Assimp::Importer importer;
   const aiScene* scene = importer.ReadFile(
       path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals |
-                aiProcess_OptimizeMeshes | aiProcess_CalcTangentSpace);
+                aiProcess_OptimizeMeshes | aiProcess_CalcTangentSpace |
+                aiProcess_JoinIdenticalVertices);
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
       !scene->mRootNode) {
     std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-    return;
+    return false;
   }
 
   Model model;
   ProcessNode(scene->mRootNode, scene, model);
 
+  for (auto& mesh : model.meshes) BuildLods(mesh);
+
+  ct::dyn_array<ct::dyn_array<ct::dyn_array<lib_core::PackedVertex>>> packed(
+      model.meshes.size());
+  for (size_t i = 0; i < model.meshes.size(); ++i)
+    for (auto& lod : model.meshes[i].lods)
+      packed[i].push_back(PackVertices(model.meshes[i], lod));
+
   size_t size = 0;
-  for (auto& mesh : model.meshes) {
+  for (size_t i = 0; i < model.meshes.size(); ++i) {
+    auto& mesh = model.meshes[i];
     for (int ii = 0; ii < 3; ++ii)
       SerializationUtilities::CountSize(mesh.center[ii], size);
     for (int ii = 0; ii < 3; ++ii)
       SerializationUtilities::CountSize(mesh.extent[ii], size);
-    SerializationUtilities::CountSize(mesh.vertices, size);
-    SerializationUtilities::CountSize(mesh.indices, size);
+    size += sizeof(uint32_t);
+
+    for (size_t l = 0; l < mesh.lods.size(); ++l) {
+      auto& lod = mesh.lods[l];
+      size += sizeof(float) + sizeof(uint32_t);
+      SerializationUtilities::CountSize(packed[i][l], size);
+      SerializationUtilities::CountSize(lod.indices.size(), size);
+      size += sizeof(uint32_t) +
+              lod.indices.size() *
+                  (ShortIndices(lod) ? sizeof(uint16_t) : sizeof(uint32_t));
+    }
   }
 
   ct::dyn_array<uint8_t> buffer(size, 0);
   auto it = buffer.begin();
-  for (auto& mesh : model.meshes) {
+  for (size_t i = 0; i < model.meshes.size(); ++i) {
+    auto& mesh = model.meshes[i];
     for (int ii = 0; ii < 3; ++ii)
       SerializationUtilities::CopyToBuffer(mesh.center[ii], it);
     for (int ii = 0; ii < 3; ++ii)
       SerializationUtilities::CopyToBuffer(mesh.extent[ii], it);
-    SerializationUtilities::CopyToBuffer(mesh.vertices, it);
-    SerializationUtilities::CopyToBuffer(mesh.indices, it);
+    SerializationUtilities::CopyToBuffer(uint32_t(mesh.lods.size()), it);
+    comp_model.lod_levels =
+        std::max(comp_model.lod_levels, uint32_t(mesh.lods.size()));
+
+    for (size_t l = 0; l < mesh.lods.size(); ++l) {
+      auto& lod = mesh.lods[l];
+      SerializationUtilities::CopyToBuffer(lod.error, it);
+      SerializationUtilities::CopyToBuffer(lib_core::kPackedVertex, it);
+      SerializationUtilities::CopyToBuffer(packed[i][l], it);
+      if (ShortIndices(lod)) {
+        ct::dyn_array<uint16_t> indices(lod.indices.begin(),
+                                        lod.indices.end());
+        SerializationUtilities::CopyToBuffer(uint32_t(sizeof(uint16_t)), it);
+        SerializationUtilities::CopyToBuffer(indices, it);
+      } else {
+        SerializationUtilities::CopyToBuffer(uint32_t(sizeof(uint32_t)), it);
+        SerializationUtilities::CopyToBuffer(lod.indices, it);
+      }
+    }
   }
 
-  CompressedModel comp_model;
   comp_model.mesh_count = model.meshes.size();
-  comp_model.name = path;
-
-  cu::CompressMemory(buffer, comp_model.data);
-  models_.push_back(std::move(comp_model));
+  comp_model.raw_size = buffer.size();
+  return lib_core::Codec::Compress(codec_, buffer.data(), buffer.size(),
+                                   comp_model.data);
 }
 
 void ModelCooker::SerializeAndSave(ct::string save_path) {
-  std::ofstream list_output(save_path + "names.txt");
+  SortPaths(paths_);
 
-  size_t size = 0;
-  ct::dyn_array<size_t> starting_points;
-  SerializationUtilities::CountSize(models_.size(), size);
-  for (auto& model : models_) {
-    SerializationUtilities::CountSize(model.name, size);
-    SerializationUtilities::CountSize(size, size);
-    SerializationUtilities::CountSize(size, size);
-
-    list_output << model.name.substr(model.name.find_last_of('\\') + 1,
-                                     model.name.size())
-                << " " << model.mesh_count << "\n";
+  lib_core::AssetPackWriter pack(lib_core::AssetPack::kModel);
+  if (!pack.Open(save_path, paths_)) {
+    cu::Log("Failed to open model pack: " + save_path, __FILE__, __LINE__);
+    return;
   }
-  list_output.close();
 
-  for (auto& model : models_) {
-    starting_points.push_back(size);
-    SerializationUtilities::CountSize(model.data, size);
-  }
+  ct::dyn_array<size_t> mesh_counts(paths_.size(), 0);
+  ct::dyn_array<uint8_t> cooked(paths_.size(), 0);
+  ParallelCook(paths_.size(), [&](size_t slot) {
+    CookCache::Entry entry;
+    auto cook = [&](CookCache::Entry& out) {
+      CompressedModel model;
+      if (!LoadModel(paths_[slot], model)) return false;
+      out.blob = std::move(model.data);
+      out.meta = {uint32_t(model.mesh_count), kModelFormat, model.lod_levels};
+      out.codec = codec_;
+      out.raw_size = model.raw_size;
+      return true;
+    };
+    // Options that change the blob are part of the cache key.
+    auto settings = uint64_t(lod_levels_);
+    if (!CookCached(cache_, paths_[slot], kCookVersion, codec_, settings,
+                    entry, cook)) {
+      pack.Skip(slot);
+      return;
+    }
 
-  int i = 0;
-  ct::dyn_array<uint8_t> buffer(size);
-  auto it = buffer.begin();
-  SerializationUtilities::CopyToBuffer(models_.size(), it);
-  for (auto& model : models_) {
-    SerializationUtilities::CopyToBuffer(model.name, it);
-    SerializationUtilities::CopyToBuffer(model.mesh_count, it);
-    SerializationUtilities::CopyToBuffer(starting_points[i++], it);
-  }
-  for (auto& model : models_)
-    SerializationUtilities::CopyToBuffer(model.data, it);
+    mesh_counts[slot] = entry.meta[0];
+    pack.Write(slot, std::move(entry.blob), entry.meta, entry.codec,
+               entry.raw_size);
+    cooked[slot] = 1;
+  });
+
+  std::ofstream list_output(save_path + "names.txt");
+  for (size_t i = 0; i < paths_.size(); ++i)
+    if (cooked[i])
+      list_output << FileName(paths_[i]) << " " << mesh_counts[i] << "\n";
+  list_output.close();
 
-  cu::Save(save_path, buffer);
+  if (!pack.Close())
+    cu::Log("Failed to save model pack: " + save_path, __FILE__, __LINE__);
 }
 
 void ModelCooker::ProcessNode(aiNode* node, const aiScene* scene,
@@ -105,7 +160,9 @@ void ModelCooker::ProcessNode(aiNode* node, const aiScene* scene,
 
 ModelCooker::Mesh ModelCooker::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
   Mesh result;
-  result.vertices.reserve(mesh->mNumVertices);
+  result.lods.resize(1);
+  auto& source = result.lods[0];
+  source.vertices.reserve(mesh->mNumVertices);
   float max[3], min[3];
   min[0] = min[1] = min[2] = std::numeric_limits<float>::lowest();
   max[0] = max[1] = max[2] = std::numeric_limits<float>::infinity();
@@ -155,13 +212,13 @@ ModelCooker::Mesh ModelCooker::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
       vertex.texcoord[1] = 0;
     }
 
-    result.vertices.push_back(vertex);
+    source.vertices.push_back(vertex);
   }
 
   for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
     aiFace face = mesh->mFaces[i];
     for (unsigned int j = 0; j < face.mNumIndices; j++)
-      result.indices.push_back(face.mIndices[j]);
+      source.indices.push_back(face.mIndices[j]);
   }
 
   for (int i = 0; i < 3; ++i) result.center[i] = (min[i] + max[i]) * 0.5f;
@@ -169,4 +226,57 @@ ModelCooker::Mesh ModelCooker::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
 
   return result;
 }
+
+void ModelCooker::BuildLods(Mesh& mesh) const {
+  auto& source = mesh.lods[0];
+  if (source.vertices.empty()) return;
+
+  auto positions = source.vertices[0].position;
+  auto stride = sizeof(Vertex) / sizeof(float);
+  auto radius = std::sqrt(mesh.extent[0] * mesh.extent[0] +
+                          mesh.extent[1] * mesh.extent[1] +
+                          mesh.extent[2] * mesh.extent[2]);
+
+  // Levels are simplified from the one before, so errors add up. A level is
+  // only kept if it removes a meaningful share of the triangles.
+  ct::dyn_array<Lod> lods(1);
+  lods[0].indices = source.indices;
+  while (lods.size() < lod_levels_) {
+    auto& previous = lods.back();
+    Lod lod;
+    lod.indices = previous.indices;
+    lod.error = previous.error +
+                MeshSimplifier::Simplify(
+                    lod.indices, positions, stride, source.vertices.size(),
+                    previous.indices.size() / 2, radius * kMaxLodError);
+    if (lod.indices.size() > previous.indices.size() * 3 / 4) break;
+    lods.push_back(std::move(lod));
+  }
+
+  for (auto& lod : lods) {
+    MeshOptimizer::OptimizeTriangles(lod.indices, positions, stride,
+                                     source.vertices.size());
+    auto remap =
+        MeshOptimizer::OptimizeFetch(lod.indices, source.vertices.size());
+    lod.vertices = source.vertices;
+    MeshOptimizer::RemapVertices(lod.vertices, remap);
+  }
+  mesh.lods = std::move(lods);
+}
+
+bool ModelCooker::ShortIndices(const Lod& lod) {
+  return lod.vertices.size() <= 0xffff;
+}
+
+ct::dyn_array<lib_core::PackedVertex> ModelCooker::PackVertices(
+    const Mesh& mesh, const Lod& lod) {
+  ct::dyn_array<lib_core::PackedVertex> packed(lod.vertices.size());
+  for (size_t i = 0; i < lod.vertices.size(); ++i) {
+    auto& in = lod.vertices[i];
+    packed[i] = lib_core::VertexPacking::Pack(in.position, in.normal,
+                                              in.tangent, in.texcoord,
+                                              mesh.center, mesh.extent);
+  }
+  return packed;
+}
 }  // namespace cmd_fract_cooking
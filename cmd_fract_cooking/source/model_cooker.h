@@ -1,5 +1,9 @@
 #pragma once
+#include <algorithm>
+#include "codec.h"
+#include "cook_cache.h"
 #include "core_utilities.h"
+#include "vertex_packing.h"
 
 struct aiScene;
 struct aiNode;
@@ -11,9 +15,29 @@ class ModelCooker {
   ModelCooker() = default;
   ~ModelCooker() = default;
 
-  void LoadModel(ct::string path);
+  void AddModel(ct::string path);
   void SerializeAndSave(ct::string save_path);
 
+  void SetCodec(lib_core::Codec::Type codec) { codec_ = codec; }
+  void SetCache(CookCache* cache) { cache_ = cache; }
+  // Detail levels per mesh including the source, each simplified to about
+  // half the triangles of the one before.
+  void SetLodLevels(uint32_t levels) {
+    lod_levels_ = std::clamp(levels, 1u, kMaxLodLevels);
+  }
+
+  // Bump when the cooked mesh layout changes to invalidate cached blobs.
+  static constexpr uint32_t kCookVersion = 5;
+  // Stored in meta[1]. 1 added the per mesh index size ahead of the indices,
+  // 2 added the per mesh vertex format ahead of the vertices, 3 added lod
+  // levels with their simplification error. meta[2] holds the most levels
+  // any mesh in the entry has.
+  static constexpr uint32_t kModelFormat = 3;
+  static constexpr uint32_t kMaxLodLevels = 8;
+  // Simplification stops once a level strays this far, relative to the mesh
+  // bounding radius, from the one before.
+  static constexpr float kMaxLodError = .25f;
+
  protected:
  private:
   struct Vertex {
@@ -23,9 +47,14 @@ class ModelCooker {
     float texcoord[2];
   };
 
-  struct Mesh {
+  struct Lod {
     ct::dyn_array<Vertex> vertices;
     ct::dyn_array<uint32_t> indices;
+    float error = 0.f;
+  };
+
+  struct Mesh {
+    ct::dyn_array<Lod> lods;
     float center[3], extent[3];
   };
 
@@ -34,14 +63,23 @@ class ModelCooker {
   };
 
   struct CompressedModel {
-    ct::string name;
     size_t mesh_count;
+    uint32_t lod_levels = 1;
+    size_t raw_size = 0;
     ct::dyn_array<uint8_t> data;
   };
 
+  bool LoadModel(const ct::string& path, CompressedModel& comp_model);
   void ProcessNode(aiNode* node, const aiScene* scene, Model& model);
   Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
+  void BuildLods(Mesh& mesh) const;
+  static bool ShortIndices(const Lod& lod);
+  static ct::dyn_array<lib_core::PackedVertex> PackVertices(const Mesh& mesh,
+                                                            const Lod& lod);
 
-  tbb::concurrent_vector<CompressedModel> models_;
+  lib_core::Codec::Type codec_ = lib_core::Codec::kZlib;
+  CookCache* cache_ = nullptr;
+  uint32_t lod_levels_ = 4;
+  ct::dyn_array<ct::string> paths_;
 };
 }  // namespace cmd_fract_cooking
@@ -0,0 +1,34 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "core_utilities.h"
+
+namespace cmd_fract_cooking {
+// Runs cook(slot) for every slot on all cores. Slots are handed out in order
+// so results finish close to the order the pack writer appends them in, which
+// keeps the writer's reorder window small.
+template <typename Func>
+void ParallelCook(size_t count, Func&& cook) {
+  std::atomic<size_t> next = {0};
+  auto worker = [&]() {
+    for (auto slot = next++; slot < count; slot = next++) cook(slot);
+  };
+
+  auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+  ct::dyn_array<std::thread> threads;
+  for (size_t i = 1; i < std::min(size_t(cores), count); ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads) thread.join();
+}
+
+inline void SortPaths(ct::dyn_array<ct::string>& paths) {
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+}
+
+inline ct::string FileName(const ct::string& path) {
+  return path.substr(path.find_last_of("/\\") + 1);
+}
+}  // namespace cmd_fract_cooking
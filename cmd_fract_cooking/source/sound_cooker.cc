@@ -1,51 +1,68 @@
 #include "sound_cooker.h"
 #include <fstream>
 #include <iostream>
-#include "../../source_shared/include/serialization_utilities.hpp"
+#include "asset_pack.h"
 #include "core_utilities.h"
+#include "parallel_cook.h"
+
+#define STB_VORBIS_HEADER_ONLY
+#include "../../source_shared/include/stb_vorbis.hpp"
 
 namespace cmd_fract_cooking {
-void SoundCooker::LoadSound(ct::string path) {
-  if (path.find(".wav") != ct::string::npos) LoadWaveFile(path);
+void SoundCooker::AddSound(ct::string path) {
+  if (path.find(".wav") != ct::string::npos ||
+      path.find(".ogg") != ct::string::npos)
+    paths_.push_back(std::move(path));
 }
 
 void SoundCooker::SerializeAndSave(ct::string save_path) {
-  std::ofstream list_output(save_path + "_names.txt");
+  SortPaths(paths_);
 
-  size_t size = 0;
-  SerializationUtilities::CountSize(sound_vector_.size(), size);
-  for (auto &sound : sound_vector_) {
-    SerializationUtilities::CountSize(sound.path, size);
-    SerializationUtilities::CountSize(sound.desc, size);
-    list_output << sound.path.substr(sound.path.find_last_of('\\') + 1,
-                                     sound.path.size())
-                << "\n";
+  lib_core::AssetPackWriter pack(lib_core::AssetPack::kSound);
+  if (!pack.Open(save_path, paths_)) {
+    cu::Log("Failed to open sound pack: " + save_path, __FILE__, __LINE__);
+    return;
   }
-  list_output.close();
 
-  for (auto &sound : sound_vector_) {
-    sound.desc.data_location = size;
-    SerializationUtilities::CountSize(sound.data, size);
-  }
+  ct::dyn_array<uint8_t> cooked(paths_.size(), 0);
+  ParallelCook(paths_.size(), [&](size_t slot) {
+    CookCache::Entry entry;
+    auto cook = [&](CookCache::Entry& out) {
+      Sound sound;
+      auto ogg = paths_[slot].find(".ogg") != ct::string::npos;
+      if (ogg ? !LoadOggFile(paths_[slot], sound)
+              : !LoadWaveFile(paths_[slot], sound))
+        return false;
+      out.blob = std::move(sound.data);
+      out.meta = {sound.desc.channels, sound.desc.bits_per_sample,
+                  sound.desc.sample_rate, sound.desc.encoding};
+      out.codec = ogg ? lib_core::Codec::kStore : codec_;
+      out.raw_size = sound.raw_size;
+      return true;
+    };
+    if (!CookCached(cache_, paths_[slot], kCookVersion, codec_, 0, entry,
+                    cook)) {
+      pack.Skip(slot);
+      return;
+    }
+
+    pack.Write(slot, std::move(entry.blob), entry.meta, entry.codec,
+               entry.raw_size);
+    cooked[slot] = 1;
+  });
 
-  ct::dyn_array<uint8_t> buffer(size);
-  auto it = buffer.begin();
-  SerializationUtilities::CopyToBuffer(sound_vector_.size(), it);
-  for (auto &sound : sound_vector_) {
-    SerializationUtilities::CopyToBuffer(sound.path, it);
-    SerializationUtilities::CopyToBuffer(sound.desc, it);
-  }
-  for (auto &sound : sound_vector_)
-    SerializationUtilities::CopyToBuffer(sound.data, it);
+  std::ofstream list_output(save_path + "_names.txt");
+  for (size_t i = 0; i < paths_.size(); ++i)
+    if (cooked[i]) list_output << FileName(paths_[i]) << "\n";
+  list_output.close();
 
-  cu::Save(save_path, buffer);
+  if (!pack.Close())
+    cu::Log("Failed to save sound pack: " + save_path, __FILE__, __LINE__);
 }
 
-void SoundCooker::LoadWaveFile(ct::string &path) {
+bool SoundCooker::LoadWaveFile(const ct::string &path, Sound &sound) {
   std::ifstream open(path, std::ios::binary);
 
-  Sound sound;
-  sound.path = path;
   ct::dyn_array<uint8_t> uncompressed_data;
   if (!open.fail()) {
     ct::string id("    ");
@@ -82,13 +99,41 @@ void SoundCooker::LoadWaveFile(ct::string &path) {
 
         open.read((char *)uncompressed_data.data(), data_size);
 
-        cu::CompressMemory(uncompressed_data, sound.data);
+        sound.raw_size = uncompressed_data.size();
+        return lib_core::Codec::Compress(codec_, uncompressed_data.data(),
+                                         uncompressed_data.size(), sound.data);
       } else
         std::cout << "Error: RIFF file but not a wave file\n";
     } else
       std::cout << "Error: not a RIFF file\n";
   }
+  return false;
+}
+
+bool SoundCooker::LoadOggFile(const ct::string &path, Sound &sound) {
+  std::ifstream open(path, std::ios::binary | std::ios::ate);
+  if (open.fail()) return false;
+
+  sound.data.assign(size_t(open.tellg()), 0);
+  open.seekg(0);
+  open.read((char *)sound.data.data(), sound.data.size());
+
+  int error = 0;
+  auto vorbis = stb_vorbis_open_memory(
+      sound.data.data(), int(sound.data.size()), &error, nullptr);
+  if (!vorbis) {
+    std::cout << "Error: not an ogg vorbis file (" << error << ")\n";
+    return false;
+  }
+
+  auto info = stb_vorbis_get_info(vorbis);
+  stb_vorbis_close(vorbis);
 
-  sound_vector_.push_back(std::move(sound));
+  sound.desc.channels = uint16_t(info.channels);
+  sound.desc.bits_per_sample = 16;
+  sound.desc.sample_rate = info.sample_rate;
+  sound.desc.encoding = kVorbis;
+  sound.raw_size = sound.data.size();
+  return true;
 }
 }  // namespace cmd_fract_cooking
@@ -1,4 +1,6 @@
 #pragma once
+#include "codec.h"
+#include "cook_cache.h"
 #include "core_utilities.h"
 
 namespace cmd_fract_cooking {
@@ -7,25 +9,40 @@ class SoundCooker {
   SoundCooker() = default;
   ~SoundCooker() = default;
 
-  void LoadSound(ct::string path);
+  void AddSound(ct::string path);
   void SerializeAndSave(ct::string save_path);
 
+  void SetCodec(lib_core::Codec::Type codec) { codec_ = codec; }
+  void SetCache(CookCache* cache) { cache_ = cache; }
+
+  // Bump when the cooked sound layout changes to invalidate cached blobs.
+  static constexpr uint32_t kCookVersion = 2;
+
+  // Written to meta[3], must match SoundSystem::Encoding.
+  static constexpr uint32_t kPcm = 0;
+  static constexpr uint32_t kVorbis = 1;
+
  private:
   struct SoundDesc {
     uint16_t channels;
     uint16_t bits_per_sample;
     uint32_t sample_rate;
-    size_t data_location;
+    uint32_t encoding = kPcm;
   };
 
   struct Sound {
-    ct::string path;
     SoundDesc desc;
+    size_t raw_size = 0;
     ct::dyn_array<uint8_t> data;
   };
 
-  void LoadWaveFile(ct::string& path);
+  bool LoadWaveFile(const ct::string& path, Sound& sound);
+  // Vorbis is already compressed, the file is validated and stored as is and
+  // decoded at runtime by a SoundStream.
+  bool LoadOggFile(const ct::string& path, Sound& sound);
 
-  tbb::concurrent_vector<Sound> sound_vector_;
+  lib_core::Codec::Type codec_ = lib_core::Codec::kZlib;
+  CookCache* cache_ = nullptr;
+  ct::dyn_array<ct::string> paths_;
 };
 }  // namespace cmd_fract_cooking
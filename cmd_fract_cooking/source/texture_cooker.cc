@@ -1,71 +1,120 @@
 #include "texture_cooker.h"
 #include <filesystem>
 #include <fstream>
-#include "../../source_shared/include/serialization_utilities.hpp"
+#include "asset_pack.h"
 #include "core_utilities.h"
+#include "parallel_cook.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../source_shared/include/stb_image.hpp"
 
 namespace cmd_fract_cooking {
-void TextureCooker::LoadTexture(ct::string path) {
-  if (!std::filesystem::exists(path)) return;
+void TextureCooker::AddTexture(ct::string path) {
+  paths_.push_back(std::move(path));
+}
 
-  Texture tex;
-  tex.name = path.substr(path.find_last_of('/') + 1, path.size());
-  int width, height, channels = 0;
+void TextureCooker::SerializeAndSave(ct::string save_path) {
+  SortPaths(paths_);
+
+  lib_core::AssetPackWriter pack(lib_core::AssetPack::kTexture);
+  if (!pack.Open(save_path, paths_)) {
+    cu::Log("Failed to open texture pack: " + save_path, __FILE__, __LINE__);
+    return;
+  }
+
+  ct::dyn_array<uint8_t> cooked(paths_.size(), 0);
+  ParallelCook(paths_.size(), [&](size_t slot) {
+    CookCache::Entry entry;
+    auto cook = [&](CookCache::Entry& out) {
+      Texture tex;
+      if (!LoadTexture(paths_[slot], tex)) return false;
+      out.blob = std::move(tex.data);
+      out.meta = {uint32_t(tex.channels), uint32_t(tex.dims.first),
+                  uint32_t(tex.dims.second), tex.format | tex.mip_count << 8};
+      out.codec = codec_;
+      out.raw_size = tex.raw_size;
+      return true;
+    };
+    if (!CookCached(cache_, paths_[slot], kCookVersion, codec_,
+                    NameHints(FileName(paths_[slot])), entry, cook)) {
+      pack.Skip(slot);
+      return;
+    }
+
+    pack.Write(slot, std::move(entry.blob), entry.meta, entry.codec,
+               entry.raw_size);
+    cooked[slot] = 1;
+  });
+
+  std::ofstream list_output(save_path + "_names.txt");
+  for (size_t i = 0; i < paths_.size(); ++i) {
+    auto name = FileName(paths_[i]);
+    if (cooked[i] && name.find("albedo") != ct::string::npos)
+      list_output << name << "\n";
+  }
+  list_output.close();
+
+  if (!pack.Close())
+    cu::Log("Failed to save texture pack: " + save_path, __FILE__, __LINE__);
+}
 
+bool TextureCooker::LoadTexture(const ct::string &path, Texture &tex) {
+  using lib_core::TextureCompression;
+  if (!std::filesystem::exists(path)) return false;
+
+  int width, height, channels = 0;
   auto image = stbi_load(path.c_str(), &width, &height, &channels, 0);
+  if (!image) return false;
+
+  auto hints = NameHints(FileName(path));
+  auto is_normal = (hints & kNormalMap) && channels >= 3;
+  auto filter = is_normal ? TextureCompression::kNormal
+                : (hints & kAlbedo) ? TextureCompression::kSrgb
+                                    : TextureCompression::kLinear;
+  auto mips = TextureCompression::BuildMips(image, channels, width, height,
+                                            filter);
+  stbi_image_free(image);
 
   tex.channels = channels;
   tex.dims = {width, height};
-  ct::dyn_array<uint8_t> tex_source(width * height * channels);
-  std::copy(image, image + sizeof(uint8_t) * width * height * channels,
-            tex_source.begin());
+  tex.format = ChooseFormat(hints, channels, mips.front());
+  tex.mip_count = uint32_t(mips.size());
 
-  stbi_image_free(image);
+  ct::dyn_array<uint8_t> chain;
+  for (uint32_t level = 0; level < tex.mip_count; ++level)
+    TextureCompression::Encode(tex.format, mips[level].data(),
+                               TextureCompression::LevelDim(width, level),
+                               TextureCompression::LevelDim(height, level),
+                               channels, chain);
 
-  cu::CompressMemory(tex_source, tex.data);
-  textures_.push_back(tex);
+  tex.raw_size = chain.size();
+  return lib_core::Codec::Compress(codec_, chain.data(), chain.size(),
+                                   tex.data);
 }
 
-void TextureCooker::SerializeAndSave(ct::string save_path) {
-  std::ofstream list_output(save_path + "_names.txt");
-
-  size_t size = 0;
-  ct::dyn_array<size_t> starting_points;
-  SerializationUtilities::CountSize(textures_.size(), size);
-  for (auto &tex : textures_) {
-    SerializationUtilities::CountSize(tex.name, size);
-    SerializationUtilities::CountSize(tex.channels, size);
-    SerializationUtilities::CountSize(tex.dims, size);
-    SerializationUtilities::CountSize(size, size);
-
-    if (tex.name.find("albedo") != ct::string::npos)
-      list_output << tex.name.substr(tex.name.find_last_of('\\') + 1,
-                                     tex.name.size())
-                  << "\n";
-  }
-  list_output.close();
+uint32_t TextureCooker::NameHints(const ct::string &name) {
+  uint32_t hints = 0;
+  if (name.find("normal") != ct::string::npos) hints |= kNormalMap;
+  if (name.find("albedo") != ct::string::npos) hints |= kAlbedo;
+  if (name.find("rma") != ct::string::npos ||
+      name.find("rme") != ct::string::npos)
+    hints |= kMaskMap;
+  return hints;
+}
 
-  for (auto &tex : textures_) {
-    starting_points.push_back(size);
-    SerializationUtilities::CountSize(tex.data, size);
-  }
+lib_core::TextureCompression::Format TextureCooker::ChooseFormat(
+    uint32_t hints, int channels, const ct::dyn_array<uint8_t> &rgba) {
+  using lib_core::TextureCompression;
+  if (channels == 1) return TextureCompression::kBc4;
+  if (channels == 2 || (hints & kNormalMap)) return TextureCompression::kBc5;
 
-  int i = 0;
-  ct::dyn_array<uint8_t> buffer(size);
-  auto it = buffer.begin();
-  SerializationUtilities::CopyToBuffer(textures_.size(), it);
-  for (auto &tex : textures_) {
-    SerializationUtilities::CopyToBuffer(tex.name, it);
-    SerializationUtilities::CopyToBuffer(tex.channels, it);
-    SerializationUtilities::CopyToBuffer(tex.dims, it);
-    SerializationUtilities::CopyToBuffer(starting_points[i++], it);
-  }
-  for (auto &tex : textures_)
-    SerializationUtilities::CopyToBuffer(tex.data, it);
+  if (channels == 4)
+    for (size_t i = 3; i < rgba.size(); i += 4)
+      if (rgba[i] < 255) return TextureCompression::kBc3;
 
-  cu::Save(save_path, buffer);
+  // Roughness, metal and occlusion don't correlate, which BC1's single color
+  // line handles poorly.
+  if (hints & kMaskMap) return TextureCompression::kBc7;
+  return TextureCompression::kBc1;
 }
 }  // namespace cmd_fract_cooking
@@ -1,5 +1,8 @@
 #pragma once
+#include "codec.h"
+#include "cook_cache.h"
 #include "core_utilities.h"
+#include "texture_compression.h"
 
 namespace cmd_fract_cooking {
 class TextureCooker {
@@ -7,18 +10,37 @@ class TextureCooker {
   TextureCooker() = default;
   ~TextureCooker() = default;
 
-  void LoadTexture(ct::string path);
+  void AddTexture(ct::string path);
   void SerializeAndSave(ct::string save_path);
 
+  void SetCodec(lib_core::Codec::Type codec) { codec_ = codec; }
+  void SetCache(CookCache* cache) { cache_ = cache; }
+
+  // Bump when the cooked texture layout changes to invalidate cached blobs.
+  static constexpr uint32_t kCookVersion = 2;
+
  protected:
  private:
   struct Texture {
-    ct::string name;
     short channels;
     std::pair<int, int> dims;
+    lib_core::TextureCompression::Format format;
+    uint32_t mip_count;
+    size_t raw_size = 0;
     ct::dyn_array<uint8_t> data;
   };
 
-  tbb::concurrent_vector<Texture> textures_;
+  // Texture classes picked from the file name, they steer the mip filter and
+  // the block format and so are part of the cache key.
+  enum NameHint : uint32_t { kNormalMap = 1, kAlbedo = 2, kMaskMap = 4 };
+
+  bool LoadTexture(const ct::string &path, Texture &tex);
+  static uint32_t NameHints(const ct::string &name);
+  static lib_core::TextureCompression::Format ChooseFormat(
+      uint32_t hints, int channels, const ct::dyn_array<uint8_t> &rgba);
+
+  lib_core::Codec::Type codec_ = lib_core::Codec::kZlib;
+  CookCache* cache_ = nullptr;
+  ct::dyn_array<ct::string> paths_;
 };
 }  // namespace cmd_fract_cooking
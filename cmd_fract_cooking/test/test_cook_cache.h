@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "cook_cache.h"
+
+namespace cmd_fract_cooking {
+TEST(cmd_fract_cooking, CookCache_KeyCoversSettings) {
+  ct::string directory = "./test_cook_cache";
+  ct::string source = directory + "/source.bin";
+  CookCache cache(directory);
+  std::ofstream(source, std::ios::binary) << "source content";
+
+  auto key = cache.Key(source, 1, lib_core::Codec::kZlib, 0);
+  EXPECT_NE(key, 0);
+  EXPECT_EQ(cache.Key(source, 1, lib_core::Codec::kZlib, 0), key);
+  EXPECT_NE(cache.Key(source, 2, lib_core::Codec::kZlib, 0), key);
+  EXPECT_NE(cache.Key(source, 1, lib_core::Codec::kStore, 0), key);
+  EXPECT_NE(cache.Key(source, 1, lib_core::Codec::kZlib, 1), key);
+  EXPECT_EQ(cache.Key(directory + "/missing.bin", 1, lib_core::Codec::kZlib,
+                      0),
+            0);
+
+  size_t cooks = 0;
+  auto cook = [&](CookCache::Entry& out) {
+    out.blob = {1, 2, 3};
+    out.meta = {4, 5, 6, 7};
+    out.raw_size = 3;
+    ++cooks;
+    return true;
+  };
+  CookCache::Entry entry;
+  EXPECT_TRUE(CookCached(&cache, source, 1, lib_core::Codec::kStore, 2,
+                         entry, cook));
+  EXPECT_TRUE(CookCached(&cache, source, 1, lib_core::Codec::kStore, 2,
+                         entry, cook));
+  EXPECT_EQ(cooks, 1);
+  EXPECT_EQ(entry.blob, ct::dyn_array<uint8_t>({1, 2, 3}));
+  EXPECT_EQ(entry.meta[3], 7);
+
+  // Other settings miss the entry cooked above.
+  EXPECT_TRUE(CookCached(&cache, source, 1, lib_core::Codec::kStore, 3,
+                         entry, cook));
+  EXPECT_EQ(cooks, 2);
+  EXPECT_EQ(cache.Hits(), 1);
+
+  std::filesystem::remove_all(directory);
+}
+}  // namespace cmd_fract_cooking
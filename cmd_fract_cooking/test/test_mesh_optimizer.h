@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include "mesh_optimizer.h"
+
+namespace cmd_fract_cooking {
+namespace {
+void GridMesh(size_t size, ct::dyn_array<float>& positions,
+              ct::dyn_array<uint32_t>& indices) {
+  for (size_t y = 0; y <= size; ++y) {
+    for (size_t x = 0; x <= size; ++x) {
+      positions.push_back(float(x));
+      positions.push_back(float(y));
+      positions.push_back(0.f);
+    }
+  }
+
+  for (size_t y = 0; y < size; ++y) {
+    for (size_t x = 0; x < size; ++x) {
+      auto i = uint32_t(y * (size + 1) + x), row = uint32_t(size + 1);
+      indices.insert(indices.end(), {i, i + 1, i + row});
+      indices.insert(indices.end(), {i + 1, i + row + 1, i + row});
+    }
+  }
+}
+
+ct::dyn_array<std::array<uint32_t, 3>> Triangles(
+    const ct::dyn_array<uint32_t>& indices) {
+  ct::dyn_array<std::array<uint32_t, 3>> triangles;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    std::array<uint32_t, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+    std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+    triangles.push_back(t);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+}  // namespace
+
+TEST(cmd_fract_cooking, MeshOptimizer_ImprovesVertexCache) {
+  ct::dyn_array<float> positions;
+  ct::dyn_array<uint32_t> indices;
+  GridMesh(48, positions, indices);
+  auto vertex_count = positions.size() / 3;
+
+  ct::dyn_array<std::array<uint32_t, 3>> shuffled;
+  for (size_t i = 0; i < indices.size(); i += 3)
+    shuffled.push_back({indices[i], indices[i + 1], indices[i + 2]});
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+  indices.clear();
+  for (auto& t : shuffled) indices.insert(indices.end(), t.begin(), t.end());
+
+  auto before = MeshOptimizer::SimulateCache(indices, vertex_count);
+  auto source_triangles = Triangles(indices);
+
+  MeshOptimizer::OptimizeTriangles(indices, positions.data(), 3, vertex_count);
+  auto after = MeshOptimizer::SimulateCache(indices, vertex_count);
+
+  EXPECT_EQ(Triangles(indices), source_triangles);
+  EXPECT_GT(before.acmr, 1.5f);
+  EXPECT_LT(after.acmr, 0.8f);
+  EXPECT_LT(after.atvr, 1.5f);
+}
+
+TEST(cmd_fract_cooking, MeshOptimizer_FetchOrder) {
+  ct::dyn_array<uint32_t> indices = {4, 2, 0, 2, 4, 3};
+  ct::dyn_array<int> vertices = {10, 11, 12, 13, 14};
+
+  auto remap = MeshOptimizer::OptimizeFetch(indices, vertices.size());
+  MeshOptimizer::RemapVertices(vertices, remap);
+
+  EXPECT_EQ(indices, (ct::dyn_array<uint32_t>{0, 1, 2, 1, 0, 3}));
+  EXPECT_EQ(vertices, (ct::dyn_array<int>{14, 12, 10, 13}));
+  EXPECT_EQ(remap[1], MeshOptimizer::kUnused);
+}
+}  // namespace cmd_fract_cooking
@@ -0,0 +1,119 @@
+#pragma once
+#include <cmath>
+#include "mesh_simplifier.h"
+
+namespace cmd_fract_cooking {
+namespace {
+// Closed unit sphere without duplicated positions at the poles or seam.
+void SphereMesh(size_t rings, size_t segments, ct::dyn_array<float>& positions,
+                ct::dyn_array<uint32_t>& indices) {
+  auto push = [&](float x, float y, float z) {
+    positions.insert(positions.end(), {x, y, z});
+  };
+  push(0.f, 1.f, 0.f);
+  for (size_t r = 1; r < rings; ++r) {
+    auto theta = float(r) / rings * PI;
+    for (size_t s = 0; s < segments; ++s) {
+      auto phi = float(s) / segments * 2.f * PI;
+      push(std::sin(theta) * std::cos(phi), std::cos(theta),
+           std::sin(theta) * std::sin(phi));
+    }
+  }
+  push(0.f, -1.f, 0.f);
+
+  auto ring = [&](size_t r, size_t s) {
+    return uint32_t(1 + (r - 1) * segments + s % segments);
+  };
+  auto bottom = uint32_t(positions.size() / 3 - 1);
+  for (size_t s = 0; s < segments; ++s) {
+    indices.insert(indices.end(), {0, ring(1, s + 1), ring(1, s)});
+    for (size_t r = 1; r + 1 < rings; ++r) {
+      indices.insert(indices.end(),
+                     {ring(r, s), ring(r, s + 1), ring(r + 1, s)});
+      indices.insert(indices.end(),
+                     {ring(r, s + 1), ring(r + 1, s + 1), ring(r + 1, s)});
+    }
+    indices.insert(indices.end(),
+                   {ring(rings - 1, s), ring(rings - 1, s + 1), bottom});
+  }
+}
+
+float MinOutwardDot(const ct::dyn_array<float>& positions,
+                    const ct::dyn_array<uint32_t>& indices) {
+  auto min_dot = 1.f;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    auto p0 = &positions[indices[i] * 3], p1 = &positions[indices[i + 1] * 3],
+         p2 = &positions[indices[i + 2] * 3];
+    float e0[3], e1[3], n[3], c[3];
+    for (int k = 0; k < 3; ++k) {
+      e0[k] = p1[k] - p0[k], e1[k] = p2[k] - p0[k];
+      c[k] = (p0[k] + p1[k] + p2[k]) / 3.f;
+    }
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+    auto ln = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    auto lc = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+    min_dot = std::min(min_dot, (n[0] * c[0] + n[1] * c[1] + n[2] * c[2]) /
+                                    (ln * lc));
+  }
+  return min_dot;
+}
+}  // namespace
+
+TEST(cmd_fract_cooking, MeshSimplifier_Sphere) {
+  ct::dyn_array<float> positions;
+  ct::dyn_array<uint32_t> indices;
+  SphereMesh(32, 64, positions, indices);
+  auto source_count = indices.size();
+  ASSERT_GT(MinOutwardDot(positions, indices), 0.f);
+
+  auto coarse = indices;
+  auto error = MeshSimplifier::Simplify(coarse, positions.data(), 3,
+                                        positions.size() / 3,
+                                        source_count / 4, 1.f);
+  EXPECT_LE(coarse.size(), source_count / 4);
+  EXPECT_GT(coarse.size(), source_count / 8);
+  EXPECT_GT(error, 0.f);
+  EXPECT_LT(error, .05f);
+  EXPECT_GT(MinOutwardDot(positions, coarse), 0.f);
+
+  auto capped = indices;
+  auto capped_error = MeshSimplifier::Simplify(capped, positions.data(), 3,
+                                               positions.size() / 3, 0, .002f);
+  EXPECT_LE(capped_error, .002f);
+  EXPECT_GT(capped.size(), coarse.size());
+}
+
+TEST(cmd_fract_cooking, MeshSimplifier_KeepsSeamsAndBorders) {
+  // Two quads of a 4x4 grid each, sharing positions but not vertices along
+  // x = 4, like a uv seam.
+  ct::dyn_array<float> positions;
+  ct::dyn_array<uint32_t> indices;
+  for (uint32_t half = 0; half < 2; ++half) {
+    auto base = uint32_t(positions.size() / 3);
+    for (uint32_t y = 0; y <= 4; ++y)
+      for (uint32_t x = 0; x <= 4; ++x)
+        positions.insert(positions.end(), {float(x + half * 4), float(y), 0.f});
+    for (uint32_t y = 0; y < 4; ++y) {
+      for (uint32_t x = 0; x < 4; ++x) {
+        auto i = base + y * 5 + x;
+        indices.insert(indices.end(), {i, i + 1, i + 5});
+        indices.insert(indices.end(), {i + 1, i + 6, i + 5});
+      }
+    }
+  }
+
+  auto error = MeshSimplifier::Simplify(indices, positions.data(), 3,
+                                        positions.size() / 3, 0, 1e-3f);
+  EXPECT_LT(error, 1e-4f);
+  EXPECT_LT(indices.size(), 64u * 3u);
+
+  ct::tree_set<uint32_t> used(indices.begin(), indices.end());
+  for (uint32_t y = 0; y <= 4; ++y) {
+    EXPECT_EQ(used.count(y * 5 + 4), 1u);
+    EXPECT_EQ(used.count(25 + y * 5), 1u);
+  }
+  for (uint32_t v : {0u, 4u, 20u, 24u, 29u, 49u}) EXPECT_EQ(used.count(v), 1u);
+}
+}  // namespace cmd_fract_cooking
@@ -6,14 +6,16 @@ if not exist .\_build_release_\ (
   mkdir .\_build_release_\ 
 )
 
-cd .\_stock_assets_\
-call compile_assets.bat
-cd ..
-
 cd .\_build_release_\ 
 cmake -G "Visual Studio 16 2019" -A x64 .. 
 devenv cmakemaker_solution.sln /Build Release
+cd ..
+
+cd .\_stock_assets_\
+call compile_assets.bat
+cd ..
 
+cd .\_build_release_\
 cd .\app_example\Build_Output\bin\Release 
 ecs_game_engine.exe
 cd ..\..\..\..\..
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <array>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+
+#include "codec.h"
+#include "core_utilities.h"
+#include "span.h"
+
+namespace lib_core {
+// Pack layout: header, table of contents sorted by name hash, name strings,
+// then the blobs, each starting on a kBlobAlignment boundary.
+struct PackHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t type;
+  uint32_t entry_count;
+  uint64_t names_offset;
+  uint64_t names_size;
+};
+
+struct PackEntry {
+  uint64_t name_hash;
+  uint64_t offset;
+  uint64_t size;
+  uint64_t raw_size;
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint32_t codec;
+  uint32_t reserved;
+  std::array<uint32_t, 4> meta;
+};
+
+static_assert(sizeof(PackHeader) == 32, "Pack header layout changed.");
+static_assert(sizeof(PackEntry) == 64, "Pack entry layout changed.");
+
+// Encoded bytes of one entry along with what is needed to decode them.
+struct PackBlob {
+  Span<const uint8_t> data;
+  size_t raw_size = 0;
+  Codec::Type codec = Codec::kStore;
+
+  // Sizes out_data to raw_size and decodes into it in a single pass.
+  bool Unpack(ct::dyn_array<uint8_t>& out_data) const;
+};
+
+class AssetPack {
+ public:
+  enum Type : uint32_t { kTexture = 0, kModel, kSound };
+
+  static constexpr uint32_t kMagic = 0x4b415046;  // "FPAK"
+  static constexpr uint32_t kVersion = 2;
+  static constexpr size_t kBlobAlignment = 16;
+
+  AssetPack() = default;
+  ~AssetPack();
+  AssetPack(const AssetPack&) = delete;
+  AssetPack& operator=(const AssetPack&) = delete;
+
+  bool Open(const ct::string& path);
+  void Close();
+
+  bool IsOpen() const { return data_ != nullptr; }
+  Type GetType() const { return Type(header_->type); }
+
+  size_t EntryCount() const { return IsOpen() ? header_->entry_count : 0; }
+  const PackEntry& Entry(size_t i) const { return entries_[i]; }
+  std::string_view Name(const PackEntry& entry) const;
+
+  // Binary search on the name hash, the name itself breaks ties.
+  const PackEntry* Find(std::string_view name) const;
+
+  // Points straight into the mapping and stays valid until Close.
+  PackBlob Blob(const PackEntry& entry) const;
+
+  static uint64_t HashName(std::string_view name);
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  const PackHeader* header_ = nullptr;
+  const PackEntry* entries_ = nullptr;
+  const char* names_ = nullptr;
+
+#ifdef WindowsBuild
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+// Entries are either buffered with Add and written by Save, or streamed: Open
+// with every name up front, then Write or Skip each slot exactly once from any
+// thread. Blobs are appended in slot order as soon as the preceding slots are
+// done, so the output is byte identical no matter which slot finishes first,
+// and only out of order results are held in memory.
+class AssetPackWriter {
+ public:
+  explicit AssetPackWriter(AssetPack::Type type) : type_(type) {}
+
+  // Directories are stripped from the name, only the file name is stored.
+  // The blob is expected to be encoded with codec already, raw_size is the
+  // size it decodes to.
+  void Add(const ct::string& name, ct::dyn_array<uint8_t> blob,
+           std::array<uint32_t, 4> meta = {},
+           Codec::Type codec = Codec::kStore, size_t raw_size = 0);
+  bool Save(const ct::string& path);
+
+  bool Open(const ct::string& path, const ct::dyn_array<ct::string>& names);
+  void Write(size_t slot, ct::dyn_array<uint8_t> blob,
+             std::array<uint32_t, 4> meta = {},
+             Codec::Type codec = Codec::kStore, size_t raw_size = 0);
+  void Skip(size_t slot);
+  bool Close();
+
+  size_t Size() const { return items_.size(); }
+
+ private:
+  struct Item {
+    ct::string name;
+    std::array<uint32_t, 4> meta;
+    Codec::Type codec;
+    size_t raw_size;
+    ct::dyn_array<uint8_t> blob;
+  };
+
+  struct Slot {
+    bool done = false;
+    bool skipped = false;
+    PackEntry entry = {};
+    ct::dyn_array<uint8_t> blob;
+  };
+
+  void Flush();
+
+  AssetPack::Type type_;
+  ct::dyn_array<Item> items_;
+
+  std::mutex mutex_;
+  std::ofstream out_;
+  ct::dyn_array<ct::string> names_;
+  ct::dyn_array<Slot> slots_;
+  size_t next_slot_ = 0;
+  uint64_t offset_ = 0;
+  bool failed_ = false;
+};
+}  // namespace lib_core
@@ -0,0 +1,33 @@
+#pragma once
+#include "core_utilities.h"
+#include "vector_def.h"
+
+namespace lib_core {
+// Directional shadow cascade fitting. Each cascade covers a bounding sphere
+// of its slice of the view frustum, whose size only depends on the camera
+// projection, and is moved in whole shadow texels. Together that keeps the
+// shadow texels fixed in the world while the camera moves and turns.
+class CascadeFitting {
+ public:
+  struct Sphere {
+    Vector3 center;
+    float radius;
+  };
+
+  // Practical split scheme, count + 1 view distances from near to far. A
+  // lambda of 1 gives logarithmic splits and 0 uniform ones.
+  static ct::dyn_array<float> Splits(float near, float far, size_t count,
+                                     float lambda);
+
+  // Smallest sphere around the frustum slice between near and far.
+  static Sphere SliceSphere(const Vector3& eye, const Vector3& forward,
+                            float near, float far, float tan_half_fov,
+                            float aspect);
+
+  // Light view projection looking along light_dir. depth_pad moves the near
+  // plane back towards the light so casters outside the sphere still land
+  // in the map.
+  static Matrix4x4 LightMatrix(const Sphere& sphere, Vector3 light_dir,
+                               int resolution, float depth_pad);
+};
+}  // namespace lib_core
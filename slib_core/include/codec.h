@@ -0,0 +1,21 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Block codecs used for pack entries. The uncompressed size is stored next to
+// the data so decompression writes straight into a buffer of the right size.
+// Sizes the codec cannot represent, over 2 GB for LZ4 and for zlib on
+// Windows, fail instead of being truncated.
+class Codec {
+ public:
+  enum Type : uint32_t { kStore = 0, kZlib, kLz4, kZstd, kTypeCount };
+
+  static bool Compress(Type type, const uint8_t* in_data, size_t in_size,
+                       ct::dyn_array<uint8_t>& out_data);
+  static bool Decompress(Type type, const uint8_t* in_data, size_t in_size,
+                         uint8_t* out_data, size_t out_size);
+
+  static const char* Name(Type type);
+  static bool Parse(const ct::string& name, Type& type);
+};
+}  // namespace lib_core
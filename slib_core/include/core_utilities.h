@@ -109,6 +109,8 @@ class cu {
                                 ct::dyn_array<uint8_t> &out_data);
   static void DecompressMemory(ct::dyn_array<uint8_t> &in_data,
                                ct::dyn_array<uint8_t> &out_data);
+  static void DecompressMemory(const uint8_t *in_data, size_t in_size,
+                               ct::dyn_array<uint8_t> &out_data);
   static void CompressAndSave(const ct::string &save_path,
                               ct::dyn_array<uint8_t> &buffer);
   static void Save(const ct::string &save_path, ct::dyn_array<uint8_t> &buffer);
@@ -200,7 +202,7 @@ class cu {
     return result;
   }
 
-  static void PrintLogFile(const ct::string &dest_path);
+  static void FlushLogFile();
   static void PrintProfiling(const ct::string &dest_path);
 
   class TerminatingException : public std::exception {
@@ -216,23 +218,12 @@ class cu {
   };
 
   static inline void AssertError(bool condition, const ct::string &cause,
-                                 const ct::string &file = "", int line = -1) {
+                                 const char *file = "", int line = -1) {
     if (!condition) {
-      ct::string desc_str = file;
-#ifdef WindowsBuild
-      auto pos = file.find_last_of('\\');
-#else
-      auto pos = file.find_last_of('/');
-#endif
-      if (pos != std::string::npos)
-        desc_str = file.substr(pos + 1, file.size());
-      if (line != -1) desc_str += "(" + std::to_string(line) + ") ";
-
-      errors.push_back(desc_str + cause);
-      PrintLogFile("./logfile.txt");
+      ReportError(cause, file, line);
       assert(condition);
       try {
-        throw TerminatingException(desc_str + cause);
+        throw TerminatingException(cause);
       } catch (...) {
         std::terminate();
       }
@@ -240,50 +231,15 @@ class cu {
   }
 
   static inline void AssertWarning(bool condition, const ct::string &cause,
-                                   const ct::string &file = "", int line = -1) {
+                                   const char *file = "", int line = -1) {
     if (!condition) {
-      ct::string desc_str;
-      if (!file.empty())
-        desc_str += file.substr(file.find_last_of('\\') + 1, file.size());
-      if (line != -1) desc_str += "(" + std::to_string(line) + ") ";
-
-      std::cout << desc_str + cause << "\n";
-      warnings.push_back(desc_str + cause);
-      PrintLogFile("./logfile.txt");
+      ReportWarning(cause, file, line);
       assert(condition);
     }
   }
 
-  static inline void Log(const ct::string &message, const ct::string &file = "",
-                         int line = -1) {
-    ct::string desc_str;
-    if (!file.empty())
-      desc_str += file.substr(file.find_last_of('\\') + 1, file.size());
-    if (line != -1) desc_str += "(" + std::to_string(line) + ") ";
-    logs.push_back(desc_str + message);
-  }
-
-  static inline void ProfileStart(const ct::string &name) {
-    auto hash = std::hash<ct::string>{}(name);
-    str_map.insert({hash, name});
-    profile_starts.insert({hash, std::chrono::high_resolution_clock::now()});
-  }
-  static inline void ProfileStop(const ct::string &name) {
-    profile_ends.insert({std::hash<ct::string>{}(name),
-                         std::chrono::high_resolution_clock::now()});
-  }
-
-  template <class T>
-  static inline float ProfileTime(const ct::string &name) {
-    auto hash = std::hash<ct::string>{}(name);
-    decltype(profile_starts)::accessor it1, it2;
-    if (profile_starts.find(it1, hash) && profile_ends.find(it2, hash)) {
-      std::chrono::duration<float, T> dur;
-      dur = it2->second - it1->second;
-      return dur.count();
-    }
-    return 0.f;
-  }
+  static void Log(const ct::string &message, const char *file = "",
+                  int line = -1);
 
   static inline std::chrono::time_point<std::chrono::high_resolution_clock>
   TimerStart() {
@@ -298,11 +254,10 @@ class cu {
   }
 
  private:
-  static tbb::concurrent_vector<ct::string> errors, warnings, logs;
-  static tbb::concurrent_hash_map<
-      size_t, std::chrono::time_point<std::chrono::high_resolution_clock>>
-      profile_starts, profile_ends;
-  static tbb::concurrent_hash_map<size_t, ct::string> str_map;
+  static void ReportError(const ct::string &cause, const char *file,
+                          int line);
+  static void ReportWarning(const ct::string &cause, const char *file,
+                            int line);
   static bool EvalDiv(ct::string &str);
   static bool EvalMul(ct::string &str);
   static bool EvalAdd(ct::string &str);
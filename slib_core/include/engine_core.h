@@ -3,6 +3,7 @@
 #include <memory>
 #include "core_commands.h"
 #include "engine_debug_output.h"
+#include "frame_telemetry.h"
 #include "renderer.h"
 #include "window.h"
 
@@ -60,6 +61,7 @@ class EngineCore {
   [[nodiscard]] lib_graphics::CameraSystem* CameraSystem() const;
 
   [[nodiscard]] EngineDebugOutput* GetDebugOutput() const;
+  [[nodiscard]] FrameTelemetry* GetTelemetry() const;
 
   static size_t stock_box_mesh, stock_sphere_mesh, stock_material_textured,
       stock_texture, stock_material_untextured;
@@ -70,6 +72,7 @@ class EngineCore {
   std::unique_ptr<lib_graphics::Window> window_;
   std::unique_ptr<lib_graphics::Renderer> renderer_;
   std::unique_ptr<EngineDebugOutput> debug_output_;
+  std::unique_ptr<FrameTelemetry> telemetry_;
 
   lib_input::InputSystem* input_system_ = nullptr;
   lib_physics::PhysicsSystem* physics_system_ = nullptr;
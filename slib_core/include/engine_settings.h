@@ -33,6 +33,7 @@ class EngineSettings {
   void SetMouseSensitivity(float value);
   void SetMouseSmoothing(float value);
   void SetFramePace(float value);
+  void SetCascadeSplitLambda(float value);
 
   float Gamma() const;
   float MasterVolume() const;
@@ -47,6 +48,7 @@ class EngineSettings {
   float MouseSmoothing() const;
   float FramePace() const;
   float FpsTarget() const;
+  float CascadeSplitLambda() const;
 
   void SetWindowedWidth(int width);
   void SetWindowedHeight(int height);
@@ -54,6 +56,7 @@ class EngineSettings {
   void SetFullscreenHeight(int height);
   void SetMaxShadowResolution(int res);
   void SetMaxTextureResolution(int res);
+  void SetShadowCascades(int count);
 
   int WindowedWidth() const;
   int WindowedHeight() const;
@@ -61,6 +64,7 @@ class EngineSettings {
   int FullscreenHeight() const;
   int MaxShadowTexture() const;
   int MaxTextureResolution() const;
+  int ShadowCascades() const;
 
   void LoadSettings();
   void SaveSettings();
@@ -85,7 +89,8 @@ class EngineSettings {
     kFullscreenWidth,
     kFullscreenHeight,
     kMaxShadowResoulution,
-    kMaxTextureResolution
+    kMaxTextureResolution,
+    kShadowCascades
   };
   enum FloatSettings {
     kGamma,
@@ -99,7 +104,8 @@ class EngineSettings {
     kHue,
     kMouseSensitivity,
     kMouseSmoothing,
-    kFramePace
+    kFramePace,
+    kCascadeSplitLambda
   };
   enum BoolSettings { kVsync, kBloom, kSsao, kSmaa, kFullscreen, kWindowed };
 };
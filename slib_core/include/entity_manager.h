@@ -6,6 +6,7 @@
 #include "barrier.hpp"
 #include "core_utilities.h"
 #include "entity.h"
+#include "memory_tracker.h"
 
 namespace lib_core {
 class EntityManager {
@@ -75,6 +76,7 @@ class EntityManager {
           old_comps.get_value<ct::dyn_array<T>>().push_back(comp);
           e_vec.push_back(entity);
           new_update.push_back(true), old_update.push_back(true);
+          g_mem_tracker.Allocated(MemoryTracker::kEcsComponents, 2 * sizeof(T));
         }
         return;
       }
@@ -84,6 +86,7 @@ class EntityManager {
       e_vec.push_back(entity);
       new_update.push_back(true), old_update.push_back(true);
       e_comps[hash] = 0;
+      g_mem_tracker.Allocated(MemoryTracker::kEcsComponents, 2 * sizeof(T));
     };
     comp_add_funcs_.push({hash, entity, add_func});
 
@@ -117,6 +120,8 @@ class EntityManager {
                 e_vec.pop_back();
 
                 it->second.erase(hash);
+                g_mem_tracker.Freed(MemoryTracker::kEcsComponents,
+                                    2 * sizeof(T));
               }
             }
           };
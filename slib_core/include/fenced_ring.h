@@ -0,0 +1,54 @@
+#pragma once
+#include <deque>
+#include "core_utilities.h"
+
+namespace lib_core {
+// Ring allocator for a buffer the GPU reads while the CPU writes the next
+// frames. Everything pushed between two EndFrame calls is closed with one
+// fence, and that space is only handed out again after the fence signalled.
+// The buffer itself lives behind Backend so the ring can run without a GPU.
+class FencedRing {
+ public:
+  class Backend {
+   public:
+    virtual ~Backend() = default;
+
+    virtual void Write(size_t offset, const void* data, size_t size) = 0;
+    virtual uint64_t InsertFence() = 0;
+    // Blocks until the fence signalled, then releases it.
+    virtual void WaitFence(uint64_t fence) = 0;
+  };
+
+  static constexpr size_t kFull = ~size_t(0);
+
+  FencedRing(Backend& backend, size_t capacity, size_t alignment);
+  ~FencedRing();
+  FencedRing(const FencedRing&) = delete;
+  FencedRing& operator=(const FencedRing&) = delete;
+
+  // Copies size bytes in and returns their offset, kFull when they don't fit
+  // next to what the current frame already pushed.
+  size_t Push(const void* data, size_t size);
+  void EndFrame();
+  // Waits for every frame in flight.
+  void Drain();
+
+  size_t Capacity() const { return capacity_; }
+  size_t FramesInFlight() const { return frames_.size(); }
+
+ private:
+  struct Frame {
+    uint64_t fence;
+    size_t size;
+  };
+
+  void Release();
+
+  Backend& backend_;
+  size_t capacity_, alignment_;
+
+  // Bytes in use, wrap padding included, start at tail_ and end at head_.
+  size_t head_ = 0, tail_ = 0, used_ = 0, frame_size_ = 0;
+  std::deque<Frame> frames_;
+};
+}  // namespace lib_core
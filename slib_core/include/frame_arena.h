@@ -0,0 +1,110 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "core_utilities.h"
+#include "span.h"
+
+namespace lib_core {
+// Bump allocator for memory that only lives for part of a frame. Nothing is
+// freed individually, the arena is rewound to a marker instead. Blocks are
+// never moved so earlier allocations stay valid until they are rewound.
+class FrameArena {
+ public:
+  static constexpr size_t kBlockSize = 256 * 1024;
+
+  struct Marker {
+    size_t block = 0;
+    size_t offset = 0;
+  };
+
+  explicit FrameArena(size_t block_size = kBlockSize);
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  static FrameArena& Local();
+
+  void* Allocate(size_t size, size_t alignment);
+
+  template <typename T>
+  T* Alloc(size_t n = 1) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena memory is rewound without running destructors.");
+    auto ptr = static_cast<T*>(Allocate(sizeof(T) * n, alignof(T)));
+    for (size_t i = 0; i < n; ++i) new (ptr + i) T();
+    return ptr;
+  }
+
+  template <typename T>
+  Span<T> AllocSpan(size_t n) {
+    return {Alloc<T>(n), n};
+  }
+
+  Marker GetMarker() const { return {block_, offset_}; }
+  void Rewind(Marker marker);
+  void Reset() { Rewind(Marker()); }
+
+  size_t Used() const;
+  size_t Capacity() const;
+  size_t HighWater() const { return high_water_; }
+
+ private:
+  struct Block {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size;
+  };
+
+  size_t block_size_;
+  size_t block_ = 0, offset_ = 0;
+  size_t high_water_ = 0;
+  ct::dyn_array<Block> blocks_;
+};
+
+class ArenaScope {
+ public:
+  explicit ArenaScope(FrameArena& arena = FrameArena::Local())
+      : arena_(arena), marker_(arena.GetMarker()) {}
+  ~ArenaScope() { arena_.Rewind(marker_); }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  FrameArena& arena_;
+  FrameArena::Marker marker_;
+};
+
+// Lets standard containers allocate from an arena, deallocation is a no-op.
+// Containers using it must not outlive the enclosing ArenaScope.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() : arena_(&FrameArena::Local()) {}
+  ArenaAllocator(FrameArena& arena) : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  FrameArena* arena_;
+
+  template <typename U>
+  friend class ArenaAllocator;
+};
+}  // namespace lib_core
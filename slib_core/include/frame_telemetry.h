@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+#include "core_utilities.h"
+
+namespace lib_core {
+class FrameTelemetry {
+ public:
+  enum Channel {
+    kUpdate = 0,
+    kRender,
+    kCull,
+    kSyncWait,
+    kGpuSubmit,
+    kChannelCount
+  };
+
+  struct Stats {
+    size_t count = 0;
+    float avg = 0.f, max = 0.f;
+    float p50 = 0.f, p95 = 0.f, p99 = 0.f;
+  };
+
+  static constexpr size_t kHistorySize = 4096;
+
+  FrameTelemetry() = default;
+  ~FrameTelemetry() = default;
+
+  // Every channel has a single producer thread (update or render), samples
+  // are in milliseconds and the oldest ones are overwritten.
+  void Record(Channel channel, float ms) {
+    auto head = heads_[channel].load(std::memory_order_relaxed);
+    samples_[channel][head % kHistorySize] = ms;
+    heads_[channel].store(head + 1, std::memory_order_release);
+  }
+
+  float Last(Channel channel) const;
+  size_t Count(Channel channel) const;
+  float Percentile(Channel channel, float percentile) const;
+  Stats GetStats(Channel channel) const;
+
+  bool WithinBudget(Channel channel, float percentile, float budget_ms) const;
+
+  void Reset();
+  void DumpCsv(const ct::string& dest_path) const;
+
+  static const char* ChannelName(Channel channel);
+
+ private:
+  ct::dyn_array<float> History(Channel channel) const;
+
+  std::array<std::array<float, kHistorySize>, kChannelCount> samples_;
+  std::array<std::atomic<uint64_t>, kChannelCount> heads_ = {};
+};
+}  // namespace lib_core
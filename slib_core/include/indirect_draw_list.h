@@ -0,0 +1,34 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Same layout as GL's DrawElementsIndirectCommand and Vulkan's
+// VkDrawIndexedIndirectCommand, so the array can be uploaded as is.
+struct DrawIndexedIndirect {
+  uint32_t index_count;
+  uint32_t instance_count;
+  uint32_t first_index;
+  int32_t base_vertex;
+  uint32_t base_instance;
+};
+
+// Collects instanced draws out of shared vertex and index buffers into one
+// indirect command array.
+class IndirectDrawList {
+ public:
+  // Returns true when a new command was appended. Draws of the same index
+  // range whose instances continue the previous command are folded into it,
+  // empty draws are dropped.
+  bool Add(uint32_t first_index, uint32_t index_count, int32_t base_vertex,
+           uint32_t instance_count, uint32_t base_instance);
+  void Clear();
+
+  const ct::dyn_array<DrawIndexedIndirect>& Commands() const {
+    return commands_;
+  }
+  bool Empty() const { return commands_.empty(); }
+
+ private:
+  ct::dyn_array<DrawIndexedIndirect> commands_;
+};
+}  // namespace lib_core
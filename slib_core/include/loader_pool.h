@@ -0,0 +1,87 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "core_utilities.h"
+
+namespace lib_core {
+// Worker pool shared by the asset loaders. Jobs run highest priority first
+// and in submission order within a priority. The optional completion callback
+// is queued and runs on whichever thread calls DispatchCompleted, which the
+// engine does once per logic frame.
+class LoaderPool {
+ public:
+  enum Priority { kLow = 0, kNormal, kHigh, kCritical };
+  using JobId = size_t;
+  using Callback = std::function<void()>;
+
+  static LoaderPool& get();
+  ~LoaderPool();
+
+  // Zero picks one worker per core not taken by the update and render thread.
+  // Submit starts the default pool if it has not been started. A running pool
+  // asked for a different count is restarted with it, queued jobs are kept.
+  void Start(size_t workers = 0);
+  void Stop();
+
+  JobId Submit(Callback work, Priority priority = kNormal,
+               Callback on_complete = nullptr, const void* owner = nullptr);
+
+  // Only raises the priority, returns false if the job has already started.
+  bool Bump(JobId job, Priority priority);
+
+  // Returns true if the job was removed before it ran. A running job is
+  // waited for, so on return the job is guaranteed not to touch its data.
+  bool Cancel(JobId job);
+
+  // Cancels everything submitted by owner, including completions that have
+  // not been dispatched yet. Used by systems before they are destroyed.
+  void CancelOwner(const void* owner);
+
+  size_t DispatchCompleted();
+  void WaitIdle();
+
+  size_t Pending() const;
+  size_t WorkerCount() const;
+
+ private:
+  LoaderPool() = default;
+
+  using QueueKey = std::pair<int, uint64_t>;
+
+  struct Job {
+    JobId id;
+    Callback work;
+    Callback on_complete;
+    const void* owner;
+  };
+
+  struct Completion {
+    const void* owner;
+    Callback callback;
+  };
+
+  void StopWorkers();
+  void WorkerLoop();
+
+  // Held by Start and Stop, so concurrent first submits start one pool.
+  std::mutex start_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cond_, done_cond_;
+
+  bool run_ = false;
+  JobId next_id_ = 1;
+  uint64_t sequence_ = 0;
+
+  ct::tree_map<QueueKey, Job> queue_;
+  ct::hash_map<JobId, QueueKey> queued_;
+  ct::hash_map<JobId, const void*> running_;
+  ct::dyn_array<Completion> completed_;
+
+  ct::dyn_array<std::thread> workers_;
+};
+}  // namespace lib_core
+
+static auto& g_loader_pool = lib_core::LoaderPool::get();
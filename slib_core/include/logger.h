@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "core_utilities.h"
+
+namespace lib_core {
+class Logger {
+ public:
+  enum Severity { kInfo = 0, kWarning, kError };
+
+  static constexpr size_t kMessageSize = 192;
+  static constexpr size_t kRecordsPerThread = 512;
+  static constexpr size_t kMaxThreads = 64;
+  static constexpr size_t kRateSlots = 256;
+
+  struct Record {
+    Severity severity;
+    uint32_t line;
+    uint32_t suppressed;
+    int64_t time;
+    const char* file;
+    std::array<char, kMessageSize> message;
+  };
+
+  static Logger& get();
+
+  // Never blocks or allocates once the calling thread has its buffer, records
+  // are dropped when the buffer is full or the call site exceeds its rate.
+  // A buffer goes back to the pool when its thread exits. Threads beyond
+  // kMaxThreads share one overflow buffer behind a lock.
+  void Log(Severity severity, const char* message, const char* file = "",
+           int line = -1);
+
+  // Blocks until everything logged so far has been appended to disk.
+  void Flush();
+
+  void SetOutput(const ct::string& dest_path);
+  void SetMinSeverity(Severity severity);
+  void SetRateLimit(uint32_t messages_per_second);
+
+  size_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  size_t Suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+  }
+  size_t Overflowed() const {
+    return overflowed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Logger();
+  ~Logger();
+
+  // Single producer single consumer ring owned by one thread.
+  struct ThreadBuffer {
+    std::atomic<uint64_t> head = {0};
+    std::atomic<uint64_t> tail = {0};
+    std::atomic<bool> owned = {false};
+    std::array<Record, kRecordsPerThread> records;
+  };
+
+  struct RateSlot {
+    std::atomic<uint64_t> site = {0};
+    std::atomic<int64_t> window = {0};
+    std::atomic<uint32_t> count = {0};
+    std::atomic<uint32_t> suppressed = {0};
+  };
+
+  ThreadBuffer* LocalBuffer();
+  bool Push(ThreadBuffer& buffer, Severity severity, const char* message,
+            const char* file, int line, int64_t now, uint32_t suppressed);
+  bool Admit(const char* file, int line, int64_t now, uint32_t& suppressed);
+  size_t Drain();
+  void FlushThread();
+
+  std::atomic<bool> run_ = {true};
+  std::atomic<int> min_severity_ = {kInfo};
+  std::atomic<uint32_t> rate_limit_ = {20};
+  std::atomic<size_t> dropped_ = {0}, suppressed_ = {0}, overflowed_ = {0};
+  std::atomic<size_t> buffer_count_ = {0};
+  size_t reported_dropped_ = 0, reported_overflowed_ = 0;
+
+  std::array<std::unique_ptr<ThreadBuffer>, kMaxThreads> buffers_;
+  std::array<RateSlot, kRateSlots> rate_slots_;
+  ThreadBuffer overflow_;
+  std::mutex overflow_mutex_;
+
+  std::mutex registry_mutex_;
+  std::mutex flush_mutex_;
+  std::condition_variable flush_cv_;
+
+  ct::string dest_path_ = "./logfile.txt";
+  std::ofstream out_;
+  std::thread flush_thread_;
+};
+}  // namespace lib_core
+
+static auto& g_logger = lib_core::Logger::get();
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+#include "core_utilities.h"
+
+namespace lib_core {
+class MemoryTracker {
+ public:
+  enum Tag {
+    kEcsComponents = 0,
+    kMeshSource,
+    kTextureSource,
+    kSoundData,
+    kPhysics,
+    kParticles,
+    kTagCount
+  };
+
+  struct Stats {
+    size_t current = 0, high_water = 0;
+    size_t allocations = 0, frees = 0;
+  };
+
+  static MemoryTracker& get();
+
+  void Allocated(Tag tag, size_t bytes) {
+    if (bytes == 0) return;
+    auto& c = counters_[tag];
+    auto current =
+        c.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+    auto high = c.high_water.load(std::memory_order_relaxed);
+    while (current > high && !c.high_water.compare_exchange_weak(
+                                 high, current, std::memory_order_relaxed))
+      ;
+  }
+
+  void Freed(Tag tag, size_t bytes) {
+    if (bytes == 0) return;
+    auto& c = counters_[tag];
+    c.current.fetch_sub(bytes, std::memory_order_relaxed);
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t Current(Tag tag) const;
+  size_t HighWater(Tag tag) const;
+  size_t Total() const;
+  Stats GetStats(Tag tag) const;
+
+  void ResetHighWater();
+  void Dump(const ct::string& dest_path) const;
+  ct::string Summary(Tag tag) const;
+
+  static const char* TagName(Tag tag);
+
+ private:
+  MemoryTracker() = default;
+
+  struct Counters {
+    std::atomic<size_t> current = {0}, high_water = {0};
+    std::atomic<size_t> allocations = {0}, frees = {0};
+  };
+  std::array<Counters, kTagCount> counters_;
+};
+
+class Allocator {
+ public:
+  virtual ~Allocator() = default;
+
+  virtual void* Allocate(size_t size, size_t alignment) = 0;
+  virtual void Deallocate(void* ptr, size_t size, size_t alignment) = 0;
+};
+
+class HeapAllocator : public Allocator {
+ public:
+  static HeapAllocator& get();
+
+  void* Allocate(size_t size, size_t alignment) override;
+  void Deallocate(void* ptr, size_t size, size_t alignment) override;
+};
+
+// Forwards to the upstream allocator and charges every byte to a tag.
+class TrackingAllocator : public Allocator {
+ public:
+  explicit TrackingAllocator(MemoryTracker::Tag tag,
+                             Allocator* upstream = &HeapAllocator::get())
+      : tag_(tag), upstream_(upstream) {}
+
+  void* Allocate(size_t size, size_t alignment) override;
+  void Deallocate(void* ptr, size_t size, size_t alignment) override;
+
+  MemoryTracker::Tag GetTag() const { return tag_; }
+
+ private:
+  MemoryTracker::Tag tag_;
+  Allocator* upstream_;
+};
+}  // namespace lib_core
+
+static auto& g_mem_tracker = lib_core::MemoryTracker::get();
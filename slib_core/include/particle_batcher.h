@@ -0,0 +1,63 @@
+#pragma once
+#include "core_utilities.h"
+#include "matrix4x4.h"
+#include "particle_simulator.h"
+
+namespace lib_core {
+// Packs simulated particles for drawing from one view. Emitters sharing a
+// blend mode and texture end up in one batch, and alpha blended batches are
+// radix sorted back to front. Nothing here touches a graphics API, so the sort
+// and pack stages can be driven and timed without a context.
+class ParticleBatcher {
+ public:
+  enum Blend : uint32_t { kAdditive, kAlpha };
+
+  struct Emitter {
+    size_t id;
+    Blend blend;
+    size_t texture;
+  };
+
+  struct Batch {
+    Blend blend;
+    size_t texture;
+    size_t first, count;
+  };
+
+  struct View {
+    ct::dyn_array<ParticleSimulator::Instance> instances;
+    ct::dyn_array<Batch> batches;
+  };
+
+  // Batches come out ordered by blend mode, then texture. Emitters missing
+  // from particles, or without live particles, are skipped.
+  void Build(const ParticleSimulator::Output& particles,
+             const ct::dyn_array<Emitter>& emitters, const Matrix4x4& view,
+             View& out);
+
+  // Unsigned order of the result matches float order.
+  static uint32_t FloatKey(float value);
+  // Stable least significant digit sort on the upper 32 bits of keys, bytes
+  // that are the same for every key are skipped. scratch holds count keys.
+  static void RadixSort(uint64_t* keys, uint64_t* scratch, size_t count);
+
+ private:
+  void Sort(const ParticleSimulator::Output& particles,
+            const ct::dyn_array<Emitter>& emitters, const Matrix4x4& view,
+            View& out);
+  void Pack(const ParticleSimulator::Output& particles, View& out);
+
+  // A contiguous run of one emitter's particles, source and target are
+  // offsets into the simulator output and the packed view.
+  struct Run {
+    size_t source, target, count;
+    bool sorted;
+  };
+
+  ct::dyn_array<size_t> order_;
+  ct::dyn_array<Run> runs_;
+  // First run of every batch, then one past the last run.
+  ct::dyn_array<size_t> batch_runs_;
+  ct::dyn_array<uint64_t> keys_, scratch_;
+};
+}  // namespace lib_core
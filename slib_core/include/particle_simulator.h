@@ -0,0 +1,106 @@
+#pragma once
+#include <memory>
+#include "core_utilities.h"
+#include "struct_of_arrays.hpp"
+#include "vector_def.h"
+
+namespace lib_core {
+// Emits and ages particles on the CPU, one structure of arrays ring per
+// emitter. Emitters are stepped in parallel and every live particle comes out
+// as one evaluated instance, so a renderer only has to copy them.
+class ParticleSimulator {
+ public:
+  enum Shape { kPoint, kCircle, kSquare, kSphere, kCube };
+
+  struct EmitterDesc {
+    Shape shape = kPoint;
+    bool loop = true;
+    size_t max_particles = 500;
+
+    float particle_life = 2.f;
+    // Scales how much faster than particle_life a particle may age.
+    float life_randomness = .4f;
+    float emitting_speed = 1.f;
+    float end_velocity = 5.f;
+    float center_velocity = .01f;
+    Vector4 type_data{0.f};
+    Vector4 random_scale{.1f};
+    Vector3 start_velocity{0.f};
+    Vector3 gravity{0.f};
+
+    Vector4 start_color{1.f};
+    Vector4 end_color{0.f};
+    Vector2 start_size{.5f, 1.f};
+    Vector2 end_size{1.f, 2.f};
+    Vector2 rotate_speed{.1f, .5f};
+  };
+
+  // One emitter at its current time, new particles start at origin.
+  struct EmitterFrame {
+    size_t id;
+    EmitterDesc desc;
+    Vector3 origin;
+    float time;
+  };
+
+  // Three vec4 in std430 storage buffers. The vertex shader takes the sine
+  // and cosine of rotation.
+  struct Instance {
+    float position[3], size;
+    float color[4];
+    float rotation, pad[3];
+  };
+
+  struct Output {
+    ct::dyn_array<Instance> instances;
+    // First instance and count per emitter id.
+    ct::hash_map<size_t, std::pair<size_t, size_t>> ranges;
+  };
+
+  explicit ParticleSimulator(uint64_t seed = 0);
+  ~ParticleSimulator();
+  ParticleSimulator(const ParticleSimulator&) = delete;
+  ParticleSimulator& operator=(const ParticleSimulator&) = delete;
+
+  // Counter based random number in [0, 1), the same for the same inputs.
+  static float Random(uint64_t key, uint64_t counter);
+
+  // Steps every emitter to its frame time and writes the live particles.
+  // Pools of emitters missing from frames are released.
+  void Update(const ct::dyn_array<EmitterFrame>& frames, Output& out);
+
+  size_t EmitterCount() const { return pools_.size(); }
+
+ private:
+  // Position, unit direction, speed, birth time and the four per particle
+  // random values. Velocity never changes, so its length is kept rather than
+  // taken again every frame.
+  using Particles = struct_of_arrays<float, float, float, float, float, float,
+                                     float, float, float, float, float, float>;
+  enum { kPx, kPy, kPz, kDx, kDy, kDz, kSpeed, kBirth, kR0, kR1, kR2, kR3 };
+
+  // Columns hold capacity particles as a ring, the live ones start at head
+  // and are in birth order.
+  struct Pool {
+    Particles particles;
+    size_t capacity = 0, head = 0, count = 0;
+    float delta_rest = 0.f, last_time = 0.f;
+    size_t emitted = 0;
+    uint64_t key, counter = 0;
+    size_t first = 0, frame = 0;
+  };
+
+  static void Emit(Pool& pool, const EmitterFrame& frame);
+  static void Retire(Pool& pool, const EmitterFrame& frame);
+  static void Evaluate(const Pool& pool, const EmitterFrame& frame,
+                       Instance* out);
+  static void EvaluateRange(const Pool& pool, const EmitterFrame& frame,
+                            size_t first, size_t count, Instance* out);
+  void Release(Pool& pool);
+
+  uint64_t seed_;
+  size_t frame_ = 0;
+  ct::hash_map<size_t, std::unique_ptr<Pool>> pools_;
+  ct::dyn_array<Pool*> active_;
+};
+}  // namespace lib_core
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "core_utilities.h"
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Scoped zone, name must be a string literal (or otherwise outlive the
+// profiler) since only the pointer is recorded.
+#define PROFILE_ZONE(name) \
+  lib_core::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME(name) g_profiler.FrameMark(name)
+
+namespace lib_core {
+class Profiler {
+ public:
+  struct Event {
+    const char* name;
+    int64_t start;
+    int64_t end;
+    uint32_t depth;
+    bool frame_mark;
+  };
+
+  struct ZoneStats {
+    ct::string name;
+    size_t count;
+    float min, avg, max, p99;
+  };
+
+  // Single producer ring, only the owning thread writes and bumps head.
+  struct ThreadBuffer {
+    uint32_t tid = 0;
+    uint32_t depth = 0;
+    ct::string name;
+    std::atomic<uint64_t> head = {0};
+    std::array<Event, 1 << 14> events;
+  };
+
+  static Profiler& get();
+
+  void SetEnabled(bool enabled);
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void SetThreadName(const char* name);
+  void FrameMark(const char* name);
+
+  ThreadBuffer& LocalBuffer();
+  int64_t Now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::high_resolution_clock::now() - epoch_)
+        .count();
+  }
+
+  static void Record(ThreadBuffer& buffer, const Event& event) {
+    auto head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head & (buffer.events.size() - 1)] = event;
+    buffer.head.store(head + 1, std::memory_order_release);
+  }
+
+  // Snapshot and export are meant to run while producers are quiet (end of
+  // session), events overwritten mid read are not guarded against.
+  ct::dyn_array<std::pair<uint32_t, Event>> Snapshot() const;
+  ct::dyn_array<ZoneStats> Aggregate() const;
+  void ExportChromeTrace(const ct::string& dest_path) const;
+
+ private:
+  Profiler();
+  ~Profiler() = default;
+
+  std::atomic<bool> enabled_ = {true};
+  std::chrono::time_point<std::chrono::high_resolution_clock> epoch_;
+
+  mutable std::mutex registry_mutex_;
+  ct::dyn_array<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+class ProfileZone {
+ public:
+  explicit ProfileZone(const char* name) : name_(name) {
+    auto& profiler = Profiler::get();
+    if (!profiler.Enabled()) return;
+    buffer_ = &profiler.LocalBuffer();
+    ++buffer_->depth;
+    start_ = profiler.Now();
+  }
+
+  ~ProfileZone() {
+    if (!buffer_) return;
+    auto end = Profiler::get().Now();
+    --buffer_->depth;
+    Profiler::Record(*buffer_, {name_, start_, end, buffer_->depth, false});
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+ private:
+  const char* name_;
+  int64_t start_ = 0;
+  Profiler::ThreadBuffer* buffer_ = nullptr;
+};
+}  // namespace lib_core
+
+static auto& g_profiler = lib_core::Profiler::get();
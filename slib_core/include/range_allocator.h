@@ -0,0 +1,29 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// First fit allocator over a range of abstract units, used to carve shared
+// GPU buffers into per resource slices. Freed slices merge with their free
+// neighbours so the range does not fragment into slivers.
+class RangeAllocator {
+ public:
+  static constexpr size_t kInvalid = ~size_t(0);
+
+  explicit RangeAllocator(size_t capacity = 0);
+
+  // Returns the offset of size free units, kInvalid when none are left.
+  size_t Allocate(size_t size);
+  void Free(size_t offset, size_t size);
+
+  // Raising the capacity keeps every allocation valid.
+  void Grow(size_t capacity);
+  void Reset();
+
+  size_t Capacity() const { return capacity_; }
+  size_t Used() const { return used_; }
+
+ private:
+  size_t capacity_, used_ = 0;
+  ct::tree_map<size_t, size_t> free_;  // offset -> size
+};
+}  // namespace lib_core
@@ -0,0 +1,124 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Receives the commands of a RenderCommandList on replay. Implemented once
+// per graphics API, and by tests to capture what a frame would submit.
+class RenderBackend {
+ public:
+  virtual ~RenderBackend() = default;
+
+  virtual void SetState(uint32_t state) = 0;
+  // light is RenderCommandList::kNoLight unless the material samples the
+  // shadow maps of one light.
+  virtual void BindMaterial(size_t material, size_t light) = 0;
+  virtual void BindBuffer(uint32_t slot, size_t buffer, size_t offset,
+                          size_t size) = 0;
+  virtual void SetConstants(uint32_t slot, const float* data,
+                            size_t count) = 0;
+  virtual void SetTarget(size_t target, uint32_t clear) = 0;
+  virtual void Draw(size_t mesh, size_t first_instance,
+                    size_t instance_count) = 0;
+  virtual void Dispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+};
+
+// API agnostic recording of a pass. Commands carry a sort key, Sort orders
+// them by it and keeps recording order among equal keys, so a bind recorded
+// ahead of its draws stays ahead of them. Lists recorded on separate threads
+// are joined with Append.
+class RenderCommandList {
+ public:
+  enum Type : uint8_t {
+    kState,
+    kBindMaterial,
+    kBindBuffer,
+    kConstants,
+    kTarget,
+    kDraw,
+    kDispatch
+  };
+
+  // Bits of a kState command.
+  enum StateBits : uint32_t {
+    kDepthTest = 1 << 0,
+    kDepthWrite = 1 << 1,
+    kBlendAlpha = 1 << 2,
+    kBlendAdditive = 1 << 3,
+    kCullBack = 1 << 4,
+    // Plain sum of source and destination, used to accumulate lights.
+    kBlendOne = 1 << 5,
+    // Consecutive draws may go out as one indirect submission, shaders then
+    // read their instance offset from the base instance.
+    kMergeDraws = 1 << 6,
+  };
+
+  // Bits of a kTarget command.
+  enum ClearBits : uint32_t {
+    kClearColor = 1 << 0,
+    kClearDepth = 1 << 1,
+    kClearStencil = 1 << 2,
+  };
+
+  // Target of the view the list is replayed into.
+  static constexpr size_t kViewTarget = ~size_t(0);
+  static constexpr size_t kNoLight = ~size_t(0);
+  // Draw mesh of a single triangle covering the screen.
+  static constexpr size_t kScreenTriangle = ~size_t(0);
+
+  // Fields a type does not use are zero. resource is the state bits, the
+  // material, the buffer, the target or the mesh. slot is the binding of a
+  // buffer or constant and the clear bits of a target. first and count are
+  // the instance range of a draw, the byte range of a buffer bind, the range
+  // of a constant's floats, or x and y of a dispatch. A material bind keeps
+  // its light in first.
+  struct Command {
+    uint64_t key;
+    Type type;
+    uint32_t slot;
+    size_t resource;
+    size_t first, count;
+    uint32_t z;
+  };
+
+  struct Stats {
+    size_t commands = 0, draws = 0, instances = 0, dispatches = 0;
+    // State changes and binds that repeated the current one and were skipped.
+    size_t redundant = 0;
+  };
+
+  // Pass in the top byte, then a 24 bit order inside the pass, then the
+  // material, so draws group by material within one order.
+  static uint64_t Key(uint8_t pass, uint32_t order, uint32_t material);
+
+  void SetState(uint64_t key, uint32_t state);
+  void BindMaterial(uint64_t key, size_t material, size_t light = kNoLight);
+  void BindBuffer(uint64_t key, uint32_t slot, size_t buffer, size_t offset,
+                  size_t size);
+  // The floats are copied into the list, so it can be replayed after the
+  // source is gone. They apply to the material bound when replayed.
+  void SetConstants(uint64_t key, uint32_t slot, const float* data,
+                    size_t count);
+  // Draws after it go to target until the next one, cleared first.
+  void SetTarget(uint64_t key, size_t target, uint32_t clear = 0);
+  void Draw(uint64_t key, size_t mesh, size_t first_instance,
+            size_t instance_count);
+  void Dispatch(uint64_t key, uint32_t x, uint32_t y, uint32_t z);
+
+  void Append(const RenderCommandList& list);
+  void Sort();
+  void Clear() { commands_.clear(), constants_.clear(); }
+
+  // Submits the commands in their current order. State changes and material
+  // binds matching the previous one are skipped, a bind only matches with
+  // the same light.
+  Stats Replay(RenderBackend& backend) const;
+
+  const ct::dyn_array<Command>& Commands() const { return commands_; }
+  const ct::dyn_array<float>& Constants() const { return constants_; }
+  bool Empty() const { return commands_.empty(); }
+
+ private:
+  ct::dyn_array<Command> commands_;
+  ct::dyn_array<float> constants_;
+};
+}  // namespace lib_core
@@ -0,0 +1,88 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Hands out cached shadow map slots in resolution tiers and decides which
+// lights get their maps redrawn this frame. Maps are only redrawn when
+// invalidated, lights close to the camera right away and the rest in turns
+// under a per frame budget, stalest first.
+class ShadowAtlas {
+ public:
+  static constexpr int kNoTier = -1;
+  // A tier change only takes after being requested this many frames in a
+  // row, so lights near a coverage threshold don't keep moving.
+  static constexpr size_t kTierDelay = 8;
+
+  struct Request {
+    size_t light;
+    int tier;
+    bool urgent;
+  };
+
+  // tier is kNoTier when every slot that could take the light is in use
+  // this frame. render is set for lights whose map must be drawn now.
+  struct Placement {
+    size_t light;
+    int tier;
+    size_t slot;
+    bool render;
+  };
+
+  // slots[i] is how many maps tier i holds, tier 0 being the finest.
+  ShadowAtlas(ct::dyn_array<size_t> slots, size_t budget);
+
+  // Coarser tiers for lights covering less of the screen, halving per tier
+  // below half the screen height.
+  static int TierForCoverage(float coverage, int tiers);
+
+  // Starts a rendered frame, every view of the frame updates after it.
+  void BeginFrame();
+  // The light is gone, its slot is freed and its state dropped.
+  void Remove(size_t light);
+
+  // Something in the light volume changed, the map is redrawn when the
+  // budget allows.
+  void Invalidate(size_t light);
+  // The map contents are gone, it is redrawn the next time it is used.
+  void Discard(size_t light);
+
+  // Places every light requested this frame, finest tiers first. Lights that
+  // find no free slot take the least recently used one of a light not
+  // requested this frame, or drop to a coarser tier. A light changing tier
+  // keeps its slot until one in the new tier frees up. Placements come out in
+  // request order, and the caller is expected to draw those with render set.
+  // Views updating within one frame share its budget, and tier changes count
+  // frames rather than updates.
+  void Update(const ct::dyn_array<Request>& requests,
+              ct::dyn_array<Placement>& out);
+
+  size_t Budget() const { return budget_; }
+  void SetBudget(size_t budget) { budget_ = budget; }
+
+ private:
+  static constexpr size_t kFree = ~size_t(0);
+
+  struct Entry {
+    int tier = kNoTier;
+    size_t slot = 0;
+    int pending_tier = kNoTier;
+    size_t pending_frames = 0;
+    uint64_t last_used = 0, last_render = 0;
+    bool dirty = true, valid = false;
+    // First request of the light this frame, tier changes count these.
+    bool fresh = false;
+  };
+
+  void Release(Entry& entry);
+  bool Acquire(size_t light, Entry& entry, int tier);
+
+  size_t budget_;
+  uint64_t frame_ = 0;
+  // Budgeted redraws handed out this frame.
+  size_t spent_ = 0;
+  // Owning light per slot and tier, kFree when unused.
+  ct::dyn_array<ct::dyn_array<size_t>> owners_;
+  ct::hash_map<size_t, Entry> entries_;
+  ct::dyn_array<size_t> order_, candidates_;
+};
+}  // namespace lib_core
@@ -0,0 +1,34 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Bottom-left skyline rectangle packer. Keeps the top edge of everything
+// placed so far as a list of horizontal segments and drops each new rect on
+// the lowest segment run it fits on.
+class SkylinePacker {
+ public:
+  SkylinePacker(int width, int height);
+
+  // Returns false and leaves x, y untouched when the rect does not fit.
+  bool Pack(int width, int height, int& x, int& y);
+
+  // Raising the height keeps every placed rect valid.
+  void Grow(int height);
+  void Reset();
+
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+
+ private:
+  struct Segment {
+    int x, y, width;
+  };
+
+  // Lowest y a rect of the given width can rest at starting on segment i, or
+  // -1 when it runs off the right edge.
+  int Fit(size_t i, int width) const;
+
+  int width_, height_;
+  ct::dyn_array<Segment> skyline_;
+};
+}  // namespace lib_core
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+namespace lib_core {
+template <typename T>
+struct Span {
+  T* data = nullptr;
+  size_t size = 0;
+
+  T* begin() const { return data; }
+  T* end() const { return data + size; }
+  T& operator[](size_t i) const { return data[i]; }
+  bool empty() const { return size == 0; }
+};
+}  // namespace lib_core
@@ -1,5 +1,6 @@
 #pragma once
 #include "entity.h"
+#include "frame_arena.h"
 #include "unit.h"
 
 namespace lib_graphics {
@@ -33,11 +34,10 @@ class System : public Unit {
   void SetUpdate(bool update) { update_ = update; }
 
  protected:
+  // Valid until the current LogicUpdate or DrawUpdate returns.
   template <typename T>
   T& Ts() {
-    for (int i = 0; i < sizeof(T); ++i) temporary_memory_.push_back(0);
-    return *reinterpret_cast<T*>(
-        &temporary_memory_[temporary_memory_.size() - sizeof(T)]);
+    return *FrameArena::Local().Alloc<T>();
   }
 
  private:
@@ -47,8 +47,6 @@ class System : public Unit {
   bool draw_ = true;
   bool update_ = true;
 
-  ct::dyn_array<uint8_t> temporary_memory_;
-
   friend class SystemManager;
 };
 }  // namespace lib_core
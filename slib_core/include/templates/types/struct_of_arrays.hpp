@@ -10,84 +10,54 @@ class struct_of_arrays {
   }
 
   template <size_t I>
-  size_t size() const {
-    return std::get<I>(arrays_).size();
+  auto& get() {
+    return std::get<I>(arrays_);
   }
 
-  void emplace_back(Types... vals) {
-    emplace_back_rec(std::make_tuple(vals...));
+  template <size_t I>
+  const auto& get() const {
+    return std::get<I>(arrays_);
   }
-  void pop_back() { pop_back_rec(arrays_); }
-  void shrink_to_size() { shrink_to_size_rec(arrays_); }
-  void erase(size_t i) { erase_rec(i, arrays_); }
-  void reserve(size_t nr) { reserve_rec(nr, arrays_); }
-  void clear() { clear_rec(arrays_); }
 
- private:
-  std::tuple<ct::dyn_array<Types>...> arrays_;
-
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type
-  emplace_back_rec(std::tuple<funcTypes...>&) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type emplace_back_rec(
-          std::tuple<funcTypes...>& t) {
-    std::get<I>(arrays_).emplace_back(std::move(std::get<I>(t)));
-    emplace_back_rec<I + 1, funcTypes...>(t);
+  template <size_t I>
+  size_t size() const {
+    return std::get<I>(arrays_).size();
   }
 
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type
-  pop_back_rec(std::tuple<funcTypes...>&) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type pop_back_rec(std::tuple<funcTypes...>& t) {
-    std::get<I>(t).pop_back();
-    pop_back_rec<I + 1, Types...>(t);
-  }
+  size_t size() const { return std::get<0>(arrays_).size(); }
 
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type erase_rec(
-      size_t i, std::tuple<funcTypes...>& t) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type erase_rec(size_t i,
-                                                std::tuple<funcTypes...>& t) {
-    auto& a = std::get<I>(t);
-    a.erase(a.begin() + i);
-    erase_rec<I + 1, funcTypes...>(i, t);
+  // Calls f on every array in turn, for per column passes like compaction.
+  template <typename F>
+  void for_each_array(F&& f) {
+    std::apply([&](auto&... arrays) { (f(arrays), ...); }, arrays_);
   }
 
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type
-  reserver_rec(size_t i, std::tuple<funcTypes...>& t) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type reserver_rec(size_t i,
-                                                   std::tuple<funcTypes...>& t) {
-    std::get<I>(t).reserve(i);
-    reserver_rec<I + 1, funcTypes...>(i, t);
+  void emplace_back(Types... vals) {
+    std::apply([&](auto&... arrays) { (arrays.emplace_back(vals), ...); },
+               arrays_);
   }
-
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type
-  shrink_to_size_rec(std::tuple<funcTypes...>&) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type shrink_to_size_rec(
-          std::tuple<funcTypes...>& t) {
-    std::get<I>(t).shrink_to_size();
-    shrink_to_size_rec<I + 1, funcTypes...>(t);
+  void assign(size_t i, Types... vals) {
+    std::apply([&](auto&... arrays) { ((arrays[i] = vals), ...); }, arrays_);
   }
-
-  template <std::size_t I = 0, typename... funcTypes>
-  inline typename std::enable_if<I == sizeof...(funcTypes), void>::type clear_rec(
-      std::tuple<funcTypes...>&) {}
-  template <std::size_t I = 0, typename... funcTypes>
-      inline typename std::enable_if <
-      I<sizeof...(funcTypes), void>::type clear_rec(std::tuple<funcTypes...>& t) {
-    std::get<I>(t).clear();
-    clear_rec<I + 1, funcTypes...>(t);
+  void pop_back() {
+    for_each_array([](auto& array) { array.pop_back(); });
+  }
+  void shrink_to_size() {
+    for_each_array([](auto& array) { array.shrink_to_fit(); });
+  }
+  void erase(size_t i) {
+    for_each_array([i](auto& array) { array.erase(array.begin() + i); });
   }
+  void reserve(size_t nr) {
+    for_each_array([nr](auto& array) { array.reserve(nr); });
+  }
+  void resize(size_t nr) {
+    for_each_array([nr](auto& array) { array.resize(nr); });
+  }
+  void clear() {
+    for_each_array([](auto& array) { array.clear(); });
+  }
+
+ private:
+  std::tuple<ct::dyn_array<Types>...> arrays_;
 };
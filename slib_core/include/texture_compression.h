@@ -0,0 +1,45 @@
+#pragma once
+#include "core_utilities.h"
+
+namespace lib_core {
+// Offline mip generation and BCn block compression for cooked textures. A
+// cooked texture stores every level of its mip chain back to back, largest
+// first, each in the layout glCompressedTexImage2D expects. Decode only has to
+// understand the block modes Encode writes and is used to verify the encoder.
+class TextureCompression {
+ public:
+  enum Format : uint32_t {
+    kRaw = 0,
+    kBc1,
+    kBc3,
+    kBc4,
+    kBc5,
+    kBc7,
+    kFormatCount
+  };
+  enum MipFilter { kLinear, kSrgb, kNormal };
+
+  using Level = ct::dyn_array<uint8_t>;
+
+  // Every returned level is RGBA8. Source channels fill r, g, b, a in order,
+  // missing color channels read as zero and missing alpha as opaque.
+  static ct::dyn_array<Level> BuildMips(const uint8_t* image, size_t channels,
+                                        size_t width, size_t height,
+                                        MipFilter filter);
+
+  // Appends one RGBA8 level to out. kRaw keeps the first channels bytes of
+  // every texel.
+  static void Encode(Format format, const uint8_t* rgba, size_t width,
+                     size_t height, size_t channels,
+                     ct::dyn_array<uint8_t>& out);
+  static void Decode(Format format, const uint8_t* data, size_t width,
+                     size_t height, size_t channels, uint8_t* rgba);
+
+  static uint32_t MipCount(size_t width, size_t height);
+  static size_t LevelDim(size_t dim, uint32_t level);
+  static size_t LevelSize(Format format, size_t width, size_t height,
+                          size_t channels);
+
+  static const char* Name(Format format);
+};
+}  // namespace lib_core
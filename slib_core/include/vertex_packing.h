@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include "core_utilities.h"
+
+namespace lib_core {
+// 20 byte GPU layout shared by the cooker and the renderer. Positions are
+// snorm16 relative to the mesh bounds (center + extent * position), normal
+// and tangent are octahedral snorm16 and texcoords are half floats.
+// position[3] is padding.
+struct PackedVertex {
+  std::array<int16_t, 4> position;
+  std::array<int16_t, 2> normal;
+  std::array<int16_t, 2> tangent;
+  std::array<uint16_t, 2> texcoord;
+};
+
+// Written ahead of the vertices of every cooked mesh level.
+enum VertexFormat : uint32_t { kFloatVertex = 0, kPackedVertex = 1 };
+
+// Scalar conversions behind the compact mesh vertex layout: snorm16 positions
+// relative to the mesh bounds, octahedral unit vectors and half float UVs.
+class VertexPacking {
+ public:
+  static PackedVertex Pack(const float* position, const float* normal,
+                           const float* tangent, const float* texcoord,
+                           const float* center, const float* extent);
+  static std::array<float, 3> UnpackPosition(const PackedVertex& vertex,
+                                             const float* center,
+                                             const float* extent);
+
+  static int16_t ToSnorm16(float v);
+  static float FromSnorm16(int16_t v);
+
+  static std::array<int16_t, 2> OctEncode(const float* n);
+  static std::array<float, 3> OctDecode(const std::array<int16_t, 2>& e);
+
+  static uint16_t ToHalf(float v);
+  static float FromHalf(uint16_t h);
+};
+}  // namespace lib_core
@@ -0,0 +1,279 @@
+#include "asset_pack.h"
+#include <algorithm>
+#include <fstream>
+
+#ifdef WindowsBuild
+#define NOMINMAX
+#include <windows.h>
+#elif UnixBuild
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lib_core {
+AssetPack::~AssetPack() { Close(); }
+
+bool AssetPack::Open(const ct::string& path) {
+  Close();
+
+#ifdef WindowsBuild
+  auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                          OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER file_size;
+  GetFileSizeEx(file, &file_size);
+  auto mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file, mapping_ = mapping;
+  size_ = size_t(file_size.QuadPart);
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#elif UnixBuild
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size_ = size_t(file_stat.st_size);
+  auto ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  data_ = ptr == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(ptr);
+#endif
+
+  if (!data_ || size_ < sizeof(PackHeader)) {
+    Close();
+    return false;
+  }
+
+  header_ = reinterpret_cast<const PackHeader*>(data_);
+  auto toc_end = sizeof(PackHeader) + header_->entry_count * sizeof(PackEntry);
+  if (header_->magic != kMagic || header_->version != kVersion ||
+      toc_end > size_ || header_->names_offset < toc_end ||
+      header_->names_offset + header_->names_size > size_) {
+    cu::Log("Invalid or outdated asset pack: " + path, __FILE__, __LINE__);
+    Close();
+    return false;
+  }
+
+  entries_ = reinterpret_cast<const PackEntry*>(data_ + sizeof(PackHeader));
+  names_ = reinterpret_cast<const char*>(data_ + header_->names_offset);
+  return true;
+}
+
+void AssetPack::Close() {
+#ifdef WindowsBuild
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_) CloseHandle(file_);
+  file_ = mapping_ = nullptr;
+#elif UnixBuild
+  if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+  data_ = nullptr, size_ = 0;
+  header_ = nullptr, entries_ = nullptr, names_ = nullptr;
+}
+
+std::string_view AssetPack::Name(const PackEntry& entry) const {
+  if (entry.name_offset + entry.name_length > header_->names_size) return {};
+  return std::string_view(names_ + entry.name_offset, entry.name_length);
+}
+
+const PackEntry* AssetPack::Find(std::string_view name) const {
+  if (!IsOpen()) return nullptr;
+
+  auto hash = HashName(name);
+  auto end = entries_ + header_->entry_count;
+  auto it = std::lower_bound(
+      entries_, end, hash,
+      [](const PackEntry& e, uint64_t h) { return e.name_hash < h; });
+  for (; it != end && it->name_hash == hash; ++it)
+    if (Name(*it) == name) return it;
+  return nullptr;
+}
+
+PackBlob AssetPack::Blob(const PackEntry& entry) const {
+  if (entry.offset + entry.size > size_) return {};
+
+  PackBlob blob;
+  blob.data = {data_ + entry.offset, size_t(entry.size)};
+  blob.raw_size = size_t(entry.raw_size);
+  blob.codec = Codec::Type(entry.codec);
+  return blob;
+}
+
+bool PackBlob::Unpack(ct::dyn_array<uint8_t>& out_data) const {
+  out_data.resize(raw_size);
+  if (Codec::Decompress(codec, data.data, data.size, out_data.data(),
+                        out_data.size()))
+    return true;
+
+  cu::Log(ct::string("Failed to decode ") + Codec::Name(codec) + " blob",
+          __FILE__, __LINE__);
+  out_data.clear();
+  return false;
+}
+
+uint64_t AssetPack::HashName(std::string_view name) {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : name) {
+    hash ^= uint8_t(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+namespace {
+uint64_t AlignBlob(uint64_t offset) {
+  return (offset + AssetPack::kBlobAlignment - 1) &
+         ~uint64_t(AssetPack::kBlobAlignment - 1);
+}
+
+ct::string StripDirectory(const ct::string& name) {
+  return name.substr(name.find_last_of("/\\") + 1);
+}
+}  // namespace
+
+void AssetPackWriter::Add(const ct::string& name, ct::dyn_array<uint8_t> blob,
+                          std::array<uint32_t, 4> meta, Codec::Type codec,
+                          size_t raw_size) {
+  items_.push_back({name, meta, codec, raw_size, std::move(blob)});
+}
+
+bool AssetPackWriter::Save(const ct::string& path) {
+  ct::dyn_array<ct::string> names;
+  for (auto& item : items_) names.push_back(item.name);
+  if (!Open(path, names)) return false;
+
+  for (size_t i = 0; i < items_.size(); ++i) {
+    auto& item = items_[i];
+    Write(i, std::move(item.blob), item.meta, item.codec, item.raw_size);
+  }
+  items_.clear();
+  return Close();
+}
+
+bool AssetPackWriter::Open(const ct::string& path,
+                           const ct::dyn_array<ct::string>& names) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  out_ = std::ofstream(path, std::ios::binary);
+  if (out_.fail()) return false;
+
+  names_.clear();
+  uint64_t names_size = 0;
+  for (auto& name : names) {
+    names_.push_back(StripDirectory(name));
+    names_size += names_.back().size();
+  }
+
+  slots_.clear();
+  slots_.resize(names_.size());
+  next_slot_ = 0;
+  failed_ = false;
+
+  // The table of contents is written last, reserve room for all of it.
+  offset_ = AlignBlob(sizeof(PackHeader) + names_.size() * sizeof(PackEntry) +
+                      names_size);
+  ct::dyn_array<char> reserved(offset_, 0);
+  out_.write(reserved.data(), reserved.size());
+  return true;
+}
+
+void AssetPackWriter::Write(size_t slot, ct::dyn_array<uint8_t> blob,
+                            std::array<uint32_t, 4> meta, Codec::Type codec,
+                            size_t raw_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& s = slots_[slot];
+  s.done = true;
+  s.entry.size = blob.size();
+  s.entry.raw_size = codec == Codec::kStore ? blob.size() : raw_size;
+  s.entry.codec = codec;
+  s.entry.meta = meta;
+  s.blob = std::move(blob);
+  Flush();
+}
+
+void AssetPackWriter::Skip(size_t slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  slots_[slot].done = true;
+  slots_[slot].skipped = true;
+  Flush();
+}
+
+void AssetPackWriter::Flush() {
+  const char padding[AssetPack::kBlobAlignment] = {};
+  for (; next_slot_ < slots_.size() && slots_[next_slot_].done; ++next_slot_) {
+    auto& s = slots_[next_slot_];
+    if (s.skipped) continue;
+
+    auto aligned = AlignBlob(offset_);
+    out_.write(padding, aligned - offset_);
+    out_.write(reinterpret_cast<const char*>(s.blob.data()), s.blob.size());
+    s.entry.offset = aligned;
+    offset_ = aligned + s.blob.size();
+
+    s.blob.clear();
+    s.blob.shrink_to_fit();
+  }
+  failed_ |= out_.fail();
+}
+
+bool AssetPackWriter::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (next_slot_ != slots_.size()) {
+    cu::Log("Asset pack closed with unwritten slots", __FILE__, __LINE__);
+    failed_ = true;
+  }
+
+  ct::dyn_array<size_t> order;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (!slots_[i].done || slots_[i].skipped) continue;
+    slots_[i].entry.name_hash = AssetPack::HashName(names_[i]);
+    order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    auto& l = slots_[lhs].entry;
+    auto& r = slots_[rhs].entry;
+    if (l.name_hash != r.name_hash) return l.name_hash < r.name_hash;
+    return names_[lhs] < names_[rhs];
+  });
+
+  PackHeader header;
+  header.magic = AssetPack::kMagic;
+  header.version = AssetPack::kVersion;
+  header.type = type_;
+  header.entry_count = uint32_t(order.size());
+  header.names_offset = sizeof(PackHeader) + order.size() * sizeof(PackEntry);
+  header.names_size = 0;
+
+  ct::dyn_array<PackEntry> entries;
+  for (auto i : order) {
+    auto entry = slots_[i].entry;
+    entry.name_offset = uint32_t(header.names_size);
+    entry.name_length = uint32_t(names_[i].size());
+    header.names_size += entry.name_length;
+    entries.push_back(entry);
+  }
+
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out_.write(reinterpret_cast<const char*>(entries.data()),
+             entries.size() * sizeof(PackEntry));
+  for (auto i : order) out_.write(names_[i].data(), names_[i].size());
+  out_.close();
+
+  auto success = !failed_ && !out_.fail();
+  slots_.clear();
+  names_.clear();
+  return success;
+}
+}  // namespace lib_core
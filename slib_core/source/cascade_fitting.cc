@@ -0,0 +1,68 @@
+#include "cascade_fitting.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lib_core {
+ct::dyn_array<float> CascadeFitting::Splits(float near, float far,
+                                            size_t count, float lambda) {
+  count = std::max<size_t>(count, 1);
+  ct::dyn_array<float> splits(count + 1);
+  splits.front() = near;
+  splits.back() = far;
+  for (size_t i = 1; i < count; ++i) {
+    auto si = float(i) / float(count);
+    auto log_split = near * std::pow(far / near, si);
+    auto uniform_split = near + (far - near) * si;
+    splits[i] = lambda * log_split + (1.f - lambda) * uniform_split;
+  }
+  return splits;
+}
+
+CascadeFitting::Sphere CascadeFitting::SliceSphere(const Vector3& eye,
+                                                   const Vector3& forward,
+                                                   float near, float far,
+                                                   float tan_half_fov,
+                                                   float aspect) {
+  // Corner distance from the view axis per unit of depth, squared.
+  auto k2 = tan_half_fov * tan_half_fov * (1.f + aspect * aspect);
+
+  // The center is as far from the near corners as from the far ones, unless
+  // that puts it beyond the far plane.
+  auto center = .5f * (near + far) * (1.f + k2);
+  float radius;
+  if (center >= far) {
+    center = far;
+    radius = far * std::sqrt(k2);
+  } else {
+    radius = std::sqrt((far - center) * (far - center) + far * far * k2);
+  }
+
+  // Rounded up so float noise can't change the map's texel size.
+  radius = std::ceil(radius * 16.f) / 16.f;
+  return {eye + forward * center, radius};
+}
+
+Matrix4x4 CascadeFitting::LightMatrix(const Sphere& sphere, Vector3 light_dir,
+                                      int resolution, float depth_pad) {
+  light_dir.Normalize();
+  auto up = std::abs(light_dir[1]) > .99f ? Vector3(0.f, 0.f, 1.f)
+                                          : Vector3(0.f, 1.f, 0.f);
+
+  // Looking from the origin keeps light space a pure rotation, so snapping
+  // the center in it moves the map in whole texels of world space.
+  Matrix4x4 view, proj;
+  view.Lookat(Vector3(0.f), light_dir, up);
+  auto center = sphere.center;
+  center.Transform(view);
+
+  auto r = sphere.radius;
+  auto texel = 2.f * r / float(std::max(resolution, 1));
+  auto x = std::floor(center[0] / texel) * texel;
+  auto y = std::floor(center[1] / texel) * texel;
+  auto depth = -center[2];
+
+  proj.Orthographic(x - r, x + r, y - r, y + r, depth - r - depth_pad,
+                    depth + r);
+  return proj * view;
+}
+}  // namespace lib_core
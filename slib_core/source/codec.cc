@@ -0,0 +1,119 @@
+#include "codec.h"
+#include <climits>
+#include <cstring>
+#include <limits>
+#ifdef UnixBuild
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zlib.h>
+#include <zstd.h>
+#elif WindowsBuild
+#include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
+#include <zlib/zlib.h>
+#include <zstd/zstd.h>
+#endif
+
+namespace lib_core {
+namespace {
+// Cooking happens offline so every codec runs at its slow, dense setting,
+// none of them decode any slower for it.
+constexpr int kZlibLevel = Z_BEST_COMPRESSION;
+constexpr int kLz4Level = LZ4HC_CLEVEL_MAX;
+constexpr int kZstdLevel = 19;
+
+// zlib counts in uLong, which is 32 bits on Windows, and LZ4 in int.
+bool FitsZlib(size_t size) { return size <= std::numeric_limits<uLong>::max(); }
+bool FitsLz4(size_t size) { return size <= size_t(INT_MAX); }
+}  // namespace
+
+bool Codec::Compress(Type type, const uint8_t* in_data, size_t in_size,
+                     ct::dyn_array<uint8_t>& out_data) {
+  switch (type) {
+    case kStore:
+      out_data.assign(in_data, in_data + in_size);
+      return true;
+    case kZlib: {
+      if (!FitsZlib(in_size)) return false;
+      auto out_size = compressBound(uLong(in_size));
+      out_data.resize(out_size);
+      auto res = compress2(out_data.data(), &out_size, in_data, uLong(in_size),
+                           kZlibLevel);
+      out_data.resize(res == Z_OK ? out_size : 0);
+      return res == Z_OK;
+    }
+    case kLz4: {
+      if (in_size > size_t(LZ4_MAX_INPUT_SIZE)) return false;
+      out_data.resize(LZ4_compressBound(int(in_size)));
+      auto res = LZ4_compress_HC(reinterpret_cast<const char*>(in_data),
+                                 reinterpret_cast<char*>(out_data.data()),
+                                 int(in_size), int(out_data.size()), kLz4Level);
+      out_data.resize(res > 0 ? size_t(res) : 0);
+      return res > 0;
+    }
+    case kZstd: {
+      out_data.resize(ZSTD_compressBound(in_size));
+      auto res = ZSTD_compress(out_data.data(), out_data.size(), in_data,
+                               in_size, kZstdLevel);
+      out_data.resize(ZSTD_isError(res) ? 0 : res);
+      return !ZSTD_isError(res);
+    }
+    default:
+      return false;
+  }
+}
+
+bool Codec::Decompress(Type type, const uint8_t* in_data, size_t in_size,
+                       uint8_t* out_data, size_t out_size) {
+  switch (type) {
+    case kStore:
+      if (in_size != out_size) return false;
+      if (out_size > 0) std::memcpy(out_data, in_data, out_size);
+      return true;
+    case kZlib: {
+      if (!FitsZlib(in_size) || !FitsZlib(out_size)) return false;
+      auto size = uLongf(out_size);
+      auto res = uncompress(out_data, &size, in_data, uLong(in_size));
+      return res == Z_OK && size == out_size;
+    }
+    case kLz4: {
+      if (!FitsLz4(in_size) || !FitsLz4(out_size)) return false;
+      auto res = LZ4_decompress_safe(reinterpret_cast<const char*>(in_data),
+                                     reinterpret_cast<char*>(out_data),
+                                     int(in_size), int(out_size));
+      return res >= 0 && size_t(res) == out_size;
+    }
+    case kZstd: {
+      auto res = ZSTD_decompress(out_data, out_size, in_data, in_size);
+      return !ZSTD_isError(res) && res == out_size;
+    }
+    default:
+      return false;
+  }
+}
+
+const char* Codec::Name(Type type) {
+  switch (type) {
+    case kStore:
+      return "store";
+    case kZlib:
+      return "zlib";
+    case kLz4:
+      return "lz4";
+    case kZstd:
+      return "zstd";
+    default:
+      return "unknown";
+  }
+}
+
+bool Codec::Parse(const ct::string& name, Type& type) {
+  for (uint32_t t = 0; t < kTypeCount; ++t) {
+    if (name.compare(Name(Type(t))) == 0) {
+      type = Type(t);
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace lib_core
@@ -1,18 +1,14 @@
 #include "core_utilities.h"
 #include <fstream>
 #include <regex>
+#include "logger.h"
+#include "profiler.h"
 #ifdef UnixBuild
 #include <zlib.h>
 #elif WindowsBuild
 #include <zlib/zlib.h>
 #endif
 
-tbb::concurrent_hash_map<size_t, ct::string> cu::str_map;
-tbb::concurrent_vector<ct::string> cu::errors, cu::warnings, cu::logs;
-tbb::concurrent_hash_map<
-    size_t, std::chrono::time_point<std::chrono::high_resolution_clock>>
-    cu::profile_starts, cu::profile_ends;
-
 ct::string cu::ReadFile(const ct::string &path) {
   std::ifstream file(path, std::ios::binary | std::ios::ate);
   size_t size = file.tellg();
@@ -40,8 +36,13 @@ void cu::LoadAndDecompress(const ct::string &load_path,
 
 void cu::DecompressMemory(ct::dyn_array<uint8_t> &in_data,
                           ct::dyn_array<uint8_t> &out_data) {
+  DecompressMemory(in_data.data(), in_data.size(), out_data);
+}
+
+void cu::DecompressMemory(const uint8_t *in_data, size_t in_size,
+                          ct::dyn_array<uint8_t> &out_data) {
   ct::dyn_array<uint8_t> buffer;
-  buffer.reserve(in_data.size() * 2);
+  buffer.reserve(in_size * 2);
   const size_t BUFFSIZE = 128 * 1024;
   ct::dyn_array<uint8_t> temp_buffer(BUFFSIZE);
 
@@ -49,8 +50,8 @@ void cu::DecompressMemory(ct::dyn_array<uint8_t> &in_data,
   strm.opaque = nullptr;
   strm.zalloc = nullptr;
   strm.zfree = nullptr;
-  strm.next_in = in_data.data();
-  strm.avail_in = uInt(in_data.size());
+  strm.next_in = const_cast<uint8_t *>(in_data);
+  strm.avail_in = uInt(in_size);
   strm.next_out = temp_buffer.data();
   strm.avail_out = BUFFSIZE;
 
@@ -306,25 +307,28 @@ bool cu::EvalAny(ct::string &str, ct::dyn_array<ct::string> &parts,
   return true;
 }
 
-void cu::PrintLogFile(const ct::string &dest_path) {
-  std::ofstream out(dest_path);
-  out << "-----------------------Logs---------------------------\n";
-  for (auto &p : logs) out << p << "\n";
-  out << "-----------------------Errors-------------------------\n";
-  for (auto &p : errors) out << p << "\n";
-  out << "-----------------------Warnings-----------------------\n";
-  for (auto &s : warnings) out << s << "\n";
-  out.close();
+void cu::FlushLogFile() { g_logger.Flush(); }
+
+void cu::Log(const ct::string &message, const char *file, int line) {
+  g_logger.Log(lib_core::Logger::kInfo, message.c_str(), file, line);
+}
+
+void cu::ReportError(const ct::string &cause, const char *file, int line) {
+  g_logger.Log(lib_core::Logger::kError, cause.c_str(), file, line);
+  g_logger.Flush();
+}
+
+void cu::ReportWarning(const ct::string &cause, const char *file, int line) {
+  g_logger.Log(lib_core::Logger::kWarning, cause.c_str(), file, line);
 }
 
 void cu::PrintProfiling(const ct::string &dest_path) {
   std::ofstream out(dest_path);
   out << "-----------------------Profiling----------------------\n";
-  for (auto &p : profile_starts) {
-    decltype(str_map)::accessor a;
-    if (str_map.find(a, p.first))
-      out << a->second << ": "
-          << std::to_string(ProfileTime<std::milli>(a->second)) << "\n";
-  }
+  out << "zone: count, min, avg, p99, max (ms)\n";
+  for (auto &z : g_profiler.Aggregate())
+    out << z.name << ": " << z.count << ", " << std::to_string(z.min) << ", "
+        << std::to_string(z.avg) << ", " << std::to_string(z.p99) << ", "
+        << std::to_string(z.max) << "\n";
   out.close();
 }
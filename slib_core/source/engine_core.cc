@@ -8,8 +8,11 @@
 #include "input_factory.h"
 #include "input_system.h"
 #include "key_definitions.h"
+#include "loader_pool.h"
+#include "memory_tracker.h"
 #include "physics_factory.h"
 #include "physics_system.h"
+#include "profiler.h"
 #include "renderer.h"
 #include "sound_factory.h"
 #include "system/camera_system.h"
@@ -36,9 +39,9 @@ int EngineCore::StartEngine() {
   std::atomic<bool> restart = {false};
   std::atomic<bool> rebuild_rec = {false};
   std::atomic<bool> run = {true};
-  std::atomic<float> frame_time = {.0f}, max_frame_time = {.0f};
 
   auto render_thread = [&]() {
+    g_profiler.SetThreadName("Render");
     window_->SetRenderContext();
     renderer_ = gfx_mgr.CreateDeferredRenderer(this);
     renderer_->InitRenderer();
@@ -48,37 +51,44 @@ int EngineCore::StartEngine() {
       material_system_->RebuildTextures();
     }
 
-    float reset_timer = 1.f;
     int fps_count = 0;
     float fps_freq = .0f;
 
     float dt = .0f;
     std::chrono::duration<float> elapsed;
-    std::chrono::duration<float, std::milli> elapsed_milli;
-    std::chrono::time_point<std::chrono::high_resolution_clock> start_point;
+    std::chrono::duration<float, std::milli> elapsed_milli, sync_milli;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_point,
+        sync_point;
 
     float sleep;
     float sleep_time = g_settings.FramePace();
     float fps_target = g_settings.FpsTarget() * .5f;
     while (run) {
+      PROFILE_FRAME("RenderFrame");
       start_point = std::chrono::high_resolution_clock::now();
 
+      sync_point = start_point;
       g_ent_mgr.DrawUpdate();
+      sync_milli = std::chrono::high_resolution_clock::now() - sync_point;
       g_sys_mgr.DrawUpdate(renderer_.get(), GetText());
 
       renderer_->RenderFrame(dt * time_multiplier_);
-      reset_timer -= dt;
-      if (reset_timer < 0.f) {
-        reset_timer += 1.f;
-        max_frame_time = 0.f;
-      }
 
+      sync_point = std::chrono::high_resolution_clock::now();
       g_ent_mgr.FrameFinished();
-      window_->SwapBuffers();
+      sync_milli += std::chrono::high_resolution_clock::now() - sync_point;
+      telemetry_->Record(FrameTelemetry::kSyncWait, sync_milli.count());
+
+      sync_point = std::chrono::high_resolution_clock::now();
+      {
+        PROFILE_ZONE("SwapBuffers");
+        window_->SwapBuffers();
+      }
+      sync_milli = std::chrono::high_resolution_clock::now() - sync_point;
+      telemetry_->Record(FrameTelemetry::kGpuSubmit, sync_milli.count());
+
       elapsed_milli = std::chrono::high_resolution_clock::now() - start_point;
-      if (max_frame_time < elapsed_milli.count())
-        max_frame_time = elapsed_milli.count();
-      frame_time = elapsed_milli.count();
+      telemetry_->Record(FrameTelemetry::kRender, elapsed_milli.count());
 
       elapsed = std::chrono::high_resolution_clock::now() - start_point;
       sleep = sleep_time - elapsed.count();
@@ -128,6 +138,7 @@ int EngineCore::StartEngine() {
   };
 
   auto update_thread = [&]() {
+    g_profiler.SetThreadName("Update");
     std::chrono::duration<float> elapsed;
     std::chrono::duration<float, std::milli> elapsed_milli;
     std::chrono::time_point<std::chrono::high_resolution_clock> start_point;
@@ -135,14 +146,18 @@ int EngineCore::StartEngine() {
     int ups = 0;
     float ups_freq = .0f;
     float dt = 0.0;
-    float max_time = .0f;
-    float reset_timer = 100.f;
     bool toggle_pressed = false;
-    ct::string max_time_str, ups_str;
-    ct::string max_frame_str, fps_str;
+
+    auto time_line = [&](FrameTelemetry::Channel channel, const char *label) {
+      auto stats = telemetry_->GetStats(channel);
+      return std::to_string(int(stats.p50)) + "ms : " +
+             std::to_string(int(stats.p99)) + "ms :" + label;
+    };
 
     while (!window_->ShouldClose() && !restart) {
+      PROFILE_FRAME("UpdateFrame");
       start_point = std::chrono::high_resolution_clock::now();
+      g_loader_pool.DispatchCompleted();
       g_sys_mgr.LogicUpdate(dt * time_multiplier_);
 
       if (input_system_->KeyPressed(lib_input::Key::kLeftAlt)) {
@@ -195,30 +210,19 @@ int EngineCore::StartEngine() {
       if (ups_freq > 0.5f) {
         debug_output_->UpdateTopLeftLine(0, "ups: " + std::to_string(2 * ups));
         debug_output_->UpdateTopLeftLine(1, "fps: " + std::to_string(2 * fps));
+        for (int t = 0; t < MemoryTracker::kTagCount; ++t)
+          debug_output_->UpdateTopLeftLine(
+              2 + t, g_mem_tracker.Summary(MemoryTracker::Tag(t)));
+        debug_output_->UpdateTopRightLine(
+            0, time_line(FrameTelemetry::kUpdate, "Update time:"));
+        debug_output_->UpdateTopRightLine(
+            1, time_line(FrameTelemetry::kRender, "Frame time:"));
         ups_freq = 0.0;
         ups = 0;
       }
 
       elapsed_milli = std::chrono::high_resolution_clock::now() - start_point;
-      reset_timer -= elapsed_milli.count();
-      if (reset_timer < 0.f) {
-        reset_timer += 100.f;
-        max_time = 0.f;
-      }
-
-      if (max_time < elapsed_milli.count()) max_time = elapsed_milli.count();
-      max_time_str = std::to_string(max_time);
-      ups_str = std::to_string(elapsed_milli.count());
-      debug_output_->UpdateTopRightLine(
-          0, ups_str.substr(0, ups_str.find_first_of('.')) + "ms : " +
-                 max_time_str.substr(0, max_time_str.find_first_of('.')) +
-                 "ms :Update time:");
-      max_frame_str = std::to_string(max_frame_time);
-      fps_str = std::to_string(frame_time);
-      debug_output_->UpdateTopRightLine(
-          1, fps_str.substr(0, fps_str.find_first_of('.')) + "ms : " +
-                 max_frame_str.substr(0, max_frame_str.find_first_of('.')) +
-                 "ms :Frame time:");
+      telemetry_->Record(FrameTelemetry::kUpdate, elapsed_milli.count());
 
       g_ent_mgr.LogicUpdate();
       elapsed = std::chrono::high_resolution_clock::now() - start_point;
@@ -268,8 +272,11 @@ int EngineCore::StartEngine() {
   particle_system_ = nullptr;
   g_sys_mgr.ClearSystems();
 
-  cu::PrintLogFile("./logfile.txt");
+  cu::FlushLogFile();
   cu::PrintProfiling("./profiling.txt");
+  g_profiler.ExportChromeTrace("./profiling.json");
+  telemetry_->DumpCsv("./frame_times.csv");
+  g_mem_tracker.Dump("./memory.txt");
   return 1;
 }
 
@@ -323,6 +330,8 @@ EngineDebugOutput *EngineCore::GetDebugOutput() const {
   return debug_output_.get();
 }
 
+FrameTelemetry *EngineCore::GetTelemetry() const { return telemetry_.get(); }
+
 void EngineCore::InitEngine() {
   auto gfx_mgr = lib_graphics::GraphicsFactory();
   auto phy_mgr = lib_physics::PhysicsFactory();
@@ -332,6 +341,7 @@ void EngineCore::InitEngine() {
 
   window_ = gfx_mgr.CreateAppWindow();
   debug_output_ = std::make_unique<EngineDebugOutput>();
+  telemetry_ = std::make_unique<FrameTelemetry>();
 
   auto mesh_up = gfx_mgr.CreateMeshSystem(this);
   auto material_up = gfx_mgr.CreateMaterialSystem(this);
@@ -26,6 +26,7 @@ EngineSettings::EngineSettings() {
   enum_string_map_[float_hash]["kMouseSensitivity"] = kMouseSensitivity;
   enum_string_map_[float_hash]["kMouseSmoothing"] = kMouseSmoothing;
   enum_string_map_[float_hash]["kFramePace"] = kFramePace;
+  enum_string_map_[float_hash]["kCascadeSplitLambda"] = kCascadeSplitLambda;
 
   enum_string_map_[int_hash]["kWindowedWidth"] = kWindowedWidth;
   enum_string_map_[int_hash]["kWindowedHeight"] = kWindowedHeight;
@@ -33,6 +34,7 @@ EngineSettings::EngineSettings() {
   enum_string_map_[int_hash]["kFullscreenHeight"] = kFullscreenHeight;
   enum_string_map_[int_hash]["kMaxShadowResoulution"] = kMaxShadowResoulution;
   enum_string_map_[int_hash]["kMaxTextureResolution"] = kMaxTextureResolution;
+  enum_string_map_[int_hash]["kShadowCascades"] = kShadowCascades;
 
   enum_string_map_rev_[bool_hash][kVsync] = "kVsync";
   enum_string_map_rev_[bool_hash][kBloom] = "kBloom";
@@ -52,6 +54,8 @@ EngineSettings::EngineSettings() {
   enum_string_map_rev_[float_hash][kMouseSensitivity] = "kMouseSensitivity";
   enum_string_map_rev_[float_hash][kMouseSmoothing] = "kMouseSmoothing";
   enum_string_map_rev_[float_hash][kFramePace] = "kFramePace";
+  enum_string_map_rev_[float_hash][kCascadeSplitLambda] =
+      "kCascadeSplitLambda";
   enum_string_map_rev_[int_hash][kWindowedWidth] = "kWindowedWidth";
   enum_string_map_rev_[int_hash][kWindowedHeight] = "kWindowedHeight";
   enum_string_map_rev_[int_hash][kFullscreenWidth] = "kFullscreenWidth";
@@ -60,6 +64,7 @@ EngineSettings::EngineSettings() {
       "kMaxShadowResoulution";
   enum_string_map_rev_[int_hash][kMaxTextureResolution] =
       "kMaxTextureResolution";
+  enum_string_map_rev_[int_hash][kShadowCascades] = "kShadowCascades";
 
   SetDefaults();
   LoadSettings();
@@ -185,6 +190,14 @@ float EngineSettings::FramePace() const {
 
 float EngineSettings::FpsTarget() const { return Setting<float>(kFramePace); }
 
+void EngineSettings::SetCascadeSplitLambda(float value) {
+  SetSetting<float>(value, kCascadeSplitLambda);
+}
+
+float EngineSettings::CascadeSplitLambda() const {
+  return Setting<float>(kCascadeSplitLambda);
+}
+
 void EngineSettings::LoadSettings() {
   std::ifstream input("./config.ini");
   if (input.fail()) return;
@@ -291,6 +304,7 @@ void EngineSettings::SetDefaults() {
   SetMouseSensitivity(1.f);
   SetMouseSmoothing(1.f);
   SetFramePace(150.f);
+  SetCascadeSplitLambda(.85f);
 
   SetWindowedWidth(1920);
   SetWindowedHeight(1080);
@@ -298,6 +312,7 @@ void EngineSettings::SetDefaults() {
   SetFullscreenHeight(1080);
   SetMaxShadowResolution(4096);
   SetMaxTextureResolution(2048);
+  SetShadowCascades(3);
 }
 
 template <typename T>
@@ -370,4 +385,12 @@ int EngineSettings::MaxShadowTexture() const {
 int EngineSettings::MaxTextureResolution() const {
   return Setting<int>(kMaxTextureResolution);
 }
+
+void EngineSettings::SetShadowCascades(int count) {
+  SetSetting<int>(count, kShadowCascades);
+}
+
+int EngineSettings::ShadowCascades() const {
+  return Setting<int>(kShadowCascades);
+}
 }  // namespace lib_core
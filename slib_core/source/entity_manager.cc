@@ -1,4 +1,5 @@
 #include "entity_manager.h"
+#include "profiler.h"
 #include "system_manager.h"
 
 namespace lib_core {
@@ -22,6 +23,7 @@ size_t EntityManager::CreateScene() {
 }
 
 void EntityManager::LogicUpdate() {
+  PROFILE_ZONE("EntitySync");
   // Sync up with render thread
   sync_point_.Wait();
 
@@ -46,6 +48,7 @@ void EntityManager::LogicUpdate() {
 }
 
 void EntityManager::DrawUpdate() {
+  PROFILE_ZONE("EntitySync");
   if (first_sync_) {
     sync_point_.Wait();
     first_sync_ = false;
@@ -59,6 +62,7 @@ void EntityManager::DrawUpdate() {
 }
 
 void EntityManager::FrameFinished() {
+  PROFILE_ZONE("FrameFinished");
   // Sync up with update thread
   sync_point_.Wait();
 }
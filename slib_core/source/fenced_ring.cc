@@ -0,0 +1,52 @@
+#include "fenced_ring.h"
+
+namespace lib_core {
+FencedRing::FencedRing(Backend& backend, size_t capacity, size_t alignment)
+    : backend_(backend),
+      capacity_(capacity / alignment * alignment),
+      alignment_(alignment) {}
+
+FencedRing::~FencedRing() { Drain(); }
+
+size_t FencedRing::Push(const void* data, size_t size) {
+  auto aligned = (size + alignment_ - 1) / alignment_ * alignment_;
+  if (aligned == 0 || aligned > capacity_) return kFull;
+
+  for (;;) {
+    auto padding = head_ + aligned > capacity_ ? capacity_ - head_ : 0;
+    if (used_ + padding + aligned <= capacity_) {
+      auto offset = padding ? 0 : head_;
+      backend_.Write(offset, data, size);
+
+      head_ = (offset + aligned) % capacity_;
+      used_ += padding + aligned;
+      frame_size_ += padding + aligned;
+      return offset;
+    }
+
+    if (frames_.empty()) return kFull;
+    Release();
+  }
+}
+
+void FencedRing::EndFrame() {
+  if (frame_size_ == 0) return;
+  frames_.push_back({backend_.InsertFence(), frame_size_});
+  frame_size_ = 0;
+}
+
+void FencedRing::Drain() {
+  while (!frames_.empty()) Release();
+}
+
+void FencedRing::Release() {
+  auto& frame = frames_.front();
+  backend_.WaitFence(frame.fence);
+  tail_ = (tail_ + frame.size) % capacity_;
+  used_ -= frame.size;
+  frames_.pop_front();
+
+  // Nothing in flight or pending, start over at the front.
+  if (used_ == 0) head_ = tail_ = 0;
+}
+}  // namespace lib_core
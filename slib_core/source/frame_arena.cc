@@ -0,0 +1,49 @@
+#include "frame_arena.h"
+#include <algorithm>
+
+namespace lib_core {
+FrameArena::FrameArena(size_t block_size) : block_size_(block_size) {}
+
+FrameArena& FrameArena::Local() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+  auto mask = uintptr_t(alignment - 1);
+  while (block_ < blocks_.size()) {
+    auto& block = blocks_[block_];
+    auto base = reinterpret_cast<uintptr_t>(block.data.get());
+    auto start = (base + offset_ + mask) & ~mask;
+    if (start + size <= base + block.size) {
+      offset_ = start + size - base;
+      return reinterpret_cast<void*>(start);
+    }
+    ++block_, offset_ = 0;
+  }
+
+  auto block_size = std::max(block_size_, size + alignment);
+  blocks_.push_back({std::make_unique<uint8_t[]>(block_size), block_size});
+  block_ = blocks_.size() - 1, offset_ = 0;
+  return Allocate(size, alignment);
+}
+
+void FrameArena::Rewind(Marker marker) {
+  high_water_ = std::max(high_water_, Used());
+  block_ = marker.block;
+  offset_ = marker.offset;
+}
+
+size_t FrameArena::Used() const {
+  size_t used = offset_;
+  for (size_t i = 0; i < block_ && i < blocks_.size(); ++i)
+    used += blocks_[i].size;
+  return used;
+}
+
+size_t FrameArena::Capacity() const {
+  size_t capacity = 0;
+  for (auto& block : blocks_) capacity += block.size;
+  return capacity;
+}
+}  // namespace lib_core
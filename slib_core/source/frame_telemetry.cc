@@ -0,0 +1,112 @@
+#include "frame_telemetry.h"
+#include <algorithm>
+#include <fstream>
+
+namespace lib_core {
+float FrameTelemetry::Last(Channel channel) const {
+  auto head = heads_[channel].load(std::memory_order_acquire);
+  if (head == 0) return 0.f;
+  return samples_[channel][(head - 1) % kHistorySize];
+}
+
+size_t FrameTelemetry::Count(Channel channel) const {
+  return size_t(std::min<uint64_t>(
+      heads_[channel].load(std::memory_order_acquire), kHistorySize));
+}
+
+float FrameTelemetry::Percentile(Channel channel, float percentile) const {
+  auto history = History(channel);
+  if (history.empty()) return 0.f;
+
+  auto rank = co::clamp(0.f, 1.f, percentile * .01f);
+  auto it = history.begin() + size_t(rank * float(history.size() - 1));
+  std::nth_element(history.begin(), it, history.end());
+  return *it;
+}
+
+FrameTelemetry::Stats FrameTelemetry::GetStats(Channel channel) const {
+  Stats stats;
+  auto history = History(channel);
+  if (history.empty()) return stats;
+
+  stats.count = history.size();
+  for (auto ms : history) {
+    stats.avg += ms;
+    if (ms > stats.max) stats.max = ms;
+  }
+  stats.avg /= float(history.size());
+
+  std::sort(history.begin(), history.end());
+  auto at = [&](float rank) {
+    return history[size_t(rank * float(history.size() - 1))];
+  };
+  stats.p50 = at(.5f);
+  stats.p95 = at(.95f);
+  stats.p99 = at(.99f);
+  return stats;
+}
+
+bool FrameTelemetry::WithinBudget(Channel channel, float percentile,
+                                  float budget_ms) const {
+  return Percentile(channel, percentile) <= budget_ms;
+}
+
+void FrameTelemetry::Reset() {
+  for (auto& h : heads_) h.store(0, std::memory_order_release);
+}
+
+void FrameTelemetry::DumpCsv(const ct::string& dest_path) const {
+  std::array<ct::dyn_array<float>, kChannelCount> histories;
+  size_t rows = 0;
+  for (int c = 0; c < kChannelCount; ++c) {
+    histories[c] = History(Channel(c));
+    rows = std::max(rows, histories[c].size());
+  }
+
+  std::ofstream out(dest_path);
+  out << "frame";
+  for (int c = 0; c < kChannelCount; ++c)
+    out << "," << ChannelName(Channel(c)) << "_ms";
+  out << "\n";
+
+  // Channels are aligned on their most recent sample.
+  for (size_t r = 0; r < rows; ++r) {
+    out << r;
+    for (auto& h : histories) {
+      out << ",";
+      auto offset = rows - h.size();
+      if (r >= offset) out << h[r - offset];
+    }
+    out << "\n";
+  }
+  out.close();
+}
+
+const char* FrameTelemetry::ChannelName(Channel channel) {
+  switch (channel) {
+    case kUpdate:
+      return "update";
+    case kRender:
+      return "render";
+    case kCull:
+      return "cull";
+    case kSyncWait:
+      return "sync_wait";
+    case kGpuSubmit:
+      return "gpu_submit";
+    default:
+      return "unknown";
+  }
+}
+
+ct::dyn_array<float> FrameTelemetry::History(Channel channel) const {
+  auto head = heads_[channel].load(std::memory_order_acquire);
+  auto count = std::min<uint64_t>(head, kHistorySize);
+
+  ct::dyn_array<float> history;
+  history.reserve(count);
+  for (auto i = head - count; i < head; ++i)
+    history.push_back(samples_[channel][i % kHistorySize]);
+  return history;
+}
+}  // namespace lib_core
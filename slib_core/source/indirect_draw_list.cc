@@ -0,0 +1,25 @@
+#include "indirect_draw_list.h"
+
+namespace lib_core {
+bool IndirectDrawList::Add(uint32_t first_index, uint32_t index_count,
+                           int32_t base_vertex, uint32_t instance_count,
+                           uint32_t base_instance) {
+  if (index_count == 0 || instance_count == 0) return false;
+
+  if (!commands_.empty()) {
+    auto& last = commands_.back();
+    if (last.first_index == first_index && last.index_count == index_count &&
+        last.base_vertex == base_vertex &&
+        last.base_instance + last.instance_count == base_instance) {
+      last.instance_count += instance_count;
+      return false;
+    }
+  }
+
+  commands_.push_back(
+      {index_count, instance_count, first_index, base_vertex, base_instance});
+  return true;
+}
+
+void IndirectDrawList::Clear() { commands_.clear(); }
+}  // namespace lib_core
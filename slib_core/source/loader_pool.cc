@@ -0,0 +1,167 @@
+#include "loader_pool.h"
+#include <algorithm>
+#include "profiler.h"
+
+namespace lib_core {
+LoaderPool& LoaderPool::get() {
+  static LoaderPool instance;
+  return instance;
+}
+
+LoaderPool::~LoaderPool() { Stop(); }
+
+void LoaderPool::Start(size_t workers) {
+  // Submit starts the pool from whichever thread gets there first.
+  std::lock_guard<std::mutex> start_lock(start_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (run_ && (workers == 0 || workers == workers_.size())) return;
+  }
+  StopWorkers();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (workers == 0) {
+    auto cores = size_t(std::thread::hardware_concurrency());
+    workers = cores > 3 ? cores - 2 : 1;
+  }
+
+  run_ = true;
+  for (size_t i = 0; i < workers; ++i)
+    workers_.emplace_back([this]() { WorkerLoop(); });
+}
+
+void LoaderPool::Stop() {
+  std::lock_guard<std::mutex> start_lock(start_mutex_);
+  StopWorkers();
+}
+
+LoaderPool::JobId LoaderPool::Submit(Callback work, Priority priority,
+                                     Callback on_complete, const void* owner) {
+  if (WorkerCount() == 0) Start();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto id = next_id_++;
+  QueueKey key = {-int(priority), sequence_++};
+  queue_[key] = {id, std::move(work), std::move(on_complete), owner};
+  queued_[id] = key;
+  lock.unlock();
+
+  work_cond_.notify_one();
+  return id;
+}
+
+bool LoaderPool::Bump(JobId job, Priority priority) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = queued_.find(job);
+  if (it == queued_.end()) return false;
+  if (-it->second.first >= priority) return true;
+
+  auto node = queue_.extract(it->second);
+  node.key().first = -int(priority);
+  it->second = node.key();
+  queue_.insert(std::move(node));
+  return true;
+}
+
+bool LoaderPool::Cancel(JobId job) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = queued_.find(job);
+  if (it != queued_.end()) {
+    queue_.erase(it->second);
+    queued_.erase(it);
+    done_cond_.notify_all();
+    return true;
+  }
+
+  done_cond_.wait(lock, [&]() { return running_.count(job) == 0; });
+  return false;
+}
+
+void LoaderPool::CancelOwner(const void* owner) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if (it->second.owner == owner) {
+      queued_.erase(it->second.id);
+      it = queue_.erase(it);
+    } else
+      ++it;
+  }
+
+  done_cond_.wait(lock, [&]() {
+    return std::none_of(running_.begin(), running_.end(),
+                        [&](auto& job) { return job.second == owner; });
+  });
+
+  completed_.erase(std::remove_if(completed_.begin(), completed_.end(),
+                                  [&](auto& c) { return c.owner == owner; }),
+                   completed_.end());
+  done_cond_.notify_all();
+}
+
+size_t LoaderPool::DispatchCompleted() {
+  ct::dyn_array<Completion> completed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed.swap(completed_);
+  }
+
+  for (auto& c : completed) c.callback();
+  return completed.size();
+}
+
+void LoaderPool::WaitIdle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cond_.wait(lock, [&]() {
+    return (queue_.empty() || !run_) && running_.empty();
+  });
+}
+
+size_t LoaderPool::Pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + running_.size();
+}
+
+size_t LoaderPool::WorkerCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.size();
+}
+
+void LoaderPool::StopWorkers() {
+  ct::dyn_array<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    run_ = false;
+    workers.swap(workers_);
+  }
+  work_cond_.notify_all();
+  done_cond_.notify_all();
+  for (auto& worker : workers) worker.join();
+}
+
+void LoaderPool::WorkerLoop() {
+  g_profiler.SetThreadName("Loader");
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cond_.wait(lock, [&]() { return !run_ || !queue_.empty(); });
+    if (!run_) break;
+
+    auto job = std::move(queue_.begin()->second);
+    queue_.erase(queue_.begin());
+    queued_.erase(job.id);
+    running_[job.id] = job.owner;
+    lock.unlock();
+
+    {
+      PROFILE_ZONE("LoaderJob");
+      job.work();
+    }
+
+    lock.lock();
+    running_.erase(job.id);
+    if (job.on_complete)
+      completed_.push_back({job.owner, std::move(job.on_complete)});
+    done_cond_.notify_all();
+  }
+}
+}  // namespace lib_core
@@ -0,0 +1,229 @@
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lib_core {
+namespace {
+// Hands the buffer back to the logger when the thread exits.
+struct LocalSlot {
+  ~LocalSlot() {
+    if (owned) owned->store(false, std::memory_order_release);
+  }
+
+  void* buffer = nullptr;
+  std::atomic<bool>* owned = nullptr;
+};
+thread_local LocalSlot local_buffer;
+
+const char* StripPath(const char* file) {
+  auto name = file;
+  for (auto c = file; *c != '\0'; ++c)
+    if (*c == '/' || *c == '\\') name = c + 1;
+  return name;
+}
+
+const char* SeverityName(Logger::Severity severity) {
+  switch (severity) {
+    case Logger::kWarning:
+      return "Warning";
+    case Logger::kError:
+      return "Error";
+    default:
+      return "Log";
+  }
+}
+}  // namespace
+
+Logger::Logger() { flush_thread_ = std::thread([this]() { FlushThread(); }); }
+
+Logger::~Logger() {
+  run_ = false;
+  flush_cv_.notify_all();
+  if (flush_thread_.joinable()) flush_thread_.join();
+
+  std::lock_guard<std::mutex> lock(flush_mutex_);
+  Drain();
+  out_.close();
+}
+
+Logger& Logger::get() {
+  static Logger instance;
+  return instance;
+}
+
+void Logger::Log(Severity severity, const char* message, const char* file,
+                 int line) {
+  if (severity < min_severity_.load(std::memory_order_relaxed)) return;
+
+  auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+                 .count();
+  uint32_t suppressed = 0;
+  if (!Admit(file, line, now, suppressed)) return;
+
+  bool pushed = false;
+  if (auto buffer = LocalBuffer()) {
+    pushed = Push(*buffer, severity, message, file, line, now, suppressed);
+  } else {
+    overflowed_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    pushed = Push(overflow_, severity, message, file, line, now, suppressed);
+  }
+  if (!pushed) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (severity == kError) flush_cv_.notify_one();
+}
+
+bool Logger::Push(ThreadBuffer& buffer, Severity severity, const char* message,
+                  const char* file, int line, int64_t now,
+                  uint32_t suppressed) {
+  auto head = buffer.head.load(std::memory_order_relaxed);
+  if (head - buffer.tail.load(std::memory_order_acquire) >= kRecordsPerThread)
+    return false;
+
+  auto& record = buffer.records[head % kRecordsPerThread];
+  record.severity = severity;
+  record.line = uint32_t(line);
+  record.suppressed = suppressed;
+  record.time = now;
+  record.file = file ? file : "";
+  std::strncpy(record.message.data(), message, kMessageSize - 1);
+  record.message[kMessageSize - 1] = '\0';
+  buffer.head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void Logger::Flush() {
+  std::lock_guard<std::mutex> lock(flush_mutex_);
+  Drain();
+}
+
+void Logger::SetOutput(const ct::string& dest_path) {
+  std::lock_guard<std::mutex> lock(flush_mutex_);
+  Drain();
+  out_.close();
+  dest_path_ = dest_path;
+}
+
+void Logger::SetMinSeverity(Severity severity) { min_severity_ = severity; }
+
+void Logger::SetRateLimit(uint32_t messages_per_second) {
+  rate_limit_ = messages_per_second;
+}
+
+Logger::ThreadBuffer* Logger::LocalBuffer() {
+  if (local_buffer.buffer)
+    return static_cast<ThreadBuffer*>(local_buffer.buffer);
+
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  auto count = buffer_count_.load(std::memory_order_relaxed);
+  ThreadBuffer* buffer = nullptr;
+
+  // A released buffer keeps its unread records, the new owner appends after
+  // them and the flush thread drains both in order.
+  for (size_t i = 0; i < count && !buffer; ++i)
+    if (!buffers_[i]->owned.load(std::memory_order_acquire))
+      buffer = buffers_[i].get();
+  if (!buffer) {
+    if (count >= kMaxThreads) return nullptr;
+    buffers_[count] = std::make_unique<ThreadBuffer>();
+    buffer = buffers_[count].get();
+    buffer_count_.store(count + 1, std::memory_order_release);
+  }
+
+  buffer->owned.store(true, std::memory_order_relaxed);
+  local_buffer.buffer = buffer;
+  local_buffer.owned = &buffer->owned;
+  return buffer;
+}
+
+bool Logger::Admit(const char* file, int line, int64_t now,
+                   uint32_t& suppressed) {
+  auto limit = rate_limit_.load(std::memory_order_relaxed);
+  if (limit == 0) return true;
+
+  // Call sites are identified by their __FILE__ pointer and line, colliding
+  // sites simply share a budget.
+  auto site = (uint64_t(reinterpret_cast<uintptr_t>(file)) * 31u +
+               uint64_t(uint32_t(line))) |
+              1u;
+  auto& slot = rate_slots_[site % kRateSlots];
+  auto window = now / 1'000'000'000;
+
+  auto prev_site = slot.site.exchange(site, std::memory_order_relaxed);
+  auto prev_window = slot.window.exchange(window, std::memory_order_relaxed);
+  if (prev_site != site || prev_window != window) {
+    suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed);
+    slot.count.store(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  if (slot.count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+
+  slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+  suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+size_t Logger::Drain() {
+  ct::dyn_array<std::pair<ThreadBuffer*, uint64_t>> pending;
+  ct::dyn_array<const Record*> records;
+
+  auto count = buffer_count_.load(std::memory_order_acquire);
+  for (size_t i = 0; i <= count; ++i) {
+    auto buffer = i < count ? buffers_[i].get() : &overflow_;
+    auto head = buffer->head.load(std::memory_order_acquire);
+    auto tail = buffer->tail.load(std::memory_order_relaxed);
+    for (auto r = tail; r < head; ++r)
+      records.push_back(&buffer->records[r % kRecordsPerThread]);
+    pending.emplace_back(buffer, head);
+  }
+  auto dropped = dropped_.load(std::memory_order_relaxed);
+  auto overflowed = overflowed_.load(std::memory_order_relaxed);
+  if (records.empty() && dropped == reported_dropped_ &&
+      overflowed == reported_overflowed_)
+    return 0;
+
+  std::stable_sort(records.begin(), records.end(),
+                   [](auto lhs, auto rhs) { return lhs->time < rhs->time; });
+
+  if (!out_.is_open()) out_.open(dest_path_, std::ios::trunc);
+  if (dropped != reported_dropped_) {
+    out_ << "Log: " << dropped - reported_dropped_
+         << " messages dropped, buffers full\n";
+    reported_dropped_ = dropped;
+  }
+  if (overflowed != reported_overflowed_) {
+    out_ << "Log: " << overflowed - reported_overflowed_
+         << " messages went through the overflow buffer, more than "
+         << kMaxThreads << " threads are logging\n";
+    reported_overflowed_ = overflowed;
+  }
+  for (auto r : records) {
+    out_ << SeverityName(r->severity) << ": " << StripPath(r->file);
+    if (int(r->line) != -1) out_ << "(" << int(r->line) << ")";
+    out_ << " " << r->message.data();
+    if (r->suppressed > 0) out_ << " [" << r->suppressed << " suppressed]";
+    out_ << "\n";
+
+    if (r->severity != kInfo)
+      std::cout << StripPath(r->file) << " " << r->message.data() << "\n";
+  }
+  out_.flush();
+
+  for (auto& p : pending)
+    p.first->tail.store(p.second, std::memory_order_release);
+  return records.size();
+}
+
+void Logger::FlushThread() {
+  std::unique_lock<std::mutex> lock(flush_mutex_);
+  while (run_) {
+    flush_cv_.wait_for(lock, std::chrono::milliseconds(100));
+    Drain();
+  }
+}
+}  // namespace lib_core
@@ -0,0 +1,104 @@
+#include "memory_tracker.h"
+#include <fstream>
+#include <new>
+
+namespace lib_core {
+MemoryTracker& MemoryTracker::get() {
+  static MemoryTracker instance;
+  return instance;
+}
+
+size_t MemoryTracker::Current(Tag tag) const {
+  return counters_[tag].current.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::HighWater(Tag tag) const {
+  return counters_[tag].high_water.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::Total() const {
+  size_t total = 0;
+  for (auto& c : counters_) total += c.current.load(std::memory_order_relaxed);
+  return total;
+}
+
+MemoryTracker::Stats MemoryTracker::GetStats(Tag tag) const {
+  auto& c = counters_[tag];
+  Stats stats;
+  stats.current = c.current.load(std::memory_order_relaxed);
+  stats.high_water = c.high_water.load(std::memory_order_relaxed);
+  stats.allocations = c.allocations.load(std::memory_order_relaxed);
+  stats.frees = c.frees.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MemoryTracker::ResetHighWater() {
+  for (auto& c : counters_)
+    c.high_water.store(c.current.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+}
+
+void MemoryTracker::Dump(const ct::string& dest_path) const {
+  std::ofstream out(dest_path);
+  out << "tag, current (bytes), high water (bytes), allocations, frees\n";
+  for (int t = 0; t < kTagCount; ++t) {
+    auto stats = GetStats(Tag(t));
+    out << TagName(Tag(t)) << ", " << stats.current << ", "
+        << stats.high_water << ", " << stats.allocations << ", "
+        << stats.frees << "\n";
+  }
+  out.close();
+}
+
+ct::string MemoryTracker::Summary(Tag tag) const {
+  auto to_mb = [](size_t bytes) {
+    return std::to_string(int(float(bytes) / (1024.f * 1024.f) + .5f));
+  };
+  return ct::string(TagName(tag)) + ": " + to_mb(Current(tag)) + "MB (" +
+         to_mb(HighWater(tag)) + "MB peak)";
+}
+
+const char* MemoryTracker::TagName(Tag tag) {
+  switch (tag) {
+    case kEcsComponents:
+      return "ecs_components";
+    case kMeshSource:
+      return "mesh_source";
+    case kTextureSource:
+      return "texture_source";
+    case kSoundData:
+      return "sound_data";
+    case kPhysics:
+      return "physics";
+    case kParticles:
+      return "particles";
+    default:
+      return "unknown";
+  }
+}
+
+HeapAllocator& HeapAllocator::get() {
+  static HeapAllocator instance;
+  return instance;
+}
+
+void* HeapAllocator::Allocate(size_t size, size_t alignment) {
+  return ::operator new(size, std::align_val_t(alignment));
+}
+
+void HeapAllocator::Deallocate(void* ptr, size_t size, size_t alignment) {
+  ::operator delete(ptr, std::align_val_t(alignment));
+}
+
+void* TrackingAllocator::Allocate(size_t size, size_t alignment) {
+  auto ptr = upstream_->Allocate(size, alignment);
+  if (ptr) g_mem_tracker.Allocated(tag_, size);
+  return ptr;
+}
+
+void TrackingAllocator::Deallocate(void* ptr, size_t size, size_t alignment) {
+  if (!ptr) return;
+  upstream_->Deallocate(ptr, size, alignment);
+  g_mem_tracker.Freed(tag_, size);
+}
+}  // namespace lib_core
@@ -0,0 +1,126 @@
+#include "particle_batcher.h"
+#include <algorithm>
+#include <cstring>
+#include <execution>
+#include "profiler.h"
+#include "range_iterator.hpp"
+
+namespace lib_core {
+void ParticleBatcher::Build(const ParticleSimulator::Output& particles,
+                            const ct::dyn_array<Emitter>& emitters,
+                            const Matrix4x4& view, View& out) {
+  Sort(particles, emitters, view, out);
+  Pack(particles, out);
+}
+
+uint32_t ParticleBatcher::FloatKey(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  // Negative values flip entirely, positive ones only gain the sign bit.
+  return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+void ParticleBatcher::RadixSort(uint64_t* keys, uint64_t* scratch,
+                                size_t count) {
+  if (count < 2) return;
+  auto from = keys, to = scratch;
+  for (int shift = 32; shift < 64; shift += 8) {
+    size_t offsets[256] = {};
+    for (size_t i = 0; i < count; ++i) ++offsets[(from[i] >> shift) & 0xFF];
+    if (offsets[(from[0] >> shift) & 0xFF] == count) continue;
+
+    size_t sum = 0;
+    for (auto& offset : offsets) {
+      auto bucket = offset;
+      offset = sum;
+      sum += bucket;
+    }
+    for (size_t i = 0; i < count; ++i)
+      to[offsets[(from[i] >> shift) & 0xFF]++] = from[i];
+    std::swap(from, to);
+  }
+  if (from != keys) std::copy(from, from + count, keys);
+}
+
+void ParticleBatcher::Sort(const ParticleSimulator::Output& particles,
+                           const ct::dyn_array<Emitter>& emitters,
+                           const Matrix4x4& view, View& out) {
+  PROFILE_ZONE("ParticleSort");
+  order_.clear();
+  for (size_t i = 0; i < emitters.size(); ++i) {
+    auto it = particles.ranges.find(emitters[i].id);
+    if (it != particles.ranges.end() && it->second.second > 0)
+      order_.push_back(i);
+  }
+  std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+    if (emitters[a].blend != emitters[b].blend)
+      return emitters[a].blend < emitters[b].blend;
+    return emitters[a].texture < emitters[b].texture;
+  });
+
+  runs_.clear();
+  batch_runs_.clear();
+  out.batches.clear();
+  size_t total = 0;
+  for (auto i : order_) {
+    auto& emitter = emitters[i];
+    auto& range = particles.ranges.at(emitter.id);
+    if (out.batches.empty() || out.batches.back().blend != emitter.blend ||
+        out.batches.back().texture != emitter.texture) {
+      out.batches.push_back({emitter.blend, emitter.texture, total, 0});
+      batch_runs_.push_back(runs_.size());
+    }
+    runs_.push_back(
+        {range.first, total, range.second, emitter.blend == kAlpha});
+    out.batches.back().count += range.second;
+    total += range.second;
+  }
+  batch_runs_.push_back(runs_.size());
+  keys_.resize(total);
+  scratch_.resize(total);
+
+  // Distance along the view direction, which looks down negative z. The
+  // largest distance has to come first, so the key is inverted.
+  const float dx = -view.data[2], dy = -view.data[6], dz = -view.data[10],
+              dw = -view.data[14];
+  auto instances = particles.instances.data();
+  auto r = range(0, runs_.size());
+  std::for_each(std::execution::par_unseq, std::begin(r), std::end(r),
+                [&](size_t i) {
+                  auto& run = runs_[i];
+                  auto keys = keys_.data() + run.target;
+                  for (size_t j = 0; j < run.count; ++j) {
+                    auto& p = instances[run.source + j].position;
+                    auto depth = dx * p[0] + dy * p[1] + dz * p[2] + dw;
+                    uint64_t key = run.sorted ? ~FloatKey(depth) : 0u;
+                    keys[j] = key << 32 | (run.source + j);
+                  }
+                  if (run.sorted)
+                    RadixSort(keys, scratch_.data() + run.target, run.count);
+                });
+}
+
+void ParticleBatcher::Pack(const ParticleSimulator::Output& particles,
+                           View& out) {
+  PROFILE_ZONE("ParticlePack");
+  out.instances.resize(keys_.size());
+
+  auto r = range(0, out.batches.size());
+  std::for_each(
+      std::execution::par_unseq, std::begin(r), std::end(r), [&](size_t b) {
+        auto& batch = out.batches[b];
+        auto keys = keys_.begin() + batch.first;
+
+        // Every emitter of a sorted batch is already in order on its own.
+        if (batch.blend == kAlpha)
+          for (auto i = batch_runs_[b] + 1; i < batch_runs_[b + 1]; ++i) {
+            auto middle = keys_.begin() + runs_[i].target;
+            std::inplace_merge(keys, middle, middle + runs_[i].count);
+          }
+
+        for (size_t i = 0; i < batch.count; ++i)
+          out.instances[batch.first + i] =
+              particles.instances[uint32_t(keys[i])];
+      });
+}
+}  // namespace lib_core
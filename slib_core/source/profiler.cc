@@ -0,0 +1,123 @@
+#include "profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace lib_core {
+namespace {
+thread_local Profiler::ThreadBuffer* local_buffer = nullptr;
+}
+
+Profiler::Profiler() : epoch_(std::chrono::high_resolution_clock::now()) {}
+
+Profiler& Profiler::get() {
+  static Profiler instance;
+  return instance;
+}
+
+void Profiler::SetEnabled(bool enabled) { enabled_ = enabled; }
+
+void Profiler::SetThreadName(const char* name) {
+  auto& buffer = LocalBuffer();
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  buffer.name = name;
+}
+
+void Profiler::FrameMark(const char* name) {
+  if (!Enabled()) return;
+  auto& buffer = LocalBuffer();
+  auto now = Now();
+  Record(buffer, {name, now, now, buffer.depth, true});
+}
+
+Profiler::ThreadBuffer& Profiler::LocalBuffer() {
+  if (local_buffer) return *local_buffer;
+
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  buffers_.emplace_back(std::make_unique<ThreadBuffer>());
+  local_buffer = buffers_.back().get();
+  local_buffer->tid = uint32_t(buffers_.size() - 1);
+  return *local_buffer;
+}
+
+ct::dyn_array<std::pair<uint32_t, Profiler::Event>> Profiler::Snapshot()
+    const {
+  ct::dyn_array<std::pair<uint32_t, Event>> result;
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  for (auto& b : buffers_) {
+    auto head = b->head.load(std::memory_order_acquire);
+    auto size = uint64_t(b->events.size());
+    auto begin = head > size ? head - size : 0;
+    for (auto i = begin; i < head; ++i)
+      result.emplace_back(b->tid, b->events[i & (size - 1)]);
+  }
+  return result;
+}
+
+ct::dyn_array<Profiler::ZoneStats> Profiler::Aggregate() const {
+  ct::tree_map<ct::string, ct::dyn_array<float>> durations;
+  for (auto& p : Snapshot()) {
+    if (p.second.frame_mark) continue;
+    durations[p.second.name].push_back(float(p.second.end - p.second.start) *
+                                       1e-6f);
+  }
+
+  ct::dyn_array<ZoneStats> result;
+  for (auto& d : durations) {
+    auto& times = d.second;
+    ZoneStats stats;
+    stats.name = d.first;
+    stats.count = times.size();
+
+    float sum = 0.f;
+    for (auto t : times) sum += t;
+    stats.avg = sum / float(times.size());
+
+    auto minmax = std::minmax_element(times.begin(), times.end());
+    stats.min = *minmax.first;
+    stats.max = *minmax.second;
+
+    auto p99_it = times.begin() + size_t(float(times.size() - 1) * .99f);
+    std::nth_element(times.begin(), p99_it, times.end());
+    stats.p99 = *p99_it;
+    result.push_back(stats);
+  }
+  return result;
+}
+
+void Profiler::ExportChromeTrace(const ct::string& dest_path) const {
+  auto events = Snapshot();
+
+  std::ofstream out(dest_path);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"traceEvents\":[\n";
+
+  bool first = true;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (auto& b : buffers_) {
+      if (b->name.empty()) continue;
+      if (!first) out << ",\n";
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+          << b->tid << ",\"args\":{\"name\":\"" << b->name << "\"}}";
+      first = false;
+    }
+  }
+
+  for (auto& p : events) {
+    auto& e = p.second;
+    if (!first) out << ",\n";
+    out << "{\"name\":\"" << e.name << "\",\"pid\":0,\"tid\":" << p.first
+        << ",\"ts\":" << double(e.start) * 1e-3;
+    if (e.frame_mark)
+      out << ",\"ph\":\"i\",\"s\":\"t\"}";
+    else
+      out << ",\"ph\":\"X\",\"dur\":" << double(e.end - e.start) * 1e-3
+          << ",\"args\":{\"depth\":" << e.depth << "}}";
+    first = false;
+  }
+
+  out << "\n]}\n";
+  out.close();
+}
+}  // namespace lib_core
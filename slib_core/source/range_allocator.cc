@@ -0,0 +1,61 @@
+#include "range_allocator.h"
+#include <iterator>
+
+namespace lib_core {
+RangeAllocator::RangeAllocator(size_t capacity) : capacity_(capacity) {
+  Reset();
+}
+
+size_t RangeAllocator::Allocate(size_t size) {
+  if (size == 0) return kInvalid;
+
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    if (it->second < size) continue;
+
+    auto offset = it->first;
+    auto left = it->second - size;
+    free_.erase(it);
+    if (left > 0) free_[offset + size] = left;
+    used_ += size;
+    return offset;
+  }
+  return kInvalid;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size) {
+  if (size == 0) return;
+  used_ -= size;
+
+  auto next = free_.lower_bound(offset);
+  if (next != free_.end() && offset + size == next->first) {
+    size += next->second;
+    next = free_.erase(next);
+  }
+  if (next != free_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+  free_[offset] = size;
+}
+
+void RangeAllocator::Grow(size_t capacity) {
+  if (capacity <= capacity_) return;
+
+  auto extra = capacity - capacity_;
+  auto last = free_.empty() ? free_.end() : std::prev(free_.end());
+  if (last != free_.end() && last->first + last->second == capacity_)
+    last->second += extra;
+  else
+    free_[capacity_] = extra;
+  capacity_ = capacity;
+}
+
+void RangeAllocator::Reset() {
+  free_.clear();
+  used_ = 0;
+  if (capacity_ > 0) free_[0] = capacity_;
+}
+}  // namespace lib_core
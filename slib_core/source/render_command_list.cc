@@ -0,0 +1,114 @@
+#include "render_command_list.h"
+#include <algorithm>
+
+namespace lib_core {
+uint64_t RenderCommandList::Key(uint8_t pass, uint32_t order,
+                                uint32_t material) {
+  cu::AssertError(order <= 0xFFFFFF, "Render order exceeds 24 bits", __FILE__,
+                  __LINE__);
+  return uint64_t(pass) << 56 | uint64_t(order) << 32 | material;
+}
+
+void RenderCommandList::SetState(uint64_t key, uint32_t state) {
+  commands_.push_back({key, kState, 0, state, 0, 0, 0});
+}
+
+void RenderCommandList::BindMaterial(uint64_t key, size_t material,
+                                     size_t light) {
+  commands_.push_back({key, kBindMaterial, 0, material, light, 0, 0});
+}
+
+void RenderCommandList::BindBuffer(uint64_t key, uint32_t slot, size_t buffer,
+                                   size_t offset, size_t size) {
+  commands_.push_back({key, kBindBuffer, slot, buffer, offset, size, 0});
+}
+
+void RenderCommandList::SetConstants(uint64_t key, uint32_t slot,
+                                     const float* data, size_t count) {
+  commands_.push_back({key, kConstants, slot, 0, constants_.size(), count, 0});
+  constants_.insert(constants_.end(), data, data + count);
+}
+
+void RenderCommandList::SetTarget(uint64_t key, size_t target,
+                                  uint32_t clear) {
+  commands_.push_back({key, kTarget, clear, target, 0, 0, 0});
+}
+
+void RenderCommandList::Draw(uint64_t key, size_t mesh, size_t first_instance,
+                             size_t instance_count) {
+  if (instance_count == 0) return;
+  commands_.push_back(
+      {key, kDraw, 0, mesh, first_instance, instance_count, 0});
+}
+
+void RenderCommandList::Dispatch(uint64_t key, uint32_t x, uint32_t y,
+                                 uint32_t z) {
+  if (x == 0 || y == 0 || z == 0) return;
+  commands_.push_back({key, kDispatch, 0, 0, x, y, z});
+}
+
+void RenderCommandList::Append(const RenderCommandList& list) {
+  auto first = commands_.size();
+  auto offset = constants_.size();
+  commands_.insert(commands_.end(), list.commands_.begin(),
+                   list.commands_.end());
+  constants_.insert(constants_.end(), list.constants_.begin(),
+                    list.constants_.end());
+  for (auto i = first; i < commands_.size(); ++i)
+    if (commands_[i].type == kConstants) commands_[i].first += offset;
+}
+
+void RenderCommandList::Sort() {
+  std::stable_sort(
+      commands_.begin(), commands_.end(),
+      [](const Command& a, const Command& b) { return a.key < b.key; });
+}
+
+RenderCommandList::Stats RenderCommandList::Replay(
+    RenderBackend& backend) const {
+  Stats stats;
+  bool has_state = false, has_material = false;
+  size_t state = 0, material = 0, light = 0;
+
+  for (auto& c : commands_) {
+    ++stats.commands;
+    switch (c.type) {
+      case kState:
+        if (has_state && state == c.resource) {
+          ++stats.redundant;
+          break;
+        }
+        has_state = true, state = c.resource;
+        backend.SetState(uint32_t(c.resource));
+        break;
+      case kBindMaterial:
+        if (has_material && material == c.resource && light == c.first) {
+          ++stats.redundant;
+          break;
+        }
+        has_material = true, material = c.resource, light = c.first;
+        backend.BindMaterial(c.resource, c.first);
+        break;
+      case kBindBuffer:
+        backend.BindBuffer(c.slot, c.resource, c.first, c.count);
+        break;
+      case kConstants:
+        backend.SetConstants(c.slot, constants_.data() + c.first, c.count);
+        break;
+      case kTarget:
+        backend.SetTarget(c.resource, c.slot);
+        break;
+      case kDraw:
+        ++stats.draws;
+        stats.instances += c.count;
+        backend.Draw(c.resource, c.first, c.count);
+        break;
+      case kDispatch:
+        ++stats.dispatches;
+        backend.Dispatch(uint32_t(c.first), uint32_t(c.count), c.z);
+        break;
+    }
+  }
+  return stats;
+}
+}  // namespace lib_core
@@ -0,0 +1,157 @@
+#include "shadow_atlas.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lib_core {
+ShadowAtlas::ShadowAtlas(ct::dyn_array<size_t> slots, size_t budget)
+    : budget_(budget) {
+  for (auto count : slots) owners_.emplace_back(count, kFree);
+}
+
+int ShadowAtlas::TierForCoverage(float coverage, int tiers) {
+  if (tiers <= 0) return kNoTier;
+  if (coverage >= .5f) return 0;
+  if (coverage <= 0.f) return tiers - 1;
+  auto tier = int(std::ceil(-std::log2(2.f * coverage)));
+  return std::min(tier, tiers - 1);
+}
+
+void ShadowAtlas::BeginFrame() {
+  ++frame_;
+  spent_ = 0;
+}
+
+void ShadowAtlas::Remove(size_t light) {
+  auto it = entries_.find(light);
+  if (it == entries_.end()) return;
+  Release(it->second);
+  entries_.erase(it);
+}
+
+void ShadowAtlas::Invalidate(size_t light) {
+  auto it = entries_.find(light);
+  if (it != entries_.end()) it->second.dirty = true;
+}
+
+void ShadowAtlas::Discard(size_t light) {
+  auto it = entries_.find(light);
+  if (it != entries_.end()) it->second.dirty = true, it->second.valid = false;
+}
+
+void ShadowAtlas::Update(const ct::dyn_array<Request>& requests,
+                         ct::dyn_array<Placement>& out) {
+  auto tiers = int(owners_.size());
+
+  order_.resize(requests.size());
+  for (size_t i = 0; i < order_.size(); ++i) order_[i] = i;
+  std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+    if (requests[a].tier != requests[b].tier)
+      return requests[a].tier < requests[b].tier;
+    return requests[a].urgent && !requests[b].urgent;
+  });
+
+  // Everything requested this frame counts as used before any light is
+  // placed, so placing one light never evicts another that is still live.
+  for (auto& request : requests) {
+    auto& entry = entries_[request.light];
+    entry.fresh = entry.last_used != frame_;
+    entry.last_used = frame_;
+  }
+
+  for (auto i : order_) {
+    auto& request = requests[i];
+    auto& entry = entries_[request.light];
+    auto tier = std::clamp(request.tier, 0, std::max(tiers - 1, 0));
+
+    if (entry.tier != kNoTier && tier != entry.tier) {
+      if (entry.pending_tier != tier) {
+        entry.pending_tier = tier;
+        entry.pending_frames = 0;
+      }
+      if (entry.fresh) ++entry.pending_frames;
+      if (entry.pending_frames < kTierDelay) tier = entry.tier;
+    } else {
+      entry.pending_tier = kNoTier;
+    }
+    entry.fresh = false;
+
+    if (entry.tier == kNoTier) {
+      for (auto t = tier; t < tiers; ++t)
+        if (Acquire(request.light, entry, t)) break;
+    } else if (entry.tier != tier) {
+      // The light only moves once a slot closer to its tier is taken,
+      // otherwise it keeps its slot and cached map.
+      auto last = tier < entry.tier ? entry.tier : tiers;
+      for (auto t = tier; t < last; ++t)
+        if (Acquire(request.light, entry, t)) break;
+    }
+  }
+
+  out.clear();
+  candidates_.clear();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& entry = entries_[requests[i].light];
+    out.push_back({requests[i].light, entry.tier, entry.slot, false});
+
+    // Without a slot the map is drawn to a scratch target every frame.
+    if (entry.tier == kNoTier)
+      out.back().render = true;
+    else if (entry.dirty && (requests[i].urgent || !entry.valid))
+      out.back().render = true;
+    else if (entry.dirty)
+      candidates_.push_back(i);
+  }
+
+  std::stable_sort(candidates_.begin(), candidates_.end(),
+                   [&](size_t a, size_t b) {
+                     return entries_[requests[a].light].last_render <
+                            entries_[requests[b].light].last_render;
+                   });
+  auto budget = budget_ - std::min(spent_, budget_);
+  if (candidates_.size() > budget) candidates_.resize(budget);
+  spent_ += candidates_.size();
+  for (auto i : candidates_) out[i].render = true;
+
+  for (auto& placement : out) {
+    if (!placement.render || placement.tier == kNoTier) continue;
+    auto& entry = entries_[placement.light];
+    entry.dirty = false;
+    entry.valid = true;
+    entry.last_render = frame_;
+  }
+}
+
+void ShadowAtlas::Release(Entry& entry) {
+  if (entry.tier != kNoTier) owners_[entry.tier][entry.slot] = kFree;
+  entry.tier = kNoTier;
+  entry.valid = false;
+  entry.dirty = true;
+}
+
+bool ShadowAtlas::Acquire(size_t light, Entry& entry, int tier) {
+  auto& owners = owners_[tier];
+  auto slot = owners.size();
+  uint64_t oldest = frame_;
+  for (size_t i = 0; i < owners.size(); ++i) {
+    if (owners[i] == kFree) {
+      slot = i;
+      break;
+    }
+    auto& owner = entries_[owners[i]];
+    if (owner.last_used < oldest) {
+      oldest = owner.last_used;
+      slot = i;
+    }
+  }
+  if (slot == owners.size()) return false;
+
+  if (owners[slot] != kFree) Release(entries_[owners[slot]]);
+  if (entry.tier != kNoTier) owners_[entry.tier][entry.slot] = kFree;
+  owners[slot] = light;
+  entry.tier = tier;
+  entry.slot = slot;
+  entry.valid = false;
+  entry.dirty = true;
+  return true;
+}
+}  // namespace lib_core
@@ -0,0 +1,69 @@
+#include "skyline_packer.h"
+#include <algorithm>
+
+namespace lib_core {
+SkylinePacker::SkylinePacker(int width, int height)
+    : width_(width), height_(height) {
+  Reset();
+}
+
+bool SkylinePacker::Pack(int width, int height, int& x, int& y) {
+  if (width <= 0 || height <= 0) return false;
+
+  auto best = skyline_.size();
+  int best_y = height_, best_width = width_;
+  for (size_t i = 0; i < skyline_.size(); ++i) {
+    auto fit_y = Fit(i, width);
+    if (fit_y < 0 || fit_y + height > height_) continue;
+    if (fit_y < best_y ||
+        (fit_y == best_y && skyline_[i].width < best_width)) {
+      best = i;
+      best_y = fit_y;
+      best_width = skyline_[i].width;
+    }
+  }
+  if (best == skyline_.size()) return false;
+
+  x = skyline_[best].x;
+  y = best_y;
+
+  skyline_.insert(skyline_.begin() + best, {x, y + height, width});
+  auto right = x + width;
+  auto i = best + 1;
+  while (i < skyline_.size() && skyline_[i].x < right) {
+    auto& segment = skyline_[i];
+    auto end = segment.x + segment.width;
+    if (end <= right) {
+      skyline_.erase(skyline_.begin() + i);
+      continue;
+    }
+    segment.width = end - right;
+    segment.x = right;
+    break;
+  }
+
+  for (i = 0; i + 1 < skyline_.size();) {
+    if (skyline_[i].y == skyline_[i + 1].y) {
+      skyline_[i].width += skyline_[i + 1].width;
+      skyline_.erase(skyline_.begin() + i + 1);
+    } else
+      ++i;
+  }
+  return true;
+}
+
+void SkylinePacker::Grow(int height) { height_ = std::max(height_, height); }
+
+void SkylinePacker::Reset() { skyline_.assign(1, {0, 0, width_}); }
+
+int SkylinePacker::Fit(size_t i, int width) const {
+  if (skyline_[i].x + width > width_) return -1;
+
+  int y = 0;
+  for (auto remaining = width; remaining > 0; ++i) {
+    y = std::max(y, skyline_[i].y);
+    remaining -= skyline_[i].width;
+  }
+  return y;
+}
+}  // namespace lib_core
@@ -1,15 +1,28 @@
 #include "system_manager.h"
 #include "core_commands.h"
 #include "entity_manager.h"
+#include "frame_arena.h"
+#include "profiler.h"
 
 #include <execution>
 
 namespace lib_core {
+namespace {
+void UpdateSystem(System *system, float dt) {
+  ArenaScope scope;
+  system->LogicUpdate(dt);
+}
+}  // namespace
+
 void SystemManager::DrawUpdate(lib_graphics::Renderer *renderer,
                                lib_gui::TextSystem *text_renderer) {
+  PROFILE_ZONE("SystemsDrawUpdate");
   for (auto &sys_vec : system_map_)
     for (auto &p : sys_vec.second)
-      if (p->IsActive() && p->IsDrawn()) p->DrawUpdate(renderer, text_renderer);
+      if (p->IsActive() && p->IsDrawn()) {
+        ArenaScope scope;
+        p->DrawUpdate(renderer, text_renderer);
+      }
 }
 
 void SystemManager::SyncSystems() {
@@ -36,7 +49,7 @@ void SystemManager::SyncSystems() {
 }
 
 void SystemManager::SyncInputSystems(float dt) {
-  for (auto &p : system_map_[4000]) p->LogicUpdate(dt);
+  for (auto &p : system_map_[4000]) UpdateSystem(p.get(), dt);
 }
 
 void SystemManager::ClearSystems() {
@@ -72,6 +85,7 @@ void SystemManager::CleanSystems() {
 }
 
 void SystemManager::LogicUpdate(float dt) {
+  PROFILE_ZONE("SystemsLogicUpdate");
   if (g_ent_mgr.FullyLoaded() && empty_frames_ > 5)
     for (auto &p : system_map_)
       for (auto &s : p.second)
@@ -86,22 +100,14 @@ void SystemManager::LogicUpdate(float dt) {
         p.first != 4000)
       prio_ids.push_back(p.first);
 
-  for (auto &s : system_map_[1000]) {
-    if (s->IsActive() && s->IsUpdated()) {
-      s->LogicUpdate(dt);
-      s->temporary_memory_.clear();
-    }
-  }
+  for (auto &s : system_map_[1000])
+    if (s->IsActive() && s->IsUpdated()) UpdateSystem(s.get(), dt);
 
   auto &pre_run_sys_vec = system_map_[2000];
   if (!pre_run_sys_vec.empty()) {
-    pre_run_sys_vec[0]->LogicUpdate(dt);
-    pre_run_sys_vec[0]->temporary_memory_.clear();
+    UpdateSystem(pre_run_sys_vec[0].get(), dt);
     auto pre_run_systems = [&](auto &sys) {
-      if (sys->IsActive() && sys->IsUpdated()) {
-        sys->LogicUpdate(dt);
-        sys->temporary_memory_.clear();
-      }
+      if (sys->IsActive() && sys->IsUpdated()) UpdateSystem(sys.get(), dt);
     };
     if (pre_run_sys_vec.size() > 1)
       std::for_each(std::execution::par_unseq, std::begin(pre_run_sys_vec) + 1,
@@ -110,24 +116,17 @@ void SystemManager::LogicUpdate(float dt) {
 
   auto update_func = [&](size_t id) {
     auto &sys_vec = system_map_[id];
-    for (auto &s : sys_vec) {
-      if (s->Loaded()) {
-        if (s->IsActive() && s->IsUpdated()) {
-          s->LogicUpdate(dt);
-          s->temporary_memory_.clear();
-        }
-      }
-    }
+    for (auto &s : sys_vec)
+      if (s->Loaded() && s->IsActive() && s->IsUpdated())
+        UpdateSystem(s.get(), dt);
   };
   std::for_each(std::execution::par_unseq, std::begin(prio_ids),
                 std::end(prio_ids), update_func);
 
   auto &post_run_sys_vec = system_map_[3000];
   auto post_run_systems = [&](size_t id) {
-    if (post_run_sys_vec[id]->IsActive() && post_run_sys_vec[id]->IsUpdated()) {
-      post_run_sys_vec[id]->LogicUpdate(dt);
-      post_run_sys_vec[id]->temporary_memory_.clear();
-    }
+    if (post_run_sys_vec[id]->IsActive() && post_run_sys_vec[id]->IsUpdated())
+      UpdateSystem(post_run_sys_vec[id].get(), dt);
   };
   for (size_t i = 0; i < post_run_sys_vec.size(); ++i) post_run_systems(i);
 
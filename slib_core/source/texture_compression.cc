@@ -0,0 +1,597 @@
+#include "texture_compression.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace lib_core {
+namespace {
+using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+constexpr int kBc7Weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                 34, 38, 43, 47, 51, 55, 60, 64};
+
+class BitWriter {
+ public:
+  explicit BitWriter(uint8_t* out) : out_(out) {}
+
+  void Put(uint32_t value, int bits) {
+    for (int i = 0; i < bits; ++i, ++pos_)
+      if (value >> i & 1) out_[pos_ / 8] |= uint8_t(1 << pos_ % 8);
+  }
+
+ private:
+  uint8_t* out_;
+  size_t pos_ = 0;
+};
+
+class BitReader {
+ public:
+  explicit BitReader(const uint8_t* in) : in_(in) {}
+
+  uint32_t Get(int bits) {
+    uint32_t value = 0;
+    for (int i = 0; i < bits; ++i, ++pos_)
+      value |= uint32_t(in_[pos_ / 8] >> pos_ % 8 & 1) << i;
+    return value;
+  }
+
+ private:
+  const uint8_t* in_;
+  size_t pos_ = 0;
+};
+
+float SrgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f
+                         : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+}
+
+uint8_t ToByte(float v) {
+  return uint8_t(std::clamp(v * 255.f + .5f, 0.f, 255.f));
+}
+
+size_t BlockBytes(TextureCompression::Format format) {
+  switch (format) {
+    case TextureCompression::kBc1:
+    case TextureCompression::kBc4:
+      return 8;
+    case TextureCompression::kBc3:
+    case TextureCompression::kBc5:
+    case TextureCompression::kBc7:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+Block LoadBlock(const uint8_t* rgba, size_t width, size_t height, size_t bx,
+                size_t by) {
+  Block block;
+  for (size_t y = 0; y < 4; ++y) {
+    for (size_t x = 0; x < 4; ++x) {
+      auto sx = std::min(bx * 4 + x, width - 1);
+      auto sy = std::min(by * 4 + y, height - 1);
+      std::memcpy(block[y * 4 + x].data(), rgba + (sy * width + sx) * 4, 4);
+    }
+  }
+  return block;
+}
+
+void StoreBlock(const Block& block, size_t width, size_t height, size_t bx,
+                size_t by, uint8_t* rgba) {
+  for (size_t y = 0; y < 4 && by * 4 + y < height; ++y)
+    for (size_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+      std::memcpy(rgba + ((by * 4 + y) * width + bx * 4 + x) * 4,
+                  block[y * 4 + x].data(), 4);
+}
+
+// Endpoints at the extremes of the block projected on its principal axis.
+template <int N>
+void FitLine(const Block& block, std::array<float, N>& lo,
+             std::array<float, N>& hi) {
+  std::array<float, N> mean = {};
+  for (auto& texel : block)
+    for (int c = 0; c < N; ++c) mean[c] += texel[c] / 16.f;
+
+  float cov[N][N] = {};
+  for (auto& texel : block)
+    for (int i = 0; i < N; ++i)
+      for (int j = 0; j < N; ++j)
+        cov[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+
+  int start = 0;
+  for (int i = 1; i < N; ++i)
+    if (cov[i][i] > cov[start][start]) start = i;
+
+  std::array<float, N> axis;
+  for (int i = 0; i < N; ++i) axis[i] = cov[start][i];
+  for (int iter = 0; iter < 8; ++iter) {
+    std::array<float, N> next = {};
+    float scale = 0.f;
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) next[i] += cov[i][j] * axis[j];
+      scale = std::max(scale, std::abs(next[i]));
+    }
+    if (scale == 0.f) break;
+    for (int i = 0; i < N; ++i) axis[i] = next[i] / scale;
+  }
+
+  float length = 0.f;
+  for (int i = 0; i < N; ++i) length += axis[i] * axis[i];
+  if (length < 1e-12f) {
+    lo = hi = mean;
+    return;
+  }
+
+  float t_min = std::numeric_limits<float>::max(), t_max = -t_min;
+  for (auto& texel : block) {
+    float t = 0.f;
+    for (int c = 0; c < N; ++c) t += (texel[c] - mean[c]) * axis[c];
+    t_min = std::min(t_min, t);
+    t_max = std::max(t_max, t);
+  }
+
+  for (int c = 0; c < N; ++c) {
+    lo[c] = std::clamp(mean[c] + axis[c] * t_min / length, 0.f, 255.f);
+    hi[c] = std::clamp(mean[c] + axis[c] * t_max / length, 0.f, 255.f);
+  }
+}
+
+// Least squares endpoints for texel = (1 - t) * lo + t * hi given each
+// texel's interpolation weight. Returns false for degenerate weights.
+template <int N>
+bool RefineLine(const Block& block, const float* weights,
+                std::array<float, N>& lo, std::array<float, N>& hi) {
+  float aa = 0.f, ab = 0.f, bb = 0.f;
+  std::array<float, N> ax = {}, bx = {};
+  for (int i = 0; i < 16; ++i) {
+    float b = weights[i], a = 1.f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < N; ++c) {
+      ax[c] += a * block[i][c];
+      bx[c] += b * block[i][c];
+    }
+  }
+
+  float det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-6f) return false;
+  for (int c = 0; c < N; ++c) {
+    lo[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.f, 255.f);
+    hi[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.f, 255.f);
+  }
+  return true;
+}
+
+template <int N>
+uint32_t AssignIndices(const Block& block, const int (*palette)[4], int count,
+                       int* indices) {
+  uint32_t total = 0;
+  for (int i = 0; i < 16; ++i) {
+    uint32_t best = std::numeric_limits<uint32_t>::max();
+    for (int p = 0; p < count; ++p) {
+      uint32_t error = 0;
+      for (int c = 0; c < N; ++c) {
+        int d = block[i][c] - palette[p][c];
+        error += uint32_t(d * d);
+      }
+      if (error < best) {
+        best = error;
+        indices[i] = p;
+      }
+    }
+    total += best;
+  }
+  return total;
+}
+
+uint16_t To565(const std::array<float, 3>& c) {
+  return uint16_t(int(c[0] * 31.f / 255.f + .5f) << 11 |
+                  int(c[1] * 63.f / 255.f + .5f) << 5 |
+                  int(c[2] * 31.f / 255.f + .5f));
+}
+
+void From565(uint16_t v, int* c) {
+  int r = v >> 11, g = v >> 5 & 63, b = v & 31;
+  c[0] = r << 3 | r >> 2;
+  c[1] = g << 2 | g >> 4;
+  c[2] = b << 3 | b >> 2;
+  c[3] = 255;
+}
+
+void ColorPalette(uint16_t c0, uint16_t c1, bool four_color,
+                  int (*palette)[4]) {
+  From565(c0, palette[0]);
+  From565(c1, palette[1]);
+  for (int c = 0; c < 3; ++c) {
+    if (four_color) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = four_color ? 255 : 0;
+}
+
+// Four color BC1 block, also the color half of BC3.
+void EncodeColorBlock(const Block& block, uint8_t* out) {
+  constexpr float kWeights[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+
+  std::array<float, 3> lo, hi;
+  FitLine<3>(block, lo, hi);
+
+  uint32_t best_error = std::numeric_limits<uint32_t>::max();
+  uint16_t best_c0 = 0, best_c1 = 0;
+  int best_indices[16] = {}, indices[16] = {};
+  for (int iter = 0; iter < 3; ++iter) {
+    auto c0 = To565(hi), c1 = To565(lo);
+    if (c0 < c1) std::swap(c0, c1);
+
+    int palette[4][4];
+    ColorPalette(c0, c1, true, palette);
+    auto error = AssignIndices<3>(block, palette, c0 == c1 ? 1 : 4, indices);
+    if (error < best_error) {
+      best_error = error;
+      best_c0 = c0;
+      best_c1 = c1;
+      std::copy(indices, indices + 16, best_indices);
+    }
+    if (error == 0 || c0 == c1) break;
+
+    float weights[16];
+    for (int i = 0; i < 16; ++i) weights[i] = kWeights[indices[i]];
+    if (!RefineLine<3>(block, weights, lo, hi)) break;
+  }
+
+  BitWriter writer(out);
+  writer.Put(best_c0, 16);
+  writer.Put(best_c1, 16);
+  for (auto index : best_indices) writer.Put(uint32_t(index), 2);
+}
+
+void ChannelPalette(int r0, int r1, int* palette) {
+  palette[0] = r0;
+  palette[1] = r1;
+  if (r0 > r1) {
+    for (int i = 1; i < 7; ++i)
+      palette[i + 1] = ((7 - i) * r0 + i * r1) / 7;
+  } else {
+    for (int i = 1; i < 5; ++i)
+      palette[i + 1] = ((5 - i) * r0 + i * r1) / 5;
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+// Single channel block used by BC4, both halves of BC5 and BC3 alpha.
+void EncodeChannelBlock(const Block& block, int channel, uint8_t* out) {
+  int lo = 255, hi = 0;
+  for (auto& texel : block) {
+    lo = std::min<int>(lo, texel[channel]);
+    hi = std::max<int>(hi, texel[channel]);
+  }
+
+  int palette[8];
+  ChannelPalette(hi, lo, palette);
+
+  BitWriter writer(out);
+  writer.Put(uint32_t(hi), 8);
+  writer.Put(uint32_t(lo), 8);
+  for (auto& texel : block) {
+    int best = 0;
+    for (int p = 1; p < (hi == lo ? 1 : 8); ++p)
+      if (std::abs(texel[channel] - palette[p]) <
+          std::abs(texel[channel] - palette[best]))
+        best = p;
+    writer.Put(uint32_t(best), 3);
+  }
+}
+
+// BC7 mode 6 only: one subset, 7.7.7.7 endpoints with a p-bit each and
+// 4 bit indices. Good enough for everything the engine samples as RGBA.
+void EncodeBc7Block(const Block& block, uint8_t* out) {
+  std::array<float, 4> lo, hi;
+  FitLine<4>(block, lo, hi);
+
+  uint32_t best_error = std::numeric_limits<uint32_t>::max();
+  int best_q[2][4] = {}, best_p[2] = {}, best_indices[16] = {};
+  int indices[16];
+  for (int iter = 0; iter < 2; ++iter) {
+    for (int p0 = 0; p0 < 2; ++p0) {
+      for (int p1 = 0; p1 < 2; ++p1) {
+        int q[2][4], ends[2][4], palette[16][4];
+        for (int c = 0; c < 4; ++c) {
+          q[0][c] = std::clamp(int((lo[c] - p0) / 2.f + .5f), 0, 127);
+          q[1][c] = std::clamp(int((hi[c] - p1) / 2.f + .5f), 0, 127);
+          ends[0][c] = q[0][c] << 1 | p0;
+          ends[1][c] = q[1][c] << 1 | p1;
+        }
+        for (int i = 0; i < 16; ++i)
+          for (int c = 0; c < 4; ++c)
+            palette[i][c] = ((64 - kBc7Weights[i]) * ends[0][c] +
+                             kBc7Weights[i] * ends[1][c] + 32) >>
+                            6;
+
+        auto error = AssignIndices<4>(block, palette, 16, indices);
+        if (error < best_error) {
+          best_error = error;
+          std::memcpy(best_q, q, sizeof(q));
+          best_p[0] = p0;
+          best_p[1] = p1;
+          std::copy(indices, indices + 16, best_indices);
+        }
+      }
+    }
+    if (best_error == 0) break;
+
+    float weights[16];
+    for (int i = 0; i < 16; ++i)
+      weights[i] = kBc7Weights[best_indices[i]] / 64.f;
+    if (!RefineLine<4>(block, weights, lo, hi)) break;
+  }
+
+  // The anchor index drops its top bit, flip the line if it is set.
+  if (best_indices[0] & 8) {
+    std::swap(best_q[0], best_q[1]);
+    std::swap(best_p[0], best_p[1]);
+    for (auto& index : best_indices) index = 15 - index;
+  }
+
+  BitWriter writer(out);
+  writer.Put(1 << 6, 7);
+  for (int c = 0; c < 4; ++c) {
+    writer.Put(uint32_t(best_q[0][c]), 7);
+    writer.Put(uint32_t(best_q[1][c]), 7);
+  }
+  writer.Put(uint32_t(best_p[0]), 1);
+  writer.Put(uint32_t(best_p[1]), 1);
+  for (int i = 0; i < 16; ++i)
+    writer.Put(uint32_t(best_indices[i]), i == 0 ? 3 : 4);
+}
+
+void DecodeColorBlock(const uint8_t* in, bool force_four_color, Block& block) {
+  BitReader reader(in);
+  auto c0 = uint16_t(reader.Get(16)), c1 = uint16_t(reader.Get(16));
+
+  int palette[4][4];
+  ColorPalette(c0, c1, force_four_color || c0 > c1, palette);
+  for (auto& texel : block) {
+    auto index = reader.Get(2);
+    for (int c = 0; c < 4; ++c) texel[c] = uint8_t(palette[index][c]);
+  }
+}
+
+void DecodeChannelBlock(const uint8_t* in, int channel, Block& block) {
+  BitReader reader(in);
+  int r0 = int(reader.Get(8)), r1 = int(reader.Get(8));
+
+  int palette[8];
+  ChannelPalette(r0, r1, palette);
+  for (auto& texel : block) texel[channel] = uint8_t(palette[reader.Get(3)]);
+}
+
+void DecodeBc7Block(const uint8_t* in, Block& block) {
+  BitReader reader(in);
+  if (reader.Get(7) != 1 << 6) {
+    for (auto& texel : block) texel.fill(0);
+    return;
+  }
+
+  int ends[2][4];
+  for (int c = 0; c < 4; ++c) {
+    ends[0][c] = int(reader.Get(7)) << 1;
+    ends[1][c] = int(reader.Get(7)) << 1;
+  }
+  auto p0 = int(reader.Get(1)), p1 = int(reader.Get(1));
+  for (int c = 0; c < 4; ++c) {
+    ends[0][c] |= p0;
+    ends[1][c] |= p1;
+  }
+
+  for (int i = 0; i < 16; ++i) {
+    auto w = kBc7Weights[reader.Get(i == 0 ? 3 : 4)];
+    for (int c = 0; c < 4; ++c)
+      block[i][c] = uint8_t(((64 - w) * ends[0][c] + w * ends[1][c] + 32) >> 6);
+  }
+}
+}  // namespace
+
+ct::dyn_array<TextureCompression::Level> TextureCompression::BuildMips(
+    const uint8_t* image, size_t channels, size_t width, size_t height,
+    MipFilter filter) {
+  if (filter == kNormal && channels < 3) filter = kLinear;
+
+  auto to_filter_space = [&](int c, float v) {
+    if (c == 3) return v;
+    if (filter == kSrgb) return SrgbToLinear(v);
+    if (filter == kNormal) return v * 2.f - 1.f;
+    return v;
+  };
+  auto from_filter_space = [&](int c, float v) {
+    if (c == 3) return ToByte(v);
+    if (filter == kSrgb) return ToByte(LinearToSrgb(v));
+    if (filter == kNormal) return ToByte(v * .5f + .5f);
+    return ToByte(v);
+  };
+
+  ct::dyn_array<Level> levels(1, Level(width * height * 4));
+  ct::dyn_array<float> current(width * height * 4);
+  for (size_t i = 0; i < width * height; ++i) {
+    for (size_t c = 0; c < 4; ++c) {
+      uint8_t v = c < channels ? image[i * channels + c] : c == 3 ? 255 : 0;
+      levels[0][i * 4 + c] = v;
+      current[i * 4 + c] = to_filter_space(int(c), v / 255.f);
+    }
+  }
+
+  auto mip_count = MipCount(width, height);
+  for (uint32_t mip = 1; mip < mip_count; ++mip) {
+    auto next_width = LevelDim(width, 1), next_height = LevelDim(height, 1);
+    ct::dyn_array<float> next(next_width * next_height * 4);
+    for (size_t y = 0; y < next_height; ++y) {
+      for (size_t x = 0; x < next_width; ++x) {
+        size_t xs[] = {std::min(x * 2, width - 1),
+                       std::min(x * 2 + 1, width - 1)};
+        size_t ys[] = {std::min(y * 2, height - 1),
+                       std::min(y * 2 + 1, height - 1)};
+        auto texel = &next[(y * next_width + x) * 4];
+        for (auto sy : ys)
+          for (auto sx : xs)
+            for (size_t c = 0; c < 4; ++c)
+              texel[c] += current[(sy * width + sx) * 4 + c] * .25f;
+
+        if (filter == kNormal) {
+          auto length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] +
+                                  texel[2] * texel[2]);
+          if (length > 1e-6f) {
+            for (size_t c = 0; c < 3; ++c) texel[c] /= length;
+          } else {
+            texel[0] = texel[1] = 0.f;
+            texel[2] = 1.f;
+          }
+        }
+      }
+    }
+
+    Level level(next.size());
+    for (size_t i = 0; i < next.size(); ++i)
+      level[i] = from_filter_space(int(i % 4), next[i]);
+    levels.push_back(std::move(level));
+
+    current = std::move(next);
+    width = next_width;
+    height = next_height;
+  }
+  return levels;
+}
+
+void TextureCompression::Encode(Format format, const uint8_t* rgba,
+                                size_t width, size_t height, size_t channels,
+                                ct::dyn_array<uint8_t>& out) {
+  auto offset = out.size();
+  out.resize(offset + LevelSize(format, width, height, channels), 0);
+  auto dst = out.data() + offset;
+
+  if (format == kRaw) {
+    for (size_t i = 0; i < width * height; ++i)
+      for (size_t c = 0; c < channels; ++c) *dst++ = rgba[i * 4 + c];
+    return;
+  }
+
+  auto block_bytes = BlockBytes(format);
+  auto blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+  for (size_t by = 0; by < blocks_y; ++by) {
+    for (size_t bx = 0; bx < blocks_x; ++bx, dst += block_bytes) {
+      auto block = LoadBlock(rgba, width, height, bx, by);
+      switch (format) {
+        case kBc1:
+          EncodeColorBlock(block, dst);
+          break;
+        case kBc3:
+          EncodeChannelBlock(block, 3, dst);
+          EncodeColorBlock(block, dst + 8);
+          break;
+        case kBc4:
+          EncodeChannelBlock(block, 0, dst);
+          break;
+        case kBc5:
+          EncodeChannelBlock(block, 0, dst);
+          EncodeChannelBlock(block, 1, dst + 8);
+          break;
+        case kBc7:
+          EncodeBc7Block(block, dst);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+}
+
+void TextureCompression::Decode(Format format, const uint8_t* data,
+                                size_t width, size_t height, size_t channels,
+                                uint8_t* rgba) {
+  if (format == kRaw) {
+    for (size_t i = 0; i < width * height; ++i)
+      for (size_t c = 0; c < 4; ++c)
+        rgba[i * 4 + c] =
+            c < channels ? data[i * channels + c] : c == 3 ? 255 : 0;
+    return;
+  }
+
+  auto block_bytes = BlockBytes(format);
+  auto blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+  for (size_t by = 0; by < blocks_y; ++by) {
+    for (size_t bx = 0; bx < blocks_x; ++bx, data += block_bytes) {
+      Block block;
+      for (auto& texel : block) texel = {0, 0, 0, 255};
+      switch (format) {
+        case kBc1:
+          DecodeColorBlock(data, false, block);
+          break;
+        case kBc3:
+          DecodeColorBlock(data + 8, true, block);
+          DecodeChannelBlock(data, 3, block);
+          break;
+        case kBc4:
+          DecodeChannelBlock(data, 0, block);
+          break;
+        case kBc5:
+          DecodeChannelBlock(data, 0, block);
+          DecodeChannelBlock(data + 8, 1, block);
+          break;
+        case kBc7:
+          DecodeBc7Block(data, block);
+          break;
+        default:
+          break;
+      }
+      StoreBlock(block, width, height, bx, by, rgba);
+    }
+  }
+}
+
+uint32_t TextureCompression::MipCount(size_t width, size_t height) {
+  uint32_t count = 1;
+  for (auto dim = std::max(width, height); dim > 1; dim >>= 1) ++count;
+  return count;
+}
+
+size_t TextureCompression::LevelDim(size_t dim, uint32_t level) {
+  return std::max(dim >> level, size_t(1));
+}
+
+size_t TextureCompression::LevelSize(Format format, size_t width,
+                                     size_t height, size_t channels) {
+  if (format == kRaw) return width * height * channels;
+  return ((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+const char* TextureCompression::Name(Format format) {
+  switch (format) {
+    case kRaw:
+      return "raw";
+    case kBc1:
+      return "bc1";
+    case kBc3:
+      return "bc3";
+    case kBc4:
+      return "bc4";
+    case kBc5:
+      return "bc5";
+    case kBc7:
+      return "bc7";
+    default:
+      return "unknown";
+  }
+}
+}  // namespace lib_core
@@ -0,0 +1,121 @@
+#include "vertex_packing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace lib_core {
+PackedVertex VertexPacking::Pack(const float* position, const float* normal,
+                                 const float* tangent, const float* texcoord,
+                                 const float* center, const float* extent) {
+  PackedVertex out;
+  for (int c = 0; c < 3; ++c) {
+    auto offset = position[c] - center[c];
+    out.position[c] = ToSnorm16(extent[c] > 0.f ? offset / extent[c] : 0.f);
+  }
+  out.position[3] = 0;
+  out.normal = OctEncode(normal);
+  out.tangent = OctEncode(tangent);
+  for (int c = 0; c < 2; ++c) out.texcoord[c] = ToHalf(texcoord[c]);
+  return out;
+}
+
+std::array<float, 3> VertexPacking::UnpackPosition(const PackedVertex& vertex,
+                                                   const float* center,
+                                                   const float* extent) {
+  std::array<float, 3> position;
+  for (int c = 0; c < 3; ++c)
+    position[c] = center[c] + extent[c] * FromSnorm16(vertex.position[c]);
+  return position;
+}
+
+int16_t VertexPacking::ToSnorm16(float v) {
+  return int16_t(std::lround(std::clamp(v, -1.f, 1.f) * 32767.f));
+}
+
+float VertexPacking::FromSnorm16(int16_t v) {
+  return std::max(v / 32767.f, -1.f);
+}
+
+std::array<int16_t, 2> VertexPacking::OctEncode(const float* n) {
+  auto l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+  if (l1 == 0.f) return {0, 0};
+
+  float x = n[0] / l1, y = n[1] / l1;
+  if (n[2] < 0.f) {
+    auto fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+    auto fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+    x = fx;
+    y = fy;
+  }
+  return {ToSnorm16(x), ToSnorm16(y)};
+}
+
+std::array<float, 3> VertexPacking::OctDecode(const std::array<int16_t, 2>& e) {
+  std::array<float, 3> n = {FromSnorm16(e[0]), FromSnorm16(e[1]), 0.f};
+  n[2] = 1.f - std::abs(n[0]) - std::abs(n[1]);
+  auto t = std::max(-n[2], 0.f);
+  n[0] += n[0] >= 0.f ? -t : t;
+  n[1] += n[1] >= 0.f ? -t : t;
+
+  auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  for (auto& c : n) c /= length;
+  return n;
+}
+
+uint16_t VertexPacking::ToHalf(float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+
+  auto sign = uint16_t(bits >> 16 & 0x8000);
+  auto exponent = int(bits >> 23 & 0xff) - 127 + 15;
+  auto mantissa = bits & 0x7fffff;
+
+  if (exponent >= 31) {
+    bool nan = (bits & 0x7fffffff) > 0x7f800000;
+    return uint16_t(sign | 0x7c00 | (nan ? 0x200 : 0));
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) return sign;
+    mantissa |= 0x800000;
+    auto shift = uint32_t(14 - exponent);
+    auto half = mantissa >> shift;
+    auto rest = mantissa & ((1u << shift) - 1);
+    auto halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) ++half;
+    return uint16_t(sign | half);
+  }
+
+  auto half = uint32_t(exponent) << 10 | mantissa >> 13;
+  auto rest = mantissa & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+  return uint16_t(sign | half);
+}
+
+float VertexPacking::FromHalf(uint16_t h) {
+  uint32_t sign = uint32_t(h & 0x8000) << 16;
+  uint32_t exponent = h >> 10 & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+
+  uint32_t bits;
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      bits = sign;
+    } else {
+      exponent = 127 - 15 + 1;
+      while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        --exponent;
+      }
+      bits = sign | exponent << 23 | (mantissa & 0x3ff) << 13;
+    }
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | mantissa << 13;
+  } else {
+    bits = sign | (exponent - 15 + 127) << 23 | mantissa << 13;
+  }
+
+  float v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+}  // namespace lib_core
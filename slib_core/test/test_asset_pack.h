@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdio>
+#include <fstream>
+#include "asset_pack.h"
+
+namespace lib_core {
+TEST(lib_core, AssetPack_WriteAndFind) {
+  ct::string path = "./test_asset_pack.pak";
+  {
+    AssetPackWriter writer(AssetPack::kTexture);
+    writer.Add("textures\\stone_albedo.png", {1, 2, 3}, {4, 512, 256});
+    writer.Add("wood_albedo.png", {5, 6, 7, 8, 9});
+    writer.Add("dir/grass_albedo.png", {10});
+    ASSERT_TRUE(writer.Save(path));
+  }
+
+  AssetPack pack;
+  ASSERT_TRUE(pack.Open(path));
+  EXPECT_EQ(pack.GetType(), AssetPack::kTexture);
+  EXPECT_EQ(pack.EntryCount(), 3);
+
+  auto entry = pack.Find("stone_albedo.png");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(pack.Name(*entry), "stone_albedo.png");
+  EXPECT_EQ(entry->meta[0], 4);
+  EXPECT_EQ(entry->meta[1], 512);
+  EXPECT_EQ(entry->meta[2], 256);
+
+  auto blob = pack.Blob(*entry);
+  ASSERT_EQ(blob.data.size, 3);
+  EXPECT_EQ(blob.data[2], 3);
+  EXPECT_EQ(blob.codec, Codec::kStore);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(blob.data.data) %
+                AssetPack::kBlobAlignment,
+            0);
+
+  ASSERT_NE(pack.Find("grass_albedo.png"), nullptr);
+  EXPECT_EQ(pack.Blob(*pack.Find("wood_albedo.png")).raw_size, 5);
+  EXPECT_EQ(pack.Find("missing.png"), nullptr);
+
+  pack.Close();
+  std::remove(path.c_str());
+}
+
+TEST(lib_core, AssetPack_StreamingIsDeterministic) {
+  ct::dyn_array<ct::string> names = {"a.png", "b.png", "c.png", "d.png"};
+  auto write_pack = [&](const ct::string& path, ct::dyn_array<size_t> order) {
+    AssetPackWriter writer(AssetPack::kTexture);
+    EXPECT_TRUE(writer.Open(path, names));
+    for (auto slot : order) {
+      if (slot == 2)
+        writer.Skip(slot);
+      else
+        writer.Write(slot, ct::dyn_array<uint8_t>(slot + 1, uint8_t(slot)),
+                     {uint32_t(slot)});
+    }
+    EXPECT_TRUE(writer.Close());
+    return cu::ReadFile(path);
+  };
+
+  auto in_order = write_pack("./test_stream_a.pak", {0, 1, 2, 3});
+  auto reversed = write_pack("./test_stream_b.pak", {3, 2, 1, 0});
+  EXPECT_EQ(in_order, reversed);
+
+  AssetPack pack;
+  ASSERT_TRUE(pack.Open("./test_stream_b.pak"));
+  EXPECT_EQ(pack.EntryCount(), 3);
+  EXPECT_EQ(pack.Find("c.png"), nullptr);
+  auto entry = pack.Find("d.png");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->meta[0], 3);
+  EXPECT_EQ(pack.Blob(*entry).data.size, 4);
+
+  pack.Close();
+  std::remove("./test_stream_a.pak");
+  std::remove("./test_stream_b.pak");
+}
+
+TEST(lib_core, AssetPack_RejectsInvalid) {
+  ct::string path = "./test_asset_pack_invalid.pak";
+  {
+    std::ofstream out(path, std::ios::binary);
+    ct::dyn_array<char> garbage(64, 'x');
+    out.write(garbage.data(), garbage.size());
+  }
+
+  AssetPack pack;
+  EXPECT_FALSE(pack.Open(path));
+  EXPECT_FALSE(pack.IsOpen());
+  EXPECT_FALSE(pack.Open("./does_not_exist.pak"));
+  std::remove(path.c_str());
+}
+}  // namespace lib_core
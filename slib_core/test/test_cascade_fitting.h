@@ -0,0 +1,65 @@
+#pragma once
+#include "cascade_fitting.h"
+
+namespace lib_core {
+TEST(lib_core, CascadeFitting_Splits) {
+  auto uniform = CascadeFitting::Splits(1.f, 101.f, 4, 0.f);
+  ASSERT_EQ(uniform.size(), 5u);
+  for (size_t i = 0; i < uniform.size(); ++i)
+    EXPECT_FLOAT_EQ(uniform[i], 1.f + 25.f * i);
+
+  auto logarithmic = CascadeFitting::Splits(1.f, 1000.f, 3, 1.f);
+  EXPECT_FLOAT_EQ(logarithmic[1], 10.f);
+  EXPECT_FLOAT_EQ(logarithmic[2], 100.f);
+
+  auto blend = CascadeFitting::Splits(.1f, 650.f, 3, .85f);
+  for (size_t i = 1; i < blend.size(); ++i) EXPECT_GT(blend[i], blend[i - 1]);
+}
+
+TEST(lib_core, CascadeFitting_SliceSphere) {
+  auto tan_half = std::tan(.5f), aspect = 16.f / 9.f;
+  Vector3 eye(3.f, 2.f, 1.f), forward(0.f, 0.f, -1.f);
+  auto sphere = CascadeFitting::SliceSphere(eye, forward, 5.f, 40.f,
+                                            tan_half, aspect);
+
+  // Every slice corner is inside, whichever way the camera faces.
+  for (auto d : {5.f, 40.f})
+    for (auto sx : {-1.f, 1.f})
+      for (auto sy : {-1.f, 1.f}) {
+        Vector3 corner(sx * d * tan_half * aspect, sy * d * tan_half, -d);
+        corner += eye;
+        EXPECT_LE((corner - sphere.center).Length(), sphere.radius + 1e-3f);
+      }
+
+  Vector3 turned(.6f, 0.f, .8f);
+  auto other = CascadeFitting::SliceSphere(eye, turned, 5.f, 40.f, tan_half,
+                                           aspect);
+  EXPECT_EQ(other.radius, sphere.radius);
+}
+
+TEST(lib_core, CascadeFitting_TexelSnapping) {
+  CascadeFitting::Sphere sphere{Vector3(10.f, 0.f, 20.f), 32.f};
+  Vector3 dir(.3f, -1.f, .2f);
+  auto a = CascadeFitting::LightMatrix(sphere, dir, 1024, 100.f);
+
+  // The sphere is covered and sits in front of the near plane.
+  auto center = sphere.center;
+  center.Transform(a);
+  EXPECT_LT(std::abs(center[0]), 1.f);
+  EXPECT_LT(std::abs(center[1]), 1.f);
+  EXPECT_GT(center[2], -1.f);
+  EXPECT_LT(center[2], 1.f);
+
+  // Moving the sphere a tiny bit moves the map by whole texels or not at
+  // all, a fixed world point keeps its position within its texel.
+  sphere.center += Vector3(.013f, .002f, -.021f);
+  auto b = CascadeFitting::LightMatrix(sphere, dir, 1024, 100.f);
+  Vector3 pa(4.f, 1.f, 9.f), pb = pa;
+  pa.Transform(a);
+  pb.Transform(b);
+  auto texels = (pb[0] - pa[0]) * 512.f;
+  EXPECT_NEAR(texels, std::round(texels), 1e-2f);
+  texels = (pb[1] - pa[1]) * 512.f;
+  EXPECT_NEAR(texels, std::round(texels), 1e-2f);
+}
+}  // namespace lib_core
@@ -0,0 +1,66 @@
+#pragma once
+#include <climits>
+#include "asset_pack.h"
+#include "codec.h"
+
+namespace lib_core {
+TEST(lib_core, Codec_RoundTrip) {
+  ct::dyn_array<uint8_t> source(100000);
+  for (size_t i = 0; i < source.size(); ++i) source[i] = uint8_t(i / 7 % 13);
+
+  for (uint32_t t = 0; t < Codec::kTypeCount; ++t) {
+    auto type = Codec::Type(t);
+    ct::dyn_array<uint8_t> packed;
+    ASSERT_TRUE(Codec::Compress(type, source.data(), source.size(), packed))
+        << Codec::Name(type);
+    if (type != Codec::kStore) {
+      EXPECT_LT(packed.size(), source.size() / 4);
+    }
+
+    ct::dyn_array<uint8_t> unpacked(source.size());
+    ASSERT_TRUE(Codec::Decompress(type, packed.data(), packed.size(),
+                                  unpacked.data(), unpacked.size()))
+        << Codec::Name(type);
+    EXPECT_EQ(unpacked, source) << Codec::Name(type);
+
+    Codec::Type parsed;
+    EXPECT_TRUE(Codec::Parse(Codec::Name(type), parsed));
+    EXPECT_EQ(parsed, type);
+  }
+}
+
+TEST(lib_core, Codec_RejectsOversizedLz4) {
+  // Only the size is looked at, the data is never read.
+  ct::dyn_array<uint8_t> data(16), out;
+  size_t huge = size_t(INT_MAX) + 1;
+  EXPECT_FALSE(Codec::Compress(Codec::kLz4, data.data(), huge, out));
+  EXPECT_FALSE(
+      Codec::Decompress(Codec::kLz4, data.data(), huge, data.data(), 16));
+  EXPECT_FALSE(
+      Codec::Decompress(Codec::kLz4, data.data(), 16, data.data(), huge));
+}
+
+TEST(lib_core, Codec_PackEntry) {
+  ct::dyn_array<uint8_t> source(4096, 42), packed;
+  ASSERT_TRUE(
+      Codec::Compress(Codec::kLz4, source.data(), source.size(), packed));
+
+  ct::string path = "./test_codec.pak";
+  AssetPackWriter writer(AssetPack::kModel);
+  writer.Add("model.fbx", packed, {1}, Codec::kLz4, source.size());
+  ASSERT_TRUE(writer.Save(path));
+
+  AssetPack pack;
+  ASSERT_TRUE(pack.Open(path));
+  auto blob = pack.Blob(*pack.Find("model.fbx"));
+  EXPECT_EQ(blob.codec, Codec::kLz4);
+  EXPECT_EQ(blob.raw_size, source.size());
+
+  ct::dyn_array<uint8_t> unpacked;
+  ASSERT_TRUE(blob.Unpack(unpacked));
+  EXPECT_EQ(unpacked, source);
+
+  pack.Close();
+  std::remove(path.c_str());
+}
+}  // namespace lib_core
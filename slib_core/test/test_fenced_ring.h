@@ -0,0 +1,84 @@
+#pragma once
+#include <cstring>
+#include "fenced_ring.h"
+
+namespace lib_core {
+namespace {
+class FakeRingBackend : public FencedRing::Backend {
+ public:
+  explicit FakeRingBackend(size_t size) : memory(size, 0) {}
+
+  void Write(size_t offset, const void* data, size_t size) override {
+    ASSERT_LE(offset + size, memory.size());
+    std::memcpy(&memory[offset], data, size);
+  }
+  uint64_t InsertFence() override {
+    pending.push_back(++last_fence);
+    return last_fence;
+  }
+  void WaitFence(uint64_t fence) override {
+    ASSERT_FALSE(pending.empty());
+    EXPECT_EQ(pending.front(), fence);
+    pending.erase(pending.begin());
+    waited.push_back(fence);
+  }
+
+  ct::dyn_array<uint8_t> memory;
+  ct::dyn_array<uint64_t> pending, waited;
+  uint64_t last_fence = 0;
+};
+}  // namespace
+
+TEST(lib_core, FencedRing_AlignsAndWraps) {
+  FakeRingBackend backend(256);
+  FencedRing ring(backend, 256, 64);
+
+  uint8_t data[100];
+  std::memset(data, 7, sizeof(data));
+  EXPECT_EQ(ring.Push(data, 10), 0u);
+  EXPECT_EQ(ring.Push(data, 100), 64u);
+  EXPECT_EQ(backend.memory[64 + 99], 7);
+  ring.EndFrame();
+  EXPECT_EQ(backend.pending.size(), 1u);
+
+  // 192 used, the next 128 bytes wrap and must wait for the first frame.
+  EXPECT_EQ(ring.Push(data, 100), 0u);
+  EXPECT_EQ(backend.waited.size(), 1u);
+  ring.EndFrame();
+
+  EXPECT_EQ(ring.Push(data, 64), 128u);
+  EXPECT_EQ(ring.Push(data, 64), 192u);
+  // Full, but releasing the previous frame frees the front.
+  EXPECT_EQ(ring.Push(data, 1), 0u);
+  EXPECT_EQ(backend.waited.size(), 2u);
+  EXPECT_EQ(ring.FramesInFlight(), 0u);
+
+  // Only the current frame is left, nothing else can be waited for.
+  EXPECT_EQ(ring.Push(data, 64), 64u);
+  EXPECT_EQ(ring.Push(data, 100), FencedRing::kFull);
+  EXPECT_EQ(ring.Push(data, 0), FencedRing::kFull);
+  EXPECT_EQ(ring.Push(data, 257), FencedRing::kFull);
+  ring.EndFrame();
+  EXPECT_EQ(ring.FramesInFlight(), 1u);
+}
+
+TEST(lib_core, FencedRing_OnlyWaitsWhenFull) {
+  FakeRingBackend backend(1024);
+  {
+    FencedRing ring(backend, 1024, 16);
+    uint8_t data[64] = {};
+    for (int frame = 0; frame < 3; ++frame) {
+      for (int i = 0; i < 4; ++i) ring.Push(data, 64);
+      ring.EndFrame();
+    }
+    ring.EndFrame();
+    EXPECT_TRUE(backend.waited.empty());
+    EXPECT_EQ(ring.FramesInFlight(), 3u);
+
+    for (int i = 0; i < 5; ++i) ring.Push(data, 64);
+    EXPECT_EQ(backend.waited.size(), 1u);
+  }
+  EXPECT_EQ(backend.waited.size(), 3u);
+  EXPECT_TRUE(backend.pending.empty());
+}
+}  // namespace lib_core
@@ -0,0 +1,37 @@
+#pragma once
+#include "frame_arena.h"
+
+namespace lib_core {
+TEST(lib_core, FrameArena_StableAndAligned) {
+  FrameArena arena(1024);
+  auto first = arena.Alloc<uint64_t>();
+  *first = 42;
+
+  for (int i = 0; i < 100; ++i) {
+    auto span = arena.AllocSpan<float>(7);
+    EXPECT_EQ(span.size, 7);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(span.data) % alignof(float), 0);
+  }
+
+  auto aligned = arena.Allocate(3000, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+  EXPECT_EQ(*first, 42);
+}
+
+TEST(lib_core, FrameArena_ScopeRewinds) {
+  FrameArena arena(1024);
+  arena.Alloc<int>(4);
+  auto used = arena.Used();
+
+  {
+    ArenaScope scope(arena);
+    std::vector<int, ArenaAllocator<int>> vec{ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 1000; ++i) vec.push_back(i);
+    EXPECT_EQ(vec[999], 999);
+    EXPECT_GT(arena.Used(), used);
+  }
+
+  EXPECT_EQ(arena.Used(), used);
+  EXPECT_GT(arena.HighWater(), used);
+}
+}  // namespace lib_core
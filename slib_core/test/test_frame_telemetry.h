@@ -0,0 +1,33 @@
+#pragma once
+#include "frame_telemetry.h"
+
+namespace lib_core {
+TEST(lib_core, FrameTelemetry_Percentiles) {
+  FrameTelemetry telemetry;
+  for (int i = 1; i <= 100; ++i)
+    telemetry.Record(FrameTelemetry::kUpdate, float(i));
+
+  auto stats = telemetry.GetStats(FrameTelemetry::kUpdate);
+  EXPECT_EQ(stats.count, 100);
+  EXPECT_FLOAT_EQ(stats.p50, 50.f);
+  EXPECT_FLOAT_EQ(stats.p99, 99.f);
+  EXPECT_FLOAT_EQ(stats.max, 100.f);
+  EXPECT_FLOAT_EQ(telemetry.Last(FrameTelemetry::kUpdate), 100.f);
+
+  EXPECT_TRUE(telemetry.WithinBudget(FrameTelemetry::kUpdate, 95.f, 96.f));
+  EXPECT_FALSE(telemetry.WithinBudget(FrameTelemetry::kUpdate, 99.f, 16.f));
+  EXPECT_EQ(telemetry.Count(FrameTelemetry::kRender), 0);
+}
+
+TEST(lib_core, FrameTelemetry_Wraparound) {
+  FrameTelemetry telemetry;
+  for (size_t i = 0; i < FrameTelemetry::kHistorySize * 2; ++i)
+    telemetry.Record(FrameTelemetry::kRender, i < FrameTelemetry::kHistorySize
+                                                  ? 100.f
+                                                  : 1.f);
+
+  EXPECT_EQ(telemetry.Count(FrameTelemetry::kRender),
+            FrameTelemetry::kHistorySize);
+  EXPECT_FLOAT_EQ(telemetry.GetStats(FrameTelemetry::kRender).max, 1.f);
+}
+}  // namespace lib_core
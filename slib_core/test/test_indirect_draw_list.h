@@ -0,0 +1,40 @@
+#pragma once
+#include "indirect_draw_list.h"
+
+namespace lib_core {
+TEST(lib_core, IndirectDrawList_Commands) {
+  IndirectDrawList list;
+  EXPECT_TRUE(list.Add(0, 36, 0, 4, 0));
+  EXPECT_TRUE(list.Add(36, 96, 24, 2, 4));
+  EXPECT_FALSE(list.Add(36, 96, 24, 0, 6));
+  EXPECT_FALSE(list.Add(36, 0, 24, 3, 6));
+
+  auto& commands = list.Commands();
+  ASSERT_EQ(commands.size(), 2u);
+  EXPECT_EQ(commands[1].index_count, 96u);
+  EXPECT_EQ(commands[1].instance_count, 2u);
+  EXPECT_EQ(commands[1].first_index, 36u);
+  EXPECT_EQ(commands[1].base_vertex, 24);
+  EXPECT_EQ(commands[1].base_instance, 4u);
+  EXPECT_EQ(sizeof(DrawIndexedIndirect), 20u);
+
+  list.Clear();
+  EXPECT_TRUE(list.Empty());
+}
+
+TEST(lib_core, IndirectDrawList_FoldsContinuedInstances) {
+  IndirectDrawList list;
+  EXPECT_TRUE(list.Add(0, 36, 0, 4, 10));
+  EXPECT_FALSE(list.Add(0, 36, 0, 6, 14));
+  // Same mesh but a gap in the instances, or another mesh in between.
+  EXPECT_TRUE(list.Add(0, 36, 0, 1, 30));
+  EXPECT_TRUE(list.Add(36, 12, 8, 1, 31));
+  EXPECT_TRUE(list.Add(0, 36, 0, 1, 32));
+
+  auto& commands = list.Commands();
+  ASSERT_EQ(commands.size(), 4u);
+  EXPECT_EQ(commands[0].instance_count, 10u);
+  EXPECT_EQ(commands[0].base_instance, 10u);
+  EXPECT_EQ(commands[1].base_instance, 30u);
+}
+}  // namespace lib_core
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include "loader_pool.h"
+
+namespace lib_core {
+TEST(lib_core, LoaderPool_PriorityBumpAndCancel) {
+  // The order below needs a single worker, whatever ran before.
+  g_loader_pool.Start(2);
+  EXPECT_EQ(g_loader_pool.WorkerCount(), 2);
+  g_loader_pool.Start(1);
+  ASSERT_EQ(g_loader_pool.WorkerCount(), 1);
+
+  std::atomic<bool> blocked = {false}, release = {false};
+  g_loader_pool.Submit([&]() {
+    blocked = true;
+    while (!release) std::this_thread::yield();
+  });
+  while (!blocked) std::this_thread::yield();
+
+  ct::dyn_array<int> order;
+  auto record = [&](int i) { return [&order, i]() { order.push_back(i); }; };
+  g_loader_pool.Submit(record(0), LoaderPool::kLow);
+  auto bumped = g_loader_pool.Submit(record(1), LoaderPool::kLow);
+  g_loader_pool.Submit(record(2), LoaderPool::kNormal);
+  auto cancelled = g_loader_pool.Submit(record(3), LoaderPool::kHigh);
+
+  EXPECT_TRUE(g_loader_pool.Bump(bumped, LoaderPool::kCritical));
+  EXPECT_TRUE(g_loader_pool.Cancel(cancelled));
+  release = true;
+  g_loader_pool.WaitIdle();
+
+  EXPECT_EQ(order, ct::dyn_array<int>({1, 2, 0}));
+  EXPECT_FALSE(g_loader_pool.Bump(bumped, LoaderPool::kCritical));
+  EXPECT_FALSE(g_loader_pool.Cancel(bumped));
+}
+
+TEST(lib_core, LoaderPool_Completion) {
+  int owner_a = 0, owner_b = 0;
+  bool done_a = false, done_b = false;
+  g_loader_pool.Submit([]() {}, LoaderPool::kNormal,
+                       [&]() { done_a = true; }, &owner_a);
+  g_loader_pool.Submit([]() {}, LoaderPool::kNormal,
+                       [&]() { done_b = true; }, &owner_b);
+  g_loader_pool.WaitIdle();
+
+  g_loader_pool.CancelOwner(&owner_b);
+  EXPECT_EQ(g_loader_pool.DispatchCompleted(), 1);
+  EXPECT_TRUE(done_a);
+  EXPECT_FALSE(done_b);
+  EXPECT_EQ(g_loader_pool.Pending(), 0);
+}
+
+TEST(lib_core, LoaderPool_ConcurrentFirstSubmits) {
+  g_loader_pool.Stop();
+  ASSERT_EQ(g_loader_pool.WorkerCount(), 0);
+
+  std::atomic<int> ran = {0};
+  ct::dyn_array<std::thread> submitters;
+  for (int i = 0; i < 4; ++i)
+    submitters.emplace_back([&]() {
+      g_loader_pool.Submit([&]() { ++ran; });
+    });
+  for (auto& submitter : submitters) submitter.join();
+  g_loader_pool.WaitIdle();
+
+  EXPECT_EQ(ran, 4);
+  EXPECT_GT(g_loader_pool.WorkerCount(), 0);
+}
+}  // namespace lib_core
@@ -0,0 +1,69 @@
+#pragma once
+#include <filesystem>
+#include "logger.h"
+
+namespace lib_core {
+namespace {
+// Points the logger at a file in the temp directory and removes it again
+// once the test is done.
+class ScopedLogFile {
+ public:
+  ScopedLogFile()
+      : path_((std::filesystem::temp_directory_path() / "test_logfile.txt")
+                  .string()) {
+    g_logger.SetOutput(path_);
+  }
+  ~ScopedLogFile() {
+    g_logger.SetOutput("./logfile.txt");
+    std::filesystem::remove(path_);
+  }
+
+  const ct::string& Path() const { return path_; }
+
+ private:
+  ct::string path_;
+};
+}  // namespace
+
+TEST(lib_core, Logger_FlushAppendsToFile) {
+  ScopedLogFile log_file;
+  g_logger.Log(Logger::kWarning, "test warning", __FILE__, __LINE__);
+  g_logger.Flush();
+
+  auto content = cu::ReadFile(log_file.Path());
+  EXPECT_NE(content.find("Warning: test_logger.h"), ct::string::npos);
+  EXPECT_NE(content.find("test warning"), ct::string::npos);
+}
+
+TEST(lib_core, Logger_RateLimitsCallSite) {
+  ScopedLogFile log_file;
+  g_logger.SetRateLimit(5);
+  auto suppressed = g_logger.Suppressed();
+  for (int i = 0; i < 100; ++i)
+    g_logger.Log(Logger::kInfo, "test storm", __FILE__, __LINE__);
+  g_logger.Flush();
+  g_logger.SetRateLimit(20);
+
+  EXPECT_GE(g_logger.Suppressed() - suppressed, 90);
+  EXPECT_EQ(g_logger.Dropped(), 0);
+}
+
+TEST(lib_core, Logger_ReusesBuffersOfExitedThreads) {
+  ScopedLogFile log_file;
+  auto dropped = g_logger.Dropped();
+  auto overflowed = g_logger.Overflowed();
+  g_logger.SetRateLimit(0);
+  for (size_t i = 0; i < Logger::kMaxThreads * 2; ++i)
+    std::thread([i]() {
+      auto message = "test thread " + std::to_string(i);
+      g_logger.Log(Logger::kInfo, message.c_str(), __FILE__, __LINE__);
+    }).join();
+  g_logger.Flush();
+  g_logger.SetRateLimit(20);
+
+  EXPECT_EQ(g_logger.Dropped(), dropped);
+  EXPECT_EQ(g_logger.Overflowed(), overflowed);
+  auto content = cu::ReadFile(log_file.Path());
+  EXPECT_NE(content.find("test thread 127"), ct::string::npos);
+}
+}  // namespace lib_core
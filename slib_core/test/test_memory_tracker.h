@@ -0,0 +1,37 @@
+#pragma once
+#include "memory_tracker.h"
+
+namespace lib_core {
+TEST(lib_core, MemoryTracker_HighWater) {
+  auto tag = MemoryTracker::kParticles;
+  auto base = g_mem_tracker.Current(tag);
+  g_mem_tracker.ResetHighWater();
+
+  g_mem_tracker.Allocated(tag, 1000);
+  g_mem_tracker.Allocated(tag, 500);
+  g_mem_tracker.Freed(tag, 1000);
+
+  EXPECT_EQ(g_mem_tracker.Current(tag), base + 500);
+  EXPECT_EQ(g_mem_tracker.HighWater(tag), base + 1500);
+
+  g_mem_tracker.Freed(tag, 500);
+  EXPECT_EQ(g_mem_tracker.Current(tag), base);
+}
+
+TEST(lib_core, MemoryTracker_TrackingAllocator) {
+  auto tag = MemoryTracker::kPhysics;
+  auto base = g_mem_tracker.GetStats(tag);
+
+  TrackingAllocator allocator(tag);
+  auto ptr = allocator.Allocate(256, 64);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+  EXPECT_EQ(g_mem_tracker.Current(tag), base.current + 256);
+
+  allocator.Deallocate(ptr, 256, 64);
+  auto stats = g_mem_tracker.GetStats(tag);
+  EXPECT_EQ(stats.current, base.current);
+  EXPECT_EQ(stats.allocations, base.allocations + 1);
+  EXPECT_EQ(stats.frees, base.frees + 1);
+}
+}  // namespace lib_core
@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include "particle_batcher.h"
+
+namespace lib_core {
+TEST(lib_core, ParticleBatcher_RadixSort) {
+  EXPECT_LT(ParticleBatcher::FloatKey(-2.f), ParticleBatcher::FloatKey(-1.f));
+  EXPECT_LT(ParticleBatcher::FloatKey(-1.f), ParticleBatcher::FloatKey(0.f));
+  EXPECT_LT(ParticleBatcher::FloatKey(0.f), ParticleBatcher::FloatKey(.5f));
+  EXPECT_LT(ParticleBatcher::FloatKey(.5f), ParticleBatcher::FloatKey(3.f));
+
+  // Equal upper halves keep their order.
+  ct::dyn_array<uint64_t> keys(1000), scratch(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto depth = ParticleSimulator::Random(3, i) * 200.f - 100.f;
+    uint64_t key = ParticleBatcher::FloatKey(std::floor(depth));
+    keys[i] = key << 32 | i;
+  }
+  auto expected = keys;
+  std::stable_sort(
+      expected.begin(), expected.end(),
+      [](uint64_t a, uint64_t b) { return a >> 32 < b >> 32; });
+  ParticleBatcher::RadixSort(keys.data(), scratch.data(), keys.size());
+  EXPECT_EQ(keys, expected);
+}
+
+TEST(lib_core, ParticleBatcher_BatchesBackToFront) {
+  // Emitter 1 and 3 are alpha blended with the same texture, 2 is additive.
+  ParticleSimulator::Output particles;
+  float depths[] = {-1.f, -5.f, -3.f, -2.f, -4.f, -6.f, -7.f, -8.f};
+  for (auto depth : depths) {
+    particles.instances.push_back({});
+    particles.instances.back().position[2] = depth;
+  }
+  particles.ranges[1] = {0, 3};
+  particles.ranges[2] = {3, 2};
+  particles.ranges[3] = {5, 3};
+  particles.ranges[4] = {8, 0};
+
+  ct::dyn_array<ParticleBatcher::Emitter> emitters = {
+      {1, ParticleBatcher::kAlpha, 7},
+      {2, ParticleBatcher::kAdditive, 7},
+      {3, ParticleBatcher::kAlpha, 7},
+      {4, ParticleBatcher::kAlpha, 9},
+      {5, ParticleBatcher::kAlpha, 9}};
+
+  Matrix4x4 view;
+  view.Lookat({0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 1.f, 0.f});
+
+  ParticleBatcher batcher;
+  ParticleBatcher::View out;
+  batcher.Build(particles, emitters, view, out);
+
+  ASSERT_EQ(out.batches.size(), 2u);
+  EXPECT_EQ(out.batches[0].blend, ParticleBatcher::kAdditive);
+  EXPECT_EQ(out.batches[0].count, 2u);
+  EXPECT_EQ(out.batches[1].blend, ParticleBatcher::kAlpha);
+  EXPECT_EQ(out.batches[1].first, 2u);
+  EXPECT_EQ(out.batches[1].count, 6u);
+  ASSERT_EQ(out.instances.size(), 8u);
+
+  // Additive particles keep their order, alpha ones go back to front.
+  EXPECT_EQ(out.instances[0].position[2], -2.f);
+  EXPECT_EQ(out.instances[1].position[2], -4.f);
+  float expected[] = {-8.f, -7.f, -6.f, -5.f, -3.f, -1.f};
+  for (size_t i = 0; i < 6; ++i)
+    EXPECT_EQ(out.instances[2 + i].position[2], expected[i]);
+}
+}  // namespace lib_core
@@ -0,0 +1,127 @@
+#pragma once
+#include "particle_simulator.h"
+
+namespace lib_core {
+TEST(lib_core, ParticleSimulator_Random) {
+  EXPECT_EQ(ParticleSimulator::Random(7, 3), ParticleSimulator::Random(7, 3));
+  EXPECT_NE(ParticleSimulator::Random(7, 3), ParticleSimulator::Random(8, 3));
+
+  double sum = 0.0;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    auto value = ParticleSimulator::Random(1, i);
+    ASSERT_GE(value, 0.f);
+    ASSERT_LT(value, 1.f);
+    sum += value;
+  }
+  EXPECT_NEAR(sum / 10000.0, .5, .02);
+}
+
+TEST(lib_core, ParticleSimulator_EmitsAndRetires) {
+  ParticleSimulator simulator;
+  ParticleSimulator::Output out;
+
+  ParticleSimulator::EmitterFrame looping{1, {}, Vector3(0.f), 0.f};
+  looping.desc.emitting_speed = 8.f;
+  looping.desc.particle_life = 1.f;
+  looping.desc.max_particles = 100;
+
+  ParticleSimulator::EmitterFrame burst{2, {}, Vector3(0.f), 0.f};
+  burst.desc.shape = ParticleSimulator::kSphere;
+  burst.desc.type_data = {1.f, 1.f, 1.f, 2.f};
+  burst.desc.loop = false;
+  burst.desc.emitting_speed = 1000.f;
+  burst.desc.max_particles = 5;
+
+  // A steady rate times the life, and a one shot capped at max_particles.
+  for (int step = 1; step <= 40; ++step) {
+    looping.time = burst.time = step * .125f;
+    simulator.Update({looping, burst}, out);
+    if (step >= 9) {
+      EXPECT_EQ(out.ranges[1].second, 9u);
+    }
+    if (step <= 17) {
+      EXPECT_EQ(out.ranges[2].second, 5u);
+    }
+  }
+  EXPECT_EQ(out.ranges[2].second, 0u);
+  EXPECT_EQ(out.ranges[2].first, out.ranges[1].second);
+  EXPECT_EQ(out.instances.size(), out.ranges[1].second);
+
+  simulator.Update({looping}, out);
+  EXPECT_EQ(simulator.EmitterCount(), 1u);
+  EXPECT_EQ(out.ranges.count(2), 0u);
+}
+
+TEST(lib_core, ParticleSimulator_Evaluates) {
+  ParticleSimulator simulator;
+  ParticleSimulator::Output out;
+
+  ParticleSimulator::EmitterFrame frame{1, {}, Vector3(1.f, 2.f, 3.f), 0.f};
+  auto& desc = frame.desc;
+  desc.loop = false;
+  desc.max_particles = 1;
+  desc.random_scale = 0.f;
+  desc.center_velocity = 0.f;
+  desc.start_velocity = {1.f, 0.f, 0.f};
+  desc.end_velocity = 1.f;
+  desc.gravity = {0.f, -1.f, 0.f};
+  desc.start_size = {1.f, 1.f};
+  desc.end_size = {3.f, 3.f};
+  desc.start_color = {1.f, 1.f, 1.f, 1.f};
+  desc.end_color = {0.f, 0.f, 0.f, 1.f};
+  desc.rotate_speed = {0.f, 0.f};
+
+  frame.time = 1.f;
+  simulator.Update({frame}, out);
+  ASSERT_EQ(out.instances.size(), 1u);
+
+  // Constant speed over half the life, gravity scaled by the normalized age.
+  frame.time = 2.f;
+  simulator.Update({frame}, out);
+  ASSERT_EQ(out.instances.size(), 1u);
+  auto& p = out.instances[0];
+  EXPECT_NEAR(p.position[0], 2.f, 1e-5f);
+  EXPECT_NEAR(p.position[1], 1.5f, 1e-5f);
+  EXPECT_NEAR(p.position[2], 3.f, 1e-5f);
+  EXPECT_NEAR(p.size, 2.f, 1e-5f);
+  EXPECT_NEAR(p.color[0], .5f, 1e-5f);
+  EXPECT_NEAR(p.color[3], .5f * .25f * 6.7f, 1e-5f);
+  EXPECT_NEAR(p.rotation, 0.f, 1e-5f);
+}
+
+TEST(lib_core, ParticleSimulator_WrapsRing) {
+  ParticleSimulator simulator;
+  ParticleSimulator::Output out;
+
+  // One particle a step living three steps fills a three particle ring, so
+  // every step retires one and wraps the next one around.
+  ParticleSimulator::EmitterFrame frame{1, {}, Vector3(0.f), 0.f};
+  auto& desc = frame.desc;
+  desc.emitting_speed = 8.f;
+  desc.particle_life = .3f;
+  desc.max_particles = 3;
+  desc.random_scale = 0.f;
+  desc.center_velocity = 0.f;
+  desc.start_velocity = {1.f, 0.f, 0.f};
+  desc.end_velocity = 1.f;
+
+  for (int step = 1; step <= 20; ++step) {
+    frame.time = step * .125f;
+    simulator.Update({frame}, out);
+    if (step < 3) continue;
+
+    // Oldest first, each has moved as far as it is old.
+    ASSERT_EQ(out.instances.size(), 3u);
+    for (size_t i = 0; i < 3; ++i)
+      EXPECT_NEAR(out.instances[i].position[0], (2 - int(i)) * .125f, 1e-5f);
+  }
+
+  // A larger limit keeps the live particles in order.
+  desc.max_particles = 8;
+  frame.time += .125f;
+  simulator.Update({frame}, out);
+  ASSERT_EQ(out.instances.size(), 3u);
+  EXPECT_NEAR(out.instances[0].position[0], .25f, 1e-5f);
+  EXPECT_NEAR(out.instances[2].position[0], 0.f, 1e-5f);
+}
+}  // namespace lib_core
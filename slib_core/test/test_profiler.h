@@ -0,0 +1,40 @@
+#pragma once
+#include "profiler.h"
+
+#include <thread>
+
+namespace lib_core {
+TEST(lib_core, Profiler_AggregatesRepeatedZones) {
+  for (int i = 0; i < 10; ++i) {
+    PROFILE_ZONE("test_repeated_zone");
+  }
+
+  auto stats = g_profiler.Aggregate();
+  auto it = std::find_if(stats.begin(), stats.end(), [](auto& s) {
+    return s.name == "test_repeated_zone";
+  });
+  ASSERT_NE(it, stats.end());
+  EXPECT_EQ(it->count, 10);
+  EXPECT_LE(it->min, it->avg);
+  EXPECT_LE(it->p99, it->max);
+}
+
+TEST(lib_core, Profiler_NestingAndThreads) {
+  std::thread worker([]() {
+    g_profiler.SetThreadName("test_worker");
+    PROFILE_ZONE("test_outer_zone");
+    PROFILE_ZONE("test_inner_zone");
+  });
+  worker.join();
+
+  uint32_t outer_depth = 0, inner_depth = 0, outer_tid = 0, inner_tid = 1;
+  for (auto& p : g_profiler.Snapshot()) {
+    if (ct::string(p.second.name) == "test_outer_zone")
+      outer_depth = p.second.depth, outer_tid = p.first;
+    if (ct::string(p.second.name) == "test_inner_zone")
+      inner_depth = p.second.depth, inner_tid = p.first;
+  }
+  EXPECT_EQ(inner_depth, outer_depth + 1);
+  EXPECT_EQ(inner_tid, outer_tid);
+}
+}  // namespace lib_core
@@ -0,0 +1,48 @@
+#pragma once
+#include "range_allocator.h"
+
+namespace lib_core {
+TEST(lib_core, RangeAllocator_FirstFitAndMerge) {
+  RangeAllocator ranges(100);
+  EXPECT_EQ(ranges.Allocate(30), 0u);
+  EXPECT_EQ(ranges.Allocate(30), 30u);
+  EXPECT_EQ(ranges.Allocate(40), 60u);
+  EXPECT_EQ(ranges.Allocate(1), RangeAllocator::kInvalid);
+  EXPECT_EQ(ranges.Used(), 100u);
+
+  ranges.Free(0, 30);
+  ranges.Free(60, 40);
+  EXPECT_EQ(ranges.Allocate(45), RangeAllocator::kInvalid);
+  EXPECT_EQ(ranges.Allocate(10), 0u);
+
+  // Freeing the middle joins both neighbours into one run.
+  ranges.Free(30, 30);
+  EXPECT_EQ(ranges.Allocate(90), 10u);
+  EXPECT_EQ(ranges.Used(), 100u);
+
+  ranges.Free(10, 90);
+  ranges.Free(0, 10);
+  EXPECT_EQ(ranges.Used(), 0u);
+  EXPECT_EQ(ranges.Allocate(100), 0u);
+}
+
+TEST(lib_core, RangeAllocator_Grow) {
+  RangeAllocator ranges(64);
+  EXPECT_EQ(ranges.Allocate(40), 0u);
+  EXPECT_EQ(ranges.Allocate(40), RangeAllocator::kInvalid);
+
+  // The free tail is extended rather than split in two.
+  ranges.Grow(128);
+  EXPECT_EQ(ranges.Allocate(80), 40u);
+  EXPECT_EQ(ranges.Allocate(9), RangeAllocator::kInvalid);
+  EXPECT_EQ(ranges.Allocate(8), 120u);
+
+  ranges.Grow(136);
+  EXPECT_EQ(ranges.Allocate(8), 128u);
+  EXPECT_EQ(ranges.Capacity(), 136u);
+
+  ranges.Reset();
+  EXPECT_EQ(ranges.Used(), 0u);
+  EXPECT_EQ(ranges.Allocate(136), 0u);
+}
+}  // namespace lib_core
@@ -0,0 +1,130 @@
+#pragma once
+#include "render_command_list.h"
+
+namespace lib_core {
+namespace {
+// Writes every call down as a line of text, a captured frame.
+class CaptureBackend : public RenderBackend {
+ public:
+  void SetState(uint32_t state) override {
+    calls.push_back("state " + std::to_string(state));
+  }
+  void BindMaterial(size_t material, size_t light) override {
+    auto call = "material " + std::to_string(material);
+    if (light != RenderCommandList::kNoLight)
+      call.append(" light ").append(std::to_string(light));
+    calls.push_back(call);
+  }
+  void BindBuffer(uint32_t slot, size_t buffer, size_t offset,
+                  size_t size) override {
+    calls.push_back("buffer " + std::to_string(slot) + " " +
+                    std::to_string(buffer) + " " + std::to_string(offset) +
+                    " " + std::to_string(size));
+  }
+  void SetConstants(uint32_t slot, const float* data, size_t count) override {
+    auto call = "constants " + std::to_string(slot);
+    for (size_t i = 0; i < count; ++i)
+      call.append(" ").append(std::to_string(int(data[i])));
+    calls.push_back(call);
+  }
+  void SetTarget(size_t target, uint32_t clear) override {
+    calls.push_back("target " + std::to_string(int64_t(target)) + " " +
+                    std::to_string(clear));
+  }
+  void Draw(size_t mesh, size_t first, size_t count) override {
+    calls.push_back("draw " + std::to_string(int64_t(mesh)) + " " +
+                    std::to_string(first) + " " + std::to_string(count));
+  }
+  void Dispatch(uint32_t x, uint32_t y, uint32_t z) override {
+    calls.push_back("dispatch " + std::to_string(x) + " " +
+                    std::to_string(y) + " " + std::to_string(z));
+  }
+
+  ct::dyn_array<std::string> calls;
+};
+}  // namespace
+
+TEST(lib_core, RenderCommandList_SortsAndReplays) {
+  EXPECT_LT(RenderCommandList::Key(0, 5, 9), RenderCommandList::Key(1, 0, 0));
+  EXPECT_LT(RenderCommandList::Key(1, 0, 9), RenderCommandList::Key(1, 1, 0));
+  EXPECT_LT(RenderCommandList::Key(1, 1, 2), RenderCommandList::Key(1, 1, 3));
+
+  // Two passes recorded separately, the later pass recorded first.
+  RenderCommandList lighting, gbuffer, frame;
+  auto light_key = RenderCommandList::Key(1, 0, 0);
+  lighting.SetState(light_key, RenderCommandList::kBlendAdditive);
+  lighting.BindBuffer(light_key, 2, 11, 256, 64);
+  lighting.Dispatch(light_key, 8, 4, 1);
+  lighting.Dispatch(light_key, 0, 4, 1);
+
+  auto state = RenderCommandList::kDepthTest | RenderCommandList::kDepthWrite;
+  for (uint32_t material : {7u, 3u, 7u}) {
+    auto key = RenderCommandList::Key(0, 0, material);
+    gbuffer.SetState(key, state);
+    gbuffer.BindMaterial(key, material);
+    gbuffer.Draw(key, material * 10, material, 2);
+  }
+  gbuffer.Draw(RenderCommandList::Key(0, 0, 3), 1, 0, 0);
+
+  frame.Append(lighting);
+  frame.Append(gbuffer);
+  frame.Sort();
+
+  CaptureBackend capture;
+  auto stats = frame.Replay(capture);
+  ct::dyn_array<std::string> expected = {
+      "state 3",    "material 3",         "draw 30 3 2",
+      "material 7", "draw 70 7 2",        "draw 70 7 2",
+      "state 8",    "buffer 2 11 256 64", "dispatch 8 4 1"};
+  EXPECT_EQ(capture.calls, expected);
+
+  EXPECT_EQ(stats.commands, 12u);
+  EXPECT_EQ(stats.draws, 3u);
+  EXPECT_EQ(stats.instances, 6u);
+  EXPECT_EQ(stats.dispatches, 1u);
+  EXPECT_EQ(stats.redundant, 3u);
+
+  // A captured list replays the same frame again.
+  auto copy = frame;
+  CaptureBackend again;
+  copy.Replay(again);
+  EXPECT_EQ(again.calls, capture.calls);
+}
+
+TEST(lib_core, RenderCommandList_TargetsAndConstants) {
+  using List = RenderCommandList;
+
+  // A shadow map drawn into its own target ahead of the light reading it.
+  List shadow, light, frame;
+  float matrix[2] = {4.f, 5.f}, position[3] = {1.f, 2.f, 3.f};
+  shadow.BindMaterial(0, 20);
+  shadow.SetConstants(0, 1, position, 3);
+  shadow.SetTarget(0, 9, List::kClearDepth);
+  shadow.Draw(0, 30, 0, 1);
+  shadow.SetTarget(0, List::kViewTarget);
+  position[0] = 7.f;
+
+  light.BindMaterial(1, 21, 5);
+  light.BindMaterial(1, 21, 5);
+  light.BindMaterial(1, 21, 6);
+  light.SetConstants(1, 2, matrix, 2);
+  light.Draw(1, List::kScreenTriangle, 3, 1);
+
+  frame.Append(shadow);
+  frame.Append(light);
+  EXPECT_EQ(frame.Constants().size(), 5u);
+
+  CaptureBackend capture;
+  auto stats = frame.Replay(capture);
+  ct::dyn_array<std::string> expected = {
+      "material 20",         "constants 1 1 2 3", "target 9 2",
+      "draw 30 0 1",         "target -1 0",       "material 21 light 5",
+      "material 21 light 6", "constants 2 4 5",   "draw -1 3 1"};
+  EXPECT_EQ(capture.calls, expected);
+  EXPECT_EQ(stats.redundant, 1u);
+
+  frame.Clear();
+  EXPECT_TRUE(frame.Empty());
+  EXPECT_TRUE(frame.Constants().empty());
+}
+}  // namespace lib_core
@@ -0,0 +1,163 @@
+#pragma once
+#include "shadow_atlas.h"
+
+namespace lib_core {
+namespace {
+// One rendered frame with a single view.
+void Frame(ShadowAtlas& atlas, const ct::dyn_array<ShadowAtlas::Request>& in,
+           ct::dyn_array<ShadowAtlas::Placement>& out) {
+  atlas.BeginFrame();
+  atlas.Update(in, out);
+}
+}  // namespace
+
+TEST(lib_core, ShadowAtlas_CachesAndBudgets) {
+  ShadowAtlas atlas({2, 4}, 1);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+
+  // New slots are drawn right away, after that only when invalidated.
+  Frame(atlas, {{1, 0, true}, {2, 1, false}, {3, 1, false}}, out);
+  ASSERT_EQ(out.size(), 3u);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_EQ(out[1].tier, 1);
+  EXPECT_NE(out[1].slot, out[2].slot);
+  for (auto& p : out) EXPECT_TRUE(p.render);
+
+  Frame(atlas, {{1, 0, true}, {2, 1, false}, {3, 1, false}}, out);
+  for (auto& p : out) EXPECT_FALSE(p.render);
+
+  // Distant lights share the budget, the one waiting longest goes first.
+  atlas.Invalidate(1);
+  atlas.Invalidate(2);
+  atlas.Invalidate(3);
+  Frame(atlas, {{1, 0, true}, {2, 1, false}, {3, 1, false}}, out);
+  EXPECT_TRUE(out[0].render);
+  EXPECT_TRUE(out[1].render);
+  EXPECT_FALSE(out[2].render);
+
+  Frame(atlas, {{1, 0, true}, {2, 1, false}, {3, 1, false}}, out);
+  EXPECT_FALSE(out[0].render);
+  EXPECT_FALSE(out[1].render);
+  EXPECT_TRUE(out[2].render);
+
+  atlas.Discard(2);
+  Frame(atlas, {{1, 0, true}, {2, 1, false}, {3, 1, false}}, out);
+  EXPECT_TRUE(out[1].render);
+}
+
+TEST(lib_core, ShadowAtlas_EvictsAndFallsBack) {
+  ShadowAtlas atlas({1, 1}, 4);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+
+  // The fine tier is taken, so the second light drops a tier and a third
+  // gets no slot at all.
+  Frame(atlas, {{1, 0, true}, {2, 0, true}, {3, 0, true}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_EQ(out[1].tier, 1);
+  EXPECT_EQ(out[2].tier, ShadowAtlas::kNoTier);
+  EXPECT_TRUE(out[2].render);
+
+  // Light 1 is no longer requested and gives up its slot.
+  Frame(atlas, {{3, 0, true}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_TRUE(out[0].render);
+
+  Frame(atlas, {{1, 1, false}}, out);
+  EXPECT_EQ(out[0].tier, 1);
+}
+
+TEST(lib_core, ShadowAtlas_Oversubscribed) {
+  ShadowAtlas atlas({1, 2}, 4);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+
+  // Both lights want the single fine slot, the one that lost keeps its
+  // coarser slot and cached map instead of redrawing every frame.
+  Frame(atlas, {{1, 0, false}, {2, 0, false}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_EQ(out[1].tier, 1);
+  auto slot = out[1].slot;
+  for (size_t i = 0; i < 3 * ShadowAtlas::kTierDelay; ++i) {
+    Frame(atlas, {{1, 0, false}, {2, 0, false}}, out);
+    EXPECT_EQ(out[0].tier, 0);
+    EXPECT_EQ(out[1].tier, 1);
+    EXPECT_EQ(out[1].slot, slot);
+    EXPECT_FALSE(out[0].render);
+    EXPECT_FALSE(out[1].render);
+  }
+
+  // Once the fine slot frees up the waiting light moves over.
+  Frame(atlas, {{2, 0, false}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_TRUE(out[0].render);
+}
+
+TEST(lib_core, ShadowAtlas_KeepsLiveLights) {
+  ShadowAtlas atlas({1, 1}, 4);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+  Frame(atlas, {{3, 0, false}, {1, 1, false}}, out);
+
+  // Light 2 is placed first but every slot belongs to a light requested
+  // this frame, so it gets none and nobody loses theirs.
+  Frame(atlas, {{3, 0, false}, {1, 1, false}, {2, 0, true}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+  EXPECT_EQ(out[1].tier, 1);
+  EXPECT_EQ(out[2].tier, ShadowAtlas::kNoTier);
+  EXPECT_FALSE(out[0].render);
+  EXPECT_FALSE(out[1].render);
+  EXPECT_TRUE(out[2].render);
+}
+
+TEST(lib_core, ShadowAtlas_TierDelay) {
+  ShadowAtlas atlas({4, 4}, 4);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+  Frame(atlas, {{1, 0, false}}, out);
+
+  for (size_t i = 1; i < ShadowAtlas::kTierDelay; ++i) {
+    Frame(atlas, {{1, 1, false}}, out);
+    EXPECT_EQ(out[0].tier, 0);
+  }
+  Frame(atlas, {{1, 1, false}}, out);
+  EXPECT_EQ(out[0].tier, 1);
+  EXPECT_TRUE(out[0].render);
+
+  EXPECT_EQ(ShadowAtlas::TierForCoverage(.8f, 4), 0);
+  EXPECT_EQ(ShadowAtlas::TierForCoverage(.3f, 4), 1);
+  EXPECT_EQ(ShadowAtlas::TierForCoverage(.2f, 4), 2);
+  EXPECT_EQ(ShadowAtlas::TierForCoverage(.001f, 4), 3);
+}
+
+TEST(lib_core, ShadowAtlas_ViewsShareFrame) {
+  ShadowAtlas atlas({4, 4}, 1);
+  ct::dyn_array<ShadowAtlas::Placement> out;
+  Frame(atlas, {{1, 0, false}, {2, 0, false}}, out);
+
+  // Two views in one frame still redraw one light within the budget.
+  atlas.Invalidate(1);
+  atlas.Invalidate(2);
+  atlas.BeginFrame();
+  atlas.Update({{1, 0, false}, {2, 0, false}}, out);
+  EXPECT_NE(out[0].render, out[1].render);
+  atlas.Update({{1, 0, false}, {2, 0, false}}, out);
+  EXPECT_FALSE(out[0].render);
+  EXPECT_FALSE(out[1].render);
+
+  // Every view asking for a coarser tier counts as one frame.
+  for (size_t i = 1; i < ShadowAtlas::kTierDelay; ++i) {
+    atlas.BeginFrame();
+    atlas.Update({{1, 1, false}}, out);
+    atlas.Update({{1, 1, false}}, out);
+    EXPECT_EQ(out[0].tier, 0);
+  }
+  Frame(atlas, {{1, 1, false}}, out);
+  EXPECT_EQ(out[0].tier, 1);
+
+  // A removed light frees its slot, even within the frame that used it.
+  ShadowAtlas single({1}, 1);
+  Frame(single, {{1, 0, true}}, out);
+  single.Update({{2, 0, true}}, out);
+  EXPECT_EQ(out[0].tier, ShadowAtlas::kNoTier);
+  single.Remove(1);
+  single.Update({{2, 0, true}}, out);
+  EXPECT_EQ(out[0].tier, 0);
+}
+}  // namespace lib_core
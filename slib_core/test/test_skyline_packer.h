@@ -0,0 +1,55 @@
+#pragma once
+#include "skyline_packer.h"
+
+namespace lib_core {
+TEST(lib_core, SkylinePacker_NoOverlap) {
+  SkylinePacker packer(64, 64);
+
+  struct Rect {
+    int x, y, w, h;
+  };
+  ct::dyn_array<Rect> rects;
+  for (int i = 0;; ++i) {
+    Rect r = {0, 0, 3 + i * 7 % 11, 2 + i * 5 % 9};
+    if (!packer.Pack(r.w, r.h, r.x, r.y)) break;
+    rects.push_back(r);
+  }
+  EXPECT_GT(rects.size(), 40u);
+
+  int area = 0;
+  for (size_t i = 0; i < rects.size(); ++i) {
+    auto& a = rects[i];
+    EXPECT_GE(a.x, 0);
+    EXPECT_GE(a.y, 0);
+    EXPECT_LE(a.x + a.w, 64);
+    EXPECT_LE(a.y + a.h, 64);
+    area += a.w * a.h;
+    for (size_t j = i + 1; j < rects.size(); ++j) {
+      auto& b = rects[j];
+      EXPECT_TRUE(a.x + a.w <= b.x || b.x + b.w <= a.x || a.y + a.h <= b.y ||
+                  b.y + b.h <= a.y);
+    }
+  }
+  EXPECT_GT(area, 64 * 64 * 3 / 4);
+}
+
+TEST(lib_core, SkylinePacker_Grow) {
+  SkylinePacker packer(16, 8);
+
+  int x, y;
+  EXPECT_TRUE(packer.Pack(16, 8, x, y));
+  EXPECT_FALSE(packer.Pack(4, 4, x, y));
+  EXPECT_FALSE(packer.Pack(17, 1, x, y));
+
+  packer.Grow(16);
+  EXPECT_TRUE(packer.Pack(4, 4, x, y));
+  EXPECT_EQ(x, 0);
+  EXPECT_EQ(y, 8);
+  EXPECT_TRUE(packer.Pack(12, 8, x, y));
+  EXPECT_EQ(x, 4);
+  EXPECT_EQ(y, 8);
+  EXPECT_TRUE(packer.Pack(4, 4, x, y));
+  EXPECT_EQ(x, 0);
+  EXPECT_EQ(y, 12);
+}
+}  // namespace lib_core
@@ -0,0 +1,87 @@
+#pragma once
+#include <cmath>
+#include <tuple>
+#include "texture_compression.h"
+
+namespace lib_core {
+namespace {
+ct::dyn_array<uint8_t> TestImage(size_t width, size_t height) {
+  ct::dyn_array<uint8_t> image(width * height * 4);
+  for (size_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < width; ++x) {
+      auto texel = &image[(y * width + x) * 4];
+      texel[0] = uint8_t(x * 255 / (width - 1));
+      texel[1] = uint8_t(y * 255 / (height - 1));
+      texel[2] = uint8_t(128 + 100 * std::sin(x * .2) * std::cos(y * .15));
+      texel[3] = uint8_t((x + y) * 255 / (width + height - 2));
+    }
+  }
+  return image;
+}
+
+double Psnr(const ct::dyn_array<uint8_t>& a, const ct::dyn_array<uint8_t>& b,
+            size_t channels) {
+  double error = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (i % 4 >= channels) continue;
+    double d = double(a[i]) - double(b[i]);
+    error += d * d;
+  }
+  error /= double(a.size() / 4 * channels);
+  return error == 0.0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / error);
+}
+}  // namespace
+
+TEST(lib_core, TextureCompression_EncodeDecodePsnr) {
+  size_t width = 62, height = 34;
+  auto image = TestImage(width, height);
+
+  // Format, channels compared and the minimum PSNR in dB.
+  std::tuple<TextureCompression::Format, size_t, double> formats[] = {
+      {TextureCompression::kBc1, 3, 32.0}, {TextureCompression::kBc3, 4, 34.0},
+      {TextureCompression::kBc4, 1, 45.0}, {TextureCompression::kBc5, 2, 45.0},
+      {TextureCompression::kBc7, 4, 35.0}};
+  for (auto [format, channels, min_psnr] : formats) {
+    ct::dyn_array<uint8_t> blocks;
+    TextureCompression::Encode(format, image.data(), width, height, 4, blocks);
+    ASSERT_EQ(blocks.size(),
+              TextureCompression::LevelSize(format, width, height, 4));
+
+    ct::dyn_array<uint8_t> decoded(image.size());
+    TextureCompression::Decode(format, blocks.data(), width, height, 4,
+                               decoded.data());
+    EXPECT_GT(Psnr(image, decoded, channels), min_psnr)
+        << TextureCompression::Name(format);
+  }
+}
+
+TEST(lib_core, TextureCompression_MipChain) {
+  ct::dyn_array<uint8_t> checker(8 * 6 * 3);
+  for (size_t i = 0; i < 8 * 6; ++i)
+    for (size_t c = 0; c < 3; ++c) checker[i * 3 + c] = (i + i / 8) % 2 * 255;
+
+  auto linear = TextureCompression::BuildMips(checker.data(), 3, 8, 6,
+                                              TextureCompression::kLinear);
+  auto srgb = TextureCompression::BuildMips(checker.data(), 3, 8, 6,
+                                            TextureCompression::kSrgb);
+  ASSERT_EQ(linear.size(), 4);
+  EXPECT_EQ(TextureCompression::MipCount(8, 6), 4);
+  EXPECT_EQ(linear[1].size(), 4 * 3 * 4);
+  EXPECT_EQ(linear[3].size(), 4);
+  EXPECT_EQ(linear[1][0], 128);
+  EXPECT_EQ(linear[1][3], 255);
+  EXPECT_EQ(srgb[1][0], 188);
+
+  ct::dyn_array<uint8_t> normals(4 * 4 * 3);
+  for (size_t i = 0; i < 4 * 4; ++i) {
+    normals[i * 3 + 0] = i % 2 ? 218 : 37;
+    normals[i * 3 + 1] = 128;
+    normals[i * 3 + 2] = 218;
+  }
+  auto normal_mips = TextureCompression::BuildMips(
+      normals.data(), 3, 4, 4, TextureCompression::kNormal);
+  auto& top = normal_mips.back();
+  EXPECT_NEAR(top[0], 128, 1);
+  EXPECT_NEAR(top[2], 255, 1);
+}
+}  // namespace lib_core
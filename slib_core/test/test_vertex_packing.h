@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "vertex_packing.h"
+
+namespace lib_core {
+TEST(lib_core, VertexPacking_Snorm16) {
+  EXPECT_EQ(VertexPacking::ToSnorm16(1.f), 32767);
+  EXPECT_EQ(VertexPacking::ToSnorm16(-2.f), -32767);
+  EXPECT_EQ(VertexPacking::ToSnorm16(0.f), 0);
+  EXPECT_FLOAT_EQ(VertexPacking::FromSnorm16(-32768), -1.f);
+  for (float v = -1.f; v <= 1.f; v += .01f)
+    EXPECT_NEAR(VertexPacking::FromSnorm16(VertexPacking::ToSnorm16(v)), v,
+                1.f / 32767.f);
+}
+
+TEST(lib_core, VertexPacking_Octahedral) {
+  float max_error = 0.f;
+  for (int i = 0; i < 64; ++i) {
+    for (int j = 0; j <= 32; ++j) {
+      auto phi = i * 6.2831853f / 64.f, theta = j * 3.1415927f / 32.f;
+      float n[3] = {std::sin(theta) * std::cos(phi),
+                    std::sin(theta) * std::sin(phi), std::cos(theta)};
+      auto d = VertexPacking::OctDecode(VertexPacking::OctEncode(n));
+      auto dot = n[0] * d[0] + n[1] * d[1] + n[2] * d[2];
+      max_error = std::max(max_error, std::acos(std::min(dot, 1.f)));
+    }
+  }
+  EXPECT_LT(max_error, .001f);
+}
+
+TEST(lib_core, VertexPacking_Half) {
+  for (auto v : {0.f, 1.f, -1.f, .5f, 65504.f, 6.1035156e-5f, 5.9604645e-8f})
+    EXPECT_EQ(VertexPacking::FromHalf(VertexPacking::ToHalf(v)), v);
+  EXPECT_EQ(VertexPacking::ToHalf(1.f), 0x3c00);
+  EXPECT_EQ(VertexPacking::ToHalf(1e6f), 0x7c00);
+  for (float v = -4.f; v <= 4.f; v += .013f)
+    EXPECT_NEAR(VertexPacking::FromHalf(VertexPacking::ToHalf(v)), v,
+                std::abs(v) / 1024.f);
+}
+
+TEST(lib_core, VertexPacking_Vertex) {
+  EXPECT_EQ(sizeof(PackedVertex), 20u);
+
+  float center[3] = {1.f, 2.f, 3.f}, extent[3] = {2.f, 4.f, 0.f};
+  float position[3] = {2.f, -2.f, 3.f}, normal[3] = {0.f, 0.f, -1.f};
+  float tangent[3] = {1.f, 0.f, 0.f}, texcoord[2] = {.25f, 1.f};
+  auto packed = VertexPacking::Pack(position, normal, tangent, texcoord,
+                                    center, extent);
+  EXPECT_EQ(packed.position[3], 0);
+  EXPECT_EQ(packed.texcoord[1], 0x3c00);
+
+  auto unpacked = VertexPacking::UnpackPosition(packed, center, extent);
+  for (int c = 0; c < 3; ++c) EXPECT_NEAR(unpacked[c], position[c], 1e-4f);
+  auto n = VertexPacking::OctDecode(packed.normal);
+  EXPECT_NEAR(n[2], -1.f, 1e-4f);
+}
+}  // namespace lib_core
@@ -6,12 +6,12 @@ namespace lib_graphics {
 class Light {
  public:
   enum LightType { kDir, kPoint, kSpot, kEnd };
+  static constexpr int kMaxCascades = 4;
 
   Light() {
     auto max_tex_size = g_settings.MaxShadowTexture();
-    shadow_resolutions[0] = max_tex_size;
-    shadow_resolutions[1] = max_tex_size >> 1;
-    shadow_resolutions[2] = max_tex_size >> 2;
+    for (int i = 0; i < kMaxCascades; ++i)
+      shadow_resolutions[i] = max_tex_size >> i;
     cast_shadows = false;
     update_cast_shadow = false;
   }
@@ -43,9 +43,8 @@ class Light {
     type = kDir;
 
     auto max_tex_size = g_settings.MaxShadowTexture();
-    shadow_resolutions[0] = max_tex_size;
-    shadow_resolutions[1] = max_tex_size >> 1;
-    shadow_resolutions[2] = max_tex_size >> 2;
+    for (int i = 0; i < kMaxCascades; ++i)
+      shadow_resolutions[i] = max_tex_size >> i;
   }
 
   Light(lib_core::Vector3 pos, lib_core::Vector3 dir, lib_core::Vector3 col,
@@ -61,9 +60,8 @@ class Light {
     type = kSpot;
 
     auto max_tex_size = g_settings.MaxShadowTexture();
-    shadow_resolutions[0] = max_tex_size;
-    shadow_resolutions[1] = max_tex_size >> 1;
-    shadow_resolutions[2] = max_tex_size >> 2;
+    for (int i = 0; i < kMaxCascades; ++i)
+      shadow_resolutions[i] = max_tex_size >> i;
   }
 
   ~Light() = default;
@@ -90,8 +88,14 @@ class Light {
   float quadratic = 0.07f;
   float max_radius = 10.f;
 
-  std::array<float, 3> view_depth;
-  std::array<int, 3> shadow_resolutions;
+  // Directional shadows, the window depth each cascade ends at and how many
+  // are in use. Set while culling.
+  std::array<float, kMaxCascades> view_depth;
+  int cascades = 0;
+  std::array<int, kMaxCascades> shadow_resolutions;
+  // Cube map frame buffer the point shadow was cached in, set by the
+  // renderer on its per frame copy. Zero means the shared target.
+  size_t shadow_map = 0;
 
   static Light Parse(ct::string &buffer, size_t &cursor) {
     Light l;
@@ -10,8 +10,11 @@ class ParticleEmitter {
       : max_particles(max_particles), particle_texture(particle_texture_id) {}
 
   enum EmitterType { kPoint, kCircle, kSquare, kSphere, kCube };
+  // Alpha blended particles are drawn back to front.
+  enum BlendMode { kAdditive, kAlpha };
 
   EmitterType emitt_type{kPoint};
+  BlendMode blend{kAdditive};
   float emitter_time{0.f};
   bool loop{true};
 
@@ -97,6 +100,12 @@ class ParticleEmitter {
             e.emitt_type = kSphere;
           else if (val.compare("kCube") == 0)
             e.emitt_type = kCube;
+        } else if (type.compare("Blend") == 0) {
+          auto val = cu::ParseValue(buffer, cursor);
+          if (val.compare("kAdditive") == 0)
+            e.blend = kAdditive;
+          else if (val.compare("kAlpha") == 0)
+            e.blend = kAlpha;
         }
 
         type = cu::ParseType(buffer, cursor);
@@ -63,6 +63,7 @@ struct Material {
 struct MeshInit {
   ct::dyn_array<uint32_t> indices;
   ct::dyn_array<Vertex> vertices;
+  ct::dyn_array<PackedVertex> packed_vertices;
   lib_core::Vector3 center, extent;
 };
 
@@ -136,11 +137,17 @@ class AddModelMeshCommand : public lib_core::Command {
  public:
   AddModelMeshCommand() = default;
   AddModelMeshCommand(size_t mesh_id, MeshInit mesh_init)
-      : mesh_id(mesh_id), mesh_init(std::move(mesh_init)) {}
+      : mesh_id(mesh_id), base_id(mesh_id), mesh_init(std::move(mesh_init)) {}
+  // A simplified level of base_id. It gets no physics source or bounds of
+  // its own and goes away together with the base mesh.
+  AddModelMeshCommand(size_t mesh_id, size_t base_id, MeshInit mesh_init)
+      : mesh_id(mesh_id), base_id(base_id), mesh_init(std::move(mesh_init)) {}
 
   size_t MeshId() { return mesh_id; }
+  bool IsLod() const { return mesh_id != base_id; }
 
   size_t mesh_id;
+  size_t base_id;
   MeshInit mesh_init;
 };
 
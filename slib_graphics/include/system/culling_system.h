@@ -3,7 +3,9 @@
 #include "axis_aligned_box.h"
 #include "camera.h"
 #include "entity.h"
+#include "frame_arena.h"
 #include "light.h"
+#include "render_command_list.h"
 #include "sort_trees/oc_tree.h"
 #include "system.h"
 #include "system_manager.h"
@@ -39,6 +41,13 @@ class CullingSystem : public lib_core::System {
 
   const ct::dyn_array<MeshPack> *GetMeshPacks(lib_core::Entity entity,
                                               bool opeque = true);
+  // The G-buffer pass of a camera view, recorded alongside its opaque packs.
+  // Draws index the opaque instance arrays from start_ind.
+  static constexpr uint8_t kGBufferPass = 0;
+  const lib_core::RenderCommandList *GetCommands(lib_core::Entity entity);
+  // Directional lights cull their casters per cascade, the packs of each
+  // cascade are found under this key.
+  static lib_core::Entity CascadeView(lib_core::Entity light, size_t cascade);
   const ct::dyn_array<lib_core::Entity> *GetLightPacks(lib_core::Entity entity);
 
   ct::dyn_array<lib_core::Vector3> &GetAlbedoVecs(bool opeque = true);
@@ -62,6 +71,35 @@ class CullingSystem : public lib_core::System {
     BoundingVolume aabb;
   };
 
+  struct MeshLod {
+    size_t mesh_id;
+    float error;  // Object space deviation from the source mesh.
+  };
+
+  // Registers simplified stand-ins for mesh_id, ordered from fine to coarse.
+  class AddMeshLodCommand : public lib_core::Command {
+   public:
+    AddMeshLodCommand() = default;
+    AddMeshLodCommand(size_t mesh_id, ct::dyn_array<MeshLod> lods)
+        : mesh_id(mesh_id), lods(std::move(lods)) {}
+
+    size_t mesh_id;
+    ct::dyn_array<MeshLod> lods;
+  };
+
+  class RemoveMeshLodCommand : public lib_core::Command {
+   public:
+    RemoveMeshLodCommand() = default;
+    RemoveMeshLodCommand(size_t mesh_id) : mesh_id(mesh_id) {}
+
+    size_t mesh_id;
+  };
+
+  // A level is used once its error projects to fewer pixels than this, and
+  // only swapped for a coarser one with kLodHysteresis of margin.
+  static constexpr float kLodPixelError = 1.f;
+  static constexpr float kLodHysteresis = .25f;
+
   class RemoveMeshAabbCommand : public lib_core::Command {
    public:
     RemoveMeshAabbCommand() = default;
@@ -78,8 +116,17 @@ class CullingSystem : public lib_core::System {
   size_t AabbLightCheckTiled(Camera &camera, lib_core::Entity target,
                              bool clear_ents = true);
   void UpdateSearchTrees();
+  // The light or camera a view key belongs to.
+  static lib_core::Entity ViewOwner(lib_core::Entity view);
+  size_t SelectLod(lib_core::Entity view, lib_core::Entity entity,
+                   size_t mesh_id, float distance, float scale,
+                   const Camera &camera, float screen_height);
 
+  template <template <typename> class Alloc>
   struct MeshPackData {
+    template <typename T>
+    using Vec = std::vector<T, Alloc<T>>;
+
     void clear() {
       rme_vec.clear(), albedo_vec.clear();
       tex_scale.clear(), tex_offset.clear();
@@ -88,27 +135,29 @@ class CullingSystem : public lib_core::System {
       closest_dist = std::numeric_limits<float>::infinity();
     }
 
-    float closest_dist;
-    ct::dyn_array<float> transp_vec;
-    ct::dyn_array<lib_core::Vector3> rme_vec;
-    ct::dyn_array<lib_core::Vector3> albedo_vec;
-    ct::dyn_array<lib_core::Vector2> tex_scale;
-    ct::dyn_array<lib_core::Vector2> tex_offset;
-    ct::dyn_array<lib_core::Matrix4x4> world_vec;
-    ct::dyn_array<lib_core::Matrix4x4> world_inv_trans_vec;
+    float closest_dist = std::numeric_limits<float>::infinity();
+    Vec<float> transp_vec;
+    Vec<lib_core::Vector3> rme_vec;
+    Vec<lib_core::Vector3> albedo_vec;
+    Vec<lib_core::Vector2> tex_scale;
+    Vec<lib_core::Vector2> tex_offset;
+    Vec<lib_core::Matrix4x4> world_vec;
+    Vec<lib_core::Matrix4x4> world_inv_trans_vec;
   };
 
-  MeshPackData opeque_meshes_, translucent_meshes_;
-
-  lib_core::EngineCore *engine_;
+  // Per view packs only live for one DrawUpdate and come from the frame arena.
+  using PackKey = std::pair<size_t, size_t>;
+  using ScratchPack = MeshPackData<lib_core::ArenaAllocator>;
+  using ScratchPackMap =
+      std::map<PackKey, ScratchPack, std::less<PackKey>,
+               lib_core::ArenaAllocator<std::pair<const PackKey, ScratchPack>>>;
+  using ScratchDepthMap = std::map<
+      float, ScratchPackMap, std::greater<float>,
+      lib_core::ArenaAllocator<std::pair<const float, ScratchPackMap>>>;
 
-  ct::tree_map<std::pair<size_t, size_t>, MeshPackData> opeque_mesh_packs_;
-  ct::tree_map<float, ct::tree_map<std::pair<size_t, size_t>, MeshPackData>,
-               std::greater<float>>
-      translucent_mesh_packs_;
+  MeshPackData<std::allocator> opeque_meshes_, translucent_meshes_;
 
-  ct::tree_map<float, ct::dyn_array<decltype(opeque_mesh_packs_)::iterator>>
-      sorted_opeque_packs_;
+  lib_core::EngineCore *engine_;
 
   std::unique_ptr<OcTree> mesh_octree_;
   std::unique_ptr<OcTree> light_octree_;
@@ -117,15 +166,24 @@ class CullingSystem : public lib_core::System {
       light_matrices_;
   ct::hash_map<lib_core::Entity, ct::dyn_array<MeshPack>>
       opeque_mesh_packs_out_, translucent_mesh_packs_out_;
+  ct::hash_map<lib_core::Entity, lib_core::RenderCommandList>
+      gbuffer_commands_;
   ct::hash_map<lib_core::Entity, ct::dyn_array<lib_core::Entity>> light_packs_;
   ct::hash_map<lib_core::Entity, ct::dyn_array<lib_core::Entity>>
       draw_entities_;
 
   ct::hash_map<size_t, BoundingVolume> mesh_aabb_;
+  // Level 0 is the source mesh. The chosen level is kept per camera view and
+  // mesh entity so selection can hysteresis without views overwriting each
+  // other, shadow views reuse the finest level the cameras chose.
+  ct::hash_map<size_t, ct::dyn_array<MeshLod>> mesh_lods_;
+  ct::hash_map<lib_core::Entity, ct::hash_map<lib_core::Entity, uint8_t>>
+      view_lods_;
 
   ct::dyn_array<lib_core::Entity> add_mesh_vec_, add_light_vec_;
 
   size_t rem_mesh_callback_id, rem_light_callback_id_;
+  size_t rem_camera_callback_id_;
   size_t add_mesh_callback_id, add_light_callback_id_;
   size_t shadow_meshes_, mesh_count_, light_count_;
 };
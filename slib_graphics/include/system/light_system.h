@@ -14,11 +14,13 @@ class LightSystem : public lib_core::System {
       Light& light, bool culling = true);
 
  private:
+  // How far behind a cascade, towards the light, casters are still drawn.
+  static constexpr float kCasterDepth = 250.f;
+
+  // One stable, texel snapped cascade per practical split of the camera
+  // frustum, see CascadeFitting.
   static void CalculateDirLightCascades(
       Light& light, ct::dyn_array<lib_core::Matrix4x4>& shadow_cascades,
       bool culling);
-  static float ApplyCropMatrix(
-      Camera::FrustumInfo& f, Camera& cam,
-      ct::dyn_array<lib_core::Matrix4x4>& shadow_cascades);
 };
 }  // namespace lib_graphics
@@ -1,8 +1,10 @@
 #pragma once
-#include <thread>
+#include "asset_pack.h"
 #include "entity.h"
 #include "graphics_commands.h"
+#include "loader_pool.h"
 #include "system.h"
+#include "texture_compression.h"
 #include "vector_def.h"
 
 namespace lib_gui {
@@ -22,10 +24,13 @@ class MaterialSystem : public lib_core::System {
     size_t pack_hash;
     size_t name_hash;
 
-    size_t start_point;
+    lib_core::PackBlob blob;
 
     short nr_channels;
     std::pair<size_t, size_t> dim;
+    lib_core::TextureCompression::Format format =
+        lib_core::TextureCompression::kRaw;
+    uint32_t mip_count = 1;
     ct::dyn_array<uint8_t> data;
     bool loaded = false;
   };
@@ -55,9 +60,6 @@ class MaterialSystem : public lib_core::System {
   MaterialSystem(lib_core::EngineCore *engine);
   ~MaterialSystem() override;
 
-  void StartLoadThread();
-  void TerminateLoadThread();
-
   Material CreateTexturedMaterial(const ct::string &alb, const ct::string &norm,
                                   const ct::string &rme);
   Material CreateUntexturedMaterial();
@@ -69,6 +71,10 @@ class MaterialSystem : public lib_core::System {
   size_t GetTextureId(size_t tex_hash);
   size_t GetTextureId(const ct::string &tex_name);
 
+  // Moves a pending decode to the front of the loader queue, used for
+  // textures that are already being drawn with the stock texture.
+  void PrioritizeTexture(size_t tex_id);
+
   void ApplyMaterial(
       size_t mat_id,
       ct::dyn_array<std::pair<lib_core::Entity, class Light>> *lights = nullptr,
@@ -107,6 +113,7 @@ class MaterialSystem : public lib_core::System {
   tbb::concurrent_unordered_map<size_t, size_t> texture_map_;
   ct::hash_map<size_t, ct::dyn_array<std::pair<size_t, ct::string>>>
       loaded_tex_packs_;
+  ct::hash_map<size_t, std::unique_ptr<lib_core::AssetPack>> texture_packs_;
   tbb::concurrent_unordered_map<size_t, ct::string> name_hashes_;
 
   ct::dyn_array<size_t> available_framebuffers_;
@@ -114,19 +121,15 @@ class MaterialSystem : public lib_core::System {
   ct::dyn_array<std::pair<size_t, size_t>> frame_buffer_stack_;
 
  private:
-  bool run_tex_load_thread_;
-  std::condition_variable tex_load_cond_;
-
-  struct TextureLoadJob {
-    ct::dyn_array<size_t> pack_hash;
-    ct::dyn_array<size_t> tex_id;
-    ct::dyn_array<size_t> start_point;
-    ct::dyn_array<ct::dyn_array<uint8_t> *> data;
-  };
-
-  tbb::concurrent_queue<TextureLoadJob> tex_load_jobs_;
-  void TextureLoaderThread();
-
-  std::unique_ptr<std::thread> texture_unpack_thread_;
+  void QueueTextureLoad(ct::dyn_array<size_t> tex_ids,
+                        ct::dyn_array<std::pair<size_t, Texture *>> sources);
+  // Sources of a job removed before it ran are marked as not loaded, so the
+  // next AddTexture2D or AddTexture3D queues them again. A job that already
+  // ran is retired and its completion skips the upload.
+  void CancelTextureJob(size_t tex_id);
+
+  // Jobs are looked up from the render thread and retired on the logic thread.
+  std::mutex jobs_mutex_;
+  ct::hash_map<size_t, lib_core::LoaderPool::JobId> texture_jobs_;
 };
 }  // namespace lib_graphics
@@ -1,7 +1,8 @@
 #pragma once
-#include <thread>
+#include "asset_pack.h"
 #include "engine_core.h"
 #include "graphics_commands.h"
+#include "loader_pool.h"
 #include "system.h"
 #include "vector_def.h"
 #include "vertex.h"
@@ -13,7 +14,6 @@ class MeshSystem : public lib_core::System {
   ~MeshSystem() override;
 
   struct Model {
-    size_t start;
     size_t nr_meshes;
     ct::dyn_array<size_t> meshes;
   };
@@ -31,31 +31,33 @@ class MeshSystem : public lib_core::System {
   const Model* GetModel(const ct::string& name) const;
   const MeshInit* GetMeshSource(size_t mesh_id) const;
 
-  void StartLoadThread();
-  void TerminateLoadThread();
+  void PrioritizeMesh(size_t mesh_id);
+
+  // Converts float vertices to the packed GPU layout and drops them.
+  static void PackVertices(MeshInit& source);
+  static lib_core::Vector3 UnpackPosition(const MeshInit& source,
+                                          const PackedVertex& vertex);
 
  protected:
+  void StoreMeshSource(size_t mesh_id, MeshInit&& source);
+  void EraseMeshSource(size_t mesh_id);
+
   const lib_core::EngineCore* engine_;
   ct::hash_map<size_t, size_t> model_pack_map_;
   ct::hash_map<size_t, MeshInit> mesh_source_;
   ct::hash_map<size_t, ct::hash_map<size_t, Model>> loaded_model_packs_;
 
  private:
-  struct ModelLoadJob {
-    size_t pack_hash;
-    ct::dyn_array<size_t> mesh_ids;
-    size_t start_point;
-  };
-
-  std::condition_variable load_cond_;
-  bool load_models_ = true;
-  std::condition_variable model_load_cond_;
-
-  tbb::concurrent_queue<ModelLoadJob> model_load_jobs_;
-  std::unique_ptr<std::thread> model_unpack_thread_;
-
-  void ModelLoaderThread();
-
-  tbb::concurrent_unordered_map<size_t, ct::string> model_pack_name_map_;
+  // format is the model entry's meta[1], 0 for packs that predate 16 bit
+  // index storage, 1 for packs that predate per mesh vertex formats and 2
+  // for packs without lod levels. mesh_ids holds lod_slots ids per mesh.
+  void QueueModelLoad(const ct::dyn_array<size_t>& mesh_ids,
+                      lib_core::PackBlob blob, uint32_t format,
+                      uint32_t lod_slots);
+
+  size_t mesh_callback_id_;
+  std::mutex jobs_mutex_;
+  ct::hash_map<size_t, lib_core::LoaderPool::JobId> mesh_jobs_;
+  ct::hash_map<size_t, std::unique_ptr<lib_core::AssetPack>> model_packs_;
 };
 }  // namespace lib_graphics
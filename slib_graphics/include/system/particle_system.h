@@ -1,5 +1,8 @@
 #pragma once
+#include <mutex>
 #include "engine_core.h"
+#include "particle_batcher.h"
+#include "particle_simulator.h"
 #include "system.h"
 
 namespace lib_graphics {
@@ -9,15 +12,37 @@ class ParticleSystem : public lib_core::System {
  public:
   ParticleSystem(const lib_core::EngineCore* engine);
 
+  // Particles packed and sorted for one camera, by camera entity.
+  using Views = ct::hash_map<size_t, lib_core::ParticleBatcher::View>;
+
+  // Advances emitter time, simulates every emitter and packs the result for
+  // each camera. The views are handed to the draw side whole.
   void LogicUpdate(float dt) override;
 
-  virtual void DrawParticleEmitter(lib_core::Entity entity,
-                                   const lib_graphics::Camera& camera,
-                                   const TextureDesc& depth_desc) = 0;
+  // Draws every particle seen by the camera, one draw per batch.
+  virtual void DrawParticles(lib_core::Entity camera_entity,
+                             const lib_graphics::Camera& camera,
+                             const TextureDesc& depth_desc) = 0;
   virtual void PurgeGpuResources() = 0;
   virtual void RebuildGpuResources() = 0;
 
  protected:
+  // Swaps in the latest packed views, false when nothing new was published
+  // since the last call.
+  bool TakeParticles(Views& out);
+
   const lib_core::EngineCore* engine_;
+
+ private:
+  lib_core::ParticleSimulator simulator_;
+  ct::dyn_array<lib_core::ParticleSimulator::EmitterFrame> frames_;
+  lib_core::ParticleSimulator::Output simulated_;
+  lib_core::ParticleBatcher batcher_;
+  ct::dyn_array<lib_core::ParticleBatcher::Emitter> batch_emitters_;
+  Views views_;
+
+  std::mutex ready_mutex_;
+  Views ready_;
+  bool ready_new_ = false;
 };
-}  // namespace lib_graphics
\ No newline at end of file
+}  // namespace lib_graphics
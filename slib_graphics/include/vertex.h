@@ -1,5 +1,6 @@
 #pragma once
 #include "vector_def.h"
+#include "vertex_packing.h"
 
 namespace lib_graphics {
 struct Vertex {
@@ -9,6 +10,11 @@ struct Vertex {
   std::array<float, 2> texcoord;
 };
 
+using lib_core::kFloatVertex;
+using lib_core::kPackedVertex;
+using lib_core::PackedVertex;
+using lib_core::VertexFormat;
+
 struct PosVertex {
   lib_core::Vector3 position;
 };
@@ -10,6 +10,10 @@ public:
     size_t max_geometry_uniforms;
 
     float version;
+    // Buffers can be mapped persistently.
+    bool buffer_storage = false;
+    // Shaders can read gl_BaseInstanceARB and gl_DrawIDARB.
+    bool draw_parameters = false;
   };
 
   Window();
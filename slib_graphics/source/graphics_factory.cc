@@ -29,9 +29,7 @@ std::unique_ptr<CameraSystem> GraphicsFactory::CreateCameraSystem() {
 
 std::unique_ptr<MeshSystem> GraphicsFactory::CreateMeshSystem(
     lib_core::EngineCore *engine) {
-  auto ptr = std::make_unique<GlMeshSystem>(engine);
-  ptr->StartLoadThread();
-  return ptr;
+  return std::make_unique<GlMeshSystem>(engine);
 }
 
 std::unique_ptr<TransformSystem> GraphicsFactory::CreateTransformSystem() {
@@ -40,9 +38,7 @@ std::unique_ptr<TransformSystem> GraphicsFactory::CreateTransformSystem() {
 
 std::unique_ptr<MaterialSystem> GraphicsFactory::CreateMaterialSystem(
     lib_core::EngineCore *engine) {
-  auto ptr = std::make_unique<GlMaterialSystem>(engine);
-  ptr->StartLoadThread();
-  return ptr;
+  return std::make_unique<GlMaterialSystem>(engine);
 }
 
 std::unique_ptr<CullingSystem> GraphicsFactory::CreateCullingSystem(
@@ -5,6 +5,7 @@
 #include "gl_gausian_blur.h"
 #include "gl_material_system.h"
 #include "gl_window.h"
+#include "profiler.h"
 
 namespace lib_graphics {
 GlBloom::GlBloom(std::pair<size_t, size_t> dim, lib_core::EngineCore *engine,
@@ -44,6 +45,7 @@ GlBloom::~GlBloom() {
 }
 
 void GlBloom::ApplyBloomEffect() {
+  PROFILE_ZONE("Bloom");
   auto bloom_timer = cu::TimerStart();
   auto mat_system = engine_->GetMaterial();
 
@@ -1,9 +1,12 @@
 #include "gl_deferred_lighting.h"
 #include <GL/glew.h>
 #include "culling_system.h"
+#include "gl_instance_buffer.h"
 #include "gl_material_system.h"
+#include "gl_mesh_system.h"
 #include "light_system.h"
 #include "mesh_system.h"
+#include "profiler.h"
 #include "window.h"
 
 namespace lib_graphics {
@@ -17,24 +20,14 @@ GlDeferredLighting::GlDeferredLighting(lib_core::EngineCore *engine,
   ct::string vert_shader =
       cu::ReadFile("./content/shaders/opengl/deferred_lighting_world_vs.glsl");
 
-  auto shader_command = AddShaderCommand(vert_shader);
-  shader_ids_.push_back(shader_command.ShaderId());
-  issue_command(shader_command);
-
-  Material material;
-  material.shader = shader_ids_.back();
-
-  auto material_command = AddMaterialCommand(material);
-  stencil_pass_ = material_command.MaterialId();
-  issue_command(material_command);
-
-  shader_command = AddShaderCommand(
+  auto shader_command = AddShaderCommand(
       vert_shader,
       cu::ReadFile("./content/shaders/opengl/"
                    "deferred_lighting_point_shadow_world_fs.glsl"));
   shader_ids_.push_back(shader_command.ShaderId());
   issue_command(shader_command);
 
+  Material material;
   material.shader = shader_ids_.back();
   material.textures.push_back(position_tex);
   material.textures.push_back(normal_tex);
@@ -42,7 +35,7 @@ GlDeferredLighting::GlDeferredLighting(lib_core::EngineCore *engine,
   material.textures.push_back(rme_tex);
   material.textures.push_back(depth_tex);
 
-  material_command = AddMaterialCommand(material);
+  auto material_command = AddMaterialCommand(material);
   deferred_lighting_point_shadow_volume_ = material_command.MaterialId();
   issue_command(material_command);
 
@@ -121,11 +114,13 @@ GlDeferredLighting::~GlDeferredLighting() {
   issue_command(RemoveMaterialCommand(deferred_lighting_dir_quad_));
   issue_command(RemoveMaterialCommand(deferred_lighting_volume_));
   issue_command(RemoveMaterialCommand(deferred_lighting_quad_));
-  issue_command(RemoveMaterialCommand(stencil_pass_));
 }
 
+void GlDeferredLighting::BeginFrame() { shadow_mapper_->BeginFrame(); }
+
 void GlDeferredLighting::DrawLights(Camera &cam, lib_core::Entity cam_entity,
                                     lib_core::Vector3 cam_pos) {
+  PROFILE_ZONE("Lighting");
   auto lighting_timer = cu::TimerStart();
   auto cull_system = engine_->GetCulling();
 
@@ -134,12 +129,14 @@ void GlDeferredLighting::DrawLights(Camera &cam, lib_core::Entity cam_entity,
 
   light_mats.clear();
   light_packs.clear();
+  light_instances_.clear();
   int light_matrix_id = 0;
   for (auto light_ent : *lights) {
     auto light = g_ent_mgr.GetOldCbeR<Light>(light_ent);
     if (!light) continue;
 
     size_t material;
+    LightInstance instance = {};
     if (light->type == Light::kPoint) {
       auto cam_d = lib_core::Vector3(cam_pos[0], cam_pos[1], cam_pos[2]);
       cam_d -= light->data_pos;
@@ -151,18 +148,58 @@ void GlDeferredLighting::DrawLights(Camera &cam, lib_core::Entity cam_entity,
               ? (inside ? deferred_lighting_point_shadow_quad_
                         : deferred_lighting_point_shadow_volume_)
               : (inside ? deferred_lighting_quad_ : deferred_lighting_volume_);
-      light_mats[material].push_back(light_matrices[light_matrix_id++]);
+      instance.world = light_matrices[light_matrix_id++];
     } else if (light->type == Light::kDir) {
       material = light->cast_shadows ? deferred_lighting_dir_shadow_quad_
                                      : deferred_lighting_dir_quad_;
-      light_mats[material].push_back(light_matrices[light_matrix_id++]);
-      light_mats[material].push_back(light_matrices[light_matrix_id++]);
-      light_mats[material].push_back(light_matrices[light_matrix_id++]);
-    }
+      for (int i = 0; i < light->cascades; ++i)
+        light_mats[material].push_back(light_matrices[light_matrix_id++]);
+    } else
+      continue;
+    instance.position_radius = {light->data_pos[0], light->data_pos[1],
+                                light->data_pos[2], light->max_radius};
+    instance.coeff = {light->constant, light->linear, light->quadratic, 0.f};
+    instance.color = {light->color[0], light->color[1], light->color[2], 0.f};
+    instance.direction = {light->data_dir[0], light->data_dir[1],
+                          light->data_dir[2], 0.f};
+    light_instances_[material].push_back(instance);
     light_packs[material].push_back({light_ent, *light});
   }
 
-  InstanceDraw(cam, cam_entity, cam_pos);
+  instances_.clear();
+  pack_offsets_.clear();
+  for (auto &pack : light_instances_) {
+    pack_offsets_[pack.first] = int(instances_.size());
+    instances_.insert(instances_.end(), pack.second.begin(), pack.second.end());
+  }
+
+  if (light_stream_)
+    light_stream_->EndFrame();
+  else
+    light_stream_ = std::make_unique<GlInstanceBuffer>(
+        engine_->GetWindow()->Capabilities().buffer_storage, 1 << 20);
+  light_stream_->Bind(instances_.data(),
+                      instances_.size() * sizeof(LightInstance), kLightBinding);
+
+  shadow_mapper_->ScheduleShadows(cam, cam_pos, *lights);
+  RecordLights(cam, cam_pos);
+
+  // Lighting shaders read their light at first_light, shadow shaders their
+  // instances at instance_offset.
+  auto mat_system = engine_->GetMaterial();
+  auto mesh_system = static_cast<GlMeshSystem *>(engine_->GetMesh());
+  auto multi_draw = mesh_system->MultiDraw();
+  auto bind_instances = [&](size_t first, size_t) {
+    auto &locations = Locations(mat_system->GetCurrentShader());
+    glUniform1i(locations[0], GLint(first));
+    glUniform1ui(locations[1], GLuint(first));
+    glUniform1i(locations[2], multi_draw);
+  };
+  GlCommandBackend backend(engine_, multi_draw, bind_instances);
+  backend.SetScreenQuad(screen_quad_);
+  backend.SetLights(&bound_lights_);
+  backend.Replay(commands_);
+
   engine_->GetDebugOutput()->UpdateBottomRightLine(
       2, std::to_string(cu::TimerStop<std::milli>(lighting_timer)) +
              " :Lighting time");
@@ -170,212 +207,85 @@ void GlDeferredLighting::DrawLights(Camera &cam, lib_core::Entity cam_entity,
 
 void GlDeferredLighting::SetScreenQuad(unsigned quad) { screen_quad_ = quad; }
 
-void GlDeferredLighting::StencilDraw(Camera &cam, lib_core::Entity cam_entity,
-                                     lib_core::Vector3 cam_pos) {
-  auto mat_system = static_cast<GlMaterialSystem *>(engine_->GetMaterial());
-  auto mesh_system = engine_->GetMesh();
-  auto window = engine_->GetWindow();
-
-  glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
-  glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
-  for (auto &l_pack : light_packs) {
-    int inst_count = 0;
-    int max_instance =
-        1;  // l_pack.second[0].second.type == Light::kDir ? 5 : 50;
-    ct::dyn_array<std::pair<lib_core::Entity, Light>> light_pack;
-    for (int iii = 0; iii < l_pack.second.size(); iii += max_instance) {
-      light_pack.clear();
-      for (int ii = iii; ii < l_pack.second.size(); ++ii) {
-        light_pack.push_back(l_pack.second[ii]);
-        if (light_pack.size() == max_instance) break;
-      }
-
-      // Render shadows
-      if (l_pack.first == deferred_lighting_dir_shadow_quad_ ||
-          l_pack.first == deferred_lighting_point_shadow_volume_ ||
-          l_pack.first == deferred_lighting_point_shadow_quad_) {
-        glDepthMask(GL_TRUE);
-        glCullFace(GL_BACK);
-        glEnable(GL_DEPTH_TEST);
-        glDisable(GL_BLEND);
-        glDisable(GL_STENCIL_TEST);
-        shadow_mapper_->DrawShadowMap(light_pack[0]);
-      }
-
-      glDepthMask(GL_FALSE);
-      auto &mats = light_mats[l_pack.first];
-      if (l_pack.first != deferred_lighting_dir_shadow_quad_ &&
-          l_pack.first != deferred_lighting_dir_quad_) {
-        glEnable(GL_STENCIL_TEST);
-        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-        glStencilFunc(GL_ALWAYS, 0, 0xFF);
-
-        glDisable(GL_BLEND);
-        glEnable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
-        glClear(GL_STENCIL_BUFFER_BIT);
-
-        mat_system->ApplyMaterial(stencil_pass_, nullptr, true);
-
-        auto shader_program = mat_system->GetCurrentShader();
-        if (stencil_vp_loc_ - 1)
-          stencil_vp_loc_ = glGetUniformLocation(shader_program, "view_proj");
-        glUniformMatrix4fv(stencil_vp_loc_, 1, GL_FALSE, cam.view_proj_.data);
-
-        if (stencil_world_loc_ == -1)
-          stencil_world_loc_ = glGetUniformLocation(shader_program, "world[0]");
-        glUniformMatrix4fv(stencil_world_loc_, int(light_pack.size()), GL_FALSE,
-                           mats[inst_count].data);
-
-        mesh_system->DrawMesh(lib_core::EngineCore::stock_sphere_mesh,
-                              int(light_pack.size()), true);
-      }
-
-      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-      glDisable(GL_DEPTH_TEST);
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_ONE, GL_ONE);
-      glEnable(GL_CULL_FACE);
-
-      if (l_pack.first != deferred_lighting_dir_shadow_quad_ &&
-          l_pack.first != deferred_lighting_dir_quad_) {
-        if (l_pack.first == deferred_lighting_quad_ ||
-            l_pack.first == deferred_lighting_point_shadow_quad_) {
-          glCullFace(GL_BACK);
-          glStencilFunc(GL_LESS, 0, 0xFF);
-        } else {
-          glCullFace(GL_FRONT);
-          glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
-        }
-      } else {
-        glCullFace(GL_BACK);
-        glDisable(GL_STENCIL_TEST);
-      }
+bool GlDeferredLighting::ShadowPack(size_t material) const {
+  return material == deferred_lighting_dir_shadow_quad_ ||
+         material == deferred_lighting_point_shadow_volume_ ||
+         material == deferred_lighting_point_shadow_quad_;
+}
 
-      mat_system->ApplyMaterial(l_pack.first, &light_pack, true);
-      auto shader_program = mat_system->GetCurrentShader();
-
-      auto loc_it = shader_locations_.find(shader_program);
-      if (loc_it == shader_locations_.end()) {
-        auto &data = shader_locations_[shader_program];
-        data[0] = glGetUniformLocation(shader_program, "cam_pos");
-        data[1] = glGetUniformLocation(shader_program, "screen_dim");
-        data[2] = glGetUniformLocation(shader_program, "view_proj");
-        data[3] = glGetUniformLocation(shader_program, "world[0]");
-        loc_it = shader_locations_.find(shader_program);
-      }
+bool GlDeferredLighting::ScreenPack(size_t material) const {
+  return material == deferred_lighting_point_shadow_quad_ ||
+         material == deferred_lighting_quad_ ||
+         material == deferred_lighting_dir_shadow_quad_ ||
+         material == deferred_lighting_dir_quad_;
+}
 
-      std::array<float, 2> scr_dim = {float(window->GetRenderDim().first),
-                                      float(window->GetRenderDim().second)};
-
-      glUniform3fv(loc_it->second[0], 1, &cam_pos[0]);
-      glUniform2fv(loc_it->second[1], 1, scr_dim.data());
-      glUniformMatrix4fv(loc_it->second[2], 1, GL_FALSE, cam.view_proj_.data);
-      if (l_pack.first == deferred_lighting_dir_shadow_quad_)
-        glUniformMatrix4fv(loc_it->second[3], 3, GL_FALSE,
-                           mats[inst_count].data);
-      else
-        glUniformMatrix4fv(loc_it->second[3], int(light_pack.size()), GL_FALSE,
-                           mats[inst_count].data);
-
-      inst_count += int(light_pack.size());
-
-      if (l_pack.first == deferred_lighting_point_shadow_quad_ ||
-          l_pack.first == deferred_lighting_quad_ ||
-          l_pack.first == deferred_lighting_dir_shadow_quad_ ||
-          l_pack.first == deferred_lighting_dir_quad_) {
-        glBindVertexArray(screen_quad_);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, int(light_pack.size()));
-      } else
-        mesh_system->DrawMesh(lib_core::EngineCore::stock_sphere_mesh,
-                              int(light_pack.size()), true);
-    }
-  }
+const std::array<int, 3> &GlDeferredLighting::Locations(
+    unsigned shader_program) {
+  auto loc_it = shader_locations_.find(shader_program);
+  if (loc_it != shader_locations_.end()) return loc_it->second;
 
-  glDisable(GL_STENCIL_TEST);
-  glEnable(GL_DEPTH_TEST);
-  glCullFace(GL_BACK);
-  glDisable(GL_BLEND);
-  glDepthMask(GL_TRUE);
+  auto &data = shader_locations_[shader_program];
+  data[0] = glGetUniformLocation(shader_program, "first_light");
+  data[1] = glGetUniformLocation(shader_program, "instance_offset");
+  data[2] = glGetUniformLocation(shader_program, "multi_draw");
+  return data;
 }
 
-void GlDeferredLighting::InstanceDraw(Camera &cam, lib_core::Entity cam_entity,
+void GlDeferredLighting::RecordLights(const Camera &cam,
                                       lib_core::Vector3 cam_pos) {
-  auto mat_system = engine_->GetMaterial();
-  auto mesh_system = engine_->GetMesh();
+  using List = lib_core::RenderCommandList;
   auto window = engine_->GetWindow();
+  std::array<float, 2> scr_dim = {float(window->GetRenderDim().first),
+                                  float(window->GetRenderDim().second)};
 
+  commands_.Clear();
+  bound_lights_.clear();
+  uint32_t order = 0;
   for (auto &l_pack : light_packs) {
-    int inst_count = 0;
-    int max_instance = l_pack.second[0].second.type == Light::kDir ? 5 : 50;
-    if (l_pack.first == deferred_lighting_dir_shadow_quad_ ||
-        l_pack.first == deferred_lighting_point_shadow_volume_ ||
-        l_pack.first == deferred_lighting_point_shadow_quad_)
-      max_instance = 1;
-
-    ct::dyn_array<std::pair<lib_core::Entity, Light>> light_pack;
-    for (int iii = 0; iii < l_pack.second.size(); iii += max_instance) {
-      light_pack.clear();
-      for (int ii = iii; ii < l_pack.second.size(); ++ii) {
-        light_pack.push_back(l_pack.second[ii]);
-        if (light_pack.size() == max_instance) break;
-      }
-
-      // Render shadows
-      if (l_pack.first == deferred_lighting_dir_shadow_quad_ ||
-          l_pack.first == deferred_lighting_point_shadow_volume_ ||
-          l_pack.first == deferred_lighting_point_shadow_quad_) {
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
-        shadow_mapper_->DrawShadowMap(light_pack[0]);
+    // Lights without shadows share one instanced draw, shadowed lights are
+    // drawn one by one after their shadow map.
+    bool shadows = ShadowPack(l_pack.first);
+    int batch = shadows ? 1 : int(l_pack.second.size());
+    auto first = pack_offsets_[l_pack.first];
+    int cascade = 0;
+
+    for (int i = 0; i < int(l_pack.second.size()); i += batch) {
+      auto light = List::kNoLight;
+      if (shadows) {
+        auto shadowed = l_pack.second[i];
+        shadow_mapper_->RecordShadowMap(shadowed, commands_, kLightingPass,
+                                        order++);
+        light = shadowed.first.id_;
+        bound_lights_[light] = {shadowed};
       }
 
-      glDepthMask(GL_FALSE);
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_ONE, GL_ONE);
-
-      auto &mats = light_mats[l_pack.first];
-      mat_system->ApplyMaterial(l_pack.first, &light_pack, true);
-      auto shader_program = mat_system->GetCurrentShader();
-
-      auto loc_it = shader_locations_.find(shader_program);
-      if (loc_it == shader_locations_.end()) {
-        auto &data = shader_locations_[shader_program];
-        data[0] = glGetUniformLocation(shader_program, "cam_pos");
-        data[1] = glGetUniformLocation(shader_program, "screen_dim");
-        data[2] = glGetUniformLocation(shader_program, "view_proj");
-        data[3] = glGetUniformLocation(shader_program, "world[0]");
-        loc_it = shader_locations_.find(shader_program);
+      auto key = List::Key(kLightingPass, order++, uint32_t(l_pack.first));
+      commands_.SetState(key,
+                         List::kDepthTest | List::kCullBack | List::kBlendOne);
+      commands_.BindMaterial(key, l_pack.first, light);
+      commands_.SetConstants(key, GlCommandBackend::kCamPos, &cam_pos[0], 3);
+      commands_.SetConstants(key, GlCommandBackend::kScreenDim, scr_dim.data(),
+                             2);
+      commands_.SetConstants(key, GlCommandBackend::kViewProj,
+                             cam.view_proj_.data, 16);
+      auto cascades = l_pack.second[i].second.cascades;
+      if (l_pack.first == deferred_lighting_dir_shadow_quad_ && cascades > 0) {
+        commands_.SetConstants(key, GlCommandBackend::kCascadeMatrices,
+                               light_mats[l_pack.first][cascade].data,
+                               size_t(cascades) * 16);
+        cascade += cascades;
       }
 
-      std::array<float, 2> scr_dim = {float(window->GetRenderDim().first),
-                                      float(window->GetRenderDim().second)};
-
-      glUniform3fv(loc_it->second[0], 1, &cam_pos[0]);
-      glUniform2fv(loc_it->second[1], 1, scr_dim.data());
-      glUniformMatrix4fv(loc_it->second[2], 1, GL_FALSE, cam.view_proj_.data);
-      if (l_pack.first == deferred_lighting_dir_shadow_quad_)
-        glUniformMatrix4fv(loc_it->second[3], 3, GL_FALSE,
-                           mats[inst_count].data);
-      else
-        glUniformMatrix4fv(loc_it->second[3], int(light_pack.size()), GL_FALSE,
-                           mats[inst_count].data);
-
-      inst_count += int(light_pack.size());
-
-      if (l_pack.first == deferred_lighting_point_shadow_quad_ ||
-          l_pack.first == deferred_lighting_quad_ ||
-          l_pack.first == deferred_lighting_dir_shadow_quad_ ||
-          l_pack.first == deferred_lighting_dir_quad_) {
-        glBindVertexArray(screen_quad_);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, int(light_pack.size()));
-      } else
-        mesh_system->DrawMesh(lib_core::EngineCore::stock_sphere_mesh,
-                              int(light_pack.size()), true);
+      commands_.Draw(key,
+                     ScreenPack(l_pack.first)
+                         ? List::kScreenTriangle
+                         : lib_core::EngineCore::stock_sphere_mesh,
+                     first + i, batch);
     }
   }
 
-  glDisable(GL_BLEND);
-  glDepthMask(GL_TRUE);
+  commands_.SetState(List::Key(kLightingPass, order, 0),
+                     List::kDepthTest | List::kDepthWrite | List::kCullBack);
 }
 }  // namespace lib_graphics
@@ -2,6 +2,7 @@
 #include "camera.h"
 #include "engine_core.h"
 #include "entity.h"
+#include "gl_command_backend.h"
 #include "gl_shadow_mapping.h"
 #include "light.h"
 #include "material_system.h"
@@ -10,6 +11,11 @@
 namespace lib_graphics {
 class GlDeferredLighting {
  public:
+  // Storage binding of the per light instance data of lighting shaders.
+  static constexpr unsigned kLightBinding = 4;
+  // Key pass of the lighting list, which also carries the shadow maps.
+  static constexpr uint8_t kLightingPass = 1;
+
   GlDeferredLighting(lib_core::EngineCore* engine,
                      const TextureDesc& position_tex,
                      const TextureDesc& normal_tex,
@@ -17,28 +23,51 @@ class GlDeferredLighting {
                      const TextureDesc& depth_tex);
   ~GlDeferredLighting();
 
+  // Once per rendered frame, before the first camera draws its lights.
+  void BeginFrame();
   void DrawLights(Camera& cam, lib_core::Entity cam_entity,
                   lib_core::Vector3 cam_pos);
   void SetScreenQuad(unsigned quad);
 
+  // Debug snapshot of the lighting replayed by the last DrawLights call, with
+  // shadow maps recorded right ahead of the light that samples them. It is
+  // rebuilt per view, so with several cameras only the last one remains.
+  // Kept in recording order, not sorted.
+  const lib_core::RenderCommandList& Commands() const { return commands_; }
+
  protected:
  private:
-  void StencilDraw(Camera& cam, lib_core::Entity cam_entity,
-                   lib_core::Vector3 cam_pos);
-  void InstanceDraw(Camera& cam, lib_core::Entity cam_entity,
-                    lib_core::Vector3 cam_pos);
+  void RecordLights(const Camera& cam, lib_core::Vector3 cam_pos);
+  bool ShadowPack(size_t material) const;
+  bool ScreenPack(size_t material) const;
+  const std::array<int, 3>& Locations(unsigned shader_program);
+
+  // std430 layout of one light, world places the volume of point lights.
+  struct LightInstance {
+    lib_core::Matrix4x4 world;
+    std::array<float, 4> position_radius, coeff, color, direction;
+  };
 
   lib_core::EngineCore* engine_;
   ct::dyn_array<size_t> shader_ids_;
 
   unsigned screen_quad_;
 
-  int stencil_vp_loc_ = -1, stencil_world_loc_ = -1;
-  ct::hash_map<unsigned, std::array<int, 4>> shader_locations_;
+  ct::hash_map<unsigned, std::array<int, 3>> shader_locations_;
   std::unique_ptr<GlShadowMapping> shadow_mapper_;
+  lib_core::RenderCommandList commands_;
+  // Shadowed lights with their maps, sampled when the list is replayed.
+  GlCommandBackend::LightMap bound_lights_;
 
+  // Lights grouped by material. Each group is streamed as one consecutive
+  // range and its draws start at first_light.
   ct::hash_map<size_t, ct::dyn_array<std::pair<lib_core::Entity, Light>>>
       light_packs;
+  ct::hash_map<size_t, ct::dyn_array<LightInstance>> light_instances_;
+  ct::hash_map<size_t, int> pack_offsets_;
+  ct::dyn_array<LightInstance> instances_;
+  std::unique_ptr<class GlInstanceBuffer> light_stream_;
+  // Cascade matrices of directional lights.
   ct::hash_map<size_t, ct::dyn_array<lib_core::Matrix4x4>> light_mats;
 
   size_t deferred_lighting_point_shadow_volume_;
@@ -47,7 +76,5 @@ class GlDeferredLighting {
   size_t deferred_lighting_dir_quad_;
   size_t deferred_lighting_volume_;
   size_t deferred_lighting_quad_;
-
-  size_t stencil_pass_;
 };
 }  // namespace lib_graphics
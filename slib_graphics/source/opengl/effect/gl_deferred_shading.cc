@@ -1,8 +1,12 @@
 #include "gl_deferred_shading.h"
 #include <GL/glew.h>
 #include "culling_system.h"
+#include "gl_command_backend.h"
+#include "gl_instance_buffer.h"
 #include "gl_material_system.h"
-#include "mesh_system.h"
+#include "gl_mesh_system.h"
+#include "profiler.h"
+#include "window.h"
 
 namespace lib_graphics {
 GlDeferredShading::GlDeferredShading(lib_core::EngineCore *engine)
@@ -10,97 +14,79 @@ GlDeferredShading::GlDeferredShading(lib_core::EngineCore *engine)
   max_inst_ = 100;
 }
 
-void GlDeferredShading::DrawGBuffers(
-    const Camera cam,
-    const ct::dyn_array<CullingSystem::MeshPack> &mesh_packs) {
-  auto gbuffer_timer = cu::TimerStart();
-  cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                  __FILE__, __LINE__);
+GlDeferredShading::~GlDeferredShading() = default;
 
+void GlDeferredShading::BindSurfaces() {
   auto cull_system = engine_->GetCulling();
-  auto mat_system = static_cast<GlMaterialSystem *>(engine_->GetMaterial());
-  auto mesh_system = engine_->GetMesh();
-
-  auto &world_matrices = cull_system->GetWorldMatrices();
   auto &world_inv_trans_matrices = cull_system->GetWorldInvTransMatrices();
   auto &albedo_vecs = cull_system->GetAlbedoVecs();
   auto &rme_vecs = cull_system->GetRmeVecs();
   auto &tex_scale = cull_system->GetTexScaleVecs();
   auto &tex_offset = cull_system->GetTexOffsetVecs();
 
-  draw_calls_ = 0;
-  for (auto &pack : mesh_packs) {
-    cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                    __FILE__, __LINE__);
+  surfaces_.resize(world_inv_trans_matrices.size());
+  for (size_t i = 0; i < surfaces_.size(); ++i) {
+    auto &surface = surfaces_[i];
+    surface.world_inv_trans = world_inv_trans_matrices[i];
+    surface.albedo = {albedo_vecs[i][0], albedo_vecs[i][1], albedo_vecs[i][2],
+                      0.f};
+    surface.rme = {rme_vecs[i][0], rme_vecs[i][1], rme_vecs[i][2], 0.f};
+    surface.tex = {tex_scale[i][0], tex_scale[i][1], tex_offset[i][0],
+                   tex_offset[i][1]};
+  }
 
-    mat_system->ApplyMaterial(pack.material_id);
+  if (surface_stream_)
+    surface_stream_->EndFrame();
+  else
+    surface_stream_ = std::make_unique<GlInstanceBuffer>(
+        engine_->GetWindow()->Capabilities().buffer_storage, 1 << 20);
+  surface_stream_->Bind(surfaces_.data(), surfaces_.size() * sizeof(Surface),
+                        kSurfaceBinding);
+}
 
-    cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                    __FILE__, __LINE__);
+void GlDeferredShading::DrawGBuffers(
+    const Camera cam, const lib_core::RenderCommandList &commands) {
+  PROFILE_ZONE("Gbuffer");
+  auto gbuffer_timer = cu::TimerStart();
 
+  auto mat_system = static_cast<GlMaterialSystem *>(engine_->GetMaterial());
+  auto mesh_system = static_cast<GlMeshSystem *>(engine_->GetMesh());
+  auto multi_draw = mesh_system->MultiDraw();
+
+  // Instances are read from storage buffers. Camera uniforms go in whenever
+  // the replay switched shaders, the instance offset for every draw. Multi
+  // draw batches start at 0 and add each draw's base instance.
+  unsigned current_shader = 0;
+  auto bind_instances = [&](size_t first, size_t) {
     auto shader_id = mat_system->GetCurrentShader();
     auto it = shader_locations_.find(shader_id);
     if (it == shader_locations_.end()) {
       auto &data = shader_locations_[shader_id];
       data[0] = glGetUniformLocation(shader_id, "cam_pos");
       data[1] = glGetUniformLocation(shader_id, "view_proj");
-      data[2] = glGetUniformLocation(shader_id, "world[0]");
-      data[3] = glGetUniformLocation(shader_id, "world_inv_trans[0]");
-      data[4] = glGetUniformLocation(shader_id, "albedo[0]");
-      data[5] = glGetUniformLocation(shader_id, "rme[0]");
-      data[6] = glGetUniformLocation(shader_id, "tex_scale[0]");
-      data[7] = glGetUniformLocation(shader_id, "tex_offset[0]");
+      data[2] = glGetUniformLocation(shader_id, "instance_offset");
+      data[3] = glGetUniformLocation(shader_id, "multi_draw");
       it = shader_locations_.find(shader_id);
     }
 
-    cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                    __FILE__, __LINE__);
-
-    if (it->second[0] != -1)
-      glUniform3fv(it->second[0], 1, cam.position_.data());
-    if (it->second[1] != -1)
-      glUniformMatrix4fv(it->second[1], 1, GL_FALSE, cam.view_proj_.data);
-
-    cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                    __FILE__, __LINE__);
-
-    auto count = int(pack.mesh_count);
-    while (count > 0) {
-      glUniformMatrix4fv(
-          it->second[2], count > max_inst_ ? max_inst_ : count, GL_FALSE,
-          world_matrices[pack.start_ind + (pack.mesh_count - count)].data);
-      glUniformMatrix4fv(
-          it->second[3], count > max_inst_ ? max_inst_ : count, GL_FALSE,
-          world_inv_trans_matrices[pack.start_ind + (pack.mesh_count - count)]
-              .data);
-      glUniform3fv(
-          it->second[4], count > max_inst_ ? max_inst_ : count,
-          albedo_vecs[pack.start_ind + (pack.mesh_count - count)].data());
-      glUniform3fv(it->second[5], count > max_inst_ ? max_inst_ : count,
-                   rme_vecs[pack.start_ind + (pack.mesh_count - count)].data());
-      if (it->second[6])
-        glUniform2fv(
-            it->second[6], count > max_inst_ ? max_inst_ : count,
-            tex_scale[pack.start_ind + (pack.mesh_count - count)].data());
-      if (it->second[7])
-        glUniform2fv(
-            it->second[7], count > max_inst_ ? max_inst_ : count,
-            tex_offset[pack.start_ind + (pack.mesh_count - count)].data());
-
-      mesh_system->DrawMesh(pack.mesh_id,
-                            count > max_inst_ ? max_inst_ : count);
-
-      ++draw_calls_;
-      count -= max_inst_;
+    if (shader_id != current_shader) {
+      current_shader = shader_id;
+      if (it->second[0] != -1)
+        glUniform3fv(it->second[0], 1, cam.position_.data());
+      if (it->second[1] != -1)
+        glUniformMatrix4fv(it->second[1], 1, GL_FALSE, cam.view_proj_.data);
+      glUniform1i(it->second[3], multi_draw);
     }
-  }
+    glUniform1ui(it->second[2], GLuint(first));
+  };
+
+  GlCommandBackend backend(engine_, multi_draw, bind_instances);
+  backend.Replay(commands);
+  draw_calls_ = int(backend.DrawCalls());
 
   if (engine_->GetDebugOutput())
     engine_->GetDebugOutput()->UpdateBottomLeftLine(
         5, "GBuffer Draw Calls: " + std::to_string(draw_calls_));
-
-  cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Gbuffers",
-                  __FILE__, __LINE__);
   engine_->GetDebugOutput()->UpdateBottomRightLine(
       3, std::to_string(cu::TimerStop<std::milli>(gbuffer_timer)) +
              " :Gbuffer time");
@@ -109,6 +95,7 @@ void GlDeferredShading::DrawGBuffers(
 void GlDeferredShading::DrawTranslucents(
     const Camera cam,
     const ct::dyn_array<CullingSystem::MeshPack> &mesh_packs) {
+  PROFILE_ZONE("Translucency");
   auto transl_timer = cu::TimerStart();
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
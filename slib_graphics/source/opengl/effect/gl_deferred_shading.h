@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include "culling_system.h"
 #include "engine_core.h"
 #include "entity_manager.h"
@@ -6,18 +7,33 @@
 namespace lib_graphics {
 class GlDeferredShading {
  public:
+  // Storage binding of the per instance surface data of G-buffer shaders.
+  static constexpr unsigned kSurfaceBinding = 3;
+
   GlDeferredShading(lib_core::EngineCore *engine);
-  ~GlDeferredShading() = default;
+  ~GlDeferredShading();
 
+  // Pushes the surface data of every opaque instance, once a frame before
+  // the G-buffer passes. World matrices are bound by the renderer.
+  void BindSurfaces();
+  // Replays the G-buffer pass recorded by the culling system.
   void DrawGBuffers(const Camera cam,
-                    const ct::dyn_array<CullingSystem::MeshPack> &mesh_packs);
+                    const lib_core::RenderCommandList &commands);
   void DrawTranslucents(
       const Camera cam,
       const ct::dyn_array<CullingSystem::MeshPack> &mesh_packs);
 
  private:
+  // std430 layout of one instance, tex holds the texture scale and offset.
+  struct Surface {
+    lib_core::Matrix4x4 world_inv_trans;
+    std::array<float, 4> albedo, rme, tex;
+  };
+
   lib_core::EngineCore *engine_;
 
+  ct::dyn_array<Surface> surfaces_;
+  std::unique_ptr<class GlInstanceBuffer> surface_stream_;
   ct::hash_map<unsigned, std::array<int, 9>> shader_locations_;
   int draw_calls_, max_inst_;
 };
@@ -1,14 +1,15 @@
 #include "gl_shadow_mapping.h"
 #include <GL/glew.h>
-#include "culling_system.h"
+#include <cmath>
+#include <string_view>
+#include "gl_command_backend.h"
 #include "gl_material_system.h"
 #include "light_system.h"
-#include "mesh_system.h"
 #include "window.h"
 
 namespace lib_graphics {
 GlShadowMapping::GlShadowMapping(lib_core::EngineCore *engine)
-    : engine_(engine) {
+    : engine_(engine), atlas_({2, 4, 8, 16}, kRedrawBudget) {
   auto shader_command = AddShaderCommand(
       cu::ReadFile("./content/shaders/opengl/shadow_mapping_3d_vs.glsl"),
       cu::ReadFile("./content/shaders/opengl/shadow_mapping_3d_fs.glsl"),
@@ -32,48 +33,125 @@ GlShadowMapping::GlShadowMapping(lib_core::EngineCore *engine)
   material_command = AddMaterialCommand(material);
   dir_shadow_material_ = material_command.MaterialId();
   issue_command(material_command);
+
+  remove_light_callback_ =
+      g_ent_mgr.RegisterRemoveComponentCallback<lib_graphics::Light>(
+          [&](lib_core::Entity entity) {
+            atlas_.Remove(entity.id_);
+            signatures_.erase(entity.id_);
+          });
 }
 
 GlShadowMapping::~GlShadowMapping() {
+  g_ent_mgr.UnregisterRemoveComponentCallback<lib_graphics::Light>(
+      remove_light_callback_);
   for (auto &id : shader_ids_) issue_command(RemoveShaderCommand(id));
   issue_command(RemoveMaterialCommand(point_shadow_material_));
   issue_command(RemoveMaterialCommand(dir_shadow_material_));
 }
 
-void GlShadowMapping::DrawShadowMap(std::pair<lib_core::Entity, Light> &light) {
-  auto cull_system = engine_->GetCulling();
+void GlShadowMapping::BeginFrame() {
+  // Purged targets lost their contents along with their ids.
   auto mat_system = static_cast<GlMaterialSystem *>(engine_->GetMaterial());
-  auto mesh_system = engine_->GetMesh();
-  auto light_mesh_packs = cull_system->GetMeshPacks(light.first);
-
-  auto &world_matrices = cull_system->GetWorldMatrices();
-  size_t frame_buff;
+  if (cache_generation_ != mat_system->ShadowCacheGeneration()) {
+    cache_generation_ = mat_system->ShadowCacheGeneration();
+    atlas_ = lib_core::ShadowAtlas({2, 4, 8, 16}, kRedrawBudget);
+    signatures_.clear();
+  }
+  atlas_.BeginFrame();
+}
 
-  ct::dyn_array<lib_core::Matrix4x4> shadow_transforms =
-      LightSystem::GetShadowMatrices(light.second, false);
+void GlShadowMapping::ScheduleShadows(
+    const Camera &cam, lib_core::Vector3 cam_pos,
+    const ct::dyn_array<lib_core::Entity> &lights) {
+  auto cull_system = engine_->GetCulling();
+  auto &world = cull_system->GetWorldMatrices();
+
+  auto max_res = g_settings.MaxShadowTexture();
+  auto tan_half_fov = std::tan(cam.fov_ * (PI / 360.f));
+  requests_.clear();
+  for (auto entity : lights) {
+    auto light = g_ent_mgr.GetOldCbeR<Light>(entity);
+    if (!light || !light->cast_shadows || light->type != Light::kPoint)
+      continue;
+
+    auto to_light = light->data_pos;
+    to_light -= cam_pos;
+    auto dist = to_light.Length();
+    auto coverage = dist > light->max_radius
+                        ? light->max_radius / (dist * tan_half_fov)
+                        : 1.f;
+    auto tier = lib_core::ShadowAtlas::TierForCoverage(coverage, kTiers);
+    while (tier < kTiers - 1 &&
+           (max_res >> tier) > light->shadow_resolutions[0])
+      ++tier;
+
+    auto packs = cull_system->GetMeshPacks(entity);
+    auto signature = packs ? Signature(*light, *packs, world) : 0;
+    auto &cached = signatures_[entity.id_];
+    if (cached != signature) {
+      cached = signature;
+      atlas_.Invalidate(entity.id_);
+    }
+    requests_.push_back({entity.id_, tier, tier == 0});
+  }
 
-  size_t nr_maps = 1;
-  GLuint shader_id = 0;
-  switch (light.second.type) {
-    case Light::kPoint:
-      mat_system->ApplyMaterial(point_shadow_material_);
-      shader_id = mat_system->GetCurrentShader();
+  atlas_.Update(requests_, placements_);
+  placement_index_.clear();
+  for (size_t i = 0; i < placements_.size(); ++i)
+    placement_index_[placements_[i].light] = i;
+}
 
-      if (light_pos_loc_ == -1)
-        light_pos_loc_ = glGetUniformLocation(shader_id, "light_pos");
-      if (far_plane_loc_ == -1)
-        far_plane_loc_ = glGetUniformLocation(shader_id, "far_plane");
+size_t GlShadowMapping::Signature(
+    const Light &light, const ct::dyn_array<CullingSystem::MeshPack> &packs,
+    const ct::dyn_array<lib_core::Matrix4x4> &world) {
+  size_t signature = 0;
+  auto mix = [&](const void *data, size_t size) {
+    auto hash = std::hash<std::string_view>{}(
+        std::string_view(static_cast<const char *>(data), size));
+    signature ^= hash + 0x9e3779b9 + (signature << 6) + (signature >> 2);
+  };
+
+  mix(&light.data_pos, sizeof(light.data_pos));
+  mix(&light.max_radius, sizeof(light.max_radius));
+  for (auto &pack : packs) {
+    mix(&pack.mesh_id, sizeof(pack.mesh_id));
+    mix(&pack.mesh_count, sizeof(pack.mesh_count));
+    if (pack.start_ind + pack.mesh_count <= world.size())
+      mix(world[pack.start_ind].data,
+          pack.mesh_count * sizeof(lib_core::Matrix4x4));
+  }
+  return signature;
+}
 
-      glUniform3fv(light_pos_loc_, 1, light.second.data_pos.data());
-      glUniform1f(far_plane_loc_, light.second.max_radius);
+void GlShadowMapping::RecordShadowMap(
+    std::pair<lib_core::Entity, Light> &light,
+    lib_core::RenderCommandList &list, uint8_t pass, uint32_t order) {
+  using List = lib_core::RenderCommandList;
+  auto cull_system = engine_->GetCulling();
+  auto mat_system = static_cast<GlMaterialSystem *>(engine_->GetMaterial());
 
-      frame_buff = mat_system->Get3DShadowFrameBuffer(
-          light.second.shadow_resolutions[0]);
+  size_t frame_buff = 0, material;
+  switch (light.second.type) {
+    case Light::kPoint: {
+      // Lights without a cached slot share a target redrawn every time.
+      auto it = placement_index_.find(light.first.id_);
+      if (it != placement_index_.end() &&
+          placements_[it->second].tier != lib_core::ShadowAtlas::kNoTier) {
+        auto &placement = placements_[it->second];
+        frame_buff = mat_system->GetCachedShadowFrameBuffer(
+            g_settings.MaxShadowTexture() >> placement.tier, placement.slot);
+        light.second.shadow_map = frame_buff;
+        if (!placement.render) return;
+      } else {
+        frame_buff = mat_system->Get3DShadowFrameBuffer(
+            light.second.shadow_resolutions[0]);
+      }
+      material = point_shadow_material_;
       break;
+    }
     case Light::kDir:
-      mat_system->ApplyMaterial(dir_shadow_material_);
-      shader_id = mat_system->GetCurrentShader();
-      nr_maps = shadow_transforms.size();
+      material = dir_shadow_material_;
       break;
     default:
       cu::AssertWarning(false, "Faulty light type specified.", __FILE__,
@@ -81,37 +159,43 @@ void GlShadowMapping::DrawShadowMap(std::pair<lib_core::Entity, Light> &light) {
       return;
   }
 
-  int max_inst = 200;
-  GLint world_loc = glGetUniformLocation(shader_id, "world[0]");
-  GLint loc = glGetUniformLocation(shader_id, "shadow_matrices[0]");
-  for (int i = 0; i < nr_maps; ++i) {
-    if (light.second.type == Light::kDir) {
-      frame_buff = mat_system->Get2DShadowFrameBuffer(
-          light.second.shadow_resolutions[i]);
-      glUniformMatrix4fv(loc, 1, GL_FALSE, shadow_transforms[i].data);
-    } else if (light.second.type == Light::kPoint) {
-      glUniformMatrix4fv(loc, GLsizei(shadow_transforms.size()), GL_FALSE,
-                         shadow_transforms[0].data);
+  // World matrices come from the frame's instance buffer. With multi draw
+  // the packs of a map merge into one submission and every draw finds its
+  // instances through its base instance, otherwise each pack is one draw at
+  // its offset into the buffer.
+  auto key = List::Key(pass, order, uint32_t(material));
+  auto record_packs = [&](lib_core::Entity view) {
+    auto packs = cull_system->GetMeshPacks(view);
+    if (!packs) return;
+    for (auto &pack : *packs)
+      list.Draw(key, pack.mesh_id, pack.start_ind, pack.mesh_count);
+  };
+
+  list.SetState(key, List::kDepthTest | List::kDepthWrite | List::kCullBack |
+                         List::kMergeDraws);
+  list.BindMaterial(key, material);
+  auto shadow_transforms = LightSystem::GetShadowMatrices(light.second, false);
+  if (light.second.type == Light::kPoint) {
+    // One draw fills all six faces.
+    list.SetConstants(key, GlCommandBackend::kLightPos,
+                      light.second.data_pos.data(), 3);
+    list.SetConstants(key, GlCommandBackend::kFarPlane,
+                      &light.second.max_radius, 1);
+    list.SetConstants(key, GlCommandBackend::kShadowMatrices,
+                      shadow_transforms[0].data, shadow_transforms.size() * 16);
+    list.SetTarget(key, frame_buff, List::kClearDepth);
+    record_packs(light.first);
+  } else {
+    for (size_t i = 0; i < shadow_transforms.size(); ++i) {
+      list.SetConstants(key, GlCommandBackend::kShadowMatrices,
+                        shadow_transforms[i].data, 16);
+      list.SetTarget(key,
+                     mat_system->Get2DShadowFrameBuffer(
+                         light.second.shadow_resolutions[i], i),
+                     List::kClearDepth);
+      record_packs(CullingSystem::CascadeView(light.first, i));
     }
-
-    mat_system->PushFrameBuffer(frame_buff);
-    glClear(GL_DEPTH_BUFFER_BIT);
-
-    for (auto &pack : *light_mesh_packs) {
-      auto count = int(pack.mesh_count);
-      while (count > 0) {
-        if (world_loc != -1)
-          glUniformMatrix4fv(
-              world_loc, count > max_inst ? max_inst : count, GL_FALSE,
-              world_matrices[pack.start_ind + (pack.mesh_count - count)].data);
-
-        mesh_system->DrawMesh(pack.mesh_id, count > max_inst ? max_inst : count,
-                              true);
-        count -= max_inst;
-      }
-    }
-
-    mat_system->PopFrameBuffer();
   }
+  list.SetTarget(key, List::kViewTarget);
 }
 }  // namespace lib_graphics
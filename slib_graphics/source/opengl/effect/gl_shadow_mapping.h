@@ -1,7 +1,11 @@
 #pragma once
+#include "camera.h"
+#include "culling_system.h"
 #include "engine_core.h"
 #include "entity_manager.h"
 #include "light.h"
+#include "render_command_list.h"
+#include "shadow_atlas.h"
 
 namespace lib_graphics {
 class GlShadowMapping {
@@ -9,18 +13,45 @@ class GlShadowMapping {
   GlShadowMapping(lib_core::EngineCore *engine);
   ~GlShadowMapping();
 
-  void DrawShadowMap(std::pair<lib_core::Entity, Light> &light);
+  // Call once per rendered frame, before the views schedule their shadows.
+  void BeginFrame();
+  // Point shadows are cached between frames. Picks a resolution tier for
+  // every shadowed point light from its screen coverage and decides which
+  // maps get redrawn this frame, call once before drawing the lights.
+  void ScheduleShadows(const Camera &cam, lib_core::Vector3 cam_pos,
+                       const ct::dyn_array<lib_core::Entity> &lights);
+  // Records the shadow map of a light into list, drawn to its own targets and
+  // ending on the view's target again. Skips point lights whose cached map is
+  // still valid, either way the light copy is pointed at the map to sample.
+  // Draws read instance_offset and multi_draw set by the replaying pass.
+  void RecordShadowMap(std::pair<lib_core::Entity, Light> &light,
+                       lib_core::RenderCommandList &list, uint8_t pass,
+                       uint32_t order);
 
  protected:
  private:
+  static constexpr int kTiers = 4;
+  static constexpr size_t kRedrawBudget = 2;
+
+  // Everything a cached point shadow depends on, the light and the world
+  // matrices of every mesh it was culled against.
+  size_t Signature(const Light &light,
+                   const ct::dyn_array<CullingSystem::MeshPack> &packs,
+                   const ct::dyn_array<lib_core::Matrix4x4> &world);
+
   lib_core::EngineCore *engine_;
+  size_t remove_light_callback_;
+
+  lib_core::ShadowAtlas atlas_;
+  size_t cache_generation_ = 0;
+  ct::hash_map<size_t, size_t> signatures_;
+  ct::dyn_array<lib_core::ShadowAtlas::Request> requests_;
+  ct::dyn_array<lib_core::ShadowAtlas::Placement> placements_;
+  ct::hash_map<size_t, size_t> placement_index_;
 
   ct::dyn_array<size_t> shader_ids_;
 
   size_t point_shadow_material_;
   size_t dir_shadow_material_;
-
-  int light_pos_loc_ = -1;
-  int far_plane_loc_ = -1;
 };
 }  // namespace lib_graphics
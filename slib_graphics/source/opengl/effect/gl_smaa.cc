@@ -2,7 +2,9 @@
 #include <GL/glew.h>
 #include <fstream>
 #include "gl_smaa_shaders.h"
+#include "gl_stock_shaders.h"
 #include "graphics_commands.h"
+#include "profiler.h"
 #include "window.h"
 
 namespace lib_graphics {
@@ -24,6 +26,7 @@ GlSmaa::~GlSmaa() {
 void GlSmaa::ApplySmaa() {
   if (edge_shader_ == 0 && blend_shader_ == 0) InitializeShaders();
 
+  PROFILE_ZONE("Smaa");
   auto smaa_timer = cu::TimerStart();
 
   glBindFramebuffer(GL_FRAMEBUFFER, edge_fbo_);
@@ -80,37 +83,6 @@ void GlSmaa::ApplySmaa() {
 
 unsigned GlSmaa::OutputFramebuffer() { return output_fbo_; }
 
-void GlSmaa::ShaderInclude(std::string &shader) {
-  size_t start_pos = 0;
-  std::string include_dir = "#include ";
-
-  while ((start_pos = shader.find(include_dir, start_pos)) !=
-         std::string::npos) {
-    auto pos = start_pos + include_dir.length() + 1;
-    auto length = shader.find('\"', pos);
-    std::string file = shader.substr(pos, length - pos);
-    std::string content = "";
-
-    std::ifstream f;
-    f.open(("./content/" + file).c_str());
-
-    if (f.is_open()) {
-      std::array<char, 1024> buffer;
-
-      while (!f.eof()) {
-        f.getline(buffer.data(), 1024);
-        content += buffer.data();
-        content += "\n";
-      }
-    } else {
-      cu::AssertError(false, "smma shader file not found.", __FILE__, __LINE__);
-    }
-
-    shader.replace(start_pos, (length + 1) - start_pos, content);
-    start_pos += content.length();
-  }
-}
-
 void GlSmaa::ReplaceAll(std::string &str, const std::string &from,
                         const std::string &to) {
   size_t start_pos = 0;
@@ -129,9 +101,9 @@ void GlSmaa::CreateShader(std::string vs_text, std::string ps_text,
   std::string log;
   GLint success;
 
-  ShaderInclude(vs_text);
+  GlStockShaders::ShaderInclude(vs_text);
   ReplaceAll(vs_text, "hash ", "#");
-  ShaderInclude(ps_text);
+  GlStockShaders::ShaderInclude(ps_text);
   ReplaceAll(ps_text, "hash ", "#");
 
   *program = glCreateProgram();
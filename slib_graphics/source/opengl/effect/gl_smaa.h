@@ -13,7 +13,6 @@ class GlSmaa {
   unsigned OutputFramebuffer();
 
  private:
-  void ShaderInclude(std::string &shader);
   void ReplaceAll(std::string &str, const std::string &from,
                   const std::string &to);
   void CreateShader(std::string vs_text, std::string ps_text,
@@ -5,6 +5,7 @@
 #include "gl_gausian_blur.h"
 #include "gl_material_system.h"
 #include "gl_window.h"
+#include "profiler.h"
 
 namespace lib_graphics {
 GlSsao::GlSsao(std::pair<size_t, size_t> dim, GlGausianBlur *blur,
@@ -84,6 +85,7 @@ GlSsao::~GlSsao() {
 }
 
 void GlSsao::ApplySsaoEffect(Camera &cam) {
+  PROFILE_ZONE("Ssao");
   auto ssao_timer = cu::TimerStart();
   auto mat_system = engine_->GetMaterial();
 
@@ -0,0 +1,170 @@
+#include "gl_command_backend.h"
+#include <GL/glew.h>
+#include "gl_material_system.h"
+#include "gl_mesh_system.h"
+#include "material_system.h"
+
+namespace lib_graphics {
+namespace {
+constexpr std::array<const char *, GlCommandBackend::kConstantCount>
+    kConstantNames = {"cam_pos",   "screen_dim", "view_proj",
+                      "world[0]",  "light_pos",  "far_plane",
+                      "shadow_matrices[0]"};
+}  // namespace
+
+GlCommandBackend::GlCommandBackend(lib_core::EngineCore *engine,
+                                   bool multi_draw, InstanceFn bind_instances)
+    : engine_(engine),
+      multi_draw_(multi_draw),
+      bind_instances_(std::move(bind_instances)) {}
+
+lib_core::RenderCommandList::Stats GlCommandBackend::Replay(
+    const lib_core::RenderCommandList &list) {
+  draw_calls_ = 0;
+  rebind_vao_ = true;
+  auto stats = list.Replay(*this);
+  Flush();
+  if (pushed_target_) engine_->GetMaterial()->PopFrameBuffer();
+  pushed_target_ = false;
+  cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Replay",
+                  __FILE__, __LINE__);
+  return stats;
+}
+
+void GlCommandBackend::SetState(uint32_t state) {
+  Flush();
+  using List = lib_core::RenderCommandList;
+  auto toggle = [](GLenum cap, bool on) {
+    if (on)
+      glEnable(cap);
+    else
+      glDisable(cap);
+  };
+  toggle(GL_DEPTH_TEST, state & List::kDepthTest);
+  toggle(GL_CULL_FACE, state & List::kCullBack);
+  glDepthMask(state & List::kDepthWrite ? GL_TRUE : GL_FALSE);
+
+  toggle(GL_BLEND, state & (List::kBlendAlpha | List::kBlendAdditive |
+                            List::kBlendOne));
+  if (state & List::kBlendAlpha)
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  else if (state & List::kBlendAdditive)
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  else if (state & List::kBlendOne)
+    glBlendFunc(GL_ONE, GL_ONE);
+
+  merge_ = multi_draw_ && (state & List::kMergeDraws);
+}
+
+void GlCommandBackend::BindMaterial(size_t material, size_t light) {
+  Flush();
+  auto mat_system = engine_->GetMaterial();
+  if (light == lib_core::RenderCommandList::kNoLight || !lights_) {
+    mat_system->ApplyMaterial(material);
+    return;
+  }
+
+  // Shadow maps are bound per light, so the material is applied every time.
+  auto it = lights_->find(light);
+  mat_system->ApplyMaterial(material, it != lights_->end() ? &it->second
+                                                           : nullptr,
+                            true);
+}
+
+void GlCommandBackend::BindBuffer(uint32_t slot, size_t buffer, size_t offset,
+                                  size_t size) {
+  Flush();
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, GLuint(buffer), offset,
+                    size);
+}
+
+void GlCommandBackend::SetConstants(uint32_t slot, const float *data,
+                                    size_t count) {
+  if (slot >= kConstantCount) return;
+  Flush();
+
+  auto shader = engine_->GetMaterial()->GetCurrentShader();
+  auto it = locations_.find(shader);
+  if (it == locations_.end()) {
+    it = locations_.emplace(shader, std::array<int, kConstantCount>()).first;
+    for (size_t i = 0; i < kConstantCount; ++i)
+      it->second[i] = glGetUniformLocation(shader, kConstantNames[i]);
+  }
+
+  auto loc = it->second[slot];
+  if (loc == -1) return;
+  switch (count) {
+    case 1:
+      glUniform1f(loc, data[0]);
+      break;
+    case 2:
+      glUniform2fv(loc, 1, data);
+      break;
+    case 3:
+      glUniform3fv(loc, 1, data);
+      break;
+    case 4:
+      glUniform4fv(loc, 1, data);
+      break;
+    default:
+      if (count % 16 == 0)
+        glUniformMatrix4fv(loc, GLsizei(count / 16), GL_FALSE, data);
+      break;
+  }
+}
+
+void GlCommandBackend::SetTarget(size_t target, uint32_t clear) {
+  Flush();
+  auto mat_system = engine_->GetMaterial();
+  if (pushed_target_) mat_system->PopFrameBuffer();
+  pushed_target_ = false;
+  if (target != lib_core::RenderCommandList::kViewTarget)
+    pushed_target_ = mat_system->PushFrameBuffer(target);
+
+  using List = lib_core::RenderCommandList;
+  GLbitfield bits = 0;
+  if (clear & List::kClearColor) bits |= GL_COLOR_BUFFER_BIT;
+  if (clear & List::kClearDepth) bits |= GL_DEPTH_BUFFER_BIT;
+  if (clear & List::kClearStencil) bits |= GL_STENCIL_BUFFER_BIT;
+  if (bits) glClear(bits);
+}
+
+void GlCommandBackend::Draw(size_t mesh, size_t first_instance,
+                            size_t instance_count) {
+  if (mesh == lib_core::RenderCommandList::kScreenTriangle) {
+    Flush();
+    if (bind_instances_) bind_instances_(first_instance, instance_count);
+    glBindVertexArray(screen_quad_);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 3, GLsizei(instance_count));
+    rebind_vao_ = true;
+    ++draw_calls_;
+    return;
+  }
+
+  if (merge_) {
+    pending_.push_back({mesh, 0, instance_count, first_instance});
+    pending_instances_ += instance_count;
+    return;
+  }
+
+  if (bind_instances_) bind_instances_(first_instance, instance_count);
+  engine_->GetMesh()->DrawMesh(mesh, int(instance_count), rebind_vao_);
+  rebind_vao_ = false;
+  ++draw_calls_;
+}
+
+void GlCommandBackend::Dispatch(uint32_t x, uint32_t y, uint32_t z) {
+  Flush();
+  glDispatchCompute(x, y, z);
+}
+
+void GlCommandBackend::Flush() {
+  if (pending_.empty()) return;
+
+  if (bind_instances_) bind_instances_(0, pending_instances_);
+  static_cast<GlMeshSystem *>(engine_->GetMesh())->DrawPacks(pending_);
+  ++draw_calls_;
+  pending_.clear();
+  pending_instances_ = 0;
+}
+}  // namespace lib_graphics
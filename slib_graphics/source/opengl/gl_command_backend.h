@@ -0,0 +1,76 @@
+#pragma once
+#include <functional>
+#include "culling_system.h"
+#include "engine_core.h"
+#include "light.h"
+#include "render_command_list.h"
+
+namespace lib_graphics {
+// Replays command lists through the material and mesh systems. Instance data
+// lives in storage buffers and the pass binds what a draw reads in its
+// callback. With multi draw, consecutive draws under a kMergeDraws state and
+// one material go out as one indirect submission and the callback runs once
+// for the batch with first 0, shaders then add the base instance of each
+// draw. Errors are checked once per replay rather than after every call.
+class GlCommandBackend : public lib_core::RenderBackend {
+ public:
+  using InstanceFn = std::function<void(size_t first, size_t count)>;
+  // One light per entity id, for materials that sample its shadow maps.
+  using LightMap =
+      ct::hash_map<size_t, ct::dyn_array<std::pair<lib_core::Entity, Light>>>;
+
+  // Constant slots and the uniforms they set. Floats are uploaded by count,
+  // 1 to 4 as a float or vector and multiples of 16 as matrices.
+  enum Constant : uint32_t {
+    kCamPos,
+    kScreenDim,
+    kViewProj,
+    kCascadeMatrices,
+    kLightPos,
+    kFarPlane,
+    kShadowMatrices,
+    kConstantCount
+  };
+
+  GlCommandBackend(lib_core::EngineCore *engine, bool multi_draw,
+                   InstanceFn bind_instances);
+
+  lib_core::RenderCommandList::Stats Replay(
+      const lib_core::RenderCommandList &list);
+  size_t DrawCalls() const { return draw_calls_; }
+
+  void SetScreenQuad(unsigned quad) { screen_quad_ = quad; }
+  void SetLights(LightMap *lights) { lights_ = lights; }
+
+  void SetState(uint32_t state) override;
+  void BindMaterial(size_t material, size_t light) override;
+  void BindBuffer(uint32_t slot, size_t buffer, size_t offset,
+                  size_t size) override;
+  void SetConstants(uint32_t slot, const float *data, size_t count) override;
+  void SetTarget(size_t target, uint32_t clear) override;
+  void Draw(size_t mesh, size_t first_instance,
+            size_t instance_count) override;
+  void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+
+ private:
+  // Submits the draws gathered since the last state change.
+  void Flush();
+
+  lib_core::EngineCore *engine_;
+  bool multi_draw_;
+  bool merge_ = false;
+  InstanceFn bind_instances_;
+  size_t draw_calls_ = 0;
+
+  unsigned screen_quad_ = 0;
+  // The mesh system's vertex array is bound again after the screen triangle.
+  bool rebind_vao_ = true;
+  bool pushed_target_ = false;
+  LightMap *lights_ = nullptr;
+  // Uniform locations per shader program and constant slot.
+  ct::hash_map<unsigned, std::array<int, kConstantCount>> locations_;
+
+  ct::dyn_array<CullingSystem::MeshPack> pending_;
+  size_t pending_instances_ = 0;
+};
+}  // namespace lib_graphics
@@ -9,6 +9,7 @@
 #include "gl_deferred_lighting.h"
 #include "gl_deferred_shading.h"
 #include "gl_gausian_blur.h"
+#include "gl_instance_buffer.h"
 #include "gl_renderer.h"
 #include "gl_shadow_mapping.h"
 #include "gl_skybox_shading.h"
@@ -17,6 +18,7 @@
 #include "gui_factory.h"
 #include "light.h"
 #include "material_system.h"
+#include "profiler.h"
 #include "skybox.h"
 
 namespace lib_graphics {
@@ -38,6 +40,7 @@ GlDeferredRenderer::~GlDeferredRenderer() {
 }
 
 void GlDeferredRenderer::RenderFrame(float dt) {
+  PROFILE_ZONE("Render");
   auto frame_time = cu::TimerStart();
   cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Render Frame",
                   __FILE__, __LINE__);
@@ -49,6 +52,14 @@ void GlDeferredRenderer::RenderFrame(float dt) {
   auto cam_entities = g_ent_mgr.GetEbt<Camera>();
   auto camera_comps = g_ent_mgr.GetOldCbt<Camera>();
 
+  // Instance data is shared by every view, the G-buffer and shadow passes
+  // index into it.
+  auto &world_matrices = cull_system->GetWorldMatrices();
+  instance_buffer_->Bind(world_matrices.data(),
+                         world_matrices.size() * sizeof(lib_core::Matrix4x4));
+  deferred_shading_effect_->BindSurfaces();
+  deferred_lighting_effect_->BeginFrame();
+
   if (camera_comps) {
     for (int i = 0; i < camera_comps->size(); ++i) {
       auto opeque_mesh_packs = cull_system->GetMeshPacks(cam_entities->at(i));
@@ -62,7 +73,8 @@ void GlDeferredRenderer::RenderFrame(float dt) {
 
       cu::AssertError(glGetError() == GL_NO_ERROR,
                       "OpenGL error - Render Frame", __FILE__, __LINE__);
-      deferred_shading_effect_->DrawGBuffers(cam, *opeque_mesh_packs);
+      deferred_shading_effect_->DrawGBuffers(
+          cam, *cull_system->GetCommands(cam_entities->at(i)));
       cu::AssertError(glGetError() == GL_NO_ERROR,
                       "OpenGL error - Render Frame", __FILE__, __LINE__);
 
@@ -119,11 +131,9 @@ void GlDeferredRenderer::RenderFrame(float dt) {
       auto particle_emitters = g_ent_mgr.GetEbt<ParticleEmitter>();
       if (particle_emitters && !particle_emitters->empty()) {
         glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
         glDepthMask(GL_FALSE);
-        auto part_sys = engine_->ParticleSystem();
-        for (auto &e : *particle_emitters)
-          part_sys->DrawParticleEmitter(e, cam, depth_desc_);
+        engine_->ParticleSystem()->DrawParticles(cam_entities->at(i), cam,
+                                                 depth_desc_);
         glDepthMask(GL_TRUE);
         glDisable(GL_BLEND);
       }
@@ -200,6 +210,8 @@ void GlDeferredRenderer::RenderFrame(float dt) {
     }
   }
 
+  instance_buffer_->EndFrame();
+
   engine_->GetDebugOutput()->UpdateBottomRightLine(
       0,
       std::to_string(cu::TimerStop<std::milli>(frame_time)) + " :Render time");
@@ -225,6 +237,9 @@ void GlDeferredRenderer::InitRenderer() {
   glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &uniform_vert_limit);
   glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &uniform_frag_limit);
 
+  instance_buffer_ =
+      std::make_unique<GlInstanceBuffer>(window->Capabilities().buffer_storage);
+
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_CULL_FACE);
   glCullFace(GL_BACK);
@@ -24,10 +24,14 @@ class GlDeferredRenderer : public Renderer {
     std::array<float, 2> tex_coord;
   };
 
+  struct ScreenQuad {
+    unsigned vao, vbo;
+  };
+
   lib_core::EngineCore* engine_;
 
   size_t frame_buffer_, hdr_buffer_;
-  GlMeshSystem::MeshInfo full_screen_quad_;
+  ScreenQuad full_screen_quad_;
   size_t deffered_ambient_material_, tonemap_gamma_material_;
   unsigned white_texture_, black_texture_;
 
@@ -35,6 +39,7 @@ class GlDeferredRenderer : public Renderer {
   std::array<int, 20> shader_locs_;
 
   std::unique_ptr<lib_gui::GuiRenderer> gui_renderer_;
+  std::unique_ptr<class GlInstanceBuffer> instance_buffer_;
   std::unique_ptr<class GlSsao> ssao_effect_;
   std::unique_ptr<class GlSmaa> smaa_effect_;
   std::unique_ptr<class GlBloom> bloom_effect_;
@@ -0,0 +1,114 @@
+#include "gl_instance_buffer.h"
+#include <GL/glew.h>
+#include <cstring>
+
+namespace lib_graphics {
+GlInstanceBuffer::GlInstanceBuffer(bool persistent, size_t capacity)
+    : persistent_(persistent) {
+  GLint alignment = 0;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment > 0) alignment_ = size_t(alignment);
+  CreateBuffer(capacity);
+}
+
+GlInstanceBuffer::~GlInstanceBuffer() { DeleteBuffer(); }
+
+size_t GlInstanceBuffer::Push(const void *data, size_t size) {
+  if (size == 0) return 0;
+
+  auto offset = ring_->Push(data, size);
+  while (offset == lib_core::FencedRing::kFull) {
+    auto capacity = ring_->Capacity() * 2;
+    while (capacity < size * 2) capacity *= 2;
+    cu::Log("Growing instance buffer to " + std::to_string(capacity) +
+                " bytes.",
+            __FILE__, __LINE__);
+
+    // Everything pushed this frame was used already, so finish it first.
+    ring_->EndFrame();
+    DeleteBuffer();
+    CreateBuffer(capacity);
+    offset = ring_->Push(data, size);
+  }
+  return offset;
+}
+
+bool GlInstanceBuffer::Bind(const void *data, size_t size, unsigned binding) {
+  if (size == 0) return false;
+
+  auto offset = Push(data, size);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer_, offset, size);
+  return true;
+}
+
+void GlInstanceBuffer::EndFrame() {
+  ring_->EndFrame();
+  ++epoch_;
+}
+
+void GlInstanceBuffer::Write(size_t offset, const void *data, size_t size) {
+  if (mapped_) {
+    std::memcpy(mapped_ + offset, data, size);
+    return;
+  }
+
+  // The ring only hands out ranges the GPU is done with.
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+  auto ptr = glMapBufferRange(
+      GL_SHADER_STORAGE_BUFFER, offset, size,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+          GL_MAP_UNSYNCHRONIZED_BIT);
+  std::memcpy(ptr, data, size);
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+}
+
+uint64_t GlInstanceBuffer::InsertFence() {
+  return uint64_t(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+void GlInstanceBuffer::WaitFence(uint64_t fence) {
+  auto sync = reinterpret_cast<GLsync>(fence);
+  GLenum wait_return = GL_UNSIGNALED;
+  while (wait_return != GL_ALREADY_SIGNALED &&
+         wait_return != GL_CONDITION_SATISFIED &&
+         wait_return != GL_WAIT_FAILED) {
+    wait_return = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  }
+  glDeleteSync(sync);
+}
+
+void GlInstanceBuffer::CreateBuffer(size_t capacity) {
+  glGenBuffers(1, &buffer_);
+  ++epoch_;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+
+  if (persistent_) {
+    GLbitfield map_flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, map_flags);
+    mapped_ = static_cast<uint8_t *>(
+        glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, capacity, map_flags));
+  } else {
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  cu::AssertError(glGetError() == GL_NO_ERROR,
+                  "OpenGL error - Create instance buffer", __FILE__, __LINE__);
+
+  ring_ = std::make_unique<lib_core::FencedRing>(*this, capacity, alignment_);
+}
+
+void GlInstanceBuffer::DeleteBuffer() {
+  // Waits for every frame still reading the buffer.
+  ring_.reset();
+
+  if (mapped_) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    mapped_ = nullptr;
+  }
+  glDeleteBuffers(1, &buffer_);
+  buffer_ = 0;
+}
+}  // namespace lib_graphics
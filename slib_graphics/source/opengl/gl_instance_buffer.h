@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include "fenced_ring.h"
+
+namespace lib_graphics {
+// Per frame instance data in one shader storage buffer. Data is streamed
+// through a FencedRing, persistently mapped when the context supports buffer
+// storage and mapped unsynchronized per write otherwise.
+class GlInstanceBuffer : public lib_core::FencedRing::Backend {
+ public:
+  static constexpr unsigned kBinding = 0;
+
+  GlInstanceBuffer(bool persistent, size_t capacity = 4 << 20);
+  ~GlInstanceBuffer() override;
+  GlInstanceBuffer(const GlInstanceBuffer &) = delete;
+  GlInstanceBuffer &operator=(const GlInstanceBuffer &) = delete;
+
+  // Copies the data in and returns its offset, growing the buffer when a
+  // single frame needs more than it holds. Growing replaces Buffer(), so an
+  // offset is only good until the next push.
+  size_t Push(const void *data, size_t size);
+  // Pushes and binds the data as a storage buffer. False for empty data.
+  bool Bind(const void *data, size_t size, unsigned binding = kBinding);
+  void EndFrame();
+
+  unsigned Buffer() const { return buffer_; }
+  // Changes at the end of every frame and when the buffer is replaced, which
+  // is when earlier offsets stop being usable.
+  size_t Epoch() const { return epoch_; }
+
+  void Write(size_t offset, const void *data, size_t size) override;
+  uint64_t InsertFence() override;
+  void WaitFence(uint64_t fence) override;
+
+ private:
+  void CreateBuffer(size_t capacity);
+  void DeleteBuffer();
+
+  bool persistent_;
+  size_t alignment_ = 256;
+  unsigned buffer_ = 0;
+  size_t epoch_ = 0;
+  uint8_t *mapped_ = nullptr;
+  std::unique_ptr<lib_core::FencedRing> ring_;
+};
+}  // namespace lib_graphics
@@ -1,48 +1,86 @@
 #include "gl_stock_shaders.h"
+#include <fstream>
 #include "material_system.h"
 #include "renderer.h"
 
 namespace lib_graphics {
 GlStockShaders::GlStockShaders() = default;
 
+void GlStockShaders::ShaderInclude(std::string &shader) {
+  size_t start_pos = 0;
+  std::string include_dir = "#include ";
+
+  while ((start_pos = shader.find(include_dir, start_pos)) !=
+         std::string::npos) {
+    auto pos = start_pos + include_dir.length() + 1;
+    auto length = shader.find('\"', pos);
+    std::string file = shader.substr(pos, length - pos);
+    std::string content = "";
+
+    std::ifstream f;
+    f.open(("./content/" + file).c_str());
+
+    if (f.is_open()) {
+      std::array<char, 1024> buffer;
+
+      while (!f.eof()) {
+        f.getline(buffer.data(), 1024);
+        content += buffer.data();
+        content += "\n";
+      }
+    } else {
+      cu::AssertError(false, "Shader include not found.", __FILE__, __LINE__);
+    }
+
+    shader.replace(start_pos, (length + 1) - start_pos, content);
+    start_pos += content.length();
+  }
+}
+
+ct::string GlStockShaders::ReadShader(const ct::string &path) {
+  auto shader = cu::ReadFile(path);
+  ShaderInclude(shader);
+  return shader;
+}
+
 void GlStockShaders::ForwardShaders() {
   shader_source_[MaterialSystem::kText] = {
-      cu::ReadFile("./content/shaders/opengl/text_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/text_fs.glsl"), ""};
+      ReadShader("./content/shaders/opengl/text_vs.glsl"),
+      ReadShader("./content/shaders/opengl/text_fs.glsl"), ""};
 
   shader_source_[MaterialSystem::kPbrUntextured] = {
-      cu::ReadFile("./content/shaders/opengl/forward_pbr_untextured_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/forward_pbr_untextured_fs.glsl"),
+      ReadShader("./content/shaders/opengl/forward_pbr_untextured_vs.glsl"),
+      ReadShader("./content/shaders/opengl/forward_pbr_untextured_fs.glsl"),
       ""};
 
   shader_source_[MaterialSystem::kPbrTextured] = {
-      cu::ReadFile("./content/shaders/opengl/forward_pbr_textured_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/forward_pbr_textured_fs.glsl"),
+      ReadShader("./content/shaders/opengl/forward_pbr_textured_vs.glsl"),
+      ReadShader("./content/shaders/opengl/forward_pbr_textured_fs.glsl"),
       ""};
 }
 
 void GlStockShaders::DeferredShaders() {
   shader_source_[MaterialSystem::kText] = {
-      cu::ReadFile("./content/shaders/opengl/text_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/text_fs.glsl"), ""};
+      ReadShader("./content/shaders/opengl/text_vs.glsl"),
+      ReadShader("./content/shaders/opengl/text_fs.glsl"), ""};
 
   shader_source_[MaterialSystem::kPbrTextured] = {
-      cu::ReadFile("./content/shaders/opengl/deferred_pbr_textured_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/deferred_pbr_textured_fs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_pbr_textured_vs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_pbr_textured_fs.glsl"),
       ""};
 
   shader_source_[MaterialSystem::kPbrUntextured] = {
-      cu::ReadFile("./content/shaders/opengl/deferred_pbr_untextured_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/deferred_pbr_untextured_fs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_pbr_untextured_vs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_pbr_untextured_fs.glsl"),
       ""};
 
   shader_source_[MaterialSystem::kDeferredLightingAmbient] = {
-      cu::ReadFile("./content/shaders/opengl/deferred_ambient_tonemap_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/deferred_ambient_fs.glsl"), ""};
+      ReadShader("./content/shaders/opengl/deferred_ambient_tonemap_vs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_ambient_fs.glsl"), ""};
 
   shader_source_[MaterialSystem::kTonemapGamma] = {
-      cu::ReadFile("./content/shaders/opengl/deferred_ambient_tonemap_vs.glsl"),
-      cu::ReadFile("./content/shaders/opengl/deferred_tonemap_fs.glsl"), ""};
+      ReadShader("./content/shaders/opengl/deferred_ambient_tonemap_vs.glsl"),
+      ReadShader("./content/shaders/opengl/deferred_tonemap_fs.glsl"), ""};
 }
 
 void GlStockShaders::CompileShaders(MaterialSystem *mat_mgr) {
@@ -15,7 +15,13 @@ class GlStockShaders {
   size_t GetShaderId(MaterialSystem::ShaderType type);
   size_t DefToForId(size_t deferred_id);
 
+  // Replaces every #include "file" with the file's text, paths are relative
+  // to ./content/. Lets shaders share helpers such as the vertex decoders.
+  static void ShaderInclude(std::string &shader);
+
  private:
+  static ct::string ReadShader(const ct::string &path);
+
   ct::hash_map<MaterialSystem::ShaderType,
                std::tuple<ct::string, ct::string, ct::string>>
       shader_source_;
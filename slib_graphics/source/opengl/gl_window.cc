@@ -96,14 +96,26 @@ bool GlWindow::CheckCapabilities() {
   gpu_capabilities_.version = std::stof(gl_version);
   cu::Log("OpenGl version: " + std::to_string(gpu_capabilities_.version),
           __FILE__, __LINE__);
+  gpu_capabilities_.buffer_storage = GLEW_ARB_buffer_storage;
+  gpu_capabilities_.draw_parameters = GLEW_ARB_shader_draw_parameters;
+
+  GLint major, minor;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major < 4 || (major == 4 && minor < 3)) {
+    cu::Log("OpenGl 4.3 or later is required.", __FILE__, __LINE__);
+    return false;
+  }
   return true;
 }
 
 void GlWindow::CreateRenderWindow() {
   render_claimed_ = false;
   load_claimed_ = false;
-  std::array<int, 8> major_version = {4, 4, 4, 4, 4, 4, 4, 3};
-  std::array<int, 8> minor_version = {6, 5, 4, 3, 2, 1, 0, 3};
+  // Instances, particles and shadow casters are read from storage buffers,
+  // which need 4.3.
+  std::array<int, 4> major_version = {4, 4, 4, 4};
+  std::array<int, 4> minor_version = {6, 5, 4, 3};
   window_ = nullptr;
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
@@ -132,7 +144,7 @@ void GlWindow::CreateRenderWindow() {
       glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
       glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
 
-      for (int i = 0; i < 8; ++i) {
+      for (size_t i = 0; i < major_version.size(); ++i) {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major_version[i]);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor_version[i]);
 
@@ -141,7 +153,7 @@ void GlWindow::CreateRenderWindow() {
         if (window_) break;
       }
     } else {
-      for (int i = 0; i < 8; ++i) {
+      for (size_t i = 0; i < major_version.size(); ++i) {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major_version[i]);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor_version[i]);
 
@@ -152,7 +164,7 @@ void GlWindow::CreateRenderWindow() {
     }
   } else {
     current_dim_ = {g_settings.WindowedWidth(), g_settings.WindowedHeight()};
-    for (int i = 0; i < 8; ++i) {
+    for (size_t i = 0; i < major_version.size(); ++i) {
       glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major_version[i]);
       glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor_version[i]);
 
@@ -32,6 +32,73 @@ GlMaterialSystem::~GlMaterialSystem() {
   shadow_frame_buffers_3d_.clear();
 }
 
+// Cooked textures carry their whole mip chain, block compressed unless the
+// format is kRaw. Packs from before mip cooking hold a single raw level.
+// Returns the number of levels uploaded, a truncated chain stops early.
+uint32_t GlMaterialSystem::UploadTexture(unsigned target,
+                                         const Texture &texture) {
+  using lib_core::TextureCompression;
+
+  GLenum compressed_format = 0;
+  switch (texture.format) {
+    case TextureCompression::kBc1:
+      compressed_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      break;
+    case TextureCompression::kBc3:
+      compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      break;
+    case TextureCompression::kBc4:
+      compressed_format = GL_COMPRESSED_RED_RGTC1;
+      break;
+    case TextureCompression::kBc5:
+      compressed_format = GL_COMPRESSED_RG_RGTC2;
+      break;
+    case TextureCompression::kBc7:
+      compressed_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+      break;
+    default:
+      break;
+  }
+
+  int format = GL_RGB;
+  switch (texture.nr_channels) {
+    case 1:
+      format = GL_RED;
+      break;
+    case 2:
+      format = GL_RG;
+      break;
+    case 4:
+      format = GL_RGBA;
+      break;
+    default:
+      format = GL_RGB;
+      break;
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  auto data = texture.data.data();
+  auto data_end = data + texture.data.size();
+  uint32_t level = 0;
+  for (; level < texture.mip_count; ++level) {
+    auto width = TextureCompression::LevelDim(texture.dim.first, level);
+    auto height = TextureCompression::LevelDim(texture.dim.second, level);
+    auto size = TextureCompression::LevelSize(texture.format, width, height,
+                                              texture.nr_channels);
+    if (data + size > data_end) break;
+
+    if (compressed_format != 0)
+      glCompressedTexImage2D(target, int(level), compressed_format, int(width),
+                             int(height), 0, GLsizei(size), data);
+    else
+      glTexImage2D(target, int(level), format, int(width), int(height), 0,
+                   format, GL_UNSIGNED_BYTE, data);
+    data += size;
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  return level;
+}
+
 void GlMaterialSystem::LoadTexture2D(Texture &texture, bool force) {
   auto it = texture_map_.find(texture.name_hash);
   size_t id;
@@ -56,29 +123,16 @@ void GlMaterialSystem::LoadTexture2D(Texture &texture, bool force) {
   glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &aniso);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, aniso);
 
-  int format = GL_RGB;
-  switch (texture.nr_channels) {
-    case 1:
-      format = GL_R;
-      break;
-    case 2:
-      format = GL_RG;
-      break;
-    case 3:
-      format = GL_RGB;
-      break;
-    case 4:
-      format = GL_RGBA;
-      break;
-    default:
-      format = GL_RGB;
-      break;
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, format, int(texture.dim.first),
-               int(texture.dim.second), 0, format, GL_UNSIGNED_BYTE,
-               texture.data.data());
-  glGenerateMipmap(GL_TEXTURE_2D);
+  auto levels = UploadTexture(GL_TEXTURE_2D, texture);
+  cu::AssertWarning(levels == texture.mip_count, "Truncated texture mip chain",
+                    __FILE__, __LINE__);
+  // Sampling stops at the last level that made it, so a short chain stays
+  // mipmap complete.
+  if (texture.mip_count > 1)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    int(std::max(levels, 1u)) - 1);
+  else
+    glGenerateMipmap(GL_TEXTURE_2D);
   glBindTexture(GL_TEXTURE_2D, 0);
 
   textures_[id] = {tex_id, kTexture2D};
@@ -107,11 +161,8 @@ void GlMaterialSystem::LoadTexture3D(ct::dyn_array<Texture *> &faces,
   glActiveTexture(GL_TEXTURE0);
 
   glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
-  for (GLuint i = 0; i < faces.size(); i++) {
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
-                 int(faces[i]->dim.first), int(faces[i]->dim.second), 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, faces[i]->data.data());
-  }
+  for (GLuint i = 0; i < faces.size(); i++)
+    UploadTexture(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, *faces[i]);
 
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -165,28 +216,33 @@ bool GlMaterialSystem::ForceMaterial(
   if (lights) {
     int i = 0;
     for (auto &light : *lights) {
+      // Deferred lighting reads the light itself from a storage buffer and
+      // only takes the shadow maps from here.
       GLint light_loc;
       if (light.second.type == Light::kPoint) {
         light_loc = glGetUniformLocation(
             shader_program,
             ("light_position[" + std::to_string(i) + "]").c_str());
-        if (light_loc == -1) break;
-        glUniform3fv(light_loc, 1, light.second.data_pos.data());
-
-        glUniform3fv(glGetUniformLocation(
-                         shader_program,
-                         ("light_coeff[" + std::to_string(i) + "]").c_str()),
-                     1, &light.second.constant);
-
-        glUniform1f(glGetUniformLocation(
-                        shader_program,
-                        ("light_radius[" + std::to_string(i) + "]").c_str()),
-                    light.second.max_radius);
+        if (light_loc != -1) {
+          glUniform3fv(light_loc, 1, light.second.data_pos.data());
+
+          glUniform3fv(
+              glGetUniformLocation(
+                  shader_program,
+                  ("light_coeff[" + std::to_string(i) + "]").c_str()),
+              1, &light.second.constant);
+
+          glUniform1f(glGetUniformLocation(
+                          shader_program,
+                          ("light_radius[" + std::to_string(i) + "]").c_str()),
+                      light.second.max_radius);
+        }
       } else if (light.second.type == Light::kDir) {
         light_loc = glGetUniformLocation(
             shader_program,
             ("light_directions[" + std::to_string(i) + "]").c_str());
-        if (light_loc) glUniform3fv(light_loc, 1, light.second.data_dir.data());
+        if (light_loc != -1)
+          glUniform3fv(light_loc, 1, light.second.data_dir.data());
       }
 
       glUniform3fv(glGetUniformLocation(
@@ -198,7 +254,9 @@ bool GlMaterialSystem::ForceMaterial(
         if (light.second.type == Light::kPoint) {
           glActiveTexture(GL_TEXTURE0 + tex_id);
           auto depth_frame_buffer = GetFrameBuffer(
-              Get3DShadowFrameBuffer(light.second.shadow_resolutions[0]));
+              light.second.shadow_map
+                  ? light.second.shadow_map
+                  : Get3DShadowFrameBuffer(light.second.shadow_resolutions[0]));
 
           glBindTexture(GL_TEXTURE_CUBE_MAP,
                         textures_[depth_frame_buffer->textures[0].id].first);
@@ -212,10 +270,12 @@ bool GlMaterialSystem::ForceMaterial(
 
           used_textures_.insert(depth_frame_buffer->textures[0].id);
         } else if (light.second.type == Light::kDir) {
-          for (int ii = 0; ii < 3; ++ii) {
+          glUniform1i(glGetUniformLocation(shader_program, "cascade_count"),
+                      light.second.cascades);
+          for (int ii = 0; ii < light.second.cascades; ++ii) {
             glActiveTexture(GL_TEXTURE0 + tex_id);
-            auto depth_frame_buffer = GetFrameBuffer(
-                Get2DShadowFrameBuffer(light.second.shadow_resolutions[ii]));
+            auto depth_frame_buffer = GetFrameBuffer(Get2DShadowFrameBuffer(
+                light.second.shadow_resolutions[ii], ii));
 
             glBindTexture(GL_TEXTURE_2D,
                           textures_[depth_frame_buffer->textures[0].id].first);
@@ -231,6 +291,16 @@ bool GlMaterialSystem::ForceMaterial(
 
             used_textures_.insert(depth_frame_buffer->textures[0].id);
           }
+
+          // Unused entries would default to unit 0, where g_position is a
+          // sampler2D, so they share the last cascade's unit instead.
+          for (int ii = light.second.cascades;
+               ii < Light::kMaxCascades && light.second.cascades > 0; ++ii) {
+            auto tex_loc = glGetUniformLocation(
+                shader_program,
+                ("depth_map[" + std::to_string(ii) + "]").c_str());
+            glUniform1i(tex_loc, tex_id - 1);
+          }
         }
 
         auto shadow_loc = glGetUniformLocation(
@@ -267,6 +337,7 @@ bool GlMaterialSystem::ForceMaterial(
     std::pair<GLuint, TextureType> *ogl_tex_id;
     if (it == textures_.end()) {
       fully_set = false;
+      PrioritizeTexture(texture.id);
       ogl_tex_id = &textures_[lib_core::EngineCore::stock_texture];
     } else {
       used_textures_.insert(it->first);
@@ -410,6 +481,14 @@ void GlMaterialSystem::PurgeGpuResources() {
                     "OpenGL error: " + std::to_string(error), __FILE__,
                     __LINE__);
   }
+  for (auto &slots : cached_shadow_buffers_)
+    for (auto frame_buffer : slots.second) {
+      collection_exempt_.erase(frame_buffers_[frame_buffer].textures[0].id);
+      ForceFreeFramebuffer(frame_buffer);
+    }
+  cached_shadow_buffers_.clear();
+  ++shadow_cache_generation_;
+
   shadow_frame_buffers_2d_.clear();
   shadow_buffer_use_2d_.clear();
   shadow_frame_buffers_3d_.clear();
@@ -1070,13 +1149,15 @@ void GlMaterialSystem::ForceFreeFramebuffer(size_t frame_buffer_id,
                   __LINE__);
 }
 
-size_t GlMaterialSystem::Get2DShadowFrameBuffer(size_t res) {
-  auto it = shadow_frame_buffers_2d_.find(res);
+size_t GlMaterialSystem::Get2DShadowFrameBuffer(size_t res, size_t cascade) {
+  // Cascades of equal resolution are all sampled in the same pass.
+  auto key = res << 3 | cascade;
+  auto it = shadow_frame_buffers_2d_.find(key);
   if (it == shadow_frame_buffers_2d_.end()) {
-    shadow_frame_buffers_2d_[res] = Create2DShadowTarget(res, res);
-    it = shadow_frame_buffers_2d_.find(res);
+    shadow_frame_buffers_2d_[key] = Create2DShadowTarget(res, res);
+    it = shadow_frame_buffers_2d_.find(key);
   }
-  shadow_buffer_use_2d_.insert(res);
+  shadow_buffer_use_2d_.insert(key);
   return it->second;
 }
 
@@ -1090,6 +1171,15 @@ size_t GlMaterialSystem::Get3DShadowFrameBuffer(size_t res) {
   return it->second;
 }
 
+size_t GlMaterialSystem::GetCachedShadowFrameBuffer(size_t res, size_t slot) {
+  auto &slots = cached_shadow_buffers_[res];
+  while (slots.size() <= slot) {
+    slots.push_back(CreateCubeMapShadowTarget(res));
+    collection_exempt_.insert(frame_buffers_[slots.back()].textures[0].id);
+  }
+  return slots[slot];
+}
+
 GLuint GlMaterialSystem::TextureById(size_t id) {
   auto it = textures_.find(id);
   if (it != textures_.end()) return it->second.first;
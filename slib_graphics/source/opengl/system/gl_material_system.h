@@ -30,8 +30,12 @@ class GlMaterialSystem : public MaterialSystem {
 
   void ForceFreeFramebuffer(size_t frame_buffer_id, bool erase = true);
 
-  size_t Get2DShadowFrameBuffer(size_t res);
+  size_t Get2DShadowFrameBuffer(size_t res, size_t cascade = 0);
   size_t Get3DShadowFrameBuffer(size_t res);
+  // Cube shadow targets that keep their contents between frames, one per
+  // slot and resolution. Bumps ShadowCacheGeneration when they are purged.
+  size_t GetCachedShadowFrameBuffer(size_t res, size_t slot);
+  size_t ShadowCacheGeneration() const { return shadow_cache_generation_; }
 
   unsigned TextureById(size_t id);
 
@@ -39,6 +43,8 @@ class GlMaterialSystem : public MaterialSystem {
  private:
   ct::hash_map<size_t, size_t> shadow_frame_buffers_2d_;
   ct::hash_map<size_t, size_t> shadow_frame_buffers_3d_;
+  ct::hash_map<size_t, ct::dyn_array<size_t>> cached_shadow_buffers_;
+  size_t shadow_cache_generation_ = 0;
 
   size_t CreateCubeMapShadowTarget(size_t res);
   size_t Create2DShadowTarget(size_t res_x, size_t res_y);
@@ -50,6 +56,7 @@ class GlMaterialSystem : public MaterialSystem {
   void Create2DTextureTarget(CreateTextureFrameBufferCommand &fb_command);
   void CreateFrameBuffer(size_t fb_id, size_t dim_x, size_t dim_y);
   void CompileShaderRecource(AddShaderCommand &code);
+  uint32_t UploadTexture(unsigned target, const Texture &texture);
   void LoadTexture2D(Texture &texture, bool force = false);
   void LoadTexture3D(ct::dyn_array<Texture *> &faces, size_t name_hash,
                      bool force = false);
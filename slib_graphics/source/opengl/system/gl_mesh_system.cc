@@ -1,94 +1,168 @@
 #include "gl_mesh_system.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
 #include "culling_system.h"
 #include "entity_manager.h"
+#include "gl_instance_buffer.h"
 #include "graphics_commands.h"
 #include "mesh.h"
 #include "physics_commands.h"
 #include "physics_system.h"
+#include "window.h"
 
 namespace lib_graphics {
-GlMeshSystem::GlMeshSystem(lib_core::EngineCore *engine) : MeshSystem(engine) {}
-
-GlMeshSystem::~GlMeshSystem() {
-  auto size = GLsizei(meshes_.size());
-  ct::dyn_array<GLuint> vaos, vbos, ebos;
-
-  for (auto &mesh : meshes_) {
-    vaos.push_back(mesh.second.vao);
-    vbos.push_back(mesh.second.vbo);
-    ebos.push_back(mesh.second.ebo);
-  }
+namespace {
+// Arenas start out holding this many elements and double when full.
+constexpr size_t kArenaElements = 1 << 16;
+
+void SetPackedLayout() {
+  // Vertex Positions
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                        (GLvoid *)offsetof(PackedVertex, position));
+
+  // Vertex Normals
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                        (GLvoid *)offsetof(PackedVertex, normal));
+
+  // Vertex Tangents
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                        (GLvoid *)offsetof(PackedVertex, tangent));
+
+  // Vertex Texture Coords
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                        (GLvoid *)offsetof(PackedVertex, texcoord));
+}
+}  // namespace
 
-  if (!meshes_.empty()) {
-    glDeleteVertexArrays(size, vaos.data());
-    glDeleteBuffers(size, vbos.data());
-    glDeleteBuffers(size, ebos.data());
-  }
+GlMeshSystem::GlMeshSystem(lib_core::EngineCore *engine) : MeshSystem(engine) {
+  vertices_.stride = sizeof(PackedVertex);
+  indices_[0].stride = sizeof(uint16_t);
+  indices_[1].stride = sizeof(uint32_t);
 }
 
+GlMeshSystem::~GlMeshSystem() { DeleteArenas(); }
+
 void GlMeshSystem::DrawMesh(size_t mesh_id, int amount, bool force) {
   auto it = meshes_.find(mesh_id);
   if (it == meshes_.end()) return;
 
-  if (current_mesh_ != mesh_id || force) glBindVertexArray(it->second.vao);
-  glDrawElementsInstanced(GL_TRIANGLES, it->second.ind_count, GL_UNSIGNED_INT,
-                          nullptr, amount);
-  current_mesh_ = mesh_id;
+  auto &info = it->second;
+  auto wide = info.index_type == GL_UNSIGNED_INT;
+  if (current_vao_ != vaos_[wide] || force) glBindVertexArray(vaos_[wide]);
+
+  // Bounds that dequantize positions, read as constant attributes 4 and 5.
+  // Set on every draw since other vertex arrays may stream into location 4.
+  glVertexAttrib3f(4, info.center[0], info.center[1], info.center[2]);
+  glVertexAttrib3f(5, info.extent[0], info.extent[1], info.extent[2]);
+  glDrawElementsInstancedBaseVertex(
+      GL_TRIANGLES, info.ind_count, info.index_type,
+      (GLvoid *)(info.first_index * indices_[wide].stride), amount,
+      GLint(info.base_vertex));
+  current_vao_ = vaos_[wide];
   ++draw_calls_;
 }
 
-void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
-                              lib_gui::TextSystem *text_renderer) {
-  current_mesh_ = -1;
-
-  if (engine_ && engine_->GetDebugOutput())
-    engine_->GetDebugOutput()->UpdateBottomLeftLine(
-        6, "Total Mesh Draw Calls: " + std::to_string(draw_calls_));
-  draw_calls_ = 0;
-
-  auto add_mesh_func = [&](size_t id, MeshInit &source) {
-    MeshInfo info;
-    glGenVertexArrays(1, &info.vao);
-    glGenBuffers(1, &info.vbo);
-    glGenBuffers(1, &info.ebo);
+bool GlMeshSystem::MultiDraw() {
+  if (multi_draw_ == -1)
+    multi_draw_ = engine_->GetWindow()->Capabilities().draw_parameters;
+  return multi_draw_ == 1;
+}
 
-    glBindVertexArray(info.vao);
-    glBindBuffer(GL_ARRAY_BUFFER, info.vbo);
+void GlMeshSystem::RecordPacks(
+    const ct::dyn_array<CullingSystem::MeshPack> &packs, PackDraws &draws) {
+  for (auto &list : draw_lists_) list.Clear();
+  for (auto &bounds : draw_bounds_) bounds.clear();
+
+  for (auto &pack : packs) {
+    auto it = meshes_.find(pack.mesh_id);
+    if (it == meshes_.end()) continue;
+
+    auto &info = it->second;
+    auto wide = info.index_type == GL_UNSIGNED_INT;
+    if (draw_lists_[wide].Add(uint32_t(info.first_index),
+                              uint32_t(info.ind_count),
+                              int32_t(info.base_vertex),
+                              uint32_t(pack.mesh_count),
+                              uint32_t(pack.start_ind)))
+      draw_bounds_[wide].push_back(
+          {{info.center[0], info.center[1], info.center[2], 0.f},
+           {info.extent[0], info.extent[1], info.extent[2], 0.f}});
+  }
 
-    glBufferData(GL_ARRAY_BUFFER, source.vertices.size() * sizeof(Vertex),
-                 &source.vertices[0], GL_STATIC_DRAW);
+  if (!draw_stream_)
+    draw_stream_ = std::make_unique<GlInstanceBuffer>(
+        engine_->GetWindow()->Capabilities().buffer_storage, 1 << 20);
+
+  // Both index types go in as one push, growing the stream between two
+  // pushes would move the first one.
+  draw_data_.clear();
+  for (int wide = 0; wide < 2; ++wide) {
+    auto &commands = draw_lists_[wide].Commands();
+    auto bounds_size = draw_bounds_[wide].size() * sizeof(DrawBounds);
+    auto commands_size = commands.size() * sizeof(commands[0]);
+    draws.offsets[wide] = draw_data_.size();
+    draws.bounds_sizes[wide] = bounds_size;
+    draws.counts[wide] = commands.size();
+    if (commands.empty()) continue;
+
+    // Bounds of each type start on a 256 byte boundary, which satisfies any
+    // storage buffer offset alignment.
+    auto offset = draw_data_.size();
+    draw_data_.resize(offset + ((bounds_size + commands_size + 255) & ~255));
+    std::memcpy(draw_data_.data() + offset, draw_bounds_[wide].data(),
+                bounds_size);
+    std::memcpy(draw_data_.data() + offset + bounds_size, commands.data(),
+                commands_size);
+  }
+  auto offset = draw_stream_->Push(draw_data_.data(), draw_data_.size());
+  for (auto &o : draws.offsets) o += offset;
+  draws.epoch = draw_stream_->Epoch();
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, info.ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 source.indices.size() * sizeof(GLuint), &source.indices[0],
-                 GL_STATIC_DRAW);
+bool GlMeshSystem::SubmitPacks(const PackDraws &draws) {
+  if (!draw_stream_ || draws.epoch != draw_stream_->Epoch()) return false;
 
-    // Vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)nullptr);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_stream_->Buffer());
+  for (int wide = 0; wide < 2; ++wide) {
+    if (draws.counts[wide] == 0) continue;
 
-    // Vertex Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, normal));
+    auto offset = draws.offsets[wide];
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kDrawBoundsBinding,
+                      draw_stream_->Buffer(), offset, draws.bounds_sizes[wide]);
+    glBindVertexArray(vaos_[wide]);
+    current_vao_ = vaos_[wide];
 
-    // Vertex Tangents
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, tangent));
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT,
+        (GLvoid *)(offset + draws.bounds_sizes[wide]),
+        GLsizei(draws.counts[wide]), 0);
+    ++draw_calls_;
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  return true;
+}
 
-    // Vertex Texture Coords
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, texcoord));
+void GlMeshSystem::DrawPacks(
+    const ct::dyn_array<CullingSystem::MeshPack> &packs) {
+  PackDraws draws;
+  RecordPacks(packs, draws);
+  SubmitPacks(draws);
+}
 
-    glBindVertexArray(0);
+void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
+                              lib_gui::TextSystem *text_renderer) {
+  current_vao_ = 0;
+  if (draw_stream_) draw_stream_->EndFrame();
 
-    info.ind_count = GLsizei(source.indices.size());
-    meshes_[id] = info;
-  };
+  if (engine_ && engine_->GetDebugOutput())
+    engine_->GetDebugOutput()->UpdateBottomLeftLine(
+        6, "Total Mesh Draw Calls: " + std::to_string(draw_calls_));
+  draw_calls_ = 0;
 
   auto add_mesh_commands = g_sys_mgr.GetCommands<AddMeshCommand>();
   if (add_mesh_commands && !add_mesh_commands->empty()) {
@@ -98,16 +172,17 @@ void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
       aabb.center = c.mesh_init.center;
       aabb.extent = c.mesh_init.extent;
 
+      PackVertices(c.mesh_init);
       pinit.inds = c.mesh_init.indices;
-      pinit.verts.reserve(c.mesh_init.vertices.size());
-      for (auto &vert : c.mesh_init.vertices)
-        pinit.verts.push_back({vert.position});
+      pinit.verts.reserve(c.mesh_init.packed_vertices.size());
+      for (auto &vert : c.mesh_init.packed_vertices)
+        pinit.verts.push_back({UnpackPosition(c.mesh_init, vert)});
 
       issue_command(lib_physics::AddMeshSourceCommmand(c.MeshId(), pinit));
       issue_command(CullingSystem::AddMeshAabbCommand(c.MeshId(), aabb));
 
-      add_mesh_func(c.MeshId(), c.mesh_init);
-      mesh_source_[c.MeshId()] = std::move(c.mesh_init);
+      AddMesh(c.MeshId(), c.mesh_init);
+      StoreMeshSource(c.MeshId(), std::move(c.mesh_init));
     }
     add_mesh_commands->clear();
   }
@@ -115,21 +190,29 @@ void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
   auto add_model_mesh_commands = g_sys_mgr.GetCommands<AddModelMeshCommand>();
   if (add_model_mesh_commands && !add_model_mesh_commands->empty()) {
     for (auto &c : *add_model_mesh_commands) {
+      PackVertices(c.mesh_init);
+      if (c.IsLod()) {
+        AddMesh(c.MeshId(), c.mesh_init);
+        StoreMeshSource(c.MeshId(), std::move(c.mesh_init));
+        lod_meshes_[c.base_id].push_back(c.MeshId());
+        continue;
+      }
+
       BoundingVolume aabb;
       lib_physics::PhysicsInit pinit;
       aabb.center = c.mesh_init.center;
       aabb.extent = c.mesh_init.extent;
 
       pinit.inds = c.mesh_init.indices;
-      pinit.verts.reserve(c.mesh_init.vertices.size());
-      for (auto &vert : c.mesh_init.vertices)
-        pinit.verts.push_back({vert.position});
+      pinit.verts.reserve(c.mesh_init.packed_vertices.size());
+      for (auto &vert : c.mesh_init.packed_vertices)
+        pinit.verts.push_back({UnpackPosition(c.mesh_init, vert)});
 
       issue_command(lib_physics::AddMeshSourceCommmand(c.MeshId(), pinit));
       issue_command(CullingSystem::AddMeshAabbCommand(c.MeshId(), aabb));
 
-      add_mesh_func(c.MeshId(), c.mesh_init);
-      mesh_source_[c.MeshId()] = std::move(c.mesh_init);
+      AddMesh(c.MeshId(), c.mesh_init);
+      StoreMeshSource(c.MeshId(), std::move(c.mesh_init));
     }
     add_model_mesh_commands->clear();
   }
@@ -140,13 +223,13 @@ void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
       auto it = meshes_.find(c.mesh_id);
       if (it == meshes_.end()) continue;
 
-      glDeleteBuffers(1, &it->second.vbo);
-      glDeleteBuffers(1, &it->second.ebo);
-      glDeleteVertexArrays(1, &it->second.vao);
+      RemoveMesh(it->second);
 
       issue_command(CullingSystem::RemoveMeshAabbCommand(c.mesh_id));
       issue_command(lib_physics::RemoveMeshSourceCommmand(c.mesh_id));
       meshes_.erase(it);
+      EraseMeshSource(c.mesh_id);
+      RemoveLods(c.mesh_id);
     }
     remove_mesh_commands->clear();
   }
@@ -156,56 +239,132 @@ void GlMeshSystem::DrawUpdate(lib_graphics::Renderer *renderer,
 }
 
 void GlMeshSystem::RebuildResources() {
-  for (auto &mesh : meshes_) {
-    auto &mesh_init = mesh_source_[mesh.first];
-    MeshInfo info;
-    glGenVertexArrays(1, &info.vao);
-    glGenBuffers(1, &info.vbo);
-    glGenBuffers(1, &info.ebo);
-
-    glBindVertexArray(info.vao);
-    glBindBuffer(GL_ARRAY_BUFFER, info.vbo);
-
-    glBufferData(GL_ARRAY_BUFFER, mesh_init.vertices.size() * sizeof(Vertex),
-                 &mesh_init.vertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, info.ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 mesh_init.indices.size() * sizeof(uint32_t),
-                 &mesh_init.indices[0], GL_STATIC_DRAW);
-
-    // Vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)nullptr);
-
-    // Vertex Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, normal));
-
-    // Vertex Tangents
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, tangent));
-
-    // Vertex Texture Coords
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (GLvoid *)offsetof(Vertex, texcoord));
-
-    glBindVertexArray(0);
-
-    info.ind_count = GLsizei(mesh_init.indices.size());
-    meshes_[mesh.first] = info;
+  // Lod levels keep their sources too, the chains survive with their ids.
+  ct::dyn_array<size_t> mesh_ids;
+  for (auto &mesh : meshes_)
+    if (mesh_source_.count(mesh.first)) mesh_ids.push_back(mesh.first);
+
+  meshes_.clear();
+  for (auto id : mesh_ids) AddMesh(id, mesh_source_[id]);
+}
+
+void GlMeshSystem::RemoveLods(size_t mesh_id) {
+  auto lods = lod_meshes_.find(mesh_id);
+  if (lods == lod_meshes_.end()) return;
+
+  for (auto lod_id : lods->second) {
+    EraseMeshSource(lod_id);
+    auto it = meshes_.find(lod_id);
+    if (it == meshes_.end()) continue;
+    RemoveMesh(it->second);
+    meshes_.erase(it);
   }
+  lod_meshes_.erase(lods);
+  issue_command(CullingSystem::RemoveMeshLodCommand(mesh_id));
 }
 
 void GlMeshSystem::PurgeGpuResources() {
-  for (auto &mesh : meshes_) {
-    glDeleteBuffers(1, &mesh.second.vbo);
-    glDeleteBuffers(1, &mesh.second.ebo);
-    glDeleteVertexArrays(1, &mesh.second.vao);
+  DeleteArenas();
+  draw_stream_.reset();
+}
+
+void GlMeshSystem::AddMesh(size_t mesh_id, const MeshInit &source) {
+  auto it = meshes_.find(mesh_id);
+  if (it != meshes_.end()) RemoveMesh(it->second);
+
+  MeshInfo info;
+  info.center = source.center;
+  info.extent = source.extent;
+  info.vertex_count = source.packed_vertices.size();
+  info.ind_count = GLsizei(source.indices.size());
+
+  // Indices are relative to base_vertex, so most meshes fit 16 bits.
+  auto wide = info.vertex_count > 0xffff;
+  info.index_type = wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+
+  info.base_vertex = Allocate(vertices_, info.vertex_count);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vertices_.buffer);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, info.base_vertex * vertices_.stride,
+                  info.vertex_count * vertices_.stride,
+                  source.packed_vertices.data());
+
+  auto &arena = indices_[wide];
+  info.first_index = Allocate(arena, source.indices.size());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+  if (wide) {
+    glBufferSubData(GL_COPY_WRITE_BUFFER, info.first_index * arena.stride,
+                    source.indices.size() * arena.stride,
+                    source.indices.data());
+  } else {
+    ct::dyn_array<uint16_t> indices(source.indices.begin(),
+                                    source.indices.end());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, info.first_index * arena.stride,
+                    indices.size() * arena.stride, indices.data());
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  meshes_[mesh_id] = info;
+}
+
+void GlMeshSystem::RemoveMesh(MeshInfo &info) {
+  auto wide = info.index_type == GL_UNSIGNED_INT;
+  vertices_.ranges.Free(info.base_vertex, info.vertex_count);
+  indices_[wide].ranges.Free(info.first_index, size_t(info.ind_count));
+}
+
+size_t GlMeshSystem::Allocate(Arena &arena, size_t count) {
+  if (count == 0) return 0;
+
+  auto offset = arena.ranges.Allocate(count);
+  if (offset != lib_core::RangeAllocator::kInvalid) return offset;
+
+  // Move everything to a larger buffer, meshes keep their offsets.
+  auto old_capacity = arena.ranges.Capacity();
+  auto capacity = std::max({old_capacity * 2, old_capacity + count,
+                            kArenaElements});
+
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, capacity * arena.stride, nullptr,
+               GL_STATIC_DRAW);
+  if (arena.buffer) {
+    glBindBuffer(GL_COPY_READ_BUFFER, arena.buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        old_capacity * arena.stride);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &arena.buffer);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  arena.buffer = buffer;
+  arena.ranges.Grow(capacity);
+  SetupVertexArrays();
+  return arena.ranges.Allocate(count);
+}
+
+void GlMeshSystem::DeleteArenas() {
+  for (auto arena : {&vertices_, &indices_[0], &indices_[1]}) {
+    if (arena->buffer) glDeleteBuffers(1, &arena->buffer);
+    arena->buffer = 0;
+    arena->ranges = lib_core::RangeAllocator();
+  }
+
+  if (vaos_[0]) glDeleteVertexArrays(GLsizei(vaos_.size()), vaos_.data());
+  vaos_ = {0, 0};
+  current_vao_ = 0;
+}
+
+void GlMeshSystem::SetupVertexArrays() {
+  if (!vaos_[0]) glGenVertexArrays(GLsizei(vaos_.size()), vaos_.data());
+
+  for (size_t i = 0; i < vaos_.size(); ++i) {
+    glBindVertexArray(vaos_[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, vertices_.buffer);
+    SetPackedLayout();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_[i].buffer);
   }
+  glBindVertexArray(0);
+  current_vao_ = 0;
 }
 }  // namespace lib_graphics
@@ -1,33 +1,95 @@
 #pragma once
 #include "axis_aligned_box.h"
+#include "culling_system.h"
+#include "indirect_draw_list.h"
 #include "mesh_system.h"
+#include "range_allocator.h"
 #include "vertex.h"
 
 namespace lib_graphics {
 class GlMeshSystem : public MeshSystem {
  public:
+  // Storage binding of the per draw bounds read by multi draw shaders.
+  static constexpr unsigned kDrawBoundsBinding = 1;
+
   GlMeshSystem(lib_core::EngineCore* engine);
   ~GlMeshSystem() override;
 
   void DrawMesh(size_t mesh_id, int amount = 1, bool force = false) override;
 
+  // Indirect commands and bounds of a batch once pushed to the draw stream,
+  // per index type.
+  struct PackDraws {
+    size_t epoch = 0;
+    std::array<size_t, 2> offsets = {0, 0};
+    std::array<size_t, 2> bounds_sizes = {0, 0};
+    std::array<size_t, 2> counts = {0, 0};
+  };
+
+  // True when packs can be submitted indirectly. Shaders then read the
+  // instance offset from gl_BaseInstanceARB and the mesh bounds from
+  // kDrawBoundsBinding, indexed by gl_DrawIDARB.
+  bool MultiDraw();
+  // Instances start at each pack's start_ind. Only valid when MultiDraw().
+  void RecordPacks(const ct::dyn_array<CullingSystem::MeshPack>& packs,
+                   PackDraws& draws);
+  // One glMultiDrawElementsIndirect per index type. Recorded draws can be
+  // submitted again until the frame ends, false once they went stale.
+  bool SubmitPacks(const PackDraws& draws);
+  void DrawPacks(const ct::dyn_array<CullingSystem::MeshPack>& packs);
+
   void DrawUpdate(lib_graphics::Renderer* renderer,
                   lib_gui::TextSystem* text_renderer) override;
 
   void RebuildResources() override;
   void PurgeGpuResources() override;
 
+  // Where a mesh lives inside the shared arenas, offsets are in elements.
   struct MeshInfo {
     int ind_count;
-    unsigned vao;
-    unsigned vbo;
-    unsigned ebo;
+    unsigned index_type;
+    size_t first_index;
+    size_t base_vertex;
+    size_t vertex_count;
+    lib_core::Vector3 center, extent;
   };
 
  private:
-  size_t current_mesh_ = 0;
+  // A buffer shared by every mesh and carved up by a RangeAllocator.
+  struct Arena {
+    unsigned buffer = 0;
+    size_t stride;
+    lib_core::RangeAllocator ranges;
+  };
+
+  struct DrawBounds {
+    std::array<float, 4> center, extent;
+  };
+
+  void AddMesh(size_t mesh_id, const MeshInit& source);
+  void RemoveMesh(MeshInfo& info);
+  void RemoveLods(size_t mesh_id);
+  size_t Allocate(Arena& arena, size_t count);
+  void DeleteArenas();
+  void SetupVertexArrays();
+
+  unsigned current_vao_ = 0;
 
   size_t draw_calls_;
   ct::hash_map<size_t, MeshInfo> meshes_;
+  // Simplified levels of a base mesh, removed together with it.
+  ct::hash_map<size_t, ct::dyn_array<size_t>> lod_meshes_;
+
+  // Index arenas hold 16 and 32 bit indices, each with a vertex array that
+  // reads the one vertex arena.
+  Arena vertices_;
+  std::array<Arena, 2> indices_;
+  std::array<unsigned, 2> vaos_ = {0, 0};
+
+  int multi_draw_ = -1;
+  std::array<lib_core::IndirectDrawList, 2> draw_lists_;
+  std::array<ct::dyn_array<DrawBounds>, 2> draw_bounds_;
+  ct::dyn_array<uint8_t> draw_data_;
+  std::unique_ptr<class GlInstanceBuffer> draw_stream_;
 };
 }  // namespace lib_graphics
@@ -8,10 +8,14 @@
 #include "light.h"
 #include "light_system.h"
 #include "mesh.h"
+#include "profiler.h"
 #include "range_iterator.hpp"
 #include "system_manager.h"
 #include "transform.h"
+#include "window.h"
 
+#include <algorithm>
+#include <cmath>
 #include <execution>
 #include <future>
 
@@ -33,6 +37,7 @@ CullingSystem::CullingSystem(class lib_core::EngineCore *engine)
           [&](lib_core::Entity entity) {
             g_ent_mgr.RemoveComponent<MeshOctreeFlag>(entity);
             mesh_octree_->RemoveEntity(entity);
+            for (auto &view : view_lods_) view.second.erase(entity);
           });
   rem_light_callback_id_ =
       g_ent_mgr.RegisterRemoveComponentCallback<lib_graphics::Light>(
@@ -40,9 +45,25 @@ CullingSystem::CullingSystem(class lib_core::EngineCore *engine)
             g_ent_mgr.RemoveComponent<LightOctreeFlag>(entity);
             light_octree_->RemoveEntity(entity);
             draw_entities_.erase(entity);
+            for (size_t i = 0; i < Light::kMaxCascades; ++i) {
+              draw_entities_.erase(CascadeView(entity, i));
+              opeque_mesh_packs_out_.erase(CascadeView(entity, i));
+              translucent_mesh_packs_out_.erase(CascadeView(entity, i));
+              gbuffer_commands_.erase(CascadeView(entity, i));
+            }
             light_matrices_.erase(entity);
             light_packs_.erase(entity);
           });
+  rem_camera_callback_id_ =
+      g_ent_mgr.RegisterRemoveComponentCallback<lib_graphics::Camera>(
+          [&](lib_core::Entity entity) {
+            draw_entities_.erase(entity);
+            opeque_mesh_packs_out_.erase(entity);
+            translucent_mesh_packs_out_.erase(entity);
+            gbuffer_commands_.erase(entity);
+            light_packs_.erase(entity);
+            view_lods_.erase(entity);
+          });
 }
 
 CullingSystem::~CullingSystem() {
@@ -50,6 +71,8 @@ CullingSystem::~CullingSystem() {
       rem_mesh_callback_id);
   g_ent_mgr.UnregisterRemoveComponentCallback<lib_graphics::Light>(
       rem_light_callback_id_);
+  g_ent_mgr.UnregisterRemoveComponentCallback<lib_graphics::Camera>(
+      rem_camera_callback_id_);
 
   g_ent_mgr.UnregisterAddComponentCallback<lib_graphics::Mesh>(
       add_mesh_callback_id);
@@ -61,6 +84,7 @@ void CullingSystem::LogicUpdate(float dt) {}
 
 void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
                                lib_gui::TextSystem *text_renderer) {
+  PROFILE_ZONE("Culling");
   auto culling_timer = cu::TimerStart();
   auto cam = g_ent_mgr.GetOldCbt<Camera>();
   auto cam_ents = g_ent_mgr.GetEbt<Camera>();
@@ -71,11 +95,27 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
     add_mesh_aabb_command->clear();
   }
 
+  auto add_mesh_lod_command = g_sys_mgr.GetCommands<AddMeshLodCommand>();
+  if (add_mesh_lod_command && !add_mesh_lod_command->empty()) {
+    for (auto &c : *add_mesh_lod_command) {
+      auto &lods = mesh_lods_[c.mesh_id];
+      lods = {{c.mesh_id, 0.f}};
+      lods.insert(lods.end(), c.lods.begin(), c.lods.end());
+    }
+    add_mesh_lod_command->clear();
+  }
+
+  auto remove_mesh_lod_command = g_sys_mgr.GetCommands<RemoveMeshLodCommand>();
+  if (remove_mesh_lod_command && !remove_mesh_lod_command->empty()) {
+    for (auto &c : *remove_mesh_lod_command) mesh_lods_.erase(c.mesh_id);
+    remove_mesh_lod_command->clear();
+  }
+
   auto remove_mesh_aabb_command =
       g_sys_mgr.GetCommands<RemoveMeshAabbCommand>();
   if (remove_mesh_aabb_command && !remove_mesh_aabb_command->empty()) {
     for (auto &c : *remove_mesh_aabb_command) mesh_aabb_.erase(c.mesh_id);
-    add_mesh_aabb_command->clear();
+    remove_mesh_aabb_command->clear();
   }
 
   UpdateSearchTrees();
@@ -110,6 +150,7 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
             auto light_r = g_ent_mgr.GetOldCbeW<Light>(light_ent);
             auto shadow_matrices = LightSystem::GetShadowMatrices(*light_r);
             Camera::FrustumPlanes planes;
+            shadow_max = 0;
             for (int ii = 0; ii < shadow_matrices.size(); ++ii) {
               auto mat_ptr = shadow_matrices[ii].data;
               for (int i = 0; i < 3; ++i) {
@@ -119,9 +160,11 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
                                              -(i + 1));
               }
 
-              shadow_max =
-                  AabbMeshCheck(planes, light_ent, ii == 0 ? true : false);
+              shadow_max += AabbMeshCheck(planes, CascadeView(light_ent, ii));
             }
+            for (auto ii = shadow_matrices.size(); ii < Light::kMaxCascades;
+                 ++ii)
+              draw_entities_.erase(CascadeView(light_ent, ii));
           } else if (light->type == Light::kPoint) {
             auto bvol = BoundingVolume(light->data_pos, light->max_radius);
             draw_entities_[light_ent].clear();
@@ -147,17 +190,23 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
     }
   }
 
+  auto screen_height = float(engine_->GetWindow()->GetRenderDim().second);
   float dist_from_camera;
   opeque_meshes_.clear();
   translucent_meshes_.clear();
   for (auto &draw_ents : draw_entities_) {
     opeque_mesh_packs_out_[draw_ents.first].clear();
     translucent_mesh_packs_out_[draw_ents.first].clear();
-    auto camera = g_ent_mgr.GetOldCbeR<lib_graphics::Camera>(draw_ents.first);
-    auto light = g_ent_mgr.GetOldCbeR<Light>(draw_ents.first);
+    auto owner = ViewOwner(draw_ents.first);
+    auto camera = g_ent_mgr.GetOldCbeR<lib_graphics::Camera>(owner);
+    auto light = g_ent_mgr.GetOldCbeR<Light>(owner);
 
-    opeque_mesh_packs_.clear();
-    translucent_mesh_packs_.clear();
+    // Each view rewinds its scratch packs, so peak arena use is one view.
+    lib_core::ArenaScope view_scope;
+    ScratchPackMap opeque_mesh_packs;
+    ScratchDepthMap translucent_mesh_packs;
+    auto &gbuffer = gbuffer_commands_[draw_ents.first];
+    gbuffer.Clear();
 
     for (auto e : draw_ents.second) {
       auto mesh = g_ent_mgr.GetOldCbeR<Mesh>(e);
@@ -182,11 +231,34 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
                 (lib_core::Vector3(0.f) - light->data_pos).Length();
         }
 
+        auto mesh_id = mesh->mesh;
+        auto lods = mesh_lods_.find(mesh_id);
+        if (lods != mesh_lods_.end()) {
+          if (camera) {
+            float scale = 1.f;
+            if (transform)
+              for (int i = 0; i < 3; ++i)
+                scale = std::max(scale, std::abs(transform->scale_[i]));
+            mesh_id = SelectLod(draw_ents.first, e, mesh_id, dist_from_camera,
+                                scale, *camera, screen_height);
+          } else {
+            // Shadows take the finest level any camera picked.
+            auto level = lods->second.size();
+            for (auto &view : view_lods_) {
+              auto it = view.second.find(e);
+              if (it != view.second.end())
+                level = std::min(level, size_t(it->second));
+            }
+            if (level < lods->second.size())
+              mesh_id = lods->second[level].mesh_id;
+          }
+        }
+
         auto material = mesh->material;
         auto &mesh_pack = mesh->translucency < 1.f && camera
-                              ? translucent_mesh_packs_[dist_from_camera]
-                                                       [{mesh->mesh, material}]
-                              : opeque_mesh_packs_[{mesh->mesh, material}];
+                              ? translucent_mesh_packs[dist_from_camera]
+                                                      [{mesh_id, material}]
+                              : opeque_mesh_packs[{mesh_id, material}];
 
         if (mesh->translucency < 1.f && camera)
           mesh_pack.transp_vec.push_back(mesh->translucency);
@@ -213,12 +285,21 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
     }
 
     auto opeque_ops = [&]() {
-      sorted_opeque_packs_.clear();
-      for (auto it = opeque_mesh_packs_.begin(); it != opeque_mesh_packs_.end();
+      ct::tree_map<float, ct::dyn_array<ScratchPackMap::iterator>> sorted_packs;
+      for (auto it = opeque_mesh_packs.begin(); it != opeque_mesh_packs.end();
            it++)
-        sorted_opeque_packs_[it->second.closest_dist].emplace_back(it);
-
-      for (auto &p : sorted_opeque_packs_) {
+        sorted_packs[it->second.closest_dist].emplace_back(it);
+
+      // Packs keep their front to back order, equally distant ones group
+      // by material.
+      using List = lib_core::RenderCommandList;
+      if (camera)
+        gbuffer.SetState(
+            List::Key(kGBufferPass, 0, 0),
+            List::kDepthTest | List::kDepthWrite | List::kCullBack |
+                List::kMergeDraws);
+      uint32_t order = 0;
+      for (auto &p : sorted_packs) {
         for (auto &it : p.second) {
           MeshPack pack;
           pack.material_id = it->first.second;
@@ -226,6 +307,12 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
           pack.mesh_count = int(it->second.world_vec.size());
           pack.start_ind = int(opeque_meshes_.world_vec.size());
           opeque_mesh_packs_out_[draw_ents.first].push_back(pack);
+          if (camera) {
+            auto key =
+                List::Key(kGBufferPass, order, uint32_t(pack.material_id));
+            gbuffer.BindMaterial(key, pack.material_id);
+            gbuffer.Draw(key, pack.mesh_id, pack.start_ind, pack.mesh_count);
+          }
           opeque_meshes_.world_vec.insert(std::end(opeque_meshes_.world_vec),
                                           std::begin(it->second.world_vec),
                                           std::end(it->second.world_vec));
@@ -251,11 +338,13 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
                                            std::begin(it->second.tex_offset),
                                            std::end(it->second.tex_offset));
         }
+        ++order;
       }
+      gbuffer.Sort();
     };
 
     auto translucent_ops = [&]() {
-      for (auto &p : translucent_mesh_packs_) {
+      for (auto &p : translucent_mesh_packs) {
         for (auto &tp : p.second) {
           MeshPack pack;
           pack.material_id = tp.first.second;
@@ -314,9 +403,11 @@ void CullingSystem::DrawUpdate(lib_graphics::Renderer *renderer,
       3, "Mesh octree nodes: " + std::to_string(mesh_octree_->GetNrNodes()));
   dbg_out->UpdateBottomLeftLine(
       4, "Light octree nodes: " + std::to_string(light_octree_->GetNrNodes()));
+  auto culling_time = cu::TimerStop<std::milli>(culling_timer);
+  engine_->GetTelemetry()->Record(lib_core::FrameTelemetry::kCull,
+                                  culling_time);
   dbg_out->UpdateBottomRightLine(
-      1, std::to_string(cu::TimerStop<std::milli>(culling_timer)) +
-             " :Culling time");
+      1, std::to_string(culling_time) + " :Culling time");
 }
 
 const ct::dyn_array<CullingSystem::MeshPack> *CullingSystem::GetMeshPacks(
@@ -325,6 +416,21 @@ const ct::dyn_array<CullingSystem::MeshPack> *CullingSystem::GetMeshPacks(
   return &translucent_mesh_packs_out_[entity];
 }
 
+const lib_core::RenderCommandList *CullingSystem::GetCommands(
+    lib_core::Entity entity) {
+  return &gbuffer_commands_[entity];
+}
+
+// Entity ids are counted from one, the top byte is free to tell views apart.
+lib_core::Entity CullingSystem::CascadeView(lib_core::Entity light,
+                                            size_t cascade) {
+  return lib_core::Entity(light.id_ | (cascade + 1) << 56);
+}
+
+lib_core::Entity CullingSystem::ViewOwner(lib_core::Entity view) {
+  return lib_core::Entity(view.id_ & ((size_t(1) << 56) - 1));
+}
+
 const ct::dyn_array<lib_core::Entity> *CullingSystem::GetLightPacks(
     lib_core::Entity entity) {
   return &light_packs_[entity];
@@ -371,6 +477,32 @@ ct::dyn_array<lib_core::Matrix4x4> &CullingSystem::GetLightMatrices(
   return light_matrices_[ent];
 }
 
+size_t CullingSystem::SelectLod(lib_core::Entity view, lib_core::Entity entity,
+                                size_t mesh_id, float distance, float scale,
+                                const Camera &camera, float screen_height) {
+  auto &lods = mesh_lods_[mesh_id];
+  auto aabb = mesh_aabb_.find(mesh_id);
+  if (aabb != mesh_aabb_.end())
+    distance -= aabb->second.extent.Length() * scale;
+  distance = std::max(distance, camera.near_);
+
+  auto pixels_per_unit =
+      screen_height / (2.f * distance * std::tan(camera.fov_ * (PI / 360.f)));
+  auto projected = [&](size_t level) {
+    return lods[level].error * scale * pixels_per_unit;
+  };
+
+  auto &current = view_lods_[view][entity];
+  size_t level = std::min(size_t(current), lods.size() - 1);
+  while (level > 0 && projected(level) > kLodPixelError) --level;
+  while (level + 1 < lods.size() &&
+         projected(level + 1) <= kLodPixelError * (1.f - kLodHysteresis))
+    ++level;
+
+  current = uint8_t(level);
+  return lods[level].mesh_id;
+}
+
 size_t CullingSystem::AabbMeshCheck(const Camera::FrustumPlanes planes,
                                     lib_core::Entity target, bool clear_ents) {
   auto &ents = draw_entities_[target];
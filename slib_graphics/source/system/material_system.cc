@@ -1,11 +1,11 @@
 #include "material_system.h"
-#include <fstream>
+#include <algorithm>
 #include <utility>
 #include "core_utilities.h"
 #include "engine_core.h"
 #include "entity_manager.h"
 #include "light.h"
-#include "window.h"
+#include "memory_tracker.h"
 
 namespace lib_graphics {
 size_t MaterialSystem::AddTexture2D(const ct::string &texture, bool blocking) {
@@ -19,15 +19,8 @@ size_t MaterialSystem::AddTexture2D(const ct::string &texture, bool blocking) {
   name_hashes_[name_hash] = texture;
 
   if (!s_it->second->loaded) {
-    TextureLoadJob load_job;
-    load_job.tex_id.push_back(tex_id);
-    load_job.pack_hash.push_back(s_it->second->pack_hash);
-    load_job.start_point.push_back(s_it->second->start_point);
-    load_job.data.push_back(&s_it->second->data);
     s_it->second->loaded = true;
-
-    tex_load_jobs_.push(load_job);
-    tex_load_cond_.notify_one();
+    QueueTextureLoad({tex_id}, {{tex_id, s_it->second.get()}});
   }
 
   return tex_id;
@@ -35,19 +28,18 @@ size_t MaterialSystem::AddTexture2D(const ct::string &texture, bool blocking) {
 
 size_t MaterialSystem::AddTexture3D(ct::dyn_array<ct::string> &texture) {
   ct::string name = "";
-  TextureLoadJob load_job;
+  ct::dyn_array<size_t> tex_ids;
+  ct::dyn_array<std::pair<size_t, Texture *>> sources;
   for (auto &f : texture) {
     auto tex = GetTextureId(std::hash<ct::string>{}(f));
     auto s_it = texture_source_.find(tex);
 
     if (!s_it->second->loaded) {
-      load_job.pack_hash.push_back(s_it->second->pack_hash);
-      load_job.data.push_back(&s_it->second->data);
-      load_job.start_point.push_back(s_it->second->start_point);
+      sources.push_back({tex, s_it->second.get()});
       s_it->second->loaded = true;
     }
 
-    load_job.tex_id.emplace_back(tex);
+    tex_ids.emplace_back(tex);
     name += f;
   }
 
@@ -55,10 +47,7 @@ size_t MaterialSystem::AddTexture3D(ct::dyn_array<ct::string> &texture) {
   name_hashes_[name_hash] = name;
   auto tex_id = GetTextureId(name_hash);
 
-  if (!load_job.data.empty()) {
-    tex_load_jobs_.push(load_job);
-    tex_load_cond_.notify_one();
-  }
+  if (!sources.empty()) QueueTextureLoad(tex_ids, sources);
 
   return tex_id;
 }
@@ -69,40 +58,22 @@ ct::dyn_array<std::pair<size_t, ct::string>> MaterialSystem::LoadTexturePack(
   auto tex_it = loaded_tex_packs_.find(name_hash);
   if (tex_it != loaded_tex_packs_.end()) return tex_it->second;
 
-  Texture tex;
-  size_t size;
-  size_t nr_textures;
   ct::dyn_array<std::pair<size_t, ct::string>> tex_names;
+  auto pack = std::make_unique<lib_core::AssetPack>();
+  if (!pack->Open(pack_path) ||
+      pack->GetType() != lib_core::AssetPack::kTexture)
+    return tex_names;
 
-  std::ifstream texpack_file(pack_path, std::ios::binary);
-  if (texpack_file.fail()) return tex_names;
-
-  texpack_file.read((char *)&nr_textures, sizeof(size_t));
-  if (nr_textures == 0) return tex_names;
-
+  Texture tex;
   tex.pack_hash = name_hash;
-  for (int i = 0; i < nr_textures; ++i) {
-    texpack_file.read((char *)&size, sizeof(size));
-    ct::string tex_name;
-    tex_name.assign(size, ' ');
-    texpack_file.read((char *)tex_name.data(), sizeof(uint8_t) * size);
-    if (tex_name.find('\\') != ct::string::npos)
-      tex_name =
-          tex_name.substr(tex_name.find_last_of('\\') + 1, tex_name.size());
-    if (tex_name.find('/') != ct::string::npos)
-      tex_name =
-          tex_name.substr(tex_name.find_last_of('/') + 1, tex_name.size());
-
-    short channels;
-    texpack_file.read((char *)&channels, sizeof(channels));
-    tex.nr_channels = channels;
-
-    std::pair<int, int> dim_tmp;
-    texpack_file.read((char *)&dim_tmp, sizeof(dim_tmp));
-    tex.dim.first = dim_tmp.first;
-    tex.dim.second = dim_tmp.second;
-
-    texpack_file.read((char *)&tex.start_point, sizeof(tex.start_point));
+  for (size_t i = 0; i < pack->EntryCount(); ++i) {
+    auto &entry = pack->Entry(i);
+    ct::string tex_name(pack->Name(entry));
+    tex.nr_channels = short(entry.meta[0]);
+    tex.dim = {entry.meta[1], entry.meta[2]};
+    tex.format = lib_core::TextureCompression::Format(entry.meta[3] & 0xff);
+    tex.mip_count = std::max(entry.meta[3] >> 8, 1u);
+    tex.blob = pack->Blob(entry);
 
     size_t id;
     auto tex_hash = std::hash<ct::string>{}(tex_name);
@@ -116,12 +87,20 @@ ct::dyn_array<std::pair<size_t, ct::string>> MaterialSystem::LoadTexturePack(
       texture_map_[tex_hash] = id;
     }
     name_hashes_[tex_hash] = tex_name;
-    texture_source_[id] = std::make_unique<Texture>(tex);
+
+    CancelTextureJob(id);
+
+    auto &source = texture_source_[id];
+    if (source)
+      g_mem_tracker.Freed(lib_core::MemoryTracker::kTextureSource,
+                          source->data.capacity());
+    source = std::make_unique<Texture>(tex);
     tex_names.push_back({id, tex_name});
   }
 
   name_hashes_[name_hash] = pack_path;
   loaded_tex_packs_[name_hash] = tex_names;
+  texture_packs_[name_hash] = std::move(pack);
   return tex_names;
 }
 
@@ -151,53 +130,78 @@ MaterialSystem::FrameBuffer *MaterialSystem::GetFrameBuffer(size_t fb_id) {
 
 size_t MaterialSystem::GetCurrentMaterial() { return current_material_; }
 
-void MaterialSystem::TextureLoaderThread() {
-  int i;
-  TextureLoadJob job;
-  ct::hash_map<size_t, std::ifstream> files;
-  ct::hash_map<size_t, std::ifstream>::iterator file_it;
-
-#ifdef UnixBuild
-  std::mutex mtx;
-#endif
-  while (run_tex_load_thread_) {
-#ifdef UnixBuild
-    auto lock = std::unique_lock<std::mutex>(mtx, std::defer_lock);
-    tex_load_cond_.wait(lock);
-#elif WindowsBuild
-    tex_load_cond_.wait(std::unique_lock<std::mutex>(std::mutex()));
-#endif
-
-    engine_->GetWindow()->SetLoadContext();
-
-    while (tex_load_jobs_.try_pop(job)) {
-      for (i = 0; i < job.data.size(); ++i) {
-        file_it = files.find(job.pack_hash[i]);
-        if (file_it == files.end()) {
-          auto name_it = name_hashes_.find(job.pack_hash[i]);
-          files[job.pack_hash[i]] =
-              std::ifstream(name_it->second, std::ios::binary);
-          file_it = files.find(job.pack_hash[i]);
-        }
-
-        file_it->second.seekg(job.start_point[i]);
-
-        size_t data_size;
-        file_it->second.read((char *)&data_size, sizeof(data_size));
-
-        ct::dyn_array<uint8_t> compressed_tex(data_size);
-        file_it->second.read((char *)compressed_tex.data(), data_size);
-
-        cu::DecompressMemory(compressed_tex, *job.data[i]);
-
-        if (job.tex_id.size() == 1) add_textures_.push(job.tex_id[i]);
+void MaterialSystem::QueueTextureLoad(
+    ct::dyn_array<size_t> tex_ids,
+    ct::dyn_array<std::pair<size_t, Texture *>> sources) {
+  auto decode = [sources]() {
+    for (auto &source : sources) {
+      auto tex = source.second;
+      // A source decoded before keeps its buffer, only the growth is new.
+      auto capacity = tex->data.capacity();
+      tex->blob.Unpack(tex->data);
+      g_mem_tracker.Allocated(lib_core::MemoryTracker::kTextureSource,
+                              tex->data.capacity() - capacity);
+    }
+  };
+
+  auto job = std::make_shared<lib_core::LoaderPool::JobId>();
+  auto complete = [this, tex_ids, sources, job]() {
+    // The job id is the token, CancelTextureJob drops it when a source is
+    // replaced after the job started, so the stale decode is not uploaded.
+    auto current = true;
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex_);
+      for (auto &source : sources) {
+        auto it = texture_jobs_.find(source.first);
+        if (it != texture_jobs_.end() && it->second == *job)
+          texture_jobs_.erase(it);
+        else
+          current = false;
       }
+    }
+    if (!current) return;
+
+    if (tex_ids.size() == 1)
+      add_textures_.push(tex_ids.front());
+    else
+      add_texture_3d_.push(tex_ids);
+  };
+
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  *job = g_loader_pool.Submit(decode, lib_core::LoaderPool::kNormal, complete,
+                              this);
+  for (auto &source : sources) texture_jobs_[source.first] = *job;
+}
+
+void MaterialSystem::CancelTextureJob(size_t tex_id) {
+  std::unique_lock<std::mutex> lock(jobs_mutex_);
+  auto it = texture_jobs_.find(tex_id);
+  if (it == texture_jobs_.end()) return;
+  auto job = it->second;
+  lock.unlock();
 
-      if (job.tex_id.size() > 1) add_texture_3d_.push(job.tex_id);
+  auto removed = g_loader_pool.Cancel(job);
+
+  lock.lock();
+  for (auto job_it = texture_jobs_.begin(); job_it != texture_jobs_.end();) {
+    if (job_it->second != job) {
+      ++job_it;
+      continue;
     }
+    auto source_it = texture_source_.find(job_it->first);
+    if (removed && source_it != texture_source_.end())
+      source_it->second->loaded = false;
+    job_it = texture_jobs_.erase(job_it);
   }
 }
 
+void MaterialSystem::PrioritizeTexture(size_t tex_id) {
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  auto it = texture_jobs_.find(tex_id);
+  if (it != texture_jobs_.end())
+    g_loader_pool.Bump(it->second, lib_core::LoaderPool::kHigh);
+}
+
 size_t MaterialSystem::GetTextureId(size_t tex_hash) {
   size_t id;
   auto it = texture_map_.find(tex_hash);
@@ -217,20 +221,13 @@ size_t MaterialSystem::GetTextureId(const ct::string &tex_name) {
 MaterialSystem::MaterialSystem(lib_core::EngineCore *engine)
     : engine_(engine) {}
 
-void MaterialSystem::StartLoadThread() {
-  run_tex_load_thread_ = true;
-  texture_unpack_thread_ =
-      std::make_unique<std::thread>([&]() { this->TextureLoaderThread(); });
-}
-
-void MaterialSystem::TerminateLoadThread() {
-  run_tex_load_thread_ = false;
-  tex_load_cond_.notify_all();
-  texture_unpack_thread_->join();
+MaterialSystem::~MaterialSystem() {
+  g_loader_pool.CancelOwner(this);
+  for (auto &source : texture_source_)
+    g_mem_tracker.Freed(lib_core::MemoryTracker::kTextureSource,
+                        source.second->data.capacity());
 }
 
-MaterialSystem::~MaterialSystem() { TerminateLoadThread(); }
-
 Material MaterialSystem::CreateTexturedMaterial(const ct::string &alb,
                                                 const ct::string &norm,
                                                 const ct::string &rme) {
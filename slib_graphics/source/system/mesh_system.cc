@@ -1,5 +1,5 @@
 #include "mesh_system.h"
-#include <fstream>
+#include <algorithm>
 #include <utility>
 #include "../../source_shared/include/serialization_utilities.hpp"
 #include "axis_aligned_box.h"
@@ -7,18 +7,62 @@
 #include "culling_system.h"
 #include "entity_manager.h"
 #include "graphics_commands.h"
+#include "memory_tracker.h"
 #include "mesh.h"
 #include "physics_commands.h"
 #include "physics_system.h"
 #include "range_iterator.hpp"
 #include "system_manager.h"
+#include "vertex_packing.h"
 
 #include <execution>
 
 namespace lib_graphics {
-MeshSystem::MeshSystem(const lib_core::EngineCore* engine) : engine_(engine) {}
+namespace {
+// Reads one level of a mesh, everything after the shared bounds. The cooker
+// only writes packed vertices, float levels come from older packs.
+void ReadMeshLevel(ct::dyn_array<uint8_t>::iterator& it, uint32_t format,
+                   MeshInit& mesh_init) {
+  uint32_t vertex_format = kFloatVertex;
+  if (format >= 2) SerializationUtilities::ReadFromBuffer(it, vertex_format);
+  if (vertex_format == kPackedVertex)
+    SerializationUtilities::ReadFromBuffer(it, mesh_init.packed_vertices);
+  else
+    SerializationUtilities::ReadFromBuffer(it, mesh_init.vertices);
+
+  uint32_t index_size = sizeof(uint32_t);
+  if (format >= 1) SerializationUtilities::ReadFromBuffer(it, index_size);
+  if (index_size == sizeof(uint16_t)) {
+    ct::dyn_array<uint16_t> indices;
+    SerializationUtilities::ReadFromBuffer(it, indices);
+    mesh_init.indices.assign(indices.begin(), indices.end());
+  } else {
+    SerializationUtilities::ReadFromBuffer(it, mesh_init.indices);
+  }
+}
 
-MeshSystem::~MeshSystem() { TerminateLoadThread(); }
+size_t SourceBytes(const MeshInit& source) {
+  return source.vertices.capacity() * sizeof(Vertex) +
+         source.packed_vertices.capacity() * sizeof(PackedVertex) +
+         source.indices.capacity() * sizeof(uint32_t);
+}
+}  // namespace
+
+MeshSystem::MeshSystem(const lib_core::EngineCore* engine) : engine_(engine) {
+  mesh_callback_id_ =
+      g_ent_mgr.RegisterAddComponentCallback<Mesh>([&](lib_core::Entity ent) {
+        auto comp = g_ent_mgr.GetNewCbeR<Mesh>(ent);
+        if (comp) PrioritizeMesh(comp->mesh);
+      });
+}
+
+MeshSystem::~MeshSystem() {
+  g_ent_mgr.UnregisterAddComponentCallback<Mesh>(mesh_callback_id_);
+  g_loader_pool.CancelOwner(this);
+  for (auto& source : mesh_source_)
+    g_mem_tracker.Freed(lib_core::MemoryTracker::kMeshSource,
+                        SourceBytes(source.second));
+}
 
 void MeshSystem::LogicUpdate(float dt) {
   auto new_meshes = g_ent_mgr.GetNewCbt<Mesh>();
@@ -61,52 +105,38 @@ ct::dyn_array<size_t> MeshSystem::LoadModelPack(const ct::string& path) {
   auto pack_it = loaded_model_packs_.find(path_hash);
   if (pack_it != loaded_model_packs_.end()) return return_array;
 
-  model_pack_name_map_[path_hash] = path;
-  std::ifstream open(path, std::ios::binary);
+  auto pack = std::make_unique<lib_core::AssetPack>();
+  if (!pack->Open(path) || pack->GetType() != lib_core::AssetPack::kModel)
+    return return_array;
 
-  size_t model_count;
-  ct::dyn_array<size_t> read_order;
   ct::hash_map<size_t, Model> models;
 
-  open.read((char*)&model_count, sizeof(model_count));
-  size_t name_length;
-  ct::string model_name;
-  size_t model_hash;
-  for (int i = 0; i < model_count; ++i) {
+  for (size_t i = 0; i < pack->EntryCount(); ++i) {
+    auto& entry = pack->Entry(i);
+    auto model_hash = std::hash<ct::string>{}(ct::string(pack->Name(entry)));
+
     Model model;
-    open.read((char*)&name_length, sizeof(name_length));
-    model_name.clear();
-    model_name.assign(name_length, ' ');
-    open.read((char*)model_name.data(), sizeof(uint8_t) * name_length);
-
-    if (model_name.find('\\') != ct::string::npos)
-      model_name = model_name.substr(model_name.find_last_of('\\') + 1,
-                                     model_name.size());
-    if (model_name.find('/') != ct::string::npos)
-      model_name = model_name.substr(model_name.find_last_of('/') + 1,
-                                     model_name.size());
-
-    open.read((char*)&model.nr_meshes, sizeof(model.nr_meshes));
-    open.read((char*)&model.start, sizeof(model.start));
-
-    model_hash = std::hash<ct::string>{}(model_name);
-    model_pack_map_[model_hash] = path_hash;
-    models[model_hash] = std::move(model);
-    read_order.push_back(model_hash);
-  }
+    model.nr_meshes = entry.meta[0];
+    uint32_t format = entry.meta[1];
+    uint32_t lod_slots = format >= 3 ? std::max(entry.meta[2], 1u) : 1;
 
-  for (auto& ind : read_order) {
-    auto& model = models[ind];
-    for (int i = 0; i < model.nr_meshes; ++i) {
+    // Every mesh gets ids for all lod levels up front, laid out mesh by mesh.
+    ct::dyn_array<size_t> mesh_ids;
+    for (size_t ii = 0; ii < model.nr_meshes; ++ii) {
       model.meshes.push_back(g_sys_mgr.GenerateResourceIds(1));
       return_array.push_back(model.meshes.back());
+      mesh_ids.push_back(model.meshes.back());
+      for (size_t l = 1; l < lod_slots; ++l)
+        mesh_ids.push_back(g_sys_mgr.GenerateResourceIds(1));
     }
 
-    model_load_jobs_.push({path_hash, model.meshes, model.start});
+    QueueModelLoad(mesh_ids, pack->Blob(entry), format, lod_slots);
+    model_pack_map_[model_hash] = path_hash;
+    models[model_hash] = std::move(model);
   }
 
-  load_cond_.notify_all();
   loaded_model_packs_[path_hash] = std::move(models);
+  model_packs_[path_hash] = std::move(pack);
   return return_array;
 }
 
@@ -134,62 +164,110 @@ const MeshInit* MeshSystem::GetMeshSource(size_t mesh_id) const {
   return &it->second;
 }
 
-void MeshSystem::StartLoadThread() {
-  model_unpack_thread_ =
-      std::make_unique<std::thread>([&]() { this->ModelLoaderThread(); });
+void MeshSystem::PackVertices(MeshInit& source) {
+  if (source.vertices.empty()) return;
+
+  source.packed_vertices.resize(source.vertices.size());
+  for (size_t i = 0; i < source.vertices.size(); ++i) {
+    auto& in = source.vertices[i];
+    source.packed_vertices[i] = lib_core::VertexPacking::Pack(
+        in.position.data(), in.normal.data(), in.tangent.data(),
+        in.texcoord.data(), source.center.data(), source.extent.data());
+  }
+  source.vertices.clear();
+  source.vertices.shrink_to_fit();
 }
 
-void MeshSystem::TerminateLoadThread() {
-  load_models_ = false;
-  load_cond_.notify_all();
-  model_unpack_thread_->join();
+lib_core::Vector3 MeshSystem::UnpackPosition(const MeshInit& source,
+                                             const PackedVertex& vertex) {
+  auto p = lib_core::VertexPacking::UnpackPosition(
+      vertex, source.center.data(), source.extent.data());
+  return {p[0], p[1], p[2]};
 }
 
-void MeshSystem::ModelLoaderThread() {
-  ModelLoadJob job;
-  ct::hash_map<size_t, std::ifstream> files;
-  ct::hash_map<size_t, std::ifstream>::iterator file_it;
-  ct::dyn_array<uint8_t> compressed, decompressed;
-  size_t data_size;
+void MeshSystem::StoreMeshSource(size_t mesh_id, MeshInit&& source) {
+  EraseMeshSource(mesh_id);
+  g_mem_tracker.Allocated(lib_core::MemoryTracker::kMeshSource,
+                          SourceBytes(source));
+  mesh_source_[mesh_id] = std::move(source);
+}
 
-#ifdef UnixBuild
-  std::mutex mtx;
-#endif
-  while (load_models_) {
-    while (model_load_jobs_.try_pop(job)) {
-      file_it = files.find(job.pack_hash);
-      if (file_it == files.end()) {
-        auto name_it = model_pack_name_map_.find(job.pack_hash);
-        files[job.pack_hash] = std::ifstream(name_it->second, std::ios::binary);
-        file_it = files.find(job.pack_hash);
-      }
+void MeshSystem::EraseMeshSource(size_t mesh_id) {
+  auto it = mesh_source_.find(mesh_id);
+  if (it == mesh_source_.end()) return;
+
+  g_mem_tracker.Freed(lib_core::MemoryTracker::kMeshSource,
+                      SourceBytes(it->second));
+  mesh_source_.erase(it);
+}
 
-      file_it->second.seekg(job.start_point);
-      file_it->second.read((char*)&data_size, sizeof(data_size));
-      compressed.assign(data_size, 0);
-      file_it->second.read((char*)compressed.data(), data_size);
+void MeshSystem::PrioritizeMesh(size_t mesh_id) {
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  auto it = mesh_jobs_.find(mesh_id);
+  if (it != mesh_jobs_.end())
+    g_loader_pool.Bump(it->second, lib_core::LoaderPool::kHigh);
+}
 
-      cu::DecompressMemory(compressed, decompressed);
-      compressed.clear();
+void MeshSystem::QueueModelLoad(const ct::dyn_array<size_t>& mesh_ids,
+                                lib_core::PackBlob blob, uint32_t format,
+                                uint32_t lod_slots) {
+  auto meshes = std::make_shared<ct::dyn_array<MeshInit>>(mesh_ids.size());
+  auto errors = std::make_shared<ct::dyn_array<float>>(mesh_ids.size(), 0.f);
+  auto decode = [meshes, errors, blob, format, lod_slots]() {
+    ct::dyn_array<uint8_t> decompressed;
+    if (!blob.Unpack(decompressed)) return;
+
+    auto it = decompressed.begin();
+    for (size_t m = 0; m < meshes->size() / lod_slots; ++m) {
+      lib_core::Vector3 center, extent;
+      SerializationUtilities::ReadFromBuffer(it, center);
+      SerializationUtilities::ReadFromBuffer(it, extent);
+
+      uint32_t lod_count = 1;
+      if (format >= 3) SerializationUtilities::ReadFromBuffer(it, lod_count);
+      if (lod_count > lod_slots) return;
+
+      for (size_t l = 0; l < lod_count; ++l) {
+        auto slot = m * lod_slots + l;
+        auto& mesh_init = (*meshes)[slot];
+        mesh_init.center = center;
+        mesh_init.extent = extent;
+        if (format >= 3)
+          SerializationUtilities::ReadFromBuffer(it, (*errors)[slot]);
+        ReadMeshLevel(it, format, mesh_init);
+        PackVertices(mesh_init);
+      }
+    }
+  };
 
-      auto it = decompressed.begin();
-      for (auto mesh_id : job.mesh_ids) {
-        MeshInit mesh_init;
-        SerializationUtilities::ReadFromBuffer(it, mesh_init.center);
-        SerializationUtilities::ReadFromBuffer(it, mesh_init.extent);
-        SerializationUtilities::ReadFromBuffer(it, mesh_init.vertices);
-        SerializationUtilities::ReadFromBuffer(it, mesh_init.indices);
+  auto complete = [this, meshes, errors, mesh_ids, lod_slots]() {
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex_);
+      for (auto id : mesh_ids) mesh_jobs_.erase(id);
+    }
 
-        issue_command(AddModelMeshCommand(mesh_id, mesh_init));
+    for (size_t m = 0; m < mesh_ids.size(); m += lod_slots) {
+      ct::dyn_array<CullingSystem::MeshLod> lods;
+      for (size_t l = 0; l < lod_slots; ++l) {
+        auto& mesh_init = (*meshes)[m + l];
+        if (l > 0 && mesh_init.indices.empty()) continue;
+        if (l > 0) {
+          lods.push_back({mesh_ids[m + l], (*errors)[m + l]});
+          issue_command(AddModelMeshCommand(mesh_ids[m + l], mesh_ids[m],
+                                            std::move(mesh_init)));
+        } else {
+          issue_command(AddModelMeshCommand(mesh_ids[m], std::move(mesh_init)));
+        }
       }
-      decompressed.clear();
+      if (!lods.empty())
+        issue_command(
+            CullingSystem::AddMeshLodCommand(mesh_ids[m], std::move(lods)));
     }
-#ifdef UnixBuild
-    auto lock = std::unique_lock<std::mutex>(mtx, std::defer_lock);
-    load_cond_.wait(lock);
-#elif WindowsBuild
-    load_cond_.wait(std::unique_lock<std::mutex>(std::mutex()));
-#endif
-  }
+  };
+
+  std::lock_guard<std::mutex> lock(jobs_mutex_);
+  auto job = g_loader_pool.Submit(decode, lib_core::LoaderPool::kNormal,
+                                  complete, this);
+  for (auto id : mesh_ids) mesh_jobs_[id] = job;
 }
 }  // namespace lib_graphics
@@ -1,9 +1,15 @@
 #include "particle_system.h"
+#include <algorithm>
+#include <random>
+#include "camera.h"
+#include "entity_manager.h"
 #include "particle_emitter.h"
+#include "profiler.h"
+#include "transform.h"
 
 namespace lib_graphics {
 ParticleSystem::ParticleSystem(const lib_core::EngineCore *engine)
-    : engine_(engine) {}
+    : engine_(engine), simulator_(std::random_device()()) {}
 
 void ParticleSystem::LogicUpdate(float dt) {
   auto update_emitter = g_ent_mgr.GetNewUbt<ParticleEmitter>();
@@ -17,5 +23,74 @@ void ParticleSystem::LogicUpdate(float dt) {
       }
     }
   }
+
+  PROFILE_ZONE("ParticleSimulation");
+  frames_.clear();
+  batch_emitters_.clear();
+  auto entities = g_ent_mgr.GetEbt<ParticleEmitter>();
+  auto emitters = g_ent_mgr.GetNewCbt<ParticleEmitter>();
+  if (entities && emitters) {
+    for (size_t i = 0; i < entities->size(); ++i) {
+      auto &e = (*emitters)[i];
+      auto transform = g_ent_mgr.GetOldCbeR<Transform>((*entities)[i]);
+
+      auto &frame = frames_.emplace_back();
+      frame.id = (*entities)[i].id_;
+      frame.origin = transform ? transform->Position() : 0.f;
+      frame.time = e.emitter_time;
+
+      batch_emitters_.push_back(
+          {frame.id, lib_core::ParticleBatcher::Blend(e.blend),
+           e.particle_texture});
+
+      auto &desc = frame.desc;
+      desc.shape = lib_core::ParticleSimulator::Shape(e.emitt_type);
+      desc.loop = e.loop;
+      desc.max_particles = e.max_particles;
+      desc.particle_life = e.particle_life;
+      desc.emitting_speed = e.emitting_speed;
+      desc.end_velocity = e.end_velocity;
+      desc.center_velocity = e.center_velocity;
+      desc.type_data = e.type_data;
+      desc.random_scale = e.random_scale;
+      desc.start_velocity = e.start_velocity;
+      desc.gravity = e.gravity;
+      desc.start_color = e.start_color;
+      desc.end_color = e.end_color;
+      desc.start_size = e.start_size;
+      desc.end_size = e.end_size;
+      desc.rotate_speed = e.rotate_speed;
+    }
+  }
+  simulator_.Update(frames_, simulated_);
+
+  // Sorted against last frame's cameras, the same ones the renderer reads.
+  auto cam_entities = g_ent_mgr.GetEbt<Camera>();
+  auto cameras = g_ent_mgr.GetOldCbt<Camera>();
+  if (cam_entities && cameras) {
+    for (auto it = views_.begin(); it != views_.end();) {
+      auto found = std::find_if(
+          cam_entities->begin(), cam_entities->end(),
+          [&](const lib_core::Entity &e) { return e.id_ == it->first; });
+      it = found == cam_entities->end() ? views_.erase(it) : std::next(it);
+    }
+    for (size_t i = 0; i < cameras->size(); ++i)
+      batcher_.Build(simulated_, batch_emitters_, (*cameras)[i].view_,
+                     views_[(*cam_entities)[i].id_]);
+  } else {
+    views_.clear();
+  }
+
+  std::lock_guard<std::mutex> lock(ready_mutex_);
+  std::swap(ready_, views_);
+  ready_new_ = true;
+}
+
+bool ParticleSystem::TakeParticles(Views &out) {
+  std::lock_guard<std::mutex> lock(ready_mutex_);
+  if (!ready_new_) return false;
+  std::swap(out, ready_);
+  ready_new_ = false;
+  return true;
 }
 }  // namespace lib_graphics
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include "core_utilities.h"
+#include "skyline_packer.h"
+
+namespace lib_gui {
+// Single channel coverage atlas for one font face. Glyph bitmaps are packed
+// on the CPU and the texture is refreshed from the dirty rows, glyphs outside
+// the preloaded ASCII range are inserted the first time they are drawn.
+class GlyphAtlas {
+ public:
+  struct Glyph {
+    int x, y, width, height;
+    int bearing_x, bearing_y;
+    float advance;
+  };
+
+  static constexpr int kPadding = 1;
+
+  GlyphAtlas(int width = 512, int height = 256, int max_height = 4096);
+
+  const Glyph* Find(uint32_t codepoint) const;
+  // Copies a top-down bitmap with the given row pitch into the atlas. The
+  // returned pointer is valid until the next insert. A glyph that does not
+  // fit even at the maximum height is kept without pixels so it is not
+  // rasterized again.
+  const Glyph* Insert(uint32_t codepoint, int width, int height,
+                      const uint8_t* bitmap, int pitch, int bearing_x,
+                      int bearing_y, float advance);
+
+  int Width() const { return packer_.Width(); }
+  int Height() const { return packer_.Height(); }
+  const uint8_t* Pixels() const { return pixels_.data(); }
+
+  // Rows changed since the last ClearDirty, begin == end when up to date.
+  int DirtyBegin() const { return dirty_begin_; }
+  int DirtyEnd() const { return dirty_end_; }
+  void ClearDirty() { dirty_begin_ = dirty_end_ = 0; }
+
+ private:
+  bool Place(int width, int height, int& x, int& y);
+
+  lib_core::SkylinePacker packer_;
+  int max_height_;
+  ct::dyn_array<uint8_t> pixels_;
+
+  // ASCII glyphs are looked up by index, everything else through the map.
+  ct::dyn_array<Glyph> glyphs_;
+  std::array<int32_t, 128> ascii_;
+  ct::hash_map<uint32_t, size_t> extended_;
+
+  int dirty_begin_ = 0, dirty_end_ = 0;
+};
+}  // namespace lib_gui
@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include "core_utilities.h"
+#include "gui_rect.h"
+
+namespace lib_gui {
+// Turns the GuiRect components into one instance stream sorted by layer,
+// with a batch per layer that can be drawn in a single instanced call. The
+// stream is only rebuilt when a rect's position, size, color or layer
+// changes, so static menus cost no uploads.
+class GuiBatcher {
+ public:
+  // Rect center and half size in the GuiRect's screen units, rgba8 color.
+  struct RectInstance {
+    float x, y, half_x, half_y;
+    uint32_t rgba;
+  };
+
+  struct Batch {
+    uint8_t layer;
+    uint32_t first, count;
+  };
+
+  GuiBatcher();
+
+  // Returns true when the instances changed and need uploading. A null
+  // pointer means there are no rects.
+  bool Build(const ct::dyn_array<GuiRect>* rects);
+
+  const ct::dyn_array<RectInstance>& Instances() const { return instances_; }
+  const ct::dyn_array<Batch>& Batches() const { return batches_; }
+  const Batch* FindBatch(uint8_t layer) const;
+
+ private:
+  bool Changed(const ct::dyn_array<GuiRect>& rects) const;
+
+  ct::dyn_array<GuiRect> last_;
+  ct::dyn_array<RectInstance> instances_;
+  ct::dyn_array<Batch> batches_;
+  std::array<int16_t, 256> layer_batch_;
+};
+}  // namespace lib_gui
@@ -0,0 +1,15 @@
+#pragma once
+#include <algorithm>
+#include "core_utilities.h"
+
+namespace lib_gui {
+// Packs a 0 to 1 color into rgba8, red in the low byte as the GL vertex
+// streams read it.
+inline uint32_t PackRgba8(const lib_core::Vector4& rgba) {
+  auto channel = [](float c) {
+    return uint32_t(std::clamp(c, 0.f, 1.f) * 255.f + .5f);
+  };
+  return channel(rgba[0]) | channel(rgba[1]) << 8 | channel(rgba[2]) << 16 |
+         channel(rgba[3]) << 24;
+}
+}  // namespace lib_gui
@@ -0,0 +1,42 @@
+#pragma once
+#include "core_utilities.h"
+#include "gui_rect.h"
+
+namespace lib_gui {
+// Uniform grid over GuiRect bounds for cursor picking. Rects are binned by
+// component index into hashed cells, rects spanning many cells are kept in a
+// short list that every query checks. Moving a rect only re-bins that rect.
+class GuiHitGrid {
+ public:
+  static constexpr float kCellSize = 1.f / 32.f;
+  static constexpr int kMaxCells = 64;
+
+  void Rebuild(const ct::dyn_array<GuiRect>& rects);
+  // Returns true when the rect's bounds or layer changed.
+  bool Update(size_t index, const GuiRect& rect);
+
+  // Topmost rect containing the point or -1. The highest layer wins, inside
+  // a layer the later rect wins since it is drawn last.
+  int64_t Pick(lib_core::Vector2 point) const;
+
+  size_t Size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    float min_x, min_y, max_x, max_y;
+    uint8_t layer;
+    bool large;
+  };
+
+  static Entry Bounds(const GuiRect& rect);
+  static int Cell(float v);
+  static uint64_t Key(int x, int y);
+
+  void Insert(uint32_t index);
+  void Remove(uint32_t index);
+
+  ct::dyn_array<Entry> entries_;
+  ct::hash_map<uint64_t, ct::dyn_array<uint32_t>> cells_;
+  ct::dyn_array<uint32_t> large_;
+};
+}  // namespace lib_gui
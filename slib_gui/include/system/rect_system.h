@@ -1,5 +1,7 @@
 #pragma once
 #include "engine_core.h"
+#include "entity.h"
+#include "gui_hit_grid.h"
 #include "gui_rect.h"
 #include "system.h"
 
@@ -14,5 +16,13 @@ class RectSystem : public lib_core::System {
 
  protected:
   lib_core::EngineCore* engine_;
+
+ private:
+  // Hover only changes when the cursor moved or a rect was written, so
+  // everything else is skipped.
+  GuiHitGrid hit_grid_;
+  ct::dyn_array<lib_core::Entity> grid_entities_;
+  lib_core::Vector2 last_cursor_ = {-1.f, -1.f};
+  int64_t hovered_ = -1;
 };
 }  // namespace lib_gui
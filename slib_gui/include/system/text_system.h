@@ -2,6 +2,7 @@
 #include "engine_core.h"
 #include "gui_commands.h"
 #include "system.h"
+#include "text_layout.h"
 
 namespace lib_gui {
 class TextSystem : public lib_core::System {
@@ -13,21 +14,21 @@ class TextSystem : public lib_core::System {
                   TextSystem* text_renderer) override;
   void LogicUpdate(float dt) override;
   virtual void PurgeGpuResources() = 0;
-  virtual void RenderText(class GuiText text, lib_core::Vector2 screen_dim) = 0;
+  // Queues text into its font's batch, FlushText draws every batch.
+  virtual void RenderText(const GuiText& text,
+                          lib_core::Vector2 screen_dim) = 0;
+  virtual void FlushText(lib_core::Vector2 screen_dim) = 0;
 
  protected:
-  struct Character {
-    unsigned int texture_id;
-    std::pair<int, int> size;
-    std::pair<int, int> bearing;
-    unsigned int advance;
-  };
-
   struct FontPack {
     size_t hash;
     size_t ref_count;
     size_t font_size;
-    ct::dyn_array<Character> glyphs;
+
+    GlyphAtlas atlas;
+    unsigned int texture_id = 0;
+    int uploaded_height = 0;
+    ct::dyn_array<TextVertex> vertices;
   };
 
   ct::hash_map<size_t, size_t> font_id_mapping_;
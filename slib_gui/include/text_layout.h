@@ -0,0 +1,29 @@
+#pragma once
+#include "core_utilities.h"
+#include "glyph_atlas.h"
+#include "gui_text.h"
+
+namespace lib_gui {
+// Positions in pixels, texture coordinates in atlas texels so quads stay
+// valid when a later glyph grows the atlas before the flush.
+struct TextVertex {
+  float x, y, u, v;
+  uint32_t rgba;
+};
+
+// CPU side of text rendering, turns GuiText into textured quads against a
+// glyph atlas so every font and layer can be drawn in one call.
+class TextLayout {
+ public:
+  // Invalid UTF-8 sequences decode to U+FFFD.
+  static void Decode(const ct::string& text, ct::dyn_array<uint32_t>& out);
+
+  // Appends six vertices per visible glyph in pixels, y up. Codepoints
+  // missing from the atlas are skipped.
+  static void Layout(const GuiText& text,
+                     const ct::dyn_array<uint32_t>& codepoints,
+                     const GlyphAtlas& atlas, float font_size,
+                     lib_core::Vector2 screen_dim,
+                     ct::dyn_array<TextVertex>& out);
+};
+}  // namespace lib_gui
@@ -0,0 +1,59 @@
+#include "glyph_atlas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lib_gui {
+GlyphAtlas::GlyphAtlas(int width, int height, int max_height)
+    : packer_(width, height),
+      max_height_(std::max(height, max_height)),
+      pixels_(size_t(width) * height, 0) {
+  ascii_.fill(-1);
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::Find(uint32_t codepoint) const {
+  if (codepoint < ascii_.size())
+    return ascii_[codepoint] < 0 ? nullptr : &glyphs_[ascii_[codepoint]];
+
+  auto it = extended_.find(codepoint);
+  return it == extended_.end() ? nullptr : &glyphs_[it->second];
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::Insert(uint32_t codepoint, int width,
+                                            int height, const uint8_t* bitmap,
+                                            int pitch, int bearing_x,
+                                            int bearing_y, float advance) {
+  Glyph glyph = {0, 0, 0, 0, bearing_x, bearing_y, advance};
+  if (width > 0 && height > 0 && Place(width, height, glyph.x, glyph.y)) {
+    glyph.width = width;
+    glyph.height = height;
+    for (int row = 0; row < height; ++row)
+      std::memcpy(&pixels_[size_t(glyph.y + row) * Width() + glyph.x],
+                  bitmap + size_t(row) * pitch, width);
+
+    if (dirty_begin_ == dirty_end_)
+      dirty_begin_ = glyph.y, dirty_end_ = glyph.y + height;
+    dirty_begin_ = std::min(dirty_begin_, glyph.y);
+    dirty_end_ = std::max(dirty_end_, glyph.y + height);
+  }
+
+  auto index = glyphs_.size();
+  glyphs_.push_back(glyph);
+  if (codepoint < ascii_.size())
+    ascii_[codepoint] = int32_t(index);
+  else
+    extended_[codepoint] = index;
+  return &glyphs_.back();
+}
+
+bool GlyphAtlas::Place(int width, int height, int& x, int& y) {
+  while (!packer_.Pack(width + kPadding, height + kPadding, x, y)) {
+    if (Height() >= max_height_) return false;
+
+    auto old_height = Height();
+    packer_.Grow(std::min(old_height * 2, max_height_));
+    pixels_.resize(size_t(Width()) * Height(), 0);
+    dirty_begin_ = 0, dirty_end_ = Height();
+  }
+  return true;
+}
+}  // namespace lib_gui
@@ -0,0 +1,59 @@
+#include "gui_batcher.h"
+#include "gui_color.h"
+
+namespace lib_gui {
+GuiBatcher::GuiBatcher() { layer_batch_.fill(-1); }
+
+bool GuiBatcher::Build(const ct::dyn_array<GuiRect>* rects) {
+  static const ct::dyn_array<GuiRect> kNoRects;
+  auto& source = rects ? *rects : kNoRects;
+  if (!Changed(source)) return false;
+  last_ = source;
+
+  // Counting sort keeps component order inside a layer, which is the order
+  // rects used to be drawn in.
+  std::array<uint32_t, 256> offsets = {};
+  for (auto& rect : source) ++offsets[rect.layer];
+
+  batches_.clear();
+  layer_batch_.fill(-1);
+  uint32_t first = 0;
+  for (size_t layer = 0; layer < offsets.size(); ++layer) {
+    auto count = offsets[layer];
+    offsets[layer] = first;
+    if (count == 0) continue;
+
+    layer_batch_[layer] = int16_t(batches_.size());
+    batches_.push_back({uint8_t(layer), first, count});
+    first += count;
+  }
+
+  instances_.resize(source.size());
+  for (auto& rect : source)
+    instances_[offsets[rect.layer]++] = {
+        rect.position_[0], rect.position_[1], rect.half_size_[0],
+        rect.half_size_[1], PackRgba8(rect.rgba_)};
+  return true;
+}
+
+const GuiBatcher::Batch* GuiBatcher::FindBatch(uint8_t layer) const {
+  auto index = layer_batch_[layer];
+  return index < 0 ? nullptr : &batches_[index];
+}
+
+bool GuiBatcher::Changed(const ct::dyn_array<GuiRect>& rects) const {
+  if (rects.size() != last_.size()) return true;
+
+  for (size_t i = 0; i < rects.size(); ++i) {
+    auto &a = rects[i], &b = last_[i];
+    if (a.layer != b.layer) return true;
+    for (int c = 0; c < 2; ++c)
+      if (a.position_[c] != b.position_[c] ||
+          a.half_size_[c] != b.half_size_[c])
+        return true;
+    for (int c = 0; c < 4; ++c)
+      if (a.rgba_[c] != b.rgba_[c]) return true;
+  }
+  return false;
+}
+}  // namespace lib_gui
@@ -0,0 +1,108 @@
+#include "gui_hit_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lib_gui {
+void GuiHitGrid::Rebuild(const ct::dyn_array<GuiRect>& rects) {
+  entries_.clear();
+  cells_.clear();
+  large_.clear();
+
+  entries_.reserve(rects.size());
+  for (auto& rect : rects) {
+    entries_.push_back(Bounds(rect));
+    Insert(uint32_t(entries_.size() - 1));
+  }
+}
+
+bool GuiHitGrid::Update(size_t index, const GuiRect& rect) {
+  auto bounds = Bounds(rect);
+  auto& entry = entries_[index];
+  if (bounds.min_x == entry.min_x && bounds.min_y == entry.min_y &&
+      bounds.max_x == entry.max_x && bounds.max_y == entry.max_y &&
+      bounds.layer == entry.layer)
+    return false;
+
+  Remove(uint32_t(index));
+  entry = bounds;
+  Insert(uint32_t(index));
+  return true;
+}
+
+int64_t GuiHitGrid::Pick(lib_core::Vector2 point) const {
+  int64_t best = -1;
+  auto test = [&](uint32_t index) {
+    auto& entry = entries_[index];
+    if (point[0] >= entry.max_x || point[0] <= entry.min_x ||
+        point[1] >= entry.max_y || point[1] <= entry.min_y)
+      return;
+    if (best < 0 || entry.layer > entries_[best].layer ||
+        (entry.layer == entries_[best].layer && index > best))
+      best = index;
+  };
+
+  for (auto index : large_) test(index);
+  auto it = cells_.find(Key(Cell(point[0]), Cell(point[1])));
+  if (it != cells_.end())
+    for (auto index : it->second) test(index);
+  return best;
+}
+
+GuiHitGrid::Entry GuiHitGrid::Bounds(const GuiRect& rect) {
+  Entry entry;
+  entry.min_x = rect.position_[0] - rect.half_size_[0];
+  entry.max_x = rect.position_[0] + rect.half_size_[0];
+  entry.min_y = rect.position_[1] - rect.half_size_[1];
+  entry.max_y = rect.position_[1] + rect.half_size_[1];
+  entry.layer = rect.layer;
+
+  auto cells_x = int64_t(Cell(entry.max_x)) - Cell(entry.min_x) + 1;
+  auto cells_y = int64_t(Cell(entry.max_y)) - Cell(entry.min_y) + 1;
+  entry.large = cells_x * cells_y > kMaxCells;
+  return entry;
+}
+
+int GuiHitGrid::Cell(float v) {
+  return int(std::clamp(std::floor(v / kCellSize), -1e6f, 1e6f));
+}
+
+uint64_t GuiHitGrid::Key(int x, int y) {
+  return uint64_t(uint32_t(x)) << 32 | uint32_t(y);
+}
+
+void GuiHitGrid::Insert(uint32_t index) {
+  auto& entry = entries_[index];
+  if (entry.large) {
+    large_.push_back(index);
+    return;
+  }
+
+  for (auto y = Cell(entry.min_y); y <= Cell(entry.max_y); ++y)
+    for (auto x = Cell(entry.min_x); x <= Cell(entry.max_x); ++x)
+      cells_[Key(x, y)].push_back(index);
+}
+
+void GuiHitGrid::Remove(uint32_t index) {
+  auto erase = [index](ct::dyn_array<uint32_t>& list) {
+    auto it = std::find(list.begin(), list.end(), index);
+    if (it == list.end()) return;
+    *it = list.back();
+    list.pop_back();
+  };
+
+  auto& entry = entries_[index];
+  if (entry.large) {
+    erase(large_);
+    return;
+  }
+
+  for (auto y = Cell(entry.min_y); y <= Cell(entry.max_y); ++y) {
+    for (auto x = Cell(entry.min_x); x <= Cell(entry.max_x); ++x) {
+      auto it = cells_.find(Key(x, y));
+      if (it == cells_.end()) continue;
+      erase(it->second);
+      if (it->second.empty()) cells_.erase(it);
+    }
+  }
+}
+}  // namespace lib_gui
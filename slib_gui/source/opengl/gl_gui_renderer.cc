@@ -15,26 +15,24 @@ void GlGuiRenderer::Draw(lib_core::Vector2 screen_dim) {
   auto rect_sys = static_cast<GlRectSystem*>(engine_->GetRect());
   auto text_sys = engine_->GetText();
 
-  for (auto& s : sorted_comps_) {
-    s.second.rects.clear();
-    s.second.texts.clear();
-  }
+  for (auto& s : sorted_comps_) s.second.texts.clear();
 
   auto rect_comps = g_ent_mgr.GetOldCbt<lib_gui::GuiRect>();
   auto text_comps = g_ent_mgr.GetOldCbt<lib_gui::GuiText>();
   if (text_comps)
     for (size_t i = 0; i < text_comps->size(); ++i)
       sorted_comps_[(*text_comps)[i].layer].texts.push_back(i);
-  if (rect_comps)
-    for (size_t i = 0; i < rect_comps->size(); ++i)
-      sorted_comps_[(*rect_comps)[i].layer].rects.push_back(i);
+
+  rect_sys->PrepareRects(rect_comps);
+  for (auto& batch : rect_sys->Batcher().Batches())
+    sorted_comps_[batch.layer];
 
   for (auto& layer : sorted_comps_) {
-    for (auto& rect : layer.second.rects)
-      rect_sys->DrawRect((*rect_comps)[rect], screen_dim);
+    rect_sys->DrawLayer(layer.first, screen_dim);
 
     for (auto& text : layer.second.texts)
       text_sys->RenderText((*text_comps)[text], screen_dim);
+    text_sys->FlushText(screen_dim);
   }
 }
 }  // namespace lib_gui
\ No newline at end of file
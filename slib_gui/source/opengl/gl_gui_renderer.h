@@ -12,7 +12,6 @@ class GlGuiRenderer : public GuiRenderer {
  private:
   struct SortedCompStruct {
     ct::dyn_array<size_t> texts;
-    ct::dyn_array<size_t> rects;
   };
 
   ct::tree_map<uint8_t, SortedCompStruct> sorted_comps_;
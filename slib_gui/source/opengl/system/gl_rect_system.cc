@@ -13,6 +13,8 @@
 #include <GL/GL.h>
 #endif
 
+#include <algorithm>
+#include <cstddef>
 #include "core_utilities.h"
 #include "entity_manager.h"
 #include "gl_rect_system.h"
@@ -33,33 +35,34 @@ void GlRectSystem::DrawUpdate(lib_graphics::Renderer *renderer,
                   __FILE__, __LINE__);
 }
 
-void GlRectSystem::DrawRect(GuiRect &rect, lib_core::Vector2 screen_dim) {
-  lib_core::Matrix4x4 projection;
-  projection.Orthographic(0.0f, screen_dim[0], 0.0f, screen_dim[1]);
+void GlRectSystem::PrepareRects(const ct::dyn_array<GuiRect> *rects) {
+  if (!batcher_.Build(rects)) return;
+
+  auto &instances = batcher_.Instances();
+  auto bytes = instances.size() * sizeof(GuiBatcher::RectInstance);
+  if (bytes == 0) return;
+
+  glBindBuffer(GL_ARRAY_BUFFER, rect_vbo_);
+  if (bytes > vbo_size_) {
+    vbo_size_ = std::max(bytes, vbo_size_ * 2);
+    glBufferData(GL_ARRAY_BUFFER, vbo_size_, nullptr, GL_DYNAMIC_DRAW);
+  }
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GlRectSystem::DrawLayer(uint8_t layer, lib_core::Vector2 screen_dim) {
+  auto batch = batcher_.FindBatch(layer);
+  if (!batch) return;
 
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   glBindVertexArray(rect_vao_);
   glUseProgram(shader_);
-  glUniform4fv(color_loc_, 1, &rect.rgba_[0]);
-  glUniformMatrix4fv(proj_loc_, 1, GL_FALSE, projection.data);
-
-  auto a_ratio = screen_dim[1] / screen_dim[0];
-
-  auto x_pos = rect.position_[0] * screen_dim[0] * a_ratio;
-  auto x_half = rect.half_size_[0] * screen_dim[0] * a_ratio;
-  auto y_pos = rect.position_[1] * screen_dim[1];
-  auto y_half = rect.half_size_[1] * screen_dim[1];
-  GLfloat vertices[6][2] = {
-      {x_pos - x_half, y_pos + y_half}, {x_pos - x_half, y_pos - y_half},
-      {x_pos + x_half, y_pos - y_half}, {x_pos - x_half, y_pos + y_half},
-      {x_pos + x_half, y_pos - y_half}, {x_pos + x_half, y_pos + y_half}};
-
-  glBindBuffer(GL_ARRAY_BUFFER, rect_vbo_);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glDrawArrays(GL_TRIANGLES, 0, 6);
+  glUniform2f(screen_loc_, screen_dim[0], screen_dim[1]);
+  glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, batch->count,
+                                    batch->first);
 
   glBindVertexArray(0);
   glDisable(GL_BLEND);
@@ -69,6 +72,8 @@ void GlRectSystem::PurgeGpuResources() {
   glDeleteVertexArrays(1, &rect_vao_);
   glDeleteBuffers(1, &rect_vbo_);
   glDeleteProgram(shader_);
+  batcher_ = GuiBatcher();
+  vbo_size_ = 0;
   init_draw_ = false;
 }
 
@@ -82,10 +87,15 @@ void GlRectSystem::CreateRectResources() {
   glGenBuffers(1, &rect_vbo_);
   glBindVertexArray(rect_vao_);
   glBindBuffer(GL_ARRAY_BUFFER, rect_vbo_);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 2, nullptr,
-               GL_DYNAMIC_DRAW);
   glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(GuiBatcher::RectInstance), nullptr);
+  glVertexAttribDivisor(0, 1);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                        sizeof(GuiBatcher::RectInstance),
+                        (void *)offsetof(GuiBatcher::RectInstance, rgba));
+  glVertexAttribDivisor(1, 1);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
@@ -142,7 +152,6 @@ void GlRectSystem::CreateRectResources() {
   glDeleteShader(vertex_shader);
   glDeleteShader(fragment_shader);
 
-  color_loc_ = glGetUniformLocation(shader_, "rect_color");
-  proj_loc_ = glGetUniformLocation(shader_, "projection");
+  screen_loc_ = glGetUniformLocation(shader_, "screen_dim");
 }
 }  // namespace lib_gui
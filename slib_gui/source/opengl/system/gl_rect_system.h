@@ -1,5 +1,6 @@
 #pragma once
 #include "engine_core.h"
+#include "gui_batcher.h"
 #include "gui_rect.h"
 #include "rect_system.h"
 #include "vector_def.h"
@@ -13,7 +14,11 @@ class GlRectSystem : public RectSystem {
   void DrawUpdate(lib_graphics::Renderer *renderer,
                   lib_gui::TextSystem *text_renderer) override;
 
-  void DrawRect(GuiRect &rect, lib_core::Vector2 screen_dim);
+  // Uploads the rect instances when they changed since the last frame.
+  void PrepareRects(const ct::dyn_array<GuiRect> *rects);
+  void DrawLayer(uint8_t layer, lib_core::Vector2 screen_dim);
+  const GuiBatcher &Batcher() const { return batcher_; }
+
   void PurgeGpuResources() override;
 
  private:
@@ -21,6 +26,9 @@ class GlRectSystem : public RectSystem {
 
   bool init_draw_ = false;
   unsigned rect_vao_, rect_vbo_, shader_;
-  int color_loc_, proj_loc_;
+  int screen_loc_;
+
+  GuiBatcher batcher_;
+  size_t vbo_size_ = 0;
 };
 }  // namespace lib_gui
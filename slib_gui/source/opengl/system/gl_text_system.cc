@@ -14,86 +14,87 @@
 #endif
 
 #include <ft2build.h>
-#include <iostream>
+#include <algorithm>
+#include <cstddef>
 #include "gl_text_system.h"
 #include "system_manager.h"
 #include FT_FREETYPE_H
 
 namespace lib_gui {
 
-GlTextSystem::GlTextSystem(lib_core::EngineCore *engine) : TextSystem(engine) {}
+GlTextSystem::GlTextSystem(lib_core::EngineCore *engine) : TextSystem(engine) {
+  if (FT_Init_FreeType(&ft_)) {
+    cu::Log("Could not init FreeType library", __FILE__, __LINE__);
+    ft_ = nullptr;
+  }
+}
 
-void GlTextSystem::RenderText(GuiText text, lib_core::Vector2 screen_dim) {
-  cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Text.",
-                  __FILE__, __LINE__);
+GlTextSystem::~GlTextSystem() {
+  for (auto &face : faces_) FT_Done_Face(face.second);
+  if (ft_) FT_Done_FreeType(ft_);
+}
 
+void GlTextSystem::RenderText(const GuiText &text,
+                              lib_core::Vector2 screen_dim) {
   auto font_loc = font_id_mapping_.find(text.font);
   if (font_loc == font_id_mapping_.end()) return;
 
   auto char_set = fonts_.find(font_loc->second);
   if (char_set == fonts_.end()) return;
+  auto &font = char_set->second;
 
-  lib_core::Matrix4x4 projection;
-  projection.Orthographic(0.0f, screen_dim[0], 0.0f, screen_dim[1]);
+  TextLayout::Decode(text.text, codepoints_);
+  auto face = faces_.find(char_set->first);
+  if (face != faces_.end())
+    for (auto codepoint : codepoints_)
+      if (!font.atlas.Find(codepoint)) LoadGlyph(font, face->second, codepoint);
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  TextLayout::Layout(text, codepoints_, font.atlas, float(font.font_size),
+                     screen_dim, font.vertices);
+}
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindVertexArray(text_vao);
-  glUseProgram(shader_);
+void GlTextSystem::FlushText(lib_core::Vector2 screen_dim) {
+  cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error - Draw Text.",
+                  __FILE__, __LINE__);
 
-  glUniform3fv(color_loc_, 1, &text.rgba[0]);
-  glUniformMatrix4fv(proj_loc_, 1, GL_FALSE, projection.data);
+  bool bound = false;
+  for (auto &f : fonts_) {
+    auto &font = f.second;
+    if (font.vertices.empty()) continue;
 
-  Character ch;
-  GLfloat xpos, ypos, w, h;
-  auto tmp_x = text.position[0] * screen_dim[0];
-  auto tmp_y = text.position[1] * screen_dim[1];
-  float max_x = 0.f;
+    if (!bound) {
+      lib_core::Matrix4x4 projection;
+      projection.Orthographic(0.0f, screen_dim[0], 0.0f, screen_dim[1]);
 
-  for (auto c = text.text.begin(); c != text.text.end(); c++) {
-    ch = char_set->second.glyphs[*c];
-    max_x = tmp_x + ch.bearing.first * text.half_size[0];
-    tmp_x += (ch.advance >> 6) * text.half_size[0];
-  }
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  switch (text.h_alignment) {
-    case GuiText::kLeft:
-      tmp_x = text.position[0] * screen_dim[0];
-      break;
-    case GuiText::kRight:
-      tmp_x = text.position[0] * screen_dim[0] -
-              (max_x - text.position[0] * screen_dim[0]);
-      break;
-    case GuiText::kCenter:
-      tmp_x = text.position[0] * screen_dim[0] -
-              (max_x - text.position[0] * screen_dim[0]) * .5f;
-      tmp_x -= char_set->second.font_size * .25f;
-      tmp_y -= char_set->second.font_size * .25f;
-      break;
-  }
+      glActiveTexture(GL_TEXTURE0);
+      glBindVertexArray(text_vao);
+      glBindBuffer(GL_ARRAY_BUFFER, text_vbo);
+      glUseProgram(shader_);
+      glUniformMatrix4fv(proj_loc_, 1, GL_FALSE, projection.data);
+      bound = true;
+    }
 
-  for (auto c = text.text.begin(); c != text.text.end(); c++) {
-    ch = char_set->second.glyphs[*c];
-
-    xpos = tmp_x + ch.bearing.first * text.half_size[0];
-    ypos = tmp_y - (ch.size.second - ch.bearing.second) * text.half_size[1];
-
-    w = ch.size.first * text.half_size[0];
-    h = ch.size.second * text.half_size[1];
-    GLfloat vertices[6][4] = {
-        {xpos, ypos + h, 0.0, 0.0}, {xpos, ypos, 0.0, 1.0},
-        {xpos + w, ypos, 1.0, 1.0}, {xpos, ypos + h, 0.0, 0.0},
-        {xpos + w, ypos, 1.0, 1.0}, {xpos + w, ypos + h, 1.0, 0.0}};
-    glBindTexture(GL_TEXTURE_2D, ch.texture_id);
-    glBindBuffer(GL_ARRAY_BUFFER, text_vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    tmp_x += (ch.advance >> 6) * text.half_size[0];
+    // Bound for every font, UploadAtlas only binds when it has work to do.
+    UploadAtlas(font);
+    glBindTexture(GL_TEXTURE_2D, font.texture_id);
+    glUniform2f(atlas_size_loc_, 1.f / font.atlas.Width(),
+                1.f / font.atlas.Height());
+
+    // Orphan the buffer every flush so the driver never waits on the
+    // previous layer's draw.
+    auto bytes = font.vertices.size() * sizeof(TextVertex);
+    vbo_size_ = std::max(vbo_size_, bytes);
+    glBufferData(GL_ARRAY_BUFFER, vbo_size_, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, font.vertices.data());
+    glDrawArrays(GL_TRIANGLES, 0, GLsizei(font.vertices.size()));
+    font.vertices.clear();
   }
+  if (!bound) return;
 
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
   glBindTexture(GL_TEXTURE_2D, 0);
   glDisable(GL_BLEND);
@@ -102,15 +103,17 @@ void GlTextSystem::RenderText(GuiText text, lib_core::Vector2 screen_dim) {
 }
 
 void GlTextSystem::PurgeGpuResources() {
-  for (auto &f : fonts_)
-    for (auto &c : f.second.glyphs) glDeleteTextures(1, &c.texture_id);
+  for (auto &f : fonts_) glDeleteTextures(1, &f.second.texture_id);
   fonts_.clear();
   shared_resource_lookup_.clear();
+  for (auto &face : faces_) FT_Done_Face(face.second);
+  faces_.clear();
 
   glDeleteVertexArrays(1, &text_vao);
   glDeleteBuffers(1, &text_vbo);
   glDeleteProgram(shader_);
-  color_loc_ = -1;
+  vbo_size_ = 0;
+  proj_loc_ = atlas_size_loc_ = -1;
   init_draw_ = false;
 }
 
@@ -140,7 +143,12 @@ void GlTextSystem::HandleUnloadCommand(UnloadFontCommand &command) {
     --it->second.ref_count;
     if (it->second.ref_count > 0) return;
 
-    for (auto &c : it->second.glyphs) glDeleteTextures(1, &c.texture_id);
+    glDeleteTextures(1, &it->second.texture_id);
+    auto face = faces_.find(it->first);
+    if (face != faces_.end()) {
+      FT_Done_Face(face->second);
+      faces_.erase(face);
+    }
     shared_resource_lookup_.erase(it->second.hash);
     loaded_fonts_.erase(it->first);
     fonts_.erase(it);
@@ -152,56 +160,29 @@ void GlTextSystem::HandleLoadCommand(LoadFontCommand &command) {
   cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error.", __FILE__,
                   __LINE__);
 
-  FT_Library ft;
-  if (FT_Init_FreeType(&ft))
-    std::cout << "ERROR::FREETYPE: Could not init FreeType Library"
-              << std::endl;
+  auto &font = fonts_[command.FontId()];
+  font.font_size = command.size;
+  font.atlas = GlyphAtlas();
+  font.uploaded_height = 0;
+  font.vertices.clear();
 
   FT_Face face;
-  if (FT_New_Face(ft, command.path.c_str(), 0, &face))
-    std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-
-  FT_Set_Pixel_Sizes(face, 0, command.size);
-  if (FT_Load_Char(face, 'X', FT_LOAD_RENDER))
-    std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-
-  glPixelStorei(GL_UNPACK_ALIGNMENT,
-                1);  // Disable byte-alignment restriction
-
-  ct::dyn_array<Character> characters(128);
-  for (GLubyte c = 0; c < 128; c++) {
-    // Load character glyph
-    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-      std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-      continue;
-    }
-    // Generate texture
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width,
-                 face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE,
-                 face->glyph->bitmap.buffer);
-    // Set texture options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // Now store character for later use
-    Character character = {
-        texture,
-        {face->glyph->bitmap.width, face->glyph->bitmap.rows},
-        {face->glyph->bitmap_left, face->glyph->bitmap_top},
-        unsigned(face->glyph->advance.x)};
-    characters[c] = std::move(character);
+  if (!ft_ || FT_New_Face(ft_, command.path.c_str(), 0, &face)) {
+    cu::Log("Failed to load font: " + command.path, __FILE__, __LINE__);
+  } else {
+    FT_Set_Pixel_Sizes(face, 0, FT_UInt(command.size));
+    faces_[command.FontId()] = face;
+    for (uint32_t c = 0; c < 128; ++c) LoadGlyph(font, face, c);
   }
 
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  FT_Done_Face(face);
-  FT_Done_FreeType(ft);
-
-  fonts_[command.FontId()].font_size = command.size;
-  fonts_[command.FontId()].glyphs.swap(characters);
+  glGenTextures(1, &font.texture_id);
+  glBindTexture(GL_TEXTURE_2D, font.texture_id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  UploadAtlas(font);
+  glBindTexture(GL_TEXTURE_2D, 0);
 
   if (loaded_fonts_.find(command.FontId()) == loaded_fonts_.end())
     loaded_fonts_[command.FontId()] = command;
@@ -210,41 +191,82 @@ void GlTextSystem::HandleLoadCommand(LoadFontCommand &command) {
                   __LINE__);
 }
 
+const GlyphAtlas::Glyph *GlTextSystem::LoadGlyph(FontPack &font,
+                                                 FT_FaceRec_ *face,
+                                                 uint32_t codepoint) {
+  // Glyphs the face can't render are still inserted, empty, so they are only
+  // tried once.
+  if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+    return font.atlas.Insert(codepoint, 0, 0, nullptr, 0, 0, 0, 0.f);
+
+  auto glyph = face->glyph;
+  return font.atlas.Insert(codepoint, int(glyph->bitmap.width),
+                           int(glyph->bitmap.rows), glyph->bitmap.buffer,
+                           glyph->bitmap.pitch, glyph->bitmap_left,
+                           glyph->bitmap_top, float(glyph->advance.x >> 6));
+}
+
+void GlTextSystem::UploadAtlas(FontPack &font) {
+  auto &atlas = font.atlas;
+  if (font.uploaded_height == atlas.Height() &&
+      atlas.DirtyBegin() == atlas.DirtyEnd())
+    return;
+
+  glBindTexture(GL_TEXTURE_2D, font.texture_id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (font.uploaded_height != atlas.Height()) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.Width(), atlas.Height(), 0,
+                 GL_RED, GL_UNSIGNED_BYTE, atlas.Pixels());
+    font.uploaded_height = atlas.Height();
+  } else {
+    auto begin = atlas.DirtyBegin();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, begin, atlas.Width(),
+                    atlas.DirtyEnd() - begin, GL_RED, GL_UNSIGNED_BYTE,
+                    atlas.Pixels() + size_t(begin) * atlas.Width());
+  }
+  atlas.ClearDirty();
+}
+
 void GlTextSystem::CreateTextResources() {
   cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error.", __FILE__,
                   __LINE__);
   ct::string vert_shader =
       "#version 420 core\n"
       "layout(location = 0) in vec4 vertex;\n"
-      "out vec2 TexCoords;\n\n"
+      "layout(location = 1) in vec4 vertex_color;\n"
+      "out vec2 TexCoords;\n"
+      "out vec3 TextColor;\n\n"
 
-      "uniform mat4 projection;\n\n"
+      "uniform mat4 projection;\n"
+      "uniform vec2 inv_atlas_size;\n\n"
 
       "void main(){\n"
       "  gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);\n"
-      "  TexCoords = vertex.zw;\n"
+      "  TexCoords = vertex.zw * inv_atlas_size;\n"
+      "  TextColor = vertex_color.rgb;\n"
       "}";
 
   ct::string frag_shader =
       "#version 420 core\n"
       "in vec2 TexCoords;\n"
+      "in vec3 TextColor;\n"
       "out vec4 color;\n\n"
 
-      "uniform sampler2D text;\n"
-      "uniform vec3 textColor;\n\n"
+      "uniform sampler2D text;\n\n"
 
       "void main() {\n"
-      "  color = vec4(textColor, texture(text, TexCoords).r);\n"
+      "  color = vec4(TextColor, texture(text, TexCoords).r);\n"
       "}";
 
   glGenVertexArrays(1, &text_vao);
   glGenBuffers(1, &text_vbo);
   glBindVertexArray(text_vao);
   glBindBuffer(GL_ARRAY_BUFFER, text_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, nullptr,
-               GL_DYNAMIC_DRAW);
   glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), nullptr);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex),
+                        (void *)offsetof(TextVertex, rgba));
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
@@ -300,7 +322,7 @@ void GlTextSystem::CreateTextResources() {
   glDeleteShader(fragment_shader);
 
   proj_loc_ = glGetUniformLocation(shader_, "projection");
-  color_loc_ = glGetUniformLocation(shader_, "textColor");
+  atlas_size_loc_ = glGetUniformLocation(shader_, "inv_atlas_size");
   cu::AssertError(glGetError() == GL_NO_ERROR, "OpenGL error.", __FILE__,
                   __LINE__);
 }
@@ -3,15 +3,19 @@
 #include "gui_text.h"
 #include "text_system.h"
 
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
 namespace lib_gui {
 class GlTextSystem : public TextSystem {
  public:
   GlTextSystem(lib_core::EngineCore *engine);
-  ~GlTextSystem() override = default;
+  ~GlTextSystem() override;
 
   void DrawUpdate(lib_graphics::Renderer *renderer,
                   lib_gui::TextSystem *text_renderer) override;
-  void RenderText(GuiText text, lib_core::Vector2 screen_dim) override;
+  void RenderText(const GuiText &text, lib_core::Vector2 screen_dim) override;
+  void FlushText(lib_core::Vector2 screen_dim) override;
 
   void PurgeGpuResources() override;
 
@@ -20,9 +24,18 @@ class GlTextSystem : public TextSystem {
   void HandleLoadCommand(LoadFontCommand &command) override;
 
   void CreateTextResources();
+  const GlyphAtlas::Glyph *LoadGlyph(FontPack &font, FT_FaceRec_ *face,
+                                     uint32_t codepoint);
+  void UploadAtlas(FontPack &font);
 
   bool init_draw_ = false;
   unsigned text_vao, text_vbo, shader_;
-  int color_loc_, proj_loc_;
+  size_t vbo_size_ = 0;
+  int proj_loc_, atlas_size_loc_;
+
+  // Faces stay open so glyphs outside ASCII can be rasterized on demand.
+  FT_LibraryRec_ *ft_ = nullptr;
+  ct::hash_map<size_t, FT_FaceRec_ *> faces_;
+  ct::dyn_array<uint32_t> codepoints_;
 };
 }  // namespace lib_gui
@@ -8,6 +8,7 @@
 #include "gui_slider.h"
 #include "range_iterator.hpp"
 
+#include <algorithm>
 #include <execution>
 
 namespace lib_gui {
@@ -15,38 +16,67 @@ RectSystem::RectSystem(lib_core::EngineCore* engine) : engine_(engine) {}
 
 void RectSystem::LogicUpdate(float dt) {
   auto rect_comps = g_ent_mgr.GetNewCbt<GuiRect>();
+  if (!rect_comps) {
+    grid_entities_.clear();
+    hovered_ = -1;
+    return;
+  }
 
-  if (rect_comps) {
-    auto old_comps = g_ent_mgr.GetOldCbt<GuiRect>();
-    auto cursor_comp = g_ent_mgr.GetNewCbeR<lib_input::CursorInput>();
-    auto rect_update = g_ent_mgr.GetNewUbt<GuiRect>();
-
-    auto cursor_check_func = [&](size_t i) {
-      auto& rect = (*old_comps)[i];
-      if (cursor_comp->pos[0] < rect.position_[0] + rect.half_size_[0] &&
-          cursor_comp->pos[0] > rect.position_[0] - rect.half_size_[0] &&
-          cursor_comp->pos[1] < rect.position_[1] + rect.half_size_[1] &&
-          cursor_comp->pos[1] > rect.position_[1] - rect.half_size_[1]) {
-        rect.hover = true;
-        (*rect_update)[i] = true;
-      } else if (rect.hover) {
-        rect.hover = false;
-        (*rect_update)[i] = true;
-      }
-    };
+  auto old_comps = g_ent_mgr.GetOldCbt<GuiRect>();
+  auto cursor_comp = g_ent_mgr.GetNewCbeR<lib_input::CursorInput>();
+  auto rect_update = g_ent_mgr.GetNewUbt<GuiRect>();
+  auto rect_ents = g_ent_mgr.GetEbt<GuiRect>();
 
-    auto update_func = [&](size_t i) {
-      if ((*rect_update)[i]) {
-        (*rect_update)[i] = false;
-        (*rect_comps)[i] = (*old_comps)[i];
-      }
-    };
+  bool moved = false;
+  if (grid_entities_ != *rect_ents) {
+    // Components were added or removed and indices may have shifted.
+    hit_grid_.Rebuild(*old_comps);
+    grid_entities_ = *rect_ents;
+    for (size_t i = 0; i < old_comps->size(); ++i) {
+      if (!(*old_comps)[i].hover) continue;
+      (*old_comps)[i].hover = false;
+      (*rect_update)[i] = true;
+    }
+    hovered_ = -1;
+    moved = true;
+  } else {
+    auto begin = rect_update->begin(), end = rect_update->end();
+    for (auto it = std::find(begin, end, 1); it != end;
+         it = std::find(it + 1, end, 1))
+      moved |= hit_grid_.Update(it - begin, (*old_comps)[it - begin]);
+  }
+
+  auto cursor = cursor_comp ? cursor_comp->pos : last_cursor_;
+  if (moved || cursor[0] != last_cursor_[0] || cursor[1] != last_cursor_[1]) {
+    last_cursor_ = cursor;
 
-    auto r = range(0, rect_update->size());
-    std::for_each(std::execution::par_unseq, std::begin(r), std::end(r),
-                  cursor_check_func);
-    std::for_each(std::execution::par_unseq, std::begin(r), std::end(r),
-                  update_func);
+    auto picked = hit_grid_.Pick(cursor);
+    if (picked != hovered_) {
+      if (hovered_ >= 0) {
+        (*old_comps)[hovered_].hover = false;
+        (*rect_update)[hovered_] = true;
+      }
+      if (picked >= 0) {
+        (*old_comps)[picked].hover = true;
+        (*rect_update)[picked] = true;
+      }
+      hovered_ = picked;
+    }
   }
+
+  auto update_func = [&](size_t i) {
+    if ((*rect_update)[i]) {
+      (*rect_update)[i] = false;
+      (*rect_comps)[i] = (*old_comps)[i];
+    }
+  };
+
+  if (std::find(rect_update->begin(), rect_update->end(), 1) ==
+      rect_update->end())
+    return;
+
+  auto r = range(0, rect_update->size());
+  std::for_each(std::execution::par_unseq, std::begin(r), std::end(r),
+                update_func);
 }
 }  // namespace lib_gui
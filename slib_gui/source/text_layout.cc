@@ -0,0 +1,97 @@
+#include "text_layout.h"
+#include "gui_color.h"
+
+namespace lib_gui {
+void TextLayout::Decode(const ct::string& text, ct::dyn_array<uint32_t>& out) {
+  constexpr uint32_t kReplacement = 0xfffd;
+
+  out.clear();
+  auto bytes = reinterpret_cast<const uint8_t*>(text.data());
+  for (size_t i = 0, size = text.size(); i < size;) {
+    auto lead = bytes[i++];
+    if (lead < 0x80) {
+      out.push_back(lead);
+      continue;
+    }
+
+    int extra;
+    uint32_t codepoint, min;
+    if ((lead & 0xe0) == 0xc0)
+      extra = 1, codepoint = lead & 0x1f, min = 0x80;
+    else if ((lead & 0xf0) == 0xe0)
+      extra = 2, codepoint = lead & 0x0f, min = 0x800;
+    else if ((lead & 0xf8) == 0xf0)
+      extra = 3, codepoint = lead & 0x07, min = 0x10000;
+    else {
+      out.push_back(kReplacement);
+      continue;
+    }
+
+    int read = 0;
+    while (read < extra && i < size && (bytes[i] & 0xc0) == 0x80)
+      codepoint = codepoint << 6 | (bytes[i++] & 0x3f), ++read;
+
+    if (read < extra || codepoint < min || codepoint > 0x10ffff ||
+        (codepoint >= 0xd800 && codepoint < 0xe000))
+      codepoint = kReplacement;
+    out.push_back(codepoint);
+  }
+}
+
+void TextLayout::Layout(const GuiText& text,
+                        const ct::dyn_array<uint32_t>& codepoints,
+                        const GlyphAtlas& atlas, float font_size,
+                        lib_core::Vector2 screen_dim,
+                        ct::dyn_array<TextVertex>& out) {
+  // Alpha comes from glyph coverage, only the text's rgb is kept.
+  auto rgba = PackRgba8(text.rgba) | 0xffu << 24;
+  auto scale_x = text.half_size[0], scale_y = text.half_size[1];
+
+  auto origin_x = text.position[0] * screen_dim[0];
+  auto origin_y = text.position[1] * screen_dim[1];
+
+  // Quads are laid out left aligned and shifted once the width is known.
+  auto first = out.size();
+  auto pen_x = origin_x, max_x = origin_x;
+  for (auto codepoint : codepoints) {
+    auto glyph = atlas.Find(codepoint);
+    if (!glyph) continue;
+
+    auto x = pen_x + glyph->bearing_x * scale_x;
+    max_x = x;
+    pen_x += glyph->advance * scale_x;
+    if (glyph->width == 0) continue;
+
+    auto y = origin_y - (glyph->height - glyph->bearing_y) * scale_y;
+    auto w = glyph->width * scale_x, h = glyph->height * scale_y;
+    auto u0 = float(glyph->x), u1 = float(glyph->x + glyph->width);
+    auto v0 = float(glyph->y), v1 = float(glyph->y + glyph->height);
+
+    out.push_back({x, y + h, u0, v0, rgba});
+    out.push_back({x, y, u0, v1, rgba});
+    out.push_back({x + w, y, u1, v1, rgba});
+    out.push_back({x, y + h, u0, v0, rgba});
+    out.push_back({x + w, y, u1, v1, rgba});
+    out.push_back({x + w, y + h, u1, v0, rgba});
+  }
+
+  float shift_x = 0.f, shift_y = 0.f;
+  switch (text.h_alignment) {
+    case GuiText::kLeft:
+      break;
+    case GuiText::kRight:
+      shift_x = origin_x - max_x;
+      break;
+    case GuiText::kCenter:
+      shift_x = (origin_x - max_x) * .5f - font_size * .25f;
+      shift_y = -font_size * .25f;
+      break;
+  }
+  if (shift_x == 0.f && shift_y == 0.f) return;
+
+  for (auto i = first; i < out.size(); ++i) {
+    out[i].x += shift_x;
+    out[i].y += shift_y;
+  }
+}
+}  // namespace lib_gui
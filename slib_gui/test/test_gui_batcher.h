@@ -0,0 +1,56 @@
+#pragma once
+#include "gui_batcher.h"
+
+namespace lib_gui {
+TEST(lib_gui, GuiBatcher_SortsByLayer) {
+  ct::dyn_array<GuiRect> rects = {
+      GuiRect({.1f, .1f}, {.05f, .05f}, {1.f, 0.f, 0.f, 1.f}, 2),
+      GuiRect({.2f, .2f}, {.05f, .05f}, {0.f, 1.f, 0.f, 1.f}, 0),
+      GuiRect({.3f, .3f}, {.05f, .05f}, {0.f, 0.f, 1.f, .5f}, 2),
+      GuiRect({.4f, .4f}, {.05f, .05f}, {1.f, 1.f, 1.f, 1.f}, 0)};
+
+  GuiBatcher batcher;
+  EXPECT_FALSE(batcher.Build(nullptr));
+  EXPECT_TRUE(batcher.Build(&rects));
+
+  auto& batches = batcher.Batches();
+  ASSERT_EQ(batches.size(), 2u);
+  EXPECT_EQ(batches[0].layer, 0);
+  EXPECT_EQ(batches[0].first, 0u);
+  EXPECT_EQ(batches[0].count, 2u);
+  EXPECT_EQ(batches[1].layer, 2);
+  EXPECT_EQ(batches[1].first, 2u);
+  EXPECT_EQ(batcher.FindBatch(2), &batches[1]);
+  EXPECT_EQ(batcher.FindBatch(1), nullptr);
+
+  auto& instances = batcher.Instances();
+  ASSERT_EQ(instances.size(), 4u);
+  EXPECT_FLOAT_EQ(instances[0].x, .2f);
+  EXPECT_FLOAT_EQ(instances[1].x, .4f);
+  EXPECT_FLOAT_EQ(instances[2].x, .1f);
+  EXPECT_EQ(instances[3].rgba, 0x80ff0000u);
+}
+
+TEST(lib_gui, GuiBatcher_RebuildsOnlyOnChange) {
+  ct::dyn_array<GuiRect> rects = {
+      GuiRect({.1f, .1f}, {.05f, .05f}, {1.f, 0.f, 0.f, 1.f})};
+
+  GuiBatcher batcher;
+  EXPECT_TRUE(batcher.Build(&rects));
+  EXPECT_FALSE(batcher.Build(&rects));
+
+  rects[0].hover = true;
+  EXPECT_FALSE(batcher.Build(&rects));
+
+  rects[0].rgba_[3] = 0.f;
+  EXPECT_TRUE(batcher.Build(&rects));
+  EXPECT_EQ(batcher.Instances()[0].rgba, 0x000000ffu);
+
+  rects[0].layer = 4;
+  EXPECT_TRUE(batcher.Build(&rects));
+  EXPECT_EQ(batcher.Batches()[0].layer, 4);
+
+  EXPECT_TRUE(batcher.Build(nullptr));
+  EXPECT_TRUE(batcher.Batches().empty());
+}
+}  // namespace lib_gui
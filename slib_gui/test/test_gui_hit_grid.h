@@ -0,0 +1,49 @@
+#pragma once
+#include "gui_hit_grid.h"
+
+namespace lib_gui {
+TEST(lib_gui, GuiHitGrid_PicksTopmost) {
+  ct::dyn_array<GuiRect> rects = {
+      GuiRect({.5f, .5f}, {.5f, .5f}, {0.f}, 0),
+      GuiRect({.2f, .2f}, {.05f, .05f}, {0.f}, 1),
+      GuiRect({.2f, .2f}, {.02f, .02f}, {0.f}, 1),
+      GuiRect({.8f, .8f}, {.05f, .05f}, {0.f}, 3)};
+
+  GuiHitGrid grid;
+  grid.Rebuild(rects);
+  EXPECT_EQ(grid.Size(), 4u);
+
+  EXPECT_EQ(grid.Pick({.2f, .2f}), 2);
+  EXPECT_EQ(grid.Pick({.24f, .2f}), 1);
+  EXPECT_EQ(grid.Pick({.4f, .4f}), 0);
+  EXPECT_EQ(grid.Pick({.81f, .79f}), 3);
+  EXPECT_EQ(grid.Pick({1.5f, .5f}), -1);
+}
+
+TEST(lib_gui, GuiHitGrid_Update) {
+  ct::dyn_array<GuiRect> rects;
+  for (int i = 0; i < 100; ++i)
+    rects.push_back(GuiRect({i * .01f + .005f, .5f}, {.004f, .004f}, {0.f}));
+
+  GuiHitGrid grid;
+  grid.Rebuild(rects);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(grid.Pick({i * .01f + .005f, .5f}), i);
+
+  EXPECT_FALSE(grid.Update(10, rects[10]));
+  rects[10].position_[1] = .1f;
+  EXPECT_TRUE(grid.Update(10, rects[10]));
+  EXPECT_EQ(grid.Pick({.105f, .5f}), -1);
+  EXPECT_EQ(grid.Pick({.105f, .1f}), 10);
+
+  rects[20].half_size_ = {.5f, .5f};
+  rects[20].layer = 2;
+  EXPECT_TRUE(grid.Update(20, rects[20]));
+  EXPECT_EQ(grid.Pick({.305f, .5f}), 20);
+  EXPECT_EQ(grid.Pick({.105f, .1f}), 20);
+
+  rects[20].layer = 0;
+  EXPECT_TRUE(grid.Update(20, rects[20]));
+  EXPECT_EQ(grid.Pick({.305f, .5f}), 30);
+}
+}  // namespace lib_gui
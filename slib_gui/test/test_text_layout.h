@@ -0,0 +1,81 @@
+#pragma once
+#include "text_layout.h"
+
+namespace lib_gui {
+TEST(lib_gui, TextLayout_DecodeUtf8) {
+  ct::dyn_array<uint32_t> codepoints;
+  TextLayout::Decode("a\xc3\xa5\xe2\x82\xac\xf0\x9f\x98\x80", codepoints);
+  ct::dyn_array<uint32_t> expected = {'a', 0xe5, 0x20ac, 0x1f600};
+  EXPECT_EQ(codepoints, expected);
+
+  TextLayout::Decode("\xc3x\x80\xc0\xaf", codepoints);
+  expected = {0xfffd, 'x', 0xfffd, 0xfffd};
+  EXPECT_EQ(codepoints, expected);
+}
+
+TEST(lib_gui, GlyphAtlas_InsertAndGrow) {
+  GlyphAtlas atlas(32, 16, 64);
+  ct::dyn_array<uint8_t> bitmap(10 * 10, 0xff);
+
+  auto space = atlas.Insert(' ', 0, 0, nullptr, 0, 0, 0, 4.f);
+  EXPECT_EQ(space->width, 0);
+  EXPECT_EQ(atlas.DirtyBegin(), atlas.DirtyEnd());
+
+  for (uint32_t c = 'A'; c < 'A' + 8; ++c)
+    atlas.Insert(c, 10, 10, bitmap.data(), 10, 1, 10, 11.f);
+  EXPECT_EQ(atlas.Height(), 64);
+  EXPECT_EQ(atlas.DirtyBegin(), 0);
+  EXPECT_EQ(atlas.DirtyEnd(), 64);
+
+  for (uint32_t c = 'A'; c < 'A' + 8; ++c) {
+    auto glyph = atlas.Find(c);
+    ASSERT_NE(glyph, nullptr);
+    EXPECT_EQ(glyph->width, 10);
+    EXPECT_EQ(atlas.Pixels()[glyph->y * atlas.Width() + glyph->x], 0xff);
+  }
+  EXPECT_EQ(atlas.Find('Z'), nullptr);
+
+  atlas.ClearDirty();
+  auto euro = atlas.Insert(0x20ac, 3, 2, bitmap.data(), 10, 0, 2, 4.f);
+  EXPECT_EQ(atlas.Find(0x20ac), euro);
+  EXPECT_EQ(atlas.DirtyBegin(), euro->y);
+  EXPECT_EQ(atlas.DirtyEnd(), euro->y + 2);
+
+  auto huge = atlas.Insert(0x4e00, 40, 40, bitmap.data(), 10, 0, 0, 40.f);
+  EXPECT_EQ(huge->width, 0);
+  EXPECT_EQ(huge->advance, 40.f);
+}
+
+TEST(lib_gui, TextLayout_Alignment) {
+  GlyphAtlas atlas(64, 64);
+  ct::dyn_array<uint8_t> bitmap(8 * 8, 0xff);
+  atlas.Insert('a', 8, 8, bitmap.data(), 8, 1, 8, 10.f);
+  atlas.Insert(' ', 0, 0, nullptr, 0, 0, 0, 5.f);
+
+  ct::dyn_array<uint32_t> codepoints;
+  TextLayout::Decode("a a?", codepoints);
+
+  GuiText text("", {.5f, .5f}, {1.f, 1.f}, {1.f, 0.f, 0.f, 1.f});
+  ct::dyn_array<TextVertex> left, right;
+  TextLayout::Layout(text, codepoints, atlas, 16.f, {200.f, 100.f}, left);
+  ASSERT_EQ(left.size(), 12u);
+  EXPECT_FLOAT_EQ(left[1].x, 101.f);
+  EXPECT_FLOAT_EQ(left[1].y, 50.f);
+  EXPECT_FLOAT_EQ(left[0].y, 58.f);
+  EXPECT_FLOAT_EQ(left[6 + 1].x, 116.f);
+  EXPECT_EQ(left[0].rgba, 0xff0000ffu);
+
+  // Texel coordinates survive the atlas growing before the flush.
+  auto glyph = atlas.Find('a');
+  EXPECT_FLOAT_EQ(left[0].u, float(glyph->x));
+  EXPECT_FLOAT_EQ(left[1].v, float(glyph->y + glyph->height));
+
+  text.h_alignment = GuiText::kRight;
+  TextLayout::Layout(text, codepoints, atlas, 16.f, {200.f, 100.f}, right);
+  ASSERT_EQ(right.size(), 12u);
+  for (size_t i = 0; i < left.size(); ++i) {
+    EXPECT_FLOAT_EQ(right[i].x, left[i].x - 16.f);
+    EXPECT_FLOAT_EQ(right[i].u, left[i].u);
+  }
+}
+}  // namespace lib_gui
@@ -4,6 +4,7 @@
 #include "character.h"
 #include "entity_manager.h"
 #include "gui_text.h"
+#include "logger.h"
 
 #ifndef PX_FOUNDATION_VERSION
 #define PX_FOUNDATION_VERSION PX_PHYSICS_VERSION
@@ -39,6 +40,8 @@ PhysxSystem::PhysxSystem() {
 
   if (!scene_desc.isValid()) return;
   scene_ = physics_->createScene(scene_desc);
+  scratch_ =
+      allocator_callback_.allocate(kScratchSize, "scratch", __FILE__, __LINE__);
 
   actor_handler_ =
       std::make_unique<PhysxActorHandler>(physics_, cooking_, scene_);
@@ -56,6 +59,7 @@ PhysxSystem::~PhysxSystem() {
   trigger_handler_.reset();
 
   if (scene_) scene_->release();
+  allocator_callback_.deallocate(scratch_);
   if (physics_) physics_->release();
   if (cooking_) cooking_->release();
   PxCloseExtensions();
@@ -82,7 +86,8 @@ void PhysxSystem::LogicUpdate(float dt) {
   physx::PxU32 error = 0;
   std::chrono::duration<float> dur;
   while (dt_ > step_frequency && max_iter < 20) {
-    scene_->simulate(step_frequency * time_multiplier_);
+    scene_->simulate(step_frequency * time_multiplier_, nullptr, scratch_,
+                     kScratchSize);
     auto start = std::chrono::high_resolution_clock::now();
 
     while (!scene_->fetchResults(false, &error)) {
@@ -206,36 +211,28 @@ uint32_t PhysxSystem::TbbCpuDispatcher::getWorkerCount() const {
 void PhysxSystem::PhysxErrorCallback::reportError(physx::PxErrorCode::Enum code,
                                                   const char *message,
                                                   const char *file, int line) {
-  /*std::ofstream out("./physx_error.log", std::ios::app);
-  out << code << std::endl;
-  out << message << std::endl;
-  out << file << std::endl;
-  out << line << std::endl;
-  out.close();*/
-  cu::Log(message, __FILE__, __LINE__);
+  auto severity = lib_core::Logger::kError;
+  if (code == physx::PxErrorCode::eDEBUG_INFO)
+    severity = lib_core::Logger::kInfo;
+  else if (code == physx::PxErrorCode::eDEBUG_WARNING ||
+           code == physx::PxErrorCode::ePERF_WARNING)
+    severity = lib_core::Logger::kWarning;
+  g_logger.Log(severity, message, file, line);
 }
 
 void *PhysxSystem::PhysxAllocatorCallback::allocate(size_t size,
                                                     const char *typeName,
                                                     const char *filename,
                                                     int line) {
-#ifdef WindowsBuild
-  auto ptr = _aligned_malloc(size, 16);
-#elif UnixBuild
-  auto ptr = aligned_alloc(16, size);
-#endif
-  // total_allocation_ += size;
-  // allocation_map_[ptr] = size;
-  return ptr;
+  auto base = static_cast<uint8_t *>(
+      allocator_.Allocate(size + kHeaderSize, kHeaderSize));
+  *reinterpret_cast<size_t *>(base) = size + kHeaderSize;
+  return base + kHeaderSize;
 }
 
 void PhysxSystem::PhysxAllocatorCallback::deallocate(void *ptr) {
-// total_allocation_ -= allocation_map_[ptr];
-// allocation_map_.erase(ptr);
-#ifdef WindowsBuild
-  _aligned_free(ptr);
-#elif UnixBuild
-  free(ptr);
-#endif
+  if (!ptr) return;
+  auto base = static_cast<uint8_t *>(ptr) - kHeaderSize;
+  allocator_.Deallocate(base, *reinterpret_cast<size_t *>(base), kHeaderSize);
 }
 }  // namespace lib_physics
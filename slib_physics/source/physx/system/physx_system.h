@@ -1,5 +1,6 @@
 #pragma once
 #include "entity.h"
+#include "memory_tracker.h"
 #include "physics_commands.h"
 #include "physics_system.h"
 #include "physx_actor_handler.h"
@@ -50,8 +51,10 @@ class PhysxSystem : public PhysicsSystem {
                    int line) override;
     void deallocate(void* ptr) override;
 
-    size_t total_allocation_ = 0;
-    ct::hash_map<void*, size_t> allocation_map_;
+   private:
+    // PhysX frees without a size, so it is stored in front of every block.
+    static constexpr size_t kHeaderSize = 16;
+    lib_core::TrackingAllocator allocator_{lib_core::MemoryTracker::kPhysics};
   };
 
   static physx::PxFilterFlags FilterShader(
@@ -73,6 +76,12 @@ class PhysxSystem : public PhysicsSystem {
 
   std::unique_ptr<TbbCpuDispatcher> tbb_dispatch_;
 
+  // Scratch block for simulate, PhysX wants 16 byte alignment and a multiple
+  // of 16K. It lives as long as the scene, since a step that timed out can
+  // still be writing to it.
+  static constexpr physx::PxU32 kScratchSize = 16 * 16384;
+  void* scratch_ = nullptr;
+
   std::atomic<uint32_t> ray_cast_id_ = {0};
   std::array<ct::tree_map<uint32_t, std::pair<int, float>>, 2>
       ray_cast_results_;
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include "asset_pack.h"
+#include "core_utilities.h"
+
+struct stb_vorbis;
+
+namespace lib_sound {
+// Single producer, single consumer ring of interleaved 16 bit samples. The
+// decode thread writes, the audio callback reads.
+class PcmRing {
+ public:
+  explicit PcmRing(size_t capacity);
+
+  size_t Capacity() const { return samples_.size(); }
+  size_t Available() const;
+
+  // Contiguous free space at the write position, commit what was filled.
+  int16_t* WriteRegion(size_t& count);
+  void CommitWrite(size_t count);
+
+  // Copies up to count samples and returns how many were read.
+  size_t Read(int16_t* out, size_t count);
+
+ private:
+  ct::dyn_array<int16_t> samples_;
+  std::atomic<size_t> read_ = {0}, write_ = {0};
+};
+
+// A playing Ogg Vorbis voice. Decodes straight from the sound bank into a
+// small ring instead of keeping the whole track as PCM.
+class SoundStream {
+ public:
+  static constexpr size_t kRingFrames = 16384;
+
+  SoundStream(size_t bank, lib_core::PackBlob blob, uint16_t channels,
+              bool loop);
+  ~SoundStream();
+  SoundStream(const SoundStream&) = delete;
+  SoundStream& operator=(const SoundStream&) = delete;
+
+  size_t Bank() const { return bank_; }
+  uint16_t Channels() const { return channels_; }
+
+  // Decode thread. Tops up the ring and opens the decoder on first use.
+  void Fill();
+  // Drops the decoder, the bank backing it is going away. Must not run
+  // concurrently with Fill.
+  void Close();
+
+  // Audio thread. Reads up to frames interleaved frames.
+  size_t Read(int16_t* out, size_t frames);
+  // True once the track ended, or failed, and everything decoded was played.
+  bool Finished() const;
+
+ private:
+  size_t bank_;
+  lib_core::PackBlob blob_;
+  ct::dyn_array<uint8_t> unpacked_;
+  stb_vorbis* vorbis_ = nullptr;
+
+  uint16_t channels_;
+  bool loop_;
+  std::atomic<bool> ended_ = {false};
+  PcmRing ring_;
+};
+}  // namespace lib_sound
@@ -1,7 +1,12 @@
 #pragma once
-#include <fstream>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "asset_pack.h"
 #include "engine_settings.h"
 #include "sound_commands.h"
+#include "sound_stream.h"
 #include "system.h"
 
 namespace lib_sound {
@@ -17,26 +22,35 @@ class SoundSystem : public lib_core::System {
   void LogicUpdate(float dt) override;
 
   enum SoundType { kMusic, kEffect, kAmbient, kVoice };
+  // Stored in the sound entry's meta[3]. Pcm sounds are decompressed whole
+  // on load, vorbis sounds are only ever decoded through a SoundStream.
+  enum Encoding : uint32_t { kPcm = 0, kVorbis };
   struct SoundDesc {
     uint16_t channels;
     uint16_t bits_per_sample;
     uint32_t sample_rate;
-    size_t data_location;
+    uint32_t encoding;
   };
   ct::dyn_array<uint8_t>* GetSoundData(size_t hash);
   SoundDesc* GetSoundDesc(size_t hash);
 
+  // Starts decoding a vorbis sound on the stream thread, returns nullptr for
+  // pcm or unknown sounds.
+  std::shared_ptr<SoundStream> OpenStream(size_t hash, bool loop);
+
  protected:
   void RegisterQueuedBanks();
   void LoadSound(size_t hash);
+  void DecodeStreams();
 
   struct Sound {
     SoundDesc desc;
+    lib_core::PackBlob blob;
     ct::dyn_array<uint8_t> data;
   };
 
   struct SoundBank {
-    std::ifstream file;
+    std::unique_ptr<lib_core::AssetPack> pack;
     ct::hash_map<size_t, Sound> sounds;
   };
 
@@ -50,5 +64,13 @@ class SoundSystem : public lib_core::System {
   ct::hash_map<size_t, size_t> sound_bank_map_;
 
   std::array<size_t, 3> callback_ids;
+
+  // Streams are dropped once only the decode thread still holds them.
+  static constexpr auto kDecodeInterval = std::chrono::milliseconds(10);
+  ct::dyn_array<std::shared_ptr<SoundStream>> streams_;
+  std::mutex stream_mutex_;
+  std::condition_variable stream_cv_;
+  bool stop_decode_ = false;
+  std::thread decode_thread_;
 };
 }  // namespace lib_sound
@@ -9,6 +9,7 @@
 #elif WindowsBuild
 #include "portaudio/portaudio.h"
 #endif
+#include <algorithm>
 #include <cassert>
 
 namespace lib_sound {
@@ -28,6 +29,30 @@ int portaudio_callback(const void *input, void *output, unsigned long frames,
   return stream_info->sound_func(output, frames, stream_info);
 }
 
+// Underruns play silence, the decode thread catches up on its next fill.
+template <typename T>
+void MixStream(T *samples, unsigned long frames, int channels,
+               PortAudioSystem::SoundInfo &sound,
+               PortAudioSystem::StreamInfo *info) {
+  auto &stream = *sound.stream;
+  int16_t pcm[1024];
+  auto stream_channels = stream.Channels();
+  auto chunk = sizeof(pcm) / sizeof(pcm[0]) / stream_channels;
+
+  size_t fi = 0;
+  while (fi < frames) {
+    auto read = stream.Read(pcm, std::min<size_t>(chunk, frames - fi));
+    if (read == 0) break;
+    for (size_t f = 0; f < read; ++f, ++fi)
+      for (int ii = 0; ii < channels; ++ii)
+        samples[fi * channels + ii] +=
+            T(pcm[f * stream_channels + ii % stream_channels] * sound.volume);
+  }
+
+  if (stream.Finished() && !sound.loop)
+    info->sys->RemoveSoundEntity(sound.type, sound.ent);
+}
+
 template <typename T>
 int sound_callback(void *output, unsigned long frames,
                    PortAudioSystem::StreamInfo *info) {
@@ -44,6 +69,11 @@ int sound_callback(void *output, unsigned long frames,
   for (int i = 0; i < 4; ++i) {
     std::memset(samples.data(), 0, samples.size() * sizeof(T));
     for (auto &s : info->playing_sounds_[i]) {
+      if (s.second.stream) {
+        MixStream(samples.data(), frames, info->channels, s.second, info);
+        continue;
+      }
+
       auto sound_data = info->sys->GetSoundData(s.second.sound);
       if (!sound_data) continue;
       auto sound_desc = info->sys->GetSoundDesc(s.second.sound);
@@ -102,8 +132,7 @@ PortAudioSystem::PortAudioSystem() {
         info.sound = music_comp->audio_id;
         info.type = kMusic;
         info.volume = music_comp->volume;
-
-        stream_info_.add_sound_queue_.push(info);
+        QueueSound(std::move(info));
       });
   add_es_cb_ = g_ent_mgr.RegisterAddComponentCallback<EffectSound>(
       [&](lib_core::Entity ent) {
@@ -116,8 +145,7 @@ PortAudioSystem::PortAudioSystem() {
         info.sound = es_comp->audio_id;
         info.type = kEffect;
         info.volume = es_comp->volume;
-
-        stream_info_.add_sound_queue_.push(info);
+        QueueSound(std::move(info));
       });
   add_as_cd_ = g_ent_mgr.RegisterAddComponentCallback<AmbientSound>(
       [&](lib_core::Entity ent) {
@@ -130,16 +158,17 @@ PortAudioSystem::PortAudioSystem() {
         info.sound = as_comp->audio_id;
         info.type = kAmbient;
         info.volume = as_comp->volume;
-
-        stream_info_.add_sound_queue_.push(info);
+        QueueSound(std::move(info));
       });
 
   rem_music_cb_ = g_ent_mgr.RegisterRemoveComponentCallback<Music>(
       [&](lib_core::Entity ent) {
+        DropPendingSound(ent, kMusic);
         stream_info_.remove_sound_queue_.push({ent, kMusic});
       });
   rem_as_cd_ = g_ent_mgr.RegisterRemoveComponentCallback<AmbientSound>(
       [&](lib_core::Entity ent) {
+        DropPendingSound(ent, kAmbient);
         stream_info_.remove_sound_queue_.push({ent, kAmbient});
       });
 }
@@ -195,9 +224,36 @@ void PortAudioSystem::FinalizeSystem() {
                   __FILE__, __LINE__);
 }
 
-void PortAudioSystem::LogicUpdate(float dt) { SoundSystem::LogicUpdate(dt); }
+void PortAudioSystem::LogicUpdate(float dt) {
+  SoundSystem::LogicUpdate(dt);
+
+  auto pending = std::move(pending_sounds_);
+  pending_sounds_.clear();
+  for (auto &info : pending) QueueSound(std::move(info));
+}
 
 void PortAudioSystem::RemoveSoundEntity(SoundType type, lib_core::Entity ent) {
   remove_sound_.push({type, ent});
 }
+
+void PortAudioSystem::QueueSound(SoundInfo info) {
+  // The bank may still be waiting in RegisterQueuedBanks, the voice is held
+  // back until it is known so a vorbis sound gets its stream.
+  if (!GetSoundDesc(info.sound)) {
+    pending_sounds_.push_back(std::move(info));
+    return;
+  }
+
+  info.stream = OpenStream(info.sound, info.loop);
+  stream_info_.add_sound_queue_.push(std::move(info));
+}
+
+void PortAudioSystem::DropPendingSound(lib_core::Entity ent, SoundType type) {
+  pending_sounds_.erase(
+      std::remove_if(pending_sounds_.begin(), pending_sounds_.end(),
+                     [&](const SoundInfo &info) {
+                       return info.ent == ent && info.type == type;
+                     }),
+      pending_sounds_.end());
+}
 }  // namespace lib_sound
@@ -18,6 +18,7 @@ class PortAudioSystem : public SoundSystem {
     float volume;
     size_t progress = 0;
     bool loop = true;
+    std::shared_ptr<SoundStream> stream;
   };
 
   struct StreamInfo {
@@ -37,8 +38,12 @@ class PortAudioSystem : public SoundSystem {
   void RemoveSoundEntity(SoundType type, lib_core::Entity ent);
 
  private:
+  void QueueSound(SoundInfo info);
+  void DropPendingSound(lib_core::Entity ent, SoundType type);
+
   void* stream_;
   StreamInfo stream_info_;
+  ct::dyn_array<SoundInfo> pending_sounds_;
 
   size_t add_music_cb_, add_es_cb_, add_as_cd_;
   size_t rem_music_cb_, rem_as_cd_;
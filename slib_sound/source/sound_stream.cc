@@ -0,0 +1,125 @@
+#include "sound_stream.h"
+#include <algorithm>
+#include <cstring>
+#include "memory_tracker.h"
+
+#define STB_VORBIS_HEADER_ONLY
+#include "../../source_shared/include/stb_vorbis.hpp"
+
+namespace lib_sound {
+PcmRing::PcmRing(size_t capacity) : samples_(capacity, 0) {}
+
+size_t PcmRing::Available() const {
+  return write_.load(std::memory_order_acquire) -
+         read_.load(std::memory_order_acquire);
+}
+
+int16_t* PcmRing::WriteRegion(size_t& count) {
+  auto write = write_.load(std::memory_order_relaxed);
+  auto free = samples_.size() - (write - read_.load(std::memory_order_acquire));
+  auto offset = write % samples_.size();
+  count = std::min(free, samples_.size() - offset);
+  return samples_.data() + offset;
+}
+
+void PcmRing::CommitWrite(size_t count) {
+  write_.fetch_add(count, std::memory_order_release);
+}
+
+size_t PcmRing::Read(int16_t* out, size_t count) {
+  auto read = read_.load(std::memory_order_relaxed);
+  count = std::min(count, write_.load(std::memory_order_acquire) - read);
+
+  auto offset = read % samples_.size();
+  auto first = std::min(count, samples_.size() - offset);
+  std::memcpy(out, samples_.data() + offset, first * sizeof(int16_t));
+  std::memcpy(out + first, samples_.data(), (count - first) * sizeof(int16_t));
+  read_.fetch_add(count, std::memory_order_release);
+  return count;
+}
+
+SoundStream::SoundStream(size_t bank, lib_core::PackBlob blob,
+                         uint16_t channels, bool loop)
+    : bank_(bank),
+      blob_(blob),
+      channels_(std::max<uint16_t>(channels, 1)),
+      loop_(loop),
+      ring_(kRingFrames * channels_) {
+  g_mem_tracker.Allocated(lib_core::MemoryTracker::kSoundData,
+                          ring_.Capacity() * sizeof(int16_t));
+}
+
+SoundStream::~SoundStream() {
+  Close();
+  g_mem_tracker.Freed(lib_core::MemoryTracker::kSoundData,
+                      ring_.Capacity() * sizeof(int16_t));
+}
+
+void SoundStream::Fill() {
+  if (ended_) return;
+
+  if (!vorbis_) {
+    auto data = blob_.data.data;
+    auto size = blob_.data.size;
+    if (blob_.codec != lib_core::Codec::kStore) {
+      if (!blob_.Unpack(unpacked_)) {
+        ended_ = true;
+        return;
+      }
+      g_mem_tracker.Allocated(lib_core::MemoryTracker::kSoundData,
+                              unpacked_.capacity());
+      data = unpacked_.data(), size = unpacked_.size();
+    }
+
+    int error = 0;
+    vorbis_ = stb_vorbis_open_memory(data, int(size), &error, nullptr);
+    if (!vorbis_) {
+      cu::Log("Failed to open vorbis stream: " + std::to_string(error),
+              __FILE__, __LINE__);
+      ended_ = true;
+      return;
+    }
+  }
+
+  // A looping track rewinds once per empty read, a second empty read in a
+  // row means there is nothing to decode at all.
+  bool rewound = false;
+  for (;;) {
+    size_t count;
+    auto region = ring_.WriteRegion(count);
+    count -= count % channels_;
+    if (count == 0) break;
+
+    auto frames = stb_vorbis_get_samples_short_interleaved(
+        vorbis_, channels_, region, int(count));
+    if (frames > 0) {
+      ring_.CommitWrite(size_t(frames) * channels_);
+      rewound = false;
+    } else if (loop_ && !rewound && stb_vorbis_seek_start(vorbis_)) {
+      rewound = true;
+    } else {
+      ended_ = true;
+      break;
+    }
+  }
+}
+
+void SoundStream::Close() {
+  if (vorbis_) stb_vorbis_close(vorbis_);
+  vorbis_ = nullptr;
+  ended_ = true;
+
+  if (!unpacked_.empty())
+    g_mem_tracker.Freed(lib_core::MemoryTracker::kSoundData,
+                        unpacked_.capacity());
+  unpacked_ = {};
+}
+
+size_t SoundStream::Read(int16_t* out, size_t frames) {
+  return ring_.Read(out, frames * channels_) / channels_;
+}
+
+bool SoundStream::Finished() const {
+  return ended_ && ring_.Available() == 0;
+}
+}  // namespace lib_sound
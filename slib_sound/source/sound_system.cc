@@ -1,8 +1,10 @@
 #include "sound_system.h"
+#include <algorithm>
 #include "ambient_sound.h"
 #include "core_utilities.h"
 #include "effect_sound.h"
 #include "entity_manager.h"
+#include "memory_tracker.h"
 #include "music.h"
 
 namespace lib_sound {
@@ -22,12 +24,28 @@ SoundSystem::SoundSystem() {
         auto comp = g_ent_mgr.GetNewCbeR<AmbientSound>(ent);
         add_sound_.insert(comp->audio_id);
       });
+
+  decode_thread_ = std::thread([this]() { DecodeStreams(); });
 }
 
 SoundSystem::~SoundSystem() {
   g_ent_mgr.UnregisterAddComponentCallback<Music>(callback_ids[0]);
   g_ent_mgr.UnregisterAddComponentCallback<EffectSound>(callback_ids[1]);
   g_ent_mgr.UnregisterAddComponentCallback<AmbientSound>(callback_ids[2]);
+
+  {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    stop_decode_ = true;
+  }
+  stream_cv_.notify_one();
+  decode_thread_.join();
+  for (auto &stream : streams_) stream->Close();
+  streams_.clear();
+
+  for (auto &bank : sound_banks_)
+    for (auto &sound : bank.second.sounds)
+      g_mem_tracker.Freed(lib_core::MemoryTracker::kSoundData,
+                          sound.second.data.capacity());
 }
 
 void SoundSystem::RegisterSoundBank(const ct::string &path) {
@@ -83,6 +101,27 @@ ct::dyn_array<uint8_t> *SoundSystem::GetSoundData(size_t hash) {
   return nullptr;
 }
 
+std::shared_ptr<SoundStream> SoundSystem::OpenStream(size_t hash, bool loop) {
+  auto it = sound_bank_map_.find(hash);
+  if (it == sound_bank_map_.end()) return nullptr;
+  auto bank_it = sound_banks_.find(it->second);
+  if (bank_it == sound_banks_.end()) return nullptr;
+  auto sound_it = bank_it->second.sounds.find(hash);
+  if (sound_it == bank_it->second.sounds.end()) return nullptr;
+
+  auto &sound = sound_it->second;
+  if (sound.desc.encoding != kVorbis) return nullptr;
+
+  auto stream = std::make_shared<SoundStream>(it->second, sound.blob,
+                                              sound.desc.channels, loop);
+  {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    streams_.push_back(stream);
+  }
+  stream_cv_.notify_one();
+  return stream;
+}
+
 SoundSystem::SoundDesc *SoundSystem::GetSoundDesc(size_t hash) {
   auto it = sound_bank_map_.find(hash);
   if (it != sound_bank_map_.end()) {
@@ -102,36 +141,41 @@ void SoundSystem::RegisterQueuedBanks() {
     auto bank_hash = std::hash<ct::string>{}(path);
     if (sound_banks_.find(bank_hash) != sound_banks_.end()) return;
 
+    auto pack = std::make_unique<lib_core::AssetPack>();
+    if (!pack->Open(path) || pack->GetType() != lib_core::AssetPack::kSound)
+      continue;
+
     auto &bank = sound_banks_[bank_hash];
-    bank.file = std::ifstream(path, std::ios::binary);
-
-    if (!bank.file.fail()) {
-      size_t nr_sounds;
-      bank.file.read((char *)&nr_sounds, sizeof(nr_sounds));
-
-      size_t path_length;
-      ct::string sound_str;
-      for (int i = 0; i < nr_sounds; ++i) {
-        bank.file.read((char *)&path_length, sizeof(path_length));
-        sound_str.assign(path_length, ' ');
-        bank.file.read((char *)sound_str.data(), sizeof(uint8_t) * path_length);
-
-        if (sound_str.find_last_of('\\') != ct::string::npos)
-          sound_str = sound_str.substr(sound_str.find_last_of('\\') + 1,
-                                       sound_str.size());
-
-        auto sound_hash = std::hash<ct::string>{}(sound_str);
-        sound_bank_map_[sound_hash] = bank_hash;
-        auto &sound = bank.sounds[sound_hash];
-        bank.file.read((char *)&sound.desc, sizeof(sound.desc));
-      }
-    } else
-      sound_banks_.erase(bank_hash);
+    for (size_t i = 0; i < pack->EntryCount(); ++i) {
+      auto &entry = pack->Entry(i);
+      auto sound_hash = std::hash<ct::string>{}(ct::string(pack->Name(entry)));
+      sound_bank_map_[sound_hash] = bank_hash;
+
+      auto &sound = bank.sounds[sound_hash];
+      sound.desc.channels = uint16_t(entry.meta[0]);
+      sound.desc.bits_per_sample = uint16_t(entry.meta[1]);
+      sound.desc.sample_rate = entry.meta[2];
+      sound.desc.encoding = entry.meta[3];
+      sound.blob = pack->Blob(entry);
+    }
+    bank.pack = std::move(pack);
   }
 
   while (remove_packs_.try_pop(path)) {
     auto bank_hash = std::hash<ct::string>{}(path);
-    sound_banks_.erase(bank_hash);
+    auto bank_it = sound_banks_.find(bank_hash);
+    if (bank_it == sound_banks_.end()) continue;
+
+    {
+      std::lock_guard<std::mutex> lock(stream_mutex_);
+      for (auto &stream : streams_)
+        if (stream->Bank() == bank_hash) stream->Close();
+    }
+
+    for (auto &sound : bank_it->second.sounds)
+      g_mem_tracker.Freed(lib_core::MemoryTracker::kSoundData,
+                          sound.second.data.capacity());
+    sound_banks_.erase(bank_it);
   }
 }
 
@@ -142,16 +186,11 @@ void SoundSystem::LoadSound(size_t hash) {
     if (bank_it != sound_banks_.end()) {
       auto sound_it = bank_it->second.sounds.find(hash);
       if (sound_it != bank_it->second.sounds.end()) {
-        if (sound_it->second.data.empty()) {
-          bank_it->second.file.seekg(sound_it->second.desc.data_location);
-
-          size_t data_size;
-          bank_it->second.file.read((char *)&data_size, sizeof(size_t));
-          ct::dyn_array<uint8_t> compressed(data_size);
-          bank_it->second.file.read((char *)compressed.data(),
-                                    compressed.size());
-
-          cu::DecompressMemory(compressed, sound_it->second.data);
+        auto &sound = sound_it->second;
+        if (sound.desc.encoding == kPcm && sound.data.empty()) {
+          sound.blob.Unpack(sound.data);
+          g_mem_tracker.Allocated(lib_core::MemoryTracker::kSoundData,
+                                  sound.data.capacity());
 
           loaded_sounds_.insert(hash);
         }
@@ -159,4 +198,17 @@ void SoundSystem::LoadSound(size_t hash) {
     }
   }
 }
+
+void SoundSystem::DecodeStreams() {
+  std::unique_lock<std::mutex> lock(stream_mutex_);
+  while (!stop_decode_) {
+    for (auto &stream : streams_) stream->Fill();
+    streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+                                  [](auto &stream) {
+                                    return stream.use_count() == 1;
+                                  }),
+                   streams_.end());
+    stream_cv_.wait_for(lock, kDecodeInterval);
+  }
+}
 }  // namespace lib_sound
@@ -0,0 +1,12 @@
+// The one translation unit that compiles stb_vorbis, the sound streams and
+// the sound cooker include it with STB_VORBIS_HEADER_ONLY.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+// temp_free expands to a bare 0 when stb_vorbis uses alloca.
+#pragma GCC diagnostic ignored "-Wunused-value"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include "../../source_shared/include/stb_vorbis.hpp"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#include "sound_stream.h"
+
+namespace lib_sound {
+TEST(lib_sound, PcmRing_WrapsAround) {
+  PcmRing ring(8);
+
+  size_t count;
+  auto region = ring.WriteRegion(count);
+  EXPECT_EQ(count, 8u);
+  for (int16_t i = 0; i < 6; ++i) region[i] = i;
+  ring.CommitWrite(6);
+
+  int16_t out[8];
+  EXPECT_EQ(ring.Read(out, 4), 4u);
+  EXPECT_EQ(out[3], 3);
+
+  region = ring.WriteRegion(count);
+  EXPECT_EQ(count, 2u);
+  region[0] = 6, region[1] = 7;
+  ring.CommitWrite(2);
+
+  region = ring.WriteRegion(count);
+  EXPECT_EQ(count, 4u);
+  for (int16_t i = 0; i < 4; ++i) region[i] = 8 + i;
+  ring.CommitWrite(4);
+
+  EXPECT_EQ(ring.Available(), 8u);
+  ring.WriteRegion(count);
+  EXPECT_EQ(count, 0u);
+
+  EXPECT_EQ(ring.Read(out, 8), 8u);
+  for (int16_t i = 0; i < 8; ++i) EXPECT_EQ(out[i], 4 + i);
+  EXPECT_EQ(ring.Read(out, 8), 0u);
+}
+}  // namespace lib_sound